@@ -143,6 +143,10 @@ public:
         if (!data->hasAccessibleBuffer())
             return nullptr;
 
+        // Entries of the package are looked up randomly, so a large readahead
+        // window is useless and only wastes the page cache.
+        data->advise(vfs::AdviseHint::kRandom);
+
         auto result = std::make_unique<Package>();
         result->data_ = data;
         result->pkg_addr_ = reinterpret_cast<const uint8_t*>(data->getAccessibleBuffer());
@@ -259,6 +263,11 @@ public:
         return root_node_.get();
     }
 
+    g_nodiscard std::shared_ptr<Data> GetEntryDataView(const proto::DataTableEntry *entry) const {
+        CHECK(entry);
+        return Data::MakeView(data_, entry->data - pkg_addr_, entry->size);
+    }
+
 private:
     std::shared_ptr<Data>           data_;
     const uint8_t                  *pkg_addr_;
@@ -353,6 +362,14 @@ public:
         return Storage{entry->size, entry->data};
     }
 
+    g_nodiscard std::shared_ptr<Data> GetDataView() const {
+        if (ref_node_->type_ != DirtreeNode::kFile_Type)
+            return nullptr;
+        const proto::DataTableEntry *entry =
+                ref_node_->package_->GetGDTEntry(ref_node_->data_id_);
+        return ref_node_->package_->GetEntryDataView(entry);
+    }
+
 private:
     DirtreeNode *ref_node_;
     std::vector<std::unique_ptr<VDiskDirtreeNode>> children_;
@@ -387,15 +404,14 @@ VirtualDisk::MakeLayerDisk(const DataVector& datas)
     return vdisk;
 }
 
-std::optional<VirtualDisk::Storage>
-VirtualDisk::GetStorage(const std::string_view& path)
+VirtualDisk::VDiskDirtreeNode *VirtualDisk::FindNode(const std::string_view& path)
 {
     if (path.empty())
-        return {};
+        return nullptr;
 
     // Only absolute path is supported
     if (path[0] != '/')
-        return {};
+        return nullptr;
 
     std::string_view sv(path);
     while (sv[0] == '/')
@@ -416,7 +432,7 @@ VirtualDisk::GetStorage(const std::string_view& path)
         if (name == "..")
         {
             if (node_stack.size() <= 1)
-                return {};
+                return nullptr;
             node_stack.pop();
             continue;
         }
@@ -424,13 +440,30 @@ VirtualDisk::GetStorage(const std::string_view& path)
         HashedStringView name_view(name);
         int32_t child_idx = node_stack.top()->FindChildrenByName(name_view);
         if (child_idx < 0)
-            return {};
+            return nullptr;
 
         auto *next = node_stack.top()->GetChildren()[child_idx].get();
         node_stack.push(next);
     }
 
-    return node_stack.top()->GetStorage();
+    return node_stack.top();
+}
+
+std::optional<VirtualDisk::Storage>
+VirtualDisk::GetStorage(const std::string_view& path)
+{
+    VDiskDirtreeNode *node = FindNode(path);
+    if (!node)
+        return {};
+    return node->GetStorage();
+}
+
+std::shared_ptr<Data> VirtualDisk::GetData(const std::string_view& path)
+{
+    VDiskDirtreeNode *node = FindNode(path);
+    if (!node)
+        return nullptr;
+    return node->GetDataView();
 }
 
 CRPKG_NAMESPACE_END
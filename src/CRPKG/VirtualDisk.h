@@ -44,7 +44,15 @@ public:
 
     std::optional<Storage> GetStorage(const std::string_view& path);
 
+    /**
+     * Get the contents of a file as a readonly `Data` without copying.
+     * The returned `Data` keeps the underlying package alive.
+     */
+    std::shared_ptr<Data> GetData(const std::string_view& path);
+
 private:
+    VDiskDirtreeNode *FindNode(const std::string_view& path);
+
     std::vector<std::unique_ptr<Package>> packages_;
     std::unique_ptr<VDiskDirtreeNode> dirtree_;
 };
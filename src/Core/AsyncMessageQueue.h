@@ -20,6 +20,7 @@
 
 #include <queue>
 #include <mutex>
+#include <atomic>
 #include <functional>
 #include <condition_variable>
 
@@ -44,19 +45,22 @@ public:
         : message_handler_(std::move(message_handler))
         , message_listener_(nullptr)
         , notifier_(event_loop, [this] { OnMessageComing(); })
-        , non_blocking_(false) {}
+        , non_blocking_(false)
+        , pending_count_(0) {}
 
     AsyncMessageQueue(uv_loop_t *event_loop, MessageListener *listener)
         : message_listener_(listener)
         , notifier_(event_loop, [this] { OnMessageComing(); })
-        , non_blocking_(false) {}
+        , non_blocking_(false)
+        , pending_count_(0) {}
 
     AsyncMessageQueue(AsyncMessageQueue<T, UniquePtr>&& rhs) noexcept
         : message_handler_(std::move(rhs.message_handler_))
         , message_listener_(rhs.message_listener_)
         , queue_(std::move(rhs.queue_))
         , notifier_(std::move(rhs.notifier_))
-        , non_blocking_(rhs.non_blocking_) {}
+        , non_blocking_(rhs.non_blocking_)
+        , pending_count_(rhs.pending_count_.load()) {}
 
     void Enqueue(Message message, std::function<void(const Message&)> finish_enqueue = {});
     void SetNonBlocking(bool non_blocking);
@@ -79,6 +83,15 @@ public:
      */
     Message WaitOnce();
 
+    /**
+     * The number of messages which have been enqueued but not taken
+     * by the receiver yet. It can be read from any thread without locking,
+     * which is useful for profiling (trace counters, for example).
+     */
+    g_nodiscard g_inline size_t GetPendingCount() const {
+        return pending_count_.load(std::memory_order_relaxed);
+    }
+
 private:
     void OnMessageComing();
 
@@ -90,6 +103,7 @@ private:
     std::condition_variable      queue_cond_;
     uv::AsyncHandle              notifier_;
     bool                         non_blocking_;
+    std::atomic<size_t>          pending_count_;
 };
 
 template<typename T, typename U>
@@ -114,6 +128,7 @@ void AsyncMessageQueue<T, U>::Enqueue(
 {
     std::scoped_lock<std::mutex> lock(queue_lock_);
     queue_.emplace(std::move(message));
+    pending_count_.fetch_add(1, std::memory_order_relaxed);
     if (finish_enqueue)
         finish_enqueue(queue_.back());
     notifier_.Send();
@@ -143,6 +158,7 @@ void AsyncMessageQueue<T, U>::OnMessageComing()
         messages.emplace_back(std::move(queue_.front()));
         queue_.pop();
     }
+    pending_count_.fetch_sub(messages.size(), std::memory_order_relaxed);
     queue_lock_.unlock();
 
     if (!message_handler_ && !message_listener_)
@@ -168,6 +184,7 @@ typename AsyncMessageQueue<T, U>::Message AsyncMessageQueue<T, U>::WaitOnce()
     queue_cond_.wait(lock, [this]() { return !this->queue_.empty(); });
     auto result = std::move(queue_.front());
     queue_.pop();
+    pending_count_.fetch_sub(1, std::memory_order_relaxed);
     return result;
 }
 
@@ -0,0 +1,142 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "Core/Errors.h"
+#include "Core/BumpArena.h"
+namespace cocoa {
+
+struct BumpArena::Block
+{
+    Block      *prev;
+    size_t      size;
+    size_t      used;
+
+    g_nodiscard uint8_t *payload() {
+        return reinterpret_cast<uint8_t*>(this) + kHeaderSize;
+    }
+
+    static const size_t kHeaderSize;
+};
+
+// Keep the payload aligned as `malloc` does
+const size_t BumpArena::Block::kHeaderSize =
+        (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+BumpArena::BumpArena(size_t block_size)
+    : block_size_(block_size)
+    , current_block_(nullptr)
+    , bytes_allocated_(0)
+    , high_water_mark_(0)
+    , bytes_reserved_(0)
+{
+    CHECK(block_size_ > 0);
+}
+
+BumpArena::~BumpArena()
+{
+    while (current_block_)
+    {
+        Block *prev = current_block_->prev;
+        std::free(current_block_);
+        current_block_ = prev;
+    }
+}
+
+BumpArena::Block *BumpArena::NewBlock(size_t min_payload_size)
+{
+    size_t size = std::max(block_size_, min_payload_size);
+    auto *block = static_cast<Block*>(std::malloc(Block::kHeaderSize + size));
+    if (!block)
+        throw std::bad_alloc();
+
+    block->prev = current_block_;
+    block->size = size;
+    block->used = 0;
+    current_block_ = block;
+    bytes_reserved_ += size;
+    return block;
+}
+
+namespace {
+
+g_inline size_t aligned_offset(uint8_t *base, size_t used, size_t alignment)
+{
+    auto addr = reinterpret_cast<uintptr_t>(base) + used;
+    addr = (addr + alignment - 1) & ~(alignment - 1);
+    return addr - reinterpret_cast<uintptr_t>(base);
+}
+
+} // namespace anonymous
+
+void *BumpArena::Allocate(size_t size, size_t alignment)
+{
+    CHECK(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    Block *block = current_block_;
+    size_t offset = 0;
+    if (block)
+        offset = aligned_offset(block->payload(), block->used, alignment);
+
+    if (!block || offset + size > block->size)
+    {
+        // Payload is aligned to `max_align_t`, which is enough for most types.
+        // Reserve some extra space for the larger alignments.
+        size_t extra = alignment > alignof(std::max_align_t) ? alignment : 0;
+        block = NewBlock(size + extra);
+        offset = aligned_offset(block->payload(), 0, alignment);
+    }
+
+    void *ptr = block->payload() + offset;
+    block->used = offset + size;
+
+    bytes_allocated_ += size;
+    high_water_mark_ = std::max(high_water_mark_, bytes_allocated_);
+    return ptr;
+}
+
+void BumpArena::Reset()
+{
+    bytes_allocated_ = 0;
+    if (!current_block_)
+        return;
+
+    if (!current_block_->prev)
+    {
+        current_block_->used = 0;
+        return;
+    }
+
+    // Several blocks have been allocated in the last cycle,
+    // merge them into a single one.
+    size_t total_size = 0;
+    while (current_block_)
+    {
+        Block *prev = current_block_->prev;
+        total_size += current_block_->size;
+        std::free(current_block_);
+        current_block_ = prev;
+    }
+    bytes_reserved_ = 0;
+    NewBlock(total_size);
+}
+
+} // namespace cocoa
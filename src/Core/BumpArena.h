@@ -0,0 +1,133 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_CORE_BUMPARENA_H
+#define COCOA_CORE_BUMPARENA_H
+
+#include <cstddef>
+#include <new>
+
+#include "Core/Project.h"
+namespace cocoa {
+
+/**
+ * A bump allocator for short-lived objects.
+ * Allocating from the arena just moves a pointer forward, and nothing is
+ * released individually: all the allocations are released at once by `Reset`.
+ * Destructors of the objects are never called by the arena, so the objects
+ * allocated from it should be destructed by their owners (STL containers
+ * using `BumpArenaAllocator`, for example) before the arena is reset.
+ *
+ * When an arena has grown into several blocks, `Reset` merges them into
+ * a single block which is large enough for the next cycle, so that a
+ * steady workload allocates from the system only once.
+ */
+class BumpArena
+{
+public:
+    CO_NONCOPYABLE(BumpArena)
+    CO_NONASSIGNABLE(BumpArena)
+
+    constexpr static size_t kDefaultBlockSize = 16 * 1024;
+
+    explicit BumpArena(size_t block_size = kDefaultBlockSize);
+    ~BumpArena();
+
+    g_nodiscard void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Release all the allocations
+    void Reset();
+
+    // Bytes allocated since the last `Reset`
+    g_nodiscard g_inline size_t GetBytesAllocated() const {
+        return bytes_allocated_;
+    }
+
+    // The maximum value `GetBytesAllocated` has ever reached
+    g_nodiscard g_inline size_t GetHighWaterMark() const {
+        return high_water_mark_;
+    }
+
+    // Bytes of memory that are held by the arena
+    g_nodiscard g_inline size_t GetBytesReserved() const {
+        return bytes_reserved_;
+    }
+
+private:
+    struct Block;
+
+    Block *NewBlock(size_t min_payload_size);
+
+    size_t      block_size_;
+    Block      *current_block_;
+    size_t      bytes_allocated_;
+    size_t      high_water_mark_;
+    size_t      bytes_reserved_;
+};
+
+/**
+ * STL-compatible allocator which allocates from a `BumpArena`.
+ * A default-constructed allocator has no arena and falls back to
+ * the global `operator new`, so that containers using it can still be
+ * created without an arena.
+ */
+template<typename T>
+class BumpArenaAllocator
+{
+public:
+    using value_type = T;
+
+    BumpArenaAllocator() noexcept : arena_(nullptr) {}
+    explicit BumpArenaAllocator(BumpArena *arena) noexcept : arena_(arena) {}
+
+    template<typename U>
+    BumpArenaAllocator(const BumpArenaAllocator<U>& other) noexcept // NOLINT
+        : arena_(other.GetArena()) {}
+
+    g_nodiscard T *allocate(size_t n) {
+        if (arena_)
+            return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, g_maybe_unused size_t n) noexcept {
+        // Memory allocated from arena is released by `BumpArena::Reset`
+        if (!arena_)
+            ::operator delete(ptr);
+    }
+
+    g_nodiscard g_inline BumpArena *GetArena() const noexcept {
+        return arena_;
+    }
+
+    template<typename U>
+    bool operator==(const BumpArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.GetArena();
+    }
+
+    template<typename U>
+    bool operator!=(const BumpArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.GetArena();
+    }
+
+private:
+    BumpArena  *arena_;
+};
+
+} // namespace cocoa
+#endif //COCOA_CORE_BUMPARENA_H
@@ -15,73 +15,599 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTEARRAY_CODECS_X86_SIMD
+#endif
+
 #include "Core/ByteArrayCodecs.h"
+#include "Core/CpuDispatch.h"
 #include "Core/Data.h"
 COCOA_BEGIN_NAMESPACE
 
 namespace {
 
-const uint32_t base64_decode_tbl[256] = {
-     0,  0,  0,  0,  0,  0,  0,  0,
-     0,  0,  0,  0,  0,  0,  0,  0,
-     0,  0,  0,  0,  0,  0,  0,  0,
-     0,  0,  0,  0,  0,  0,  0,  0,
-     0,  0,  0,  0,  0,  0,  0,  0,
-     0,  0,  0, 62, 63, 62, 62, 63,
-    52, 53, 54, 55, 56, 57, 58, 59,
-    60, 61,  0,  0,  0,  0,  0,  0,
-     0,  0,  1,  2,  3,  4,  5,  6,
-     7,  8,  9, 10, 11, 12, 13, 14,
-    15, 16, 17, 18, 19, 20, 21, 22,
-    23, 24, 25,  0,  0,  0,  0, 63,
-     0, 26, 27, 28, 29, 30, 31, 32,
-    33, 34, 35, 36, 37, 38, 39, 40,
-    41, 42, 43, 44, 45, 46, 47, 48,
-    49, 50, 51,  0,  0,  0,  0,  0
-    /* Remaining space is filled by zero */
-};
+constexpr uint8_t kInvalid = 0xff;
+
+const char base64_encode_tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char hex_encode_tbl[] = "0123456789abcdef";
+
+constexpr std::array<uint8_t, 256> make_base64_decode_table(bool url_safe)
+{
+    std::array<uint8_t, 256> table{};
+    for (uint8_t& v : table)
+        v = kInvalid;
+    for (int i = 0; i < 64; i++)
+        table[static_cast<uint8_t>(base64_encode_tbl[i])] = i;
+    if (url_safe)
+    {
+        table['-'] = 62;
+        table['_'] = 63;
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> make_hex_decode_table()
+{
+    std::array<uint8_t, 256> table{};
+    for (uint8_t& v : table)
+        v = kInvalid;
+    for (int i = 0; i < 10; i++)
+        table['0' + i] = i;
+    for (int i = 0; i < 6; i++)
+    {
+        table['a' + i] = 10 + i;
+        table['A' + i] = 10 + i;
+    }
+    return table;
+}
+
+constexpr auto base64_strict_decode_tbl = make_base64_decode_table(false);
+constexpr auto base64_lenient_decode_tbl = make_base64_decode_table(true);
+constexpr auto hex_decode_tbl = make_hex_decode_table();
+
+/**
+ * SIMD kernels only process whole blocks. They return the number of
+ * consumed input bytes, and the remaining part (which starts at the boundary
+ * of a base64 quantum or a hex digit pair) is handled by the scalar code.
+ * Decoding kernels stop at the first block containing any character
+ * outside the standard alphabet, leaving it to the scalar code which
+ * handles the paddings, skipping and errors.
+ */
+using EncodeKernel = size_t(const uint8_t *src, size_t size, char *out);
+using DecodeKernel = size_t(const char *src, size_t length, uint8_t *out);
+
+size_t no_blocks(const uint8_t *, size_t, char *) { return 0; }
+size_t no_blocks(const char *, size_t, uint8_t *) { return 0; }
+
+#if defined(BYTEARRAY_CODECS_X86_SIMD)
+
+// Base64 kernels are adapted from:
+// Wojciech Muła, Daniel Lemire. Faster Base64 Encoding and Decoding
+// Using AVX2 Instructions. ACM Transactions on the Web, 2018, 12(3).
+
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2  __attribute__((target("avx2")))
+
+TARGET_SSSE3 g_inline __m128i base64_encode_block_ssse3(__m128i in)
+{
+    // Each 32-bit lane holds 3 input bytes [b1 b0 b2 b1]
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // Spread the four 6-bit indices into separate bytes
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    // Translate indices to ASCII by adding an offset for the range they belong to
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    result = _mm_shuffle_epi8(shift_lut, result);
+    return _mm_add_epi8(result, indices);
+}
+
+TARGET_SSSE3 size_t base64_encode_ssse3(const uint8_t *src, size_t size, char *out)
+{
+    size_t i = 0;
+    // 16 bytes are loaded but only 12 of them are encoded
+    for (; i + 16 <= size; i += 12)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), base64_encode_block_ssse3(in));
+        out += 16;
+    }
+    return i;
+}
+
+/**
+ * Translate ASCII to 6-bit values in place.
+ * Returns false if any character is outside the standard alphabet.
+ */
+TARGET_SSSE3 g_inline bool base64_translate_ssse3(__m128i& in)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+    __m128i lo_nibbles = _mm_and_si128(in, mask_2f);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    if (_mm_movemask_epi8(invalid) != 0xffff)
+        return false;
+
+    __m128i eq_2f = _mm_cmpeq_epi8(in, mask_2f);
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    in = _mm_add_epi8(in, roll);
+    return true;
+}
+
+TARGET_SSSE3 g_inline __m128i base64_pack_ssse3(__m128i values)
+{
+    // Merge 6-bit values into 24-bit groups, then gather 12 bytes at the front
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                                  -1, -1, -1, -1));
+}
+
+TARGET_SSSE3 size_t base64_decode_ssse3(const char *src, size_t length, uint8_t *out)
+{
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (!base64_translate_ssse3(in))
+            break;
+        __m128i packed = base64_pack_ssse3(in);
+
+        // Store exactly 12 bytes as `out` may not have more space
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+        auto tail = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+        std::memcpy(out + 8, &tail, sizeof(tail));
+        out += 12;
+    }
+    return i;
+}
+
+/**
+ * Translate hex digits to 4-bit values in place.
+ * Returns false if any character is not a hex digit.
+ */
+TARGET_SSSE3 g_inline bool hex_translate_ssse3(__m128i& in)
+{
+    // Unsigned comparison `x <= n` is `min(x, n) == x`
+    __m128i digits = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    __m128i letters = _mm_sub_epi8(_mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff)
+        return false;
+
+    letters = _mm_add_epi8(letters, _mm_set1_epi8(10));
+    in = _mm_or_si128(_mm_and_si128(is_digit, digits), _mm_and_si128(is_letter, letters));
+    return true;
+}
+
+TARGET_SSSE3 size_t hex_encode_ssse3(const uint8_t *src, size_t size, char *out)
+{
+    const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_encode_tbl));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(hi, lo));
+        out += 32;
+    }
+    return i;
+}
+
+TARGET_SSSE3 size_t hex_decode_ssse3(const char *src, size_t length, uint8_t *out)
+{
+    // Multiply the high nibbles by 16 and add the low nibbles
+    const __m128i weights = _mm_set1_epi16(0x0110);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        if (!hex_translate_ssse3(in0) || !hex_translate_ssse3(in1))
+            break;
+        __m128i v0 = _mm_maddubs_epi16(in0, weights);
+        __m128i v1 = _mm_maddubs_epi16(in1, weights);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v0, v1));
+        out += 16;
+    }
+    return i;
+}
+
+TARGET_AVX2 size_t base64_encode_avx2(const uint8_t *src, size_t size, char *out)
+{
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shift_lut = _mm256_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t i = 0;
+    // Each 128-bit lane loads 16 bytes and encodes 12 of them
+    for (; i + 28 <= size; i += 24)
+    {
+        __m256i in = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, shuffle);
+
+        __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), result);
+        out += 32;
+    }
+    return i + base64_encode_ssse3(src + i, size - i, out);
+}
+
+TARGET_AVX2 size_t base64_decode_avx2(const char *src, size_t length, uint8_t *out)
+{
+    const __m256i lut_lo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lut_hi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    const __m256i pack_shuffle = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(in, mask_2f));
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+
+        __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+        in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles)));
+
+        __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, pack_shuffle);
+        // Move 12 bytes of each lane together
+        merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(merged));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm256_extracti128_si256(merged, 1));
+        out += 24;
+    }
+    return i + base64_decode_ssse3(src + i, length - i, out);
+}
+
+TARGET_AVX2 size_t hex_encode_avx2(const uint8_t *src, size_t size, char *out)
+{
+    const __m256i lut = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_encode_tbl)));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(in, mask));
+        // Unpacking works in each lane: [0, 8) + [16, 24) and [8, 16) + [24, 32)
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_permute2x128_si256(a, b, 0x31));
+        out += 64;
+    }
+    return i + hex_encode_ssse3(src + i, size - i, out);
+}
+
+TARGET_AVX2 g_inline bool hex_translate_avx2(__m256i& in)
+{
+    __m256i digits = _mm256_sub_epi8(in, _mm256_set1_epi8('0'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+    __m256i letters = _mm256_sub_epi8(_mm256_or_si256(in, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+    if (~_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != 0)
+        return false;
+
+    letters = _mm256_add_epi8(letters, _mm256_set1_epi8(10));
+    in = _mm256_blendv_epi8(letters, digits, is_digit);
+    return true;
+}
+
+TARGET_AVX2 size_t hex_decode_avx2(const char *src, size_t length, uint8_t *out)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+        if (!hex_translate_avx2(in0) || !hex_translate_avx2(in1))
+            break;
+        __m256i v = _mm256_packus_epi16(_mm256_maddubs_epi16(in0, weights),
+                                        _mm256_maddubs_epi16(in1, weights));
+        // Packing works in each lane, so 64-bit groups are in order 0, 2, 1, 3
+        v = _mm256_permute4x64_epi64(v, 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+        out += 32;
+    }
+    return i + hex_decode_ssse3(src + i, length - i, out);
+}
+
+#undef TARGET_SSSE3
+#undef TARGET_AVX2
+
+#endif // BYTEARRAY_CODECS_X86_SIMD
+
+// SSSE3 kernels are used by the SSE4.2 tier
+#if defined(BYTEARRAY_CODECS_X86_SIMD)
+#define KERNELS(scalar, ssse3, avx2) { scalar, ssse3, avx2, nullptr }
+#else
+#define KERNELS(scalar, ssse3, avx2) { scalar, nullptr, nullptr, nullptr }
+#endif
+
+CpuDispatchedFunction<EncodeKernel> g_base64_encode_kernel(
+        "ByteArrayCodecs::Base64Encode", KERNELS(no_blocks, base64_encode_ssse3, base64_encode_avx2));
+CpuDispatchedFunction<DecodeKernel> g_base64_decode_kernel(
+        "ByteArrayCodecs::Base64Decode", KERNELS(no_blocks, base64_decode_ssse3, base64_decode_avx2));
+CpuDispatchedFunction<EncodeKernel> g_hex_encode_kernel(
+        "ByteArrayCodecs::HexEncode", KERNELS(no_blocks, hex_encode_ssse3, hex_encode_avx2));
+CpuDispatchedFunction<DecodeKernel> g_hex_decode_kernel(
+        "ByteArrayCodecs::HexDecode", KERNELS(no_blocks, hex_decode_ssse3, hex_decode_avx2));
+
+#undef KERNELS
+
+std::shared_ptr<Data> adopt_as_data(std::unique_ptr<uint8_t[]> buffer, size_t size)
+{
+    auto deleter = buffer.get_deleter();
+    return Data::MakeFromExternal(buffer.release(), size, [deleter](void *p) {
+        deleter(reinterpret_cast<uint8_t*>(p));
+    });
+}
 
 } // namespace anonymous
 
-std::shared_ptr<Data> ByteArrayCodecs::DecodeBase64(const char *str, size_t len)
+size_t ByteArrayCodecs::GetBase64EncodedLength(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+size_t ByteArrayCodecs::GetBase64DecodedMaxLength(size_t length)
+{
+    return (length + 3) / 4 * 3;
+}
+
+void ByteArrayCodecs::EncodeBase64(const uint8_t *data, size_t size, char *out)
+{
+    size_t i = g_base64_encode_kernel(data, size, out);
+    out += i / 3 * 4;
+
+    const char *T = base64_encode_tbl;
+    for (; i + 3 <= size; i += 3)
+    {
+        uint32_t n = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        *out++ = T[(n >> 18) & 0x3f];
+        *out++ = T[(n >> 12) & 0x3f];
+        *out++ = T[(n >> 6) & 0x3f];
+        *out++ = T[n & 0x3f];
+    }
+
+    if (i < size)
+    {
+        uint32_t n = data[i] << 16;
+        if (i + 1 < size)
+            n |= data[i + 1] << 8;
+        *out++ = T[(n >> 18) & 0x3f];
+        *out++ = T[(n >> 12) & 0x3f];
+        *out++ = (i + 1 < size) ? T[(n >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+}
+
+std::string ByteArrayCodecs::EncodeBase64(const uint8_t *data, size_t size)
+{
+    std::string result(GetBase64EncodedLength(size), '\0');
+    EncodeBase64(data, size, result.data());
+    return result;
+}
+
+ssize_t ByteArrayCodecs::DecodeBase64(const char *str, size_t length, uint8_t *out, DecodeMode mode)
+{
+    size_t i = g_base64_decode_kernel(str, length, out);
+    uint8_t *ptr = out + i / 4 * 3;
+
+    bool strict = (mode == DecodeMode::kStrict);
+    const uint8_t *T = strict ? base64_strict_decode_tbl.data()
+                              : base64_lenient_decode_tbl.data();
+
+    uint32_t n = 0;
+    int count = 0;
+    for (; i < length; i++)
+    {
+        uint8_t v = T[static_cast<uint8_t>(str[i])];
+        if (v != kInvalid)
+        {
+            n = (n << 6) | v;
+            if (++count == 4)
+            {
+                *ptr++ = static_cast<uint8_t>(n >> 16);
+                *ptr++ = static_cast<uint8_t>(n >> 8);
+                *ptr++ = static_cast<uint8_t>(n);
+                n = 0;
+                count = 0;
+            }
+        }
+        else if (str[i] == '=')
+            break;
+        else if (strict)
+            return -1;
+    }
+
+    if (strict)
+    {
+        // Quantum must be completed by paddings exactly, and the unused
+        // bits must be zero (canonical encoding).
+        size_t paddings = length - i;
+        if (count == 1 || (count == 0 && paddings > 0))
+            return -1;
+        if (count > 1)
+        {
+            if (paddings != static_cast<size_t>(4 - count))
+                return -1;
+            for (; i < length; i++)
+            {
+                if (str[i] != '=')
+                    return -1;
+            }
+            if ((count == 2 && (n & 0xf)) || (count == 3 && (n & 0x3)))
+                return -1;
+        }
+    }
+
+    if (count == 2)
+    {
+        *ptr++ = static_cast<uint8_t>(n >> 4);
+    }
+    else if (count == 3)
+    {
+        *ptr++ = static_cast<uint8_t>(n >> 10);
+        *ptr++ = static_cast<uint8_t>(n >> 2);
+    }
+
+    return ptr - out;
+}
+
+std::shared_ptr<Data> ByteArrayCodecs::DecodeBase64(const char *str, size_t len, DecodeMode mode)
 {
     if (len == 0)
         return nullptr;
 
-    // At least one padding is required
-    int padding = len % 4 != 0 || str[len - 1] == '=';
-
-    const size_t L = ((len + 3) / 4 - padding) * 4;
-    size_t out_len = L / 4 * 3 + padding;
+    auto buffer = std::make_unique<uint8_t[]>(GetBase64DecodedMaxLength(len));
+    ssize_t out_len = DecodeBase64(str, len, buffer.get(), mode);
+    if (out_len <= 0)
+        return nullptr;
 
-    auto buffer = std::make_unique<uint8_t[]>(out_len + 1);
+    return adopt_as_data(std::move(buffer), out_len);
+}
 
-    constexpr const uint32_t *T = base64_decode_tbl;
-#define S(x) static_cast<uint8_t>(str[x])
-    for (size_t i = 0, j = 0; i < L; i += 4)
+void ByteArrayCodecs::EncodeHex(const uint8_t *data, size_t size, char *out)
+{
+    size_t i = g_hex_encode_kernel(data, size, out);
+    out += i * 2;
+    for (; i < size; i++)
     {
-        uint32_t n = (T[S(i)] << 18) | (T[S(i + 1)] << 12) | (T[S(i + 2)] << 6) | T[S(i + 3)];
-        buffer[j++] = static_cast<uint8_t>(n >> 16);
-        buffer[j++] = static_cast<uint8_t>((n >> 8) & 0xff);
-        buffer[j++] = static_cast<uint8_t>(n & 0xff);
+        *out++ = hex_encode_tbl[data[i] >> 4];
+        *out++ = hex_encode_tbl[data[i] & 0xf];
     }
-    if (padding)
+}
+
+std::string ByteArrayCodecs::EncodeHex(const uint8_t *data, size_t size)
+{
+    std::string result(size * 2, '\0');
+    EncodeHex(data, size, result.data());
+    return result;
+}
+
+ssize_t ByteArrayCodecs::DecodeHex(const char *str, size_t length, uint8_t *out, DecodeMode mode)
+{
+    bool strict = (mode == DecodeMode::kStrict);
+    if (strict && (length & 1))
+        return -1;
+
+    size_t i = g_hex_decode_kernel(str, length, out);
+    uint8_t *ptr = out + i / 2;
+
+    int pending = -1;
+    for (; i < length; i++)
     {
-        uint32_t n = (T[S(L)] << 18) | (T[S(L + 1)] << 12);
-        buffer[out_len - 1] = static_cast<uint8_t>(n >> 16);
-        if (len > L + 2 && str[L + 2] != '=')
+        uint8_t v = hex_decode_tbl[static_cast<uint8_t>(str[i])];
+        if (v == kInvalid)
+        {
+            if (strict)
+                return -1;
+            continue;
+        }
+
+        if (pending < 0)
         {
-            n |= T[S(L + 2)] << 6;
-            buffer[out_len] = static_cast<uint8_t>((n >> 8) & 0xff);
-            out_len++;
+            pending = v;
+        }
+        else
+        {
+            *ptr++ = static_cast<uint8_t>((pending << 4) | v);
+            pending = -1;
         }
     }
-#undef S
 
-    auto deleter = buffer.get_deleter();
-    return Data::MakeFromExternal(buffer.release(), out_len, [deleter](void *p) {
-        deleter(reinterpret_cast<uint8_t*>(p));
-    });
+    return ptr - out;
+}
+
+std::shared_ptr<Data> ByteArrayCodecs::DecodeHex(const char *str, size_t length, DecodeMode mode)
+{
+    if (length < 2)
+        return nullptr;
+
+    auto buffer = std::make_unique<uint8_t[]>(length / 2);
+    ssize_t out_len = DecodeHex(str, length, buffer.get(), mode);
+    if (out_len <= 0)
+        return nullptr;
+
+    return adopt_as_data(std::move(buffer), out_len);
+}
+
+const char *ByteArrayCodecs::GetImplementationName()
+{
+    switch (g_base64_encode_kernel.resolve())
+    {
+    case CpuInfo::Tier::kBaseline:
+        return "scalar";
+    case CpuInfo::Tier::kSSE4_2:
+        return "ssse3";
+    default:
+        return "avx2";
+    }
 }
 
 COCOA_END_NAMESPACE
@@ -19,6 +19,9 @@
 #define COCOA_CORE_BYTEARRAYCODECS_H
 
 #include <memory>
+#include <string>
+
+#include <sys/types.h>
 
 #include "Core/Project.h"
 COCOA_BEGIN_NAMESPACE
@@ -28,7 +31,50 @@ class Data;
 class ByteArrayCodecs
 {
 public:
-    static std::shared_ptr<Data> DecodeBase64(const char *str, size_t length);
+    enum class DecodeMode
+    {
+        // Reject characters outside the standard alphabet, missing or misplaced
+        // paddings and nonzero trailing bits (base64), or odd length (hex).
+        kStrict,
+
+        // Skip characters outside the alphabet (whitespaces, line breaks, etc.),
+        // accept URL-safe base64 alphabet, missing paddings and a dangling
+        // character at the end (which is discarded).
+        kLenient
+    };
+
+    static size_t GetBase64EncodedLength(size_t size);
+    static size_t GetBase64DecodedMaxLength(size_t length);
+
+    // `out` should have `GetBase64EncodedLength(size)` bytes at least
+    static void EncodeBase64(const uint8_t *data, size_t size, char *out);
+    static std::string EncodeBase64(const uint8_t *data, size_t size);
+
+    /**
+     * Decode into `out` which has `GetBase64DecodedMaxLength(length)` bytes at least.
+     * Returns the number of decoded bytes, or -1 if `str` is rejected in `mode`.
+     */
+    static ssize_t DecodeBase64(const char *str, size_t length, uint8_t *out, DecodeMode mode);
+
+    // Returns nullptr if `str` is rejected or nothing is decoded
+    static std::shared_ptr<Data> DecodeBase64(const char *str, size_t length,
+                                              DecodeMode mode = DecodeMode::kLenient);
+
+    // `out` should have `size * 2` bytes at least. Digits are in lower case.
+    static void EncodeHex(const uint8_t *data, size_t size, char *out);
+    static std::string EncodeHex(const uint8_t *data, size_t size);
+
+    // `out` should have `length / 2` bytes at least
+    static ssize_t DecodeHex(const char *str, size_t length, uint8_t *out, DecodeMode mode);
+    static std::shared_ptr<Data> DecodeHex(const char *str, size_t length,
+                                           DecodeMode mode = DecodeMode::kStrict);
+
+    /**
+     * SIMD kernels are dispatched by the tier reported by `CpuInfo`
+     * (see `Core/CpuDispatch.h`). SSSE3 kernels are used by the SSE4.2 tier.
+     * Returns "avx2", "ssse3" or "scalar".
+     */
+    static const char *GetImplementationName();
 };
 
 COCOA_END_NAMESPACE
@@ -45,11 +45,25 @@ const Template g_templates[] = {
             .long_name = "disable-log-decoration",
             .desc = "Do NOT write logs with colors in ANSI escape code."
         },
+        {
+            .long_name = "log-async",
+            .has_value = Template::RequireValue::kOptional,
+            .value_type = ValueType::kString,
+            .desc = "Format and write logs in a background thread;\n"
+                    "values: drop,block (what to do when the buffer is full)."
+        },
         {
             .long_name = "initialize-only",
             .desc = "Exit immediately after finishing all the\n"
                     "initialization steps (not running script)"
         },
+        {
+            .long_name = "cpu-tier",
+            .has_value = Template::RequireValue::kNecessary,
+            .value_type = ValueType::kString,
+            .desc = "Force the instruction set used by dispatched kernels for testing;\n"
+                    "values: baseline,sse4.2,avx2,avx512 (clamped to what CPU supports)."
+        },
         {
             .long_name = "disable-traceback-symbol-folding",
             .desc = "Disable symbols folding of traceback information\n"
@@ -207,6 +221,54 @@ const Template g_templates[] = {
             .desc = "Limit the maximum number of samples recorded by \n"
                     "the internal graphics profiler (32 by default)."
         },
+        {
+            .long_name = "gl-dynamic-resolution",
+            .has_value = Template::RequireValue::kEmpty,
+            .desc = "Render at a reduced internal resolution and upscale the\n"
+                    "frames when the raster backend cannot keep up with the\n"
+                    "frame budget."
+        },
+        {
+            .long_name = "gl-dynamic-resolution-min-scale",
+            .has_value = Template::RequireValue::kNecessary,
+            .value_type = ValueType::kFloat,
+            .desc = "Minimum internal resolution scale of dynamic resolution,\n"
+                    "in (0, 1] (0.5 by default)."
+        },
+        {
+            .long_name = "gl-dynamic-resolution-budget",
+            .has_value = Template::RequireValue::kNecessary,
+            .value_type = ValueType::kFloat,
+            .desc = "Frame time budget in milliseconds for dynamic resolution\n"
+                    "(16.6 by default)."
+        },
+        {
+            .long_name = "gl-pointer-resampling",
+            .has_value = Template::RequireValue::kEmpty,
+            .desc = "Report the pointer position resampled at the frame time\n"
+                    "instead of the latest motion event to reduce jitter."
+        },
+        {
+            .long_name = "gl-frame-pacing",
+            .has_value = Template::RequireValue::kEmpty,
+            .desc = "Delay the frame signal to the latest safe start time\n"
+                    "predicted from recent frames to reduce the latency."
+        },
+        {
+            .long_name = "gl-filter-cache-budget",
+            .has_value = Template::RequireValue::kNecessary,
+            .value_type = ValueType::kInteger,
+            .desc = "Memory budget in MiB for caching the results of image\n"
+                    "filters and backdrop filters (32 by default, 0 to disable)."
+        },
+        {
+            .long_name = "gl-memory-budget",
+            .has_value = Template::RequireValue::kNecessary,
+            .value_type = ValueType::kInteger,
+            .desc = "Memory budget in MiB for all the purgeable graphics caches\n"
+                    "(0 by default, which means caches are only purged under\n"
+                    "memory pressure reported by the system)."
+        },
         {
             .long_name = "gl-hwcompose-disable-presentation",
             .has_value = Template::RequireValue::kEmpty,
@@ -0,0 +1,108 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+#include <algorithm>
+
+#include "Core/CpuDispatch.h"
+#include "Core/Journal.h"
+
+#define THIS_FILE_MODULE COCOA_MODULE_NAME(Core.CpuDispatch)
+
+namespace cocoa {
+
+namespace {
+
+struct RegistryStorage
+{
+    std::mutex lock;
+    std::vector<CpuDispatchedFunctionBase*> functions;
+};
+
+// Dispatched functions are usually constructed during static initialization,
+// so the storage must be initialized on first use.
+RegistryStorage& get_registry_storage()
+{
+    static RegistryStorage storage;
+    return storage;
+}
+
+} // namespace anonymous
+
+CpuDispatchedFunctionBase::CpuDispatchedFunctionBase(const char *name)
+    : name_(name)
+{
+    CpuDispatchRegistry::Register(this);
+}
+
+CpuDispatchedFunctionBase::~CpuDispatchedFunctionBase()
+{
+    CpuDispatchRegistry::Unregister(this);
+}
+
+CpuDispatchedFunctionBase::Tier CpuDispatchedFunctionBase::selectTier(uint32_t available) const
+{
+    // Dispatched functions may be called before `CpuInfo` is created
+    // (static initialization, for example), and only baseline is safe then.
+    auto tier = static_cast<int>(Tier::kBaseline);
+    if (CpuInfo::HasInstance())
+        tier = static_cast<int>(CpuInfo::Ref().getTier());
+
+    while (tier > 0 && !(available & (1U << tier)))
+        tier--;
+    return static_cast<Tier>(tier);
+}
+
+void CpuDispatchRegistry::Register(CpuDispatchedFunctionBase *function)
+{
+    RegistryStorage& storage = get_registry_storage();
+    std::scoped_lock<std::mutex> lock(storage.lock);
+    storage.functions.push_back(function);
+}
+
+void CpuDispatchRegistry::Unregister(CpuDispatchedFunctionBase *function)
+{
+    RegistryStorage& storage = get_registry_storage();
+    std::scoped_lock<std::mutex> lock(storage.lock);
+    auto itr = std::find(storage.functions.begin(), storage.functions.end(), function);
+    if (itr != storage.functions.end())
+        storage.functions.erase(itr);
+}
+
+std::vector<CpuDispatchRegistry::Entry> CpuDispatchRegistry::ResolveAll()
+{
+    RegistryStorage& storage = get_registry_storage();
+    std::scoped_lock<std::mutex> lock(storage.lock);
+
+    if (CpuInfo::HasInstance())
+    {
+        QLOG(LOG_DEBUG, "Dispatching functions for CPU tier {} (supported: {})",
+             CpuInfo::TierToString(CpuInfo::Ref().getTier()),
+             CpuInfo::TierToString(CpuInfo::Ref().getSupportedTier()));
+    }
+
+    std::vector<Entry> entries;
+    for (CpuDispatchedFunctionBase *function : storage.functions)
+    {
+        entries.emplace_back(Entry{function->getName(), function->resolve()});
+        QLOG(LOG_DEBUG, "  %fg<hl>{}%reset -> {}", entries.back().name,
+             CpuInfo::TierToString(entries.back().tier));
+    }
+    return entries;
+}
+
+} // namespace cocoa
@@ -0,0 +1,180 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COCOA_CORE_CPUDISPATCH_H
+#define COCOA_CORE_CPUDISPATCH_H
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <string>
+
+#include "Core/Project.h"
+#include "Core/CpuInfo.h"
+
+namespace cocoa {
+
+/**
+ * Function multiversioning for hot kernels.
+ *
+ * A kernel body is written once as an always-inlined function, and
+ * `CPU_DISPATCH_DEFINE_VARIANTS` compiles it for each tier by inlining
+ * it into wrappers with different target attributes, so the compiler
+ * vectorizes the same code for different instruction sets:
+ *
+ *   CPU_DISPATCH_INLINE void scale_body(float *p, size_t n, float s) {
+ *       for (size_t i = 0; i < n; i++) p[i] *= s;
+ *   }
+ *   CPU_DISPATCH_DEFINE_VARIANTS(scale, void, (float *p, size_t n, float s), (p, n, s))
+ *
+ *   CpuDispatchedFunction<void(float*, size_t, float)> g_scale(
+ *           "Scale", CPU_DISPATCH_VARIANTS_LIST(scale));
+ *
+ * The variant is resolved when the function is called for the first time
+ * (or by `CpuDispatchRegistry::ResolveAll()`) from `CpuInfo::getTier()`.
+ * Hand-written variants are also accepted, and a nullptr variant falls back
+ * to the nearest lower tier.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_DISPATCH_TARGET_SSE4_2  __attribute__((target("sse4.2,popcnt")))
+#define CPU_DISPATCH_TARGET_AVX2    __attribute__((target("avx2,fma,bmi,bmi2,f16c,popcnt")))
+#define CPU_DISPATCH_TARGET_AVX512  \
+    __attribute__((target("avx512f,avx512bw,avx512cd,avx512dq,avx512vl,avx2,fma,bmi,bmi2,f16c,popcnt")))
+#else
+#define CPU_DISPATCH_TARGET_SSE4_2
+#define CPU_DISPATCH_TARGET_AVX2
+#define CPU_DISPATCH_TARGET_AVX512
+#endif
+
+#define CPU_DISPATCH_INLINE __attribute__((always_inline)) inline
+
+#define CPU_DISPATCH_DEFINE_VARIANTS(name, ret, params, args)                  \
+    ret name##_baseline params { return name##_body args; }                    \
+    CPU_DISPATCH_TARGET_SSE4_2 ret name##_sse4_2 params { return name##_body args; } \
+    CPU_DISPATCH_TARGET_AVX2 ret name##_avx2 params { return name##_body args; }     \
+    CPU_DISPATCH_TARGET_AVX512 ret name##_avx512 params { return name##_body args; }
+
+#define CPU_DISPATCH_VARIANTS_LIST(name) \
+    { name##_baseline, name##_sse4_2, name##_avx2, name##_avx512 }
+
+class CpuDispatchedFunctionBase
+{
+public:
+    using Tier = CpuInfo::Tier;
+
+    explicit CpuDispatchedFunctionBase(const char *name);
+    virtual ~CpuDispatchedFunctionBase();
+
+    g_nodiscard g_inline const char *getName() const {
+        return name_;
+    }
+
+    // Resolve the function if it has not been resolved yet
+    virtual Tier resolve() const = 0;
+
+protected:
+    /**
+     * Select the highest available tier which is not higher than the tier
+     * reported by `CpuInfo`. `available` has a bit set for each tier
+     * which has a variant.
+     */
+    Tier selectTier(uint32_t available) const;
+
+private:
+    const char *name_;
+};
+
+template<typename T>
+class CpuDispatchedFunction;
+
+template<typename R, typename...Args>
+class CpuDispatchedFunction<R(Args...)> : public CpuDispatchedFunctionBase
+{
+public:
+    using Pointer = R(*)(Args...);
+    using Variants = std::array<Pointer, CpuInfo::kTiersCount>;
+
+    CpuDispatchedFunction(const char *name, const Variants& variants)
+        : CpuDispatchedFunctionBase(name)
+        , variants_(variants)
+        , selected_(nullptr)
+        , selected_tier_(Tier::kBaseline) {
+        CHECK(variants_[0] && "Baseline variant is required");
+    }
+
+    ~CpuDispatchedFunction() override = default;
+
+    g_inline R operator()(Args...args) const {
+        Pointer func = selected_.load(std::memory_order_acquire);
+        if (!func)
+        {
+            resolve();
+            func = selected_.load(std::memory_order_acquire);
+        }
+        return func(std::forward<Args>(args)...);
+    }
+
+    Tier resolve() const override {
+        if (selected_.load(std::memory_order_acquire))
+            return selected_tier_.load(std::memory_order_relaxed);
+
+        uint32_t available = 0;
+        for (int i = 0; i < CpuInfo::kTiersCount; i++)
+        {
+            if (variants_[i])
+                available |= 1U << i;
+        }
+
+        // Racing resolutions always select the same variant
+        Tier tier = selectTier(available);
+        selected_tier_.store(tier, std::memory_order_relaxed);
+        selected_.store(variants_[static_cast<int>(tier)], std::memory_order_release);
+        return tier;
+    }
+
+private:
+    Variants                    variants_;
+    mutable std::atomic<Pointer> selected_;
+    mutable std::atomic<Tier>   selected_tier_;
+};
+
+class CpuDispatchRegistry
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        CpuInfo::Tier tier;
+    };
+
+    // Dispatched functions register themselves on construction
+    static void Register(CpuDispatchedFunctionBase *function);
+    static void Unregister(CpuDispatchedFunctionBase *function);
+
+    /**
+     * Resolve all the registered functions and report the active variants,
+     * which are also written into the journal (debug level).
+     * Called after the command line is parsed so that the tier override
+     * is respected. Journal must have been initialized.
+     */
+    static std::vector<Entry> ResolveAll();
+};
+
+} // namespace cocoa
+
+#endif //COCOA_CORE_CPUDISPATCH_H
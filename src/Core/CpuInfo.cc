@@ -15,13 +15,120 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstdlib>
+
+#include "fmt/format.h"
+
 #include "Core/CpuInfo.h"
 
 namespace cocoa {
 
+namespace {
+
+struct TierDescriptor
+{
+    CpuInfo::Tier tier;
+    const char *name;
+    Bitfield<CpuInfo::Feature> required;
+};
+
+using F = CpuInfo::Feature;
+
+// Required features match the target attributes in `Core/CpuDispatch.h`
+const TierDescriptor g_tier_descriptors[] = {
+    { CpuInfo::Tier::kBaseline, "baseline", {} },
+    { CpuInfo::Tier::kSSE4_2, "sse4.2", { F::kSSSE3, F::kSSE4_1, F::kSSE4_2, F::kPOPCNT } },
+    { CpuInfo::Tier::kAVX2, "avx2", { F::kSSSE3, F::kSSE4_1, F::kSSE4_2, F::kPOPCNT, F::kAVX,
+                                      F::kAVX2, F::kFMA, F::kBMI, F::kBMI2, F::kF16C } },
+    { CpuInfo::Tier::kAVX512, "avx512", { F::kSSSE3, F::kSSE4_1, F::kSSE4_2, F::kPOPCNT, F::kAVX,
+                                          F::kAVX2, F::kFMA, F::kBMI, F::kBMI2, F::kF16C,
+                                          F::kAVX512F, F::kAVX512BW, F::kAVX512CD,
+                                          F::kAVX512DQ, F::kAVX512VL } }
+};
+
+} // namespace anonymous
+
+const char *CpuInfo::TierToString(Tier tier)
+{
+    return g_tier_descriptors[static_cast<int>(tier)].name;
+}
+
+std::optional<CpuInfo::Tier> CpuInfo::ParseTier(std::string_view str)
+{
+    for (const TierDescriptor& desc : g_tier_descriptors)
+    {
+        if (str == desc.name)
+            return desc.tier;
+    }
+    return {};
+}
+
 CpuInfo::CpuInfo()
-    : fInfo(cpu_features::GetX86Info())
+    : fSupportedTier(Tier::kBaseline)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    // The compiler builtins query CPUID and also check whether
+    // the OS has enabled the extended register states (XGETBV).
+    __builtin_cpu_init();
+
+#define F(name, feature) \
+    if (__builtin_cpu_supports(name)) fFeatures |= Feature::feature;
+
+    F("sse2", kSSE2)
+    F("ssse3", kSSSE3)
+    F("sse4.1", kSSE4_1)
+    F("sse4.2", kSSE4_2)
+    F("avx", kAVX)
+    F("avx2", kAVX2)
+    F("bmi2", kBMI2)
+    F("avx512f", kAVX512F)
+    F("avx512bw", kAVX512BW)
+    F("avx512vl", kAVX512VL)
+    F("popcnt", kPOPCNT)
+    F("fma", kFMA)
+    F("bmi", kBMI)
+    F("f16c", kF16C)
+    F("avx512cd", kAVX512CD)
+    F("avx512dq", kAVX512DQ)
+
+#undef F
+#endif
+
+    for (const TierDescriptor& desc : g_tier_descriptors)
+    {
+        bool supported = true;
+        for (uint32_t bit = 1; bit != 0; bit <<= 1)
+        {
+            auto feature = static_cast<Feature>(bit);
+            if ((desc.required & feature) && !(fFeatures & feature))
+                supported = false;
+        }
+        if (supported)
+            fSupportedTier = desc.tier;
+    }
+
+    // Journal is not available yet when `CpuInfo` is created
+    if (const char *env = ::getenv(ENV_CPU_DISPATCH_TIER); env && *env)
+    {
+        fTierOverride = ParseTier(env);
+        if (!fTierOverride)
+        {
+            fmt::print(stderr, "Warning: Ignored invalid value of environment variable ${}: {}\n",
+                       ENV_CPU_DISPATCH_TIER, env);
+        }
+    }
+}
+
+CpuInfo::Tier CpuInfo::getTier() const
+{
+    if (fTierOverride && *fTierOverride < fSupportedTier)
+        return *fTierOverride;
+    return fSupportedTier;
+}
+
+void CpuInfo::setTierOverride(Tier tier)
 {
+    fTierOverride = tier;
 }
 
 }
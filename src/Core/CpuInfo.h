@@ -18,24 +18,86 @@
 #ifndef COCOA_CORE_CPUINFO_H
 #define COCOA_CORE_CPUINFO_H
 
+#include <string_view>
+#include <optional>
+
 #include "Core/Project.h"
 #include "Core/UniquePersistent.h"
-#include "include/cpuinfo_x86.h"
+#include "Core/EnumClassBitfield.h"
 
 namespace cocoa {
 
 class CpuInfo : public UniquePersistent<CpuInfo>
 {
 public:
+    enum class Feature : uint32_t
+    {
+        kSSE2       = 1 << 0,
+        kSSSE3      = 1 << 1,
+        kSSE4_1     = 1 << 2,
+        kSSE4_2     = 1 << 3,
+        kAVX        = 1 << 4,
+        kAVX2       = 1 << 5,
+        kBMI2       = 1 << 6,
+        kAVX512F    = 1 << 7,
+        kAVX512BW   = 1 << 8,
+        kAVX512VL   = 1 << 9,
+        kPOPCNT     = 1 << 10,
+        kFMA        = 1 << 11,
+        kBMI        = 1 << 12,
+        kF16C       = 1 << 13,
+        kAVX512CD   = 1 << 14,
+        kAVX512DQ   = 1 << 15
+    };
+
+    /**
+     * Instruction set levels that the hot kernels are compiled for
+     * (see `Core/CpuDispatch.h`). Each tier contains all the lower tiers.
+     */
+    enum class Tier : uint8_t
+    {
+        kBaseline = 0,
+        kSSE4_2,
+        kAVX2,
+        kAVX512,
+
+        kLast = kAVX512
+    };
+
+    constexpr static int kTiersCount = static_cast<int>(Tier::kLast) + 1;
+
+    static const char *TierToString(Tier tier);
+    static std::optional<Tier> ParseTier(std::string_view str);
+
+    /**
+     * The tier can be forced by `ENV_CPU_DISPATCH_TIER` environment variable
+     * or `setTierOverride()`, which is clamped to the supported tier.
+     */
     CpuInfo();
     ~CpuInfo() = default;
 
-    g_nodiscard const cpu_features::X86Info& getX86Info() {
-        return fInfo;
+    g_nodiscard g_inline Tier getSupportedTier() const {
+        return fSupportedTier;
+    }
+
+    // The tier that dispatched functions should be resolved to
+    g_nodiscard Tier getTier() const;
+
+    // Must be called before any dispatched function is resolved
+    void setTierOverride(Tier tier);
+
+    g_nodiscard g_inline bool hasFeature(Feature feature) const {
+        return fFeatures & feature;
+    }
+
+    g_nodiscard g_inline Bitfield<Feature> getFeatures() const {
+        return fFeatures;
     }
 
 private:
-    cpu_features::X86Info       fInfo;
+    Bitfield<Feature>       fFeatures;
+    Tier                    fSupportedTier;
+    std::optional<Tier>     fTierOverride;
 };
 
 }
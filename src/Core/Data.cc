@@ -16,6 +16,7 @@
  */
 
 #include <cstring>
+#include <algorithm>
 
 #include "fmt/format.h"
 
@@ -47,7 +48,7 @@ public:
     }
 
     g_nodiscard uint8_t at(size_t index) const override {
-        CHECK(index >= size_ && "Index is out of range");
+        CHECK(index < size_ && "Index is out of range");
         return data_ptr_[index];
     }
 
@@ -57,6 +58,34 @@ private:
     bool                 memory_retained_;
 };
 
+class MappedFileSlice : public DataSlice
+{
+public:
+    MappedFileSlice(const std::shared_ptr<Data>& owned_data,
+                    void *map_base, size_t map_size, size_t delta, size_t size)
+            : DataSlice(owned_data), map_base_(map_base), map_size_(map_size)
+            , data_ptr_(reinterpret_cast<const uint8_t*>(map_base) + delta)
+            , size_(size) {}
+    ~MappedFileSlice() override {
+        vfs::MemUnmap(map_base_, map_size_);
+    }
+
+    g_nodiscard size_t size() const override {
+        return size_;
+    }
+
+    g_nodiscard uint8_t at(size_t index) const override {
+        CHECK(index < size_ && "Index is out of range");
+        return data_ptr_[index];
+    }
+
+private:
+    void                *map_base_;
+    size_t               map_size_;
+    const uint8_t       *data_ptr_;
+    size_t               size_;
+};
+
 class FileData : public Data
 {
 public:
@@ -74,11 +103,27 @@ public:
     }
 
     ssize_t read(void *buffer, size_t size) override {
-        if (!(flags_ & vfs::OpenFlags::kReadWrite) && !(flags_ & vfs::OpenFlags::kReadonly))
+        if (!isReadable())
             throw RuntimeException(__func__, "This data object is unreadable");
         return vfs::Read(fd_, buffer, size);
     }
 
+    ssize_t readAt(off_t offset, void *buffer, size_t size) override {
+        if (!isReadable())
+            throw RuntimeException(__func__, "This data object is unreadable");
+        return vfs::PRead(fd_, buffer, size, offset);
+    }
+
+    ssize_t readv(const vfs::IOVec *vecs, int32_t count) override {
+        if (!isReadable())
+            throw RuntimeException(__func__, "This data object is unreadable");
+        return vfs::ReadV(fd_, vecs, count);
+    }
+
+    void advise(vfs::AdviseHint hint, size_t offset, size_t size) override {
+        vfs::FAdvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(size), hint);
+    }
+
     ssize_t write(const void *buffer, size_t size) override {
         if (!(flags_ & vfs::OpenFlags::kReadWrite) && !(flags_ & vfs::OpenFlags::kWriteOnly))
             throw RuntimeException(__func__, "This data object is not writable");
@@ -94,15 +139,34 @@ public:
     }
 
     std::shared_ptr<DataSlice> slice(size_t offset, size_t size) override {
-        CHECK(offset + size >= this->size() && "Offset and size are out of range");
+        CHECK(offset + size <= this->size() && "Offset and size are out of range");
+        if (size == 0)
+            return std::make_shared<MemoryDataViewSlice>(shared_from_this(), nullptr, 0, false);
+
+        // Map the requested range into memory directly to avoid copying.
+        // Offset of a mapping must be aligned to the page size.
+        if (isReadable())
+        {
+            size_t map_offset = offset & ~(vfs::PageSize() - 1);
+            size_t delta = offset - map_offset;
+            void *ptr = vfs::MemMap(fd_, nullptr, {vfs::MapProtection::kRead},
+                                    {vfs::MapFlags::kPrivate}, size + delta,
+                                    static_cast<off64_t>(map_offset));
+            if (ptr)
+            {
+                return std::make_shared<MappedFileSlice>(shared_from_this(), ptr,
+                                                         size + delta, delta, size);
+            }
+        }
+
+        // Some files (pipes, character devices, etc.) cannot be mapped,
+        // fallback to reading them into a temporary buffer.
         auto *buf = reinterpret_cast<uint8_t*>(malloc(size));
         CHECK(buf && "Allocation failed");
 
-        Data::ScopedSeekRewind rewind(shared_from_this());
-
-        this->seek(vfs::SeekWhence::kSet, static_cast<off_t>(offset));
-        if (this->read(buf, size) != size)
+        if (this->readAt(static_cast<off_t>(offset), buf, size) != static_cast<ssize_t>(size))
         {
+            free(buf);
             throw RuntimeException(__func__,
                 fmt::format("Failed to read from file descriptor: {}", strerror(errno)));
         }
@@ -111,6 +175,10 @@ public:
     }
 
 private:
+    g_nodiscard bool isReadable() const {
+        return (flags_ & vfs::OpenFlags::kReadWrite) || (flags_ & vfs::OpenFlags::kReadonly);
+    }
+
     int32_t                    fd_;
     Bitfield<vfs::OpenFlags>   flags_;
 };
@@ -182,6 +250,30 @@ public:
         return static_cast<ssize_t>(finalSize);
     }
 
+    ssize_t readAt(off_t offset, void *buffer, size_t size) override {
+        if (offset < 0 || static_cast<size_t>(offset) > size_)
+            return -1;
+        size_t finalSize = std::min(size, size_ - static_cast<size_t>(offset));
+        if (finalSize == 0)
+            return 0;
+        std::memcpy(buffer, address_ + offset, finalSize);
+        return static_cast<ssize_t>(finalSize);
+    }
+
+    ssize_t readv(const vfs::IOVec *vecs, int32_t count) override {
+        ssize_t total = 0;
+        for (int32_t i = 0; i < count; i++)
+        {
+            ssize_t ret = this->read(vecs[i].base, vecs[i].length);
+            if (ret < 0)
+                return total > 0 ? total : ret;
+            total += ret;
+            if (static_cast<size_t>(ret) < vecs[i].length)
+                break;
+        }
+        return total;
+    }
+
     bool hasAccessibleBuffer() override {
         return true;
     }
@@ -197,7 +289,7 @@ public:
     }
 
     std::shared_ptr<DataSlice> slice(size_t offset, size_t size) override {
-        CHECK(offset + size >= size_ && "Offset and size are out of range");
+        CHECK(offset + size <= size_ && "Offset and size are out of range");
         return std::make_shared<MemoryDataViewSlice>(shared_from_this(),
                                                      address_ + offset, size, false);
     }
@@ -210,6 +302,128 @@ private:
     std::function<void(void*)> deleter_;
 };
 
+class MappedMemoryData : public MemoryData
+{
+public:
+    MappedMemoryData(void *ptr, size_t size)
+        : MemoryData(ptr, size, true, [size](void *ptr) {
+            CHECK(ptr);
+            vfs::MemUnmap(ptr, size);
+        }) {}
+    ~MappedMemoryData() override = default;
+
+    void advise(vfs::AdviseHint hint, size_t offset, size_t size) override {
+        size_t total = this->size();
+        if (offset >= total)
+            return;
+        if (size == 0 || offset + size > total)
+            size = total - offset;
+
+        // `madvise` requires the address to be aligned to the page size.
+        size_t aligned_offset = offset & ~(vfs::PageSize() - 1);
+        auto *base = reinterpret_cast<uint8_t*>(const_cast<void*>(getAccessibleBuffer()));
+        vfs::MemAdvise(base + aligned_offset, size + (offset - aligned_offset), hint);
+    }
+};
+
+class DataView : public Data
+{
+public:
+    DataView(std::shared_ptr<Data> parent, size_t offset, size_t size)
+        : parent_(std::move(parent)), offset_(offset), size_(size), cursor_(0) {}
+    ~DataView() override = default;
+
+    size_t size() override {
+        return size_;
+    }
+
+    off_t tell() override {
+        return static_cast<off_t>(cursor_);
+    }
+
+    off_t seek(vfs::SeekWhence whence, off_t offset) override {
+        off_t pos = 0;
+        switch (whence)
+        {
+        case vfs::SeekWhence::kSet:
+            pos = offset;
+            break;
+        case vfs::SeekWhence::kCurrent:
+            pos = static_cast<off_t>(cursor_) + offset;
+            break;
+        case vfs::SeekWhence::kEnd:
+            pos = static_cast<off_t>(size_) + offset;
+            break;
+        }
+        if (pos < 0 || static_cast<size_t>(pos) > size_)
+            throw RuntimeException(__func__, "Invalid offset");
+        cursor_ = static_cast<size_t>(pos);
+        return pos;
+    }
+
+    ssize_t read(void *buffer, size_t size) override {
+        ssize_t ret = this->readAt(static_cast<off_t>(cursor_), buffer, size);
+        if (ret > 0)
+            cursor_ += ret;
+        return ret;
+    }
+
+    ssize_t write(const void *buffer, size_t size) override {
+        throw RuntimeException(__func__, "Data view is readonly");
+    }
+
+    ssize_t readAt(off_t offset, void *buffer, size_t size) override {
+        if (offset < 0 || static_cast<size_t>(offset) > size_)
+            return -1;
+        size_t finalSize = std::min(size, size_ - static_cast<size_t>(offset));
+        if (finalSize == 0)
+            return 0;
+        return parent_->readAt(static_cast<off_t>(offset_ + offset), buffer, finalSize);
+    }
+
+    ssize_t readv(const vfs::IOVec *vecs, int32_t count) override {
+        ssize_t total = 0;
+        for (int32_t i = 0; i < count; i++)
+        {
+            ssize_t ret = this->read(vecs[i].base, vecs[i].length);
+            if (ret < 0)
+                return total > 0 ? total : ret;
+            total += ret;
+            if (static_cast<size_t>(ret) < vecs[i].length)
+                break;
+        }
+        return total;
+    }
+
+    void advise(vfs::AdviseHint hint, size_t offset, size_t size) override {
+        if (offset >= size_)
+            return;
+        if (size == 0 || offset + size > size_)
+            size = size_ - offset;
+        parent_->advise(hint, offset_ + offset, size);
+    }
+
+    bool hasAccessibleBuffer() override {
+        return parent_->hasAccessibleBuffer();
+    }
+
+    const void *getAccessibleBuffer() override {
+        auto *base = reinterpret_cast<const uint8_t*>(parent_->getAccessibleBuffer());
+        return base ? base + offset_ : nullptr;
+    }
+
+    std::shared_ptr<DataSlice> slice(size_t offset, size_t size) override {
+        CHECK(offset + size <= size_ && "Offset and size are out of range");
+        return parent_->slice(offset_ + offset, size);
+    }
+
+private:
+    std::shared_ptr<Data>   parent_;
+    size_t                  offset_;
+    size_t                  size_;
+    size_t                  cursor_;
+};
+
 std::shared_ptr<Data> Data::MakeFromFileMapped(const std::string& path,
                                                Bitfield<vfs::OpenFlags> flags)
 {
@@ -236,10 +450,7 @@ std::shared_ptr<Data> Data::MakeFromFileMapped(const std::string& path,
     if (!ptr)
         return nullptr;
 
-    return std::make_shared<MemoryData>(ptr, size, true, [size](void *ptr){
-        CHECK(ptr);
-        vfs::MemUnmap(ptr, size);
-    });
+    return std::make_shared<MappedMemoryData>(ptr, size);
 }
 
 std::shared_ptr<Data> Data::MakeFromFile(const std::string& path,
@@ -313,13 +524,32 @@ std::shared_ptr<Data> Data::MakeLinearBuffer(const std::shared_ptr<Data>& data)
     auto duplicated_data = Data::MakeFromSize(size);
     CHECK(duplicated_data);
 
-    size_t read_size = data->read(const_cast<void*>(duplicated_data->getAccessibleBuffer()), size);
-    if (read_size < size)
-        return nullptr;
+    // The whole data will be read once from the beginning, so hint the
+    // kernel to perform aggressive readahead.
+    data->advise(vfs::AdviseHint::kSequential);
+
+    auto *ptr = reinterpret_cast<uint8_t*>(const_cast<void*>(duplicated_data->getAccessibleBuffer()));
+    size_t read_size = 0;
+    while (read_size < size)
+    {
+        ssize_t ret = data->readAt(static_cast<off_t>(read_size), ptr + read_size, size - read_size);
+        if (ret <= 0)
+            return nullptr;
+        read_size += ret;
+    }
 
     return duplicated_data;
 }
 
+std::shared_ptr<Data> Data::MakeView(const std::shared_ptr<Data>& data,
+                                     size_t offset, size_t size)
+{
+    CHECK(data);
+    if (offset + size > data->size())
+        return nullptr;
+    return std::make_shared<DataView>(data, offset, size);
+}
+
 std::shared_ptr<Data> Data::MakeFromString(const char *str, bool no_terminator)
 {
     CHECK(str);
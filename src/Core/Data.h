@@ -68,11 +68,41 @@ public:
     static std::shared_ptr<Data> MakeLinearBuffer(const std::shared_ptr<Data>& data);
     static std::shared_ptr<Data> MakeFromExternal(void *ptr, size_t size, const ExternalDeleter& deleter);
 
+    /**
+     * Create a readonly view of the range [offset, offset + size) of `data`.
+     * The view holds a reference of `data` and never copies the contents.
+     * It has its own cursor, which means reading from the view does not
+     * change the position of `data` and vice versa.
+     */
+    static std::shared_ptr<Data> MakeView(const std::shared_ptr<Data>& data,
+                                          size_t offset, size_t size);
+
     g_nodiscard virtual size_t size() = 0;
 
     virtual ssize_t read(void *buffer, size_t size) = 0;
     virtual ssize_t write(const void *buffer, size_t size) = 0;
 
+    /**
+     * Positional read, which does not use or change the current position.
+     * Returns the number of bytes that have been read, which is less than
+     * `size` only if EOF is reached, or -1 on failure.
+     */
+    virtual ssize_t readAt(off_t offset, void *buffer, size_t size) = 0;
+
+    /**
+     * Scattered read from the current position. Buffers in `vecs` are filled
+     * in order, and the whole operation is done by only one system call for
+     * file-backed data.
+     */
+    virtual ssize_t readv(const vfs::IOVec *vecs, int32_t count) = 0;
+
+    /**
+     * Tell the underlying storage how the range [offset, offset + size) will
+     * be accessed in the future. A zero `size` means the range extends to the
+     * end of the data. It is only a hint and can be ignored safely.
+     */
+    virtual void advise(vfs::AdviseHint hint, size_t offset = 0, size_t size = 0) {}
+
     g_nodiscard virtual off_t tell() = 0;
 
     virtual off_t seek(vfs::SeekWhence whence, off_t offset) = 0;
@@ -17,15 +17,131 @@
 
 #include "Core/Errors.h"
 #include <iostream>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <algorithm>
 
 #include "Core/EventLoop.h"
 #include "Core/EventSource.h"
+#include "Core/TraceEvent.h"
 namespace cocoa
 {
 
+namespace {
+
+constexpr size_t kLanesCount = static_cast<size_t>(EventLoop::ThreadPoolLane::kLast) + 1;
+
+// Perfetto counter tracks (names must be static strings)
+struct LaneTracks
+{
+    const char *pending;
+    const char *mean_latency;
+    const char *max_latency;
+};
+
+const LaneTracks g_lane_tracks[kLanesCount] = {
+    { "EventLoop.InteractiveLane.Pending", "EventLoop.InteractiveLane.MeanQueueLatencyUs",
+      "EventLoop.InteractiveLane.MaxQueueLatencyUs" },
+    { "EventLoop.IOLane.Pending", "EventLoop.IOLane.MeanQueueLatencyUs",
+      "EventLoop.IOLane.MaxQueueLatencyUs" },
+    { "EventLoop.BackgroundLane.Pending", "EventLoop.BackgroundLane.MeanQueueLatencyUs",
+      "EventLoop.BackgroundLane.MaxQueueLatencyUs" }
+};
+
+} // namespace anonymous
+
+struct EventLoop::ThreadPoolLanes
+{
+    /**
+     * Every submitted task queues a ticket in libuv's thread pool. A ticket
+     * does not belong to a specific task: when it is executed by a worker,
+     * the worker takes the task with the highest priority from the lanes.
+     * Tickets are reused to avoid allocations.
+     */
+    struct Ticket
+    {
+        uv_work_t           work;
+        ThreadPoolLanes    *lanes;
+        ThreadPoolTask     *executed;
+    };
+
+    ~ThreadPoolLanes() {
+        for (Ticket *ticket : free_tickets)
+            delete ticket;
+    }
+
+    Ticket *acquireTicket() {
+        std::scoped_lock<std::mutex> scope(lock);
+        if (free_tickets.empty())
+            return new Ticket{ {}, this, nullptr };
+        Ticket *ticket = free_tickets.back();
+        free_tickets.pop_back();
+        return ticket;
+    }
+
+    void releaseTicket(Ticket *ticket) {
+        ticket->executed = nullptr;
+        std::scoped_lock<std::mutex> scope(lock);
+        free_tickets.push_back(ticket);
+    }
+
+    ThreadPoolTask *takeTask() {
+        std::scoped_lock<std::mutex> scope(lock);
+        for (size_t i = 0; i < kLanesCount; i++)
+        {
+            if (queues[i].empty())
+                continue;
+            ThreadPoolTask *task = queues[i].front();
+            queues[i].pop_front();
+
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - task->enqueue_time);
+            stats[i].dispatched_count++;
+            stats[i].total_queue_latency += latency;
+            stats[i].max_queue_latency = std::max(stats[i].max_queue_latency, latency);
+            return task;
+        }
+        // There is always a task for each ticket
+        MARK_UNREACHABLE();
+    }
+
+    // This function will be executed in the thread pool asynchronously
+    static void WorkCallback(uv_work_t *work) {
+        auto *ticket = reinterpret_cast<Ticket*>(work->data);
+        CHECK(ticket);
+        ticket->executed = ticket->lanes->takeTask();
+        ticket->executed->run();
+    }
+
+    // This function will be executed in main thread locally
+    // to notify us that a task have been finished.
+    static void AfterWorkCallback(uv_work_t *work, g_maybe_unused int status) {
+        auto *ticket = reinterpret_cast<Ticket*>(work->data);
+        CHECK(ticket && ticket->executed);
+
+        std::unique_ptr<ThreadPoolTask> task(ticket->executed);
+        ThreadPoolLanes *lanes = ticket->lanes;
+        lanes->releaseTicket(ticket);
+
+        if (TRACE_EVENT_CATEGORY_ENABLED("main"))
+            lanes->owner->traceThreadPoolLane(task->lane);
+
+        task->post();
+    }
+
+    std::mutex                      lock;
+    std::deque<ThreadPoolTask*>     queues[kLanesCount];
+    ThreadPoolLaneStats             stats[kLanesCount];
+    std::vector<Ticket*>            free_tickets;
+    EventLoop                      *owner = nullptr;
+};
+
 EventLoop::EventLoop()
     : loop_{}
+    , lanes_(std::make_unique<ThreadPoolLanes>())
 {
+    lanes_->owner = this;
     uv_loop_init(&loop_);
 }
 
@@ -62,48 +178,74 @@ void EventLoop::walk(std::function<void(uv_handle_t *)> function)
     }, &function);
 }
 
-namespace {
-
-struct TaskClosure
+void EventLoop::submitThreadPoolTask(std::unique_ptr<ThreadPoolTask> task, ThreadPoolLane lane)
 {
-    uv_work_t   task_work;
-    EventLoop::TaskRoutineVoid task_routine;
-    EventLoop::PostTaskRoutineVoid post_task_routine;
-};
+    task->lane = lane;
+    task->enqueue_time = std::chrono::steady_clock::now();
 
-// This function will be executed in the thread pool asynchronously
-void thread_pool_task_routine(uv_work_t *work)
-{
-    auto *closure = reinterpret_cast<TaskClosure*>(work->data);
-    CHECK(closure);
-    closure->task_routine();
+    ThreadPoolLanes::Ticket *ticket = lanes_->acquireTicket();
+    ticket->work.data = ticket;
+    {
+        std::scoped_lock<std::mutex> scope(lanes_->lock);
+        lanes_->queues[static_cast<size_t>(lane)].push_back(task.release());
+    }
+
+    uv_queue_work(&loop_, &ticket->work, ThreadPoolLanes::WorkCallback,
+                  ThreadPoolLanes::AfterWorkCallback);
 }
 
-// This function will be executed in main thread locally
-// to notify us that a task have been finished.
-void thread_pool_post_task_routine(uv_work_t *work, int status)
+void EventLoop::enqueueThreadPoolTrivialTask(TaskRoutineVoid task, PostTaskRoutineVoid post_task,
+                                             ThreadPoolLane lane)
 {
-    auto *closure = reinterpret_cast<TaskClosure*>(work->data);
-    CHECK(closure);
+    struct TrivialTask : public ThreadPoolTask
+    {
+        TrivialTask(TaskRoutineVoid task_, PostTaskRoutineVoid post_task_)
+            : task(std::move(task_)), post_task(std::move(post_task_)) {}
+        ~TrivialTask() override = default;
+
+        void run() override {
+            task();
+        }
 
-    if (closure->post_task_routine)
-        closure->post_task_routine();
+        void post() override {
+            if (post_task)
+                post_task();
+        }
 
-    delete closure;
+        TaskRoutineVoid         task;
+        PostTaskRoutineVoid     post_task;
+    };
+
+    submitThreadPoolTask(std::make_unique<TrivialTask>(std::move(task), std::move(post_task)), lane);
 }
 
-} // namespace anonymous
+EventLoop::ThreadPoolLaneStats EventLoop::getThreadPoolLaneStats(ThreadPoolLane lane)
+{
+    auto index = static_cast<size_t>(lane);
+    std::scoped_lock<std::mutex> scope(lanes_->lock);
+    ThreadPoolLaneStats stats = lanes_->stats[index];
+    stats.pending_count = lanes_->queues[index].size();
+    return stats;
+}
 
-void EventLoop::enqueueThreadPoolTrivialTask(const TaskRoutineVoid& task, const PostTaskRoutineVoid& post_task)
+void EventLoop::traceThreadPoolLane(ThreadPoolLane lane)
 {
-    auto *closure = new TaskClosure{
-        .task_routine = task,
-        .post_task_routine = post_task
-    };
-    closure->task_work.data = closure;
+    ThreadPoolLaneStats stats = getThreadPoolLaneStats(lane);
+    const LaneTracks& tracks = g_lane_tracks[static_cast<size_t>(lane)];
 
-    uv_queue_work(&loop_, &closure->task_work, thread_pool_task_routine,
-                  thread_pool_post_task_routine);
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    int64_t mean_latency_us = 0;
+    if (stats.dispatched_count > 0)
+    {
+        mean_latency_us = duration_cast<microseconds>(stats.total_queue_latency).count() /
+                          static_cast<int64_t>(stats.dispatched_count);
+    }
+
+    TRACE_COUNTER("main", tracks.pending, stats.pending_count);
+    TRACE_COUNTER("main", tracks.mean_latency, mean_latency_us);
+    TRACE_COUNTER("main", tracks.max_latency,
+                  duration_cast<microseconds>(stats.max_queue_latency).count());
 }
 
 PollSource::PollSource(EventLoop *loop, int fd)
@@ -21,11 +21,13 @@
 #include <functional>
 #include <optional>
 #include <memory>
+#include <chrono>
 
 #include <uv.h>
 
 #include "Core/Project.h"
 #include "Core/UniquePersistent.h"
+#include "Core/UniqueFunction.h"
 
 namespace cocoa
 {
@@ -55,12 +57,40 @@ public:
     }
 
     template<typename T>
-    using TaskRoutine = std::function<T()>;
+    using TaskRoutine = UniqueFunction<T()>;
     using TaskRoutineVoid = TaskRoutine<void>;
 
     template<typename T>
-    using PostTaskRoutine = std::function<void(T&&)>;
-    using PostTaskRoutineVoid = std::function<void()>;
+    using PostTaskRoutine = UniqueFunction<void(T&&)>;
+    using PostTaskRoutineVoid = UniqueFunction<void()>;
+
+    /**
+     * Tasks submitted to the thread pool are queued in lanes. Whenever a worker
+     * thread becomes available, it takes the oldest task from the lane with the
+     * highest priority, in the order: interactive, I/O, background.
+     */
+    enum class ThreadPoolLane
+    {
+        // Latency-critical tasks which a frame or a user is waiting for
+        kInteractive,
+        // Tasks which mostly block on I/O operations
+        kIO,
+        // CPU-bound tasks which are not urgent, like decoding assets
+        kBackground,
+
+        kLast = kBackground
+    };
+
+    struct ThreadPoolLaneStats
+    {
+        // Number of tasks which have been taken by worker threads
+        uint64_t                    dispatched_count = 0;
+        // Number of tasks which are still waiting in the lane
+        uint64_t                    pending_count = 0;
+        // Time between submitting and starting a task
+        std::chrono::nanoseconds    total_queue_latency{0};
+        std::chrono::nanoseconds    max_queue_latency{0};
+    };
 
     /**
      * Submit an asynchronous task to execute in the thread pool.
@@ -69,27 +99,67 @@ public:
      * by event loop in current thread.
      */
     template<typename T>
-    void enqueueThreadPoolTask(const TaskRoutine<T>& task, const PostTaskRoutine<T>& post_task);
+    void enqueueThreadPoolTask(TaskRoutine<T> task, PostTaskRoutine<T> post_task,
+                               ThreadPoolLane lane = ThreadPoolLane::kBackground);
+
+    void enqueueThreadPoolTrivialTask(TaskRoutineVoid task, PostTaskRoutineVoid post_task,
+                                      ThreadPoolLane lane = ThreadPoolLane::kBackground);
 
-    void enqueueThreadPoolTrivialTask(const TaskRoutineVoid& task, const PostTaskRoutineVoid& post_task);
+    /**
+     * The statistics are also emitted as perfetto counters in the "main"
+     * category whenever a task of the lane is finished.
+     */
+    g_nodiscard ThreadPoolLaneStats getThreadPoolLaneStats(ThreadPoolLane lane);
 
     void dispose();
 
 private:
+    struct ThreadPoolTask
+    {
+        virtual ~ThreadPoolTask() = default;
+        virtual void run() = 0;
+        virtual void post() = 0;
+
+        ThreadPoolLane                          lane = ThreadPoolLane::kBackground;
+        std::chrono::steady_clock::time_point   enqueue_time;
+    };
+
+    template<typename T>
+    struct TypedThreadPoolTask : public ThreadPoolTask
+    {
+        TypedThreadPoolTask(TaskRoutine<T> task_, PostTaskRoutine<T> post_task_)
+            : task(std::move(task_)), post_task(std::move(post_task_)) {}
+        ~TypedThreadPoolTask() override = default;
+
+        void run() override {
+            result.emplace(task());
+        }
+
+        void post() override {
+            if (post_task)
+                post_task(std::move(*result));
+        }
+
+        TaskRoutine<T>          task;
+        PostTaskRoutine<T>      post_task;
+        std::optional<T>        result;
+    };
+
+    struct ThreadPoolLanes;
+
+    void submitThreadPoolTask(std::unique_ptr<ThreadPoolTask> task, ThreadPoolLane lane);
+    void traceThreadPoolLane(ThreadPoolLane lane);
+
     uv_loop_t loop_;
+    std::unique_ptr<ThreadPoolLanes> lanes_;
 };
 
 template<typename T>
-void EventLoop::enqueueThreadPoolTask(const TaskRoutine<T>& task, const PostTaskRoutine<T>& post_task)
+void EventLoop::enqueueThreadPoolTask(TaskRoutine<T> task, PostTaskRoutine<T> post_task,
+                                      ThreadPoolLane lane)
 {
-    using Holder = std::optional<T>;
-
-    auto ret_holder = std::make_shared<Holder>();
-    enqueueThreadPoolTrivialTask([ret_holder, task]() -> void {
-        *ret_holder = std::move(task());
-    }, [ret_holder, post_task]() -> void {
-        post_task(std::move(**ret_holder));
-    });
+    submitThreadPoolTask(std::make_unique<TypedThreadPoolTask<T>>(
+            std::move(task), std::move(post_task)), lane);
 }
 
 namespace uv {
@@ -157,6 +227,29 @@ START_STOP_HANDLE_IMPL(IdleHandle, idle)
 
 #undef START_STOP_HANDLE_IMPL
 
+class TimerHandle : public HandleBase<uv_timer_t>
+{
+public:
+    explicit TimerHandle(uv_loop_t *loop) {
+        uv_timer_init(loop, Get());
+        Get()->data = this;
+    }
+
+    void Start(uint64_t timeout, uint64_t repeat, std::function<void(void)> func) {
+        func_ = std::move(func);
+        uv_timer_start(Get(), [](uv_timer_t *h) {
+            static_cast<TimerHandle*>(h->data)->func_();
+        }, timeout, repeat);
+    }
+
+    void Stop() {
+        uv_timer_stop(Get());
+    }
+
+private:
+    std::function<void(void)> func_;
+};
+
 class AsyncHandle : public HandleBase<uv_async_t>
 {
 public:
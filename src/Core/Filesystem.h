@@ -84,6 +84,15 @@ enum class SeekWhence : uint8_t
     kLastWhence = kEnd
 };
 
+enum class AdviseHint : uint8_t
+{
+    kNormal,
+    kSequential,
+    kRandom,
+    kWillNeed,
+    kDontNeed
+};
+
 enum class AccessMode : uint8_t
 {
     kReadable   = (1 << 0),
@@ -111,6 +120,13 @@ struct Stat
     struct timespec ctime;
 };
 
+// Binary compatible with `struct iovec` of POSIX
+struct IOVec
+{
+    void           *base;
+    size_t          length;
+};
+
 #define VFS_AT_FDCWD  (-1)
 
 int32_t Open(const std::string& path, Bitfield<OpenFlags> flags,
@@ -130,12 +146,24 @@ ssize_t FileSize(int32_t fd);
 ssize_t FileSize(const std::string& path);
 
 ssize_t Read(int32_t fd, void *buffer, size_t size);
+ssize_t PRead(int32_t fd, void *buffer, size_t size, off_t offset);
+ssize_t ReadV(int32_t fd, const IOVec *vecs, int32_t count);
+ssize_t PReadV(int32_t fd, const IOVec *vecs, int32_t count, off_t offset);
 ssize_t Write(int32_t fd, const void *buffer, size_t size);
+ssize_t WriteV(int32_t fd, const IOVec *vecs, int32_t count);
 off_t Seek(int32_t fd, off_t offset, SeekWhence whence);
 void *MemMap(int32_t fd, void *address, Bitfield<MapProtection> protection,
              Bitfield<MapFlags> flags, size_t size, off64_t offset);
 bool MemMapHasFailed(void *ret);
 int32_t MemUnmap(void *address, size_t size);
+size_t PageSize();
+
+// Readahead hints for the kernel. `FAdvise` works on the page cache of
+// a file, and `MemAdvise` works on a mapped memory region which should
+// be aligned to the page size. A zero `length` for `FAdvise` means
+// the whole file since `offset`.
+int32_t FAdvise(int32_t fd, off_t offset, off_t length, AdviseHint hint);
+int32_t MemAdvise(void *address, size_t size, AdviseHint hint);
 
 int32_t Truncate(const std::string& path, off_t length);
 int32_t FTruncate(int32_t fd, off_t length);
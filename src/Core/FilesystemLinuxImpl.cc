@@ -19,9 +19,12 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <linux/limits.h>
 
 #include <vector>
+#include <cstddef>
+#include <cerrno>
 
 #include "Core/Filesystem.h"
 VFS_NS_BEGIN
@@ -49,6 +52,28 @@ int32_t ModeFlagsToNative(Bitfield<Mode> mode)
     return p;
 }
 
+static_assert(sizeof(IOVec) == sizeof(struct iovec));
+static_assert(offsetof(IOVec, base) == offsetof(struct iovec, iov_base));
+static_assert(offsetof(IOVec, length) == offsetof(struct iovec, iov_len));
+
+int32_t AdviseHintToNative(AdviseHint hint, bool madv)
+{
+    switch (hint)
+    {
+    case AdviseHint::kNormal:
+        return madv ? MADV_NORMAL : POSIX_FADV_NORMAL;
+    case AdviseHint::kSequential:
+        return madv ? MADV_SEQUENTIAL : POSIX_FADV_SEQUENTIAL;
+    case AdviseHint::kRandom:
+        return madv ? MADV_RANDOM : POSIX_FADV_RANDOM;
+    case AdviseHint::kWillNeed:
+        return madv ? MADV_WILLNEED : POSIX_FADV_WILLNEED;
+    case AdviseHint::kDontNeed:
+        return madv ? MADV_DONTNEED : POSIX_FADV_DONTNEED;
+    }
+    return madv ? MADV_NORMAL : POSIX_FADV_NORMAL;
+}
+
 } // namespace anonymous
 
 int32_t Open(const std::string& path, Bitfield<OpenFlags> flags, Bitfield<Mode> mode)
@@ -182,11 +207,31 @@ ssize_t Read(int32_t fd, void *buffer, size_t size)
     return read(fd, buffer, size);
 }
 
+ssize_t PRead(int32_t fd, void *buffer, size_t size, off_t offset)
+{
+    return pread(fd, buffer, size, offset);
+}
+
+ssize_t ReadV(int32_t fd, const IOVec *vecs, int32_t count)
+{
+    return readv(fd, reinterpret_cast<const struct iovec*>(vecs), count);
+}
+
+ssize_t PReadV(int32_t fd, const IOVec *vecs, int32_t count, off_t offset)
+{
+    return preadv(fd, reinterpret_cast<const struct iovec*>(vecs), count, offset);
+}
+
 ssize_t Write(int32_t fd, const void *buffer, size_t size)
 {
     return write(fd, buffer, size);
 }
 
+ssize_t WriteV(int32_t fd, const IOVec *vecs, int32_t count)
+{
+    return writev(fd, reinterpret_cast<const struct iovec*>(vecs), count);
+}
+
 off_t Seek(int32_t fd, off_t offset, SeekWhence whence)
 {
     int32_t iWhence;
@@ -231,6 +276,30 @@ int32_t MemUnmap(void *address, size_t size)
     return munmap(address, size);
 }
 
+size_t PageSize()
+{
+    static size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+int32_t FAdvise(int32_t fd, off_t offset, off_t length, AdviseHint hint)
+{
+    // Note that `posix_fadvise` returns an error number directly
+    // instead of setting `errno`.
+    int32_t ret = posix_fadvise(fd, offset, length, AdviseHintToNative(hint, false));
+    if (ret != 0)
+    {
+        errno = ret;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t MemAdvise(void *address, size_t size, AdviseHint hint)
+{
+    return madvise(address, size, AdviseHintToNative(hint, true));
+}
+
 int32_t Truncate(const std::string& path, off_t length)
 {
     return ::truncate(path.c_str(), length);
@@ -17,189 +17,448 @@
 
 #include <queue>
 #include <vector>
-#include <bitset>
-#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <functional>
 
 #include "Core/Data.h"
 #include "Core/HuffmanCodec.h"
 #include "Core/ScalableWriteBuffer.h"
 #include "Core/Errors.h"
 
-#include "fmt/format.h"
-
 namespace cocoa {
 
 namespace {
 
+#define ALPHABET_SIZE   256
+
+#define INPUT_BUFFER_SLICE_SIZE     65536UL
+#define OUTPUT_BUFFER_SIZE          4096UL
+
 struct HuffmanNode
 {
-    using ptr = std::shared_ptr<HuffmanNode>;
-
-    bool        is_leaf_node;
-    int         freq_count;
-    ptr         left_child;
-    ptr         right_child;
-    uint8_t     symbol;
+    uint64_t    freq_count;
+    int32_t     parent;
 };
 
-struct NodeComparator
+// NOLINTNEXTLINE
+bool build_code_lengths_once(const uint64_t *freqs, uint8_t *lengths)
 {
-    bool operator()(const HuffmanNode::ptr& a, const HuffmanNode::ptr& b) const
-    {
-        return (a->freq_count > b->freq_count);
-    }
-};
+    std::vector<HuffmanNode> nodes;
+    int32_t leaf_of_symbol[ALPHABET_SIZE];
 
-using Container = std::vector<HuffmanNode::ptr>;
-using PriorityQueue = std::priority_queue<HuffmanNode::ptr, Container, NodeComparator>;
+    using QueueItem = std::pair<uint64_t, int32_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
 
-#define HUFFMAN_MAX_BITS    255
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
+    {
+        leaf_of_symbol[sym] = -1;
+        if (freqs[sym] == 0)
+            continue;
+        leaf_of_symbol[sym] = static_cast<int32_t>(nodes.size());
+        queue.emplace(freqs[sym], nodes.size());
+        nodes.emplace_back(HuffmanNode{freqs[sym], -1});
+    }
 
-struct BitCode
-{
-    int                             num_bits;
-    std::bitset<HUFFMAN_MAX_BITS>   bits;
-};
+    if (nodes.size() == 1)
+    {
+        // A single symbol still needs a 1-bit code
+        for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
+            lengths[sym] = (leaf_of_symbol[sym] >= 0) ? 1 : 0;
+        return true;
+    }
 
-using CodeTable = std::unordered_map<uint8_t, BitCode>;
+    // Huffman's algorithm. Code reference from:
+    // Thomas H. Cormen, Charles E. Leiserson, Ronald L. Rivest, Clifford Stein.
+    // Introduction to Algorithms, Third Edition[M]. Cambridge: MIT Press, 2009.pp.428-435
+    while (queue.size() > 1)
+    {
+        auto [lfreq, l] = queue.top();
+        queue.pop();
+        auto [rfreq, r] = queue.top();
+        queue.pop();
+
+        auto parent = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back(HuffmanNode{lfreq + rfreq, -1});
+        nodes[l].parent = parent;
+        nodes[r].parent = parent;
+        queue.emplace(lfreq + rfreq, parent);
+    }
 
-#define ALPHABET_SIZE   256
+    bool fits = true;
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
+    {
+        if (leaf_of_symbol[sym] < 0)
+        {
+            lengths[sym] = 0;
+            continue;
+        }
+        int depth = 0;
+        for (int32_t n = leaf_of_symbol[sym]; nodes[n].parent >= 0; n = nodes[n].parent)
+            depth++;
+        if (depth > kHuffmanMaxCodeLength)
+            fits = false;
+        lengths[sym] = static_cast<uint8_t>(std::min(depth, 255));
+    }
+    return fits;
+}
 
-void compute_symbol_frequencies(PriorityQueue& out_queue, const std::shared_ptr<Data>& input)
+void build_code_lengths(const HuffmanStreamEncoder::FrequencyTable& freqs, uint8_t *lengths)
 {
-    HuffmanNode::ptr alphabet_map_table[ALPHABET_SIZE];
+    uint64_t scaled[ALPHABET_SIZE];
+    std::copy(freqs.begin(), freqs.end(), scaled);
 
-    auto increase_symbol_freq = [&alphabet_map_table](uint8_t symbol) {
-        if (alphabet_map_table[symbol] == nullptr)
-        {
-            alphabet_map_table[symbol] = std::make_shared<HuffmanNode>(HuffmanNode{
-                .is_leaf_node = true,
-                .freq_count = 1,
-                .left_child = nullptr,
-                .right_child = nullptr,
-                .symbol = symbol
-            });
-        }
-        else
+    // Flatten the distribution until the longest code fits in the limit.
+    // Nonzero frequencies never become zero.
+    while (!build_code_lengths_once(scaled, lengths))
+    {
+        for (uint64_t& freq : scaled)
         {
-            alphabet_map_table[symbol]->freq_count++;
+            if (freq > 0)
+                freq = (freq + 1) / 2;
         }
-    };
+    }
+}
 
-    if (input->hasAccessibleBuffer())
+/**
+ * Assign canonical codes: shorter codes come first, and codes with the same
+ * length are ordered by their symbols.
+ * Returns false if the lengths do not form a valid prefix code.
+ */
+bool assign_canonical_codes(const uint8_t *lengths, uint32_t *codes)
+{
+    uint32_t length_count[kHuffmanMaxCodeLength + 1] = {0};
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
     {
-        auto *ptr = reinterpret_cast<const uint8_t*>(input->getAccessibleBuffer());
-        auto *end_ptr = ptr + input->size();
+        if (lengths[sym] > kHuffmanMaxCodeLength)
+            return false;
+        length_count[lengths[sym]]++;
+    }
+    length_count[0] = 0;
 
-        while (ptr < end_ptr)
-        {
-            increase_symbol_freq(*ptr);
-            ptr++;
-        }
+    uint32_t next_code[kHuffmanMaxCodeLength + 1] = {0};
+    uint32_t code = 0;
+    for (int len = 1; len <= kHuffmanMaxCodeLength; len++)
+    {
+        code = (code + length_count[len - 1]) << 1;
+        next_code[len] = code;
+        // Kraft's inequality is violated
+        if (length_count[len] > 0 && next_code[len] + length_count[len] > (1U << len))
+            return false;
     }
-    else
+
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
     {
-        uint8_t ch;
-        for (size_t i = 0; i < input->size(); i++)
+        codes[sym] = 0;
+        if (lengths[sym] > 0)
+            codes[sym] = next_code[lengths[sym]]++;
+    }
+    return true;
+}
+
+} // namespace anonymous
+
+void HuffmanStreamEncoder::CountFrequencies(FrequencyTable& table, const uint8_t *data, size_t size)
+{
+    const uint8_t *end = data + size;
+    while (data < end)
+        table[*data++]++;
+}
+
+HuffmanStreamEncoder::HuffmanStreamEncoder(const FrequencyTable& freqs, ScalableWriteBuffer& output)
+    : output_(output)
+    , codes_{}
+    , lengths_{}
+    , bit_accumulator_(0)
+    , bits_count_(0)
+{
+    build_code_lengths(freqs, lengths_);
+    CHECK(assign_canonical_codes(lengths_, codes_));
+
+    uint64_t total = 0;
+    for (uint64_t freq : freqs)
+        total += freq;
+
+    uint8_t header[kHuffmanHeaderSize];
+    for (int i = 0; i < 8; i++)
+        header[i] = static_cast<uint8_t>(total >> (i * 8));
+    std::memcpy(header + sizeof(uint64_t), lengths_, ALPHABET_SIZE);
+    output_.writeBytes(header, kHuffmanHeaderSize);
+
+    pending_bytes_.reserve(OUTPUT_BUFFER_SIZE);
+}
+
+void HuffmanStreamEncoder::flushBytes()
+{
+    output_.writeBytes(pending_bytes_.data(), pending_bytes_.size());
+    pending_bytes_.clear();
+}
+
+void HuffmanStreamEncoder::encode(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t sym = data[i];
+        CHECK(lengths_[sym] > 0 && "Symbol was not counted in the frequency table");
+
+        // At most 7 + kHuffmanMaxCodeLength bits are in the accumulator
+        bit_accumulator_ = (bit_accumulator_ << lengths_[sym]) | codes_[sym];
+        bits_count_ += lengths_[sym];
+        while (bits_count_ >= 8)
         {
-            input->read(&ch, 1);
-            increase_symbol_freq(ch);
+            bits_count_ -= 8;
+            pending_bytes_.push_back(static_cast<uint8_t>(bit_accumulator_ >> bits_count_));
         }
+
+        if (pending_bytes_.size() >= OUTPUT_BUFFER_SIZE)
+            flushBytes();
     }
+}
 
-    for (const HuffmanNode::ptr& node : alphabet_map_table)
+void HuffmanStreamEncoder::finish()
+{
+    if (bits_count_ > 0)
     {
-        if (node)
-            out_queue.push(node);
+        pending_bytes_.push_back(static_cast<uint8_t>(bit_accumulator_ << (8 - bits_count_)));
+        bits_count_ = 0;
     }
+    bit_accumulator_ = 0;
+    flushBytes();
 }
 
-// NOLINTNEXTLINE
-void generate_code_table(BitCode *out, const HuffmanNode::ptr& node, int depth,
-                         std::bitset<HUFFMAN_MAX_BITS>& current_bit_code)
+HuffmanStreamDecoder::HuffmanStreamDecoder(ScalableWriteBuffer& output)
+    : output_(output)
+    , status_(Status::kNeedMoreInput)
+    , remaining_symbols_(0)
+    , lengths_{}
+    , max_length_(0)
+    , bit_buffer_(0)
+    , bits_count_(0)
+    , input_ptr_(nullptr)
+    , input_end_(nullptr)
 {
-    if (node->is_leaf_node)
+    header_.reserve(kHuffmanHeaderSize);
+}
+
+bool HuffmanStreamDecoder::buildTables()
+{
+    uint32_t codes[ALPHABET_SIZE];
+    if (!assign_canonical_codes(lengths_, codes))
+        return false;
+
+    max_length_ = 0;
+    for (uint8_t len : lengths_)
+        max_length_ = std::max<int>(max_length_, len);
+
+    // Entries with zero length are invalid codes
+    primary_table_.assign(1U << kPrimaryBits, 0);
+    secondary_tables_.clear();
+
+    // Bits of the secondary table of each primary prefix
+    std::vector<int> secondary_bits(1U << kPrimaryBits, 0);
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
+    {
+        if (lengths_[sym] <= kPrimaryBits)
+            continue;
+        uint32_t prefix = codes[sym] >> (lengths_[sym] - kPrimaryBits);
+        secondary_bits[prefix] = std::max(secondary_bits[prefix], lengths_[sym] - kPrimaryBits);
+    }
+    for (uint32_t prefix = 0; prefix < secondary_bits.size(); prefix++)
     {
-        out[node->symbol] = BitCode {
-            .num_bits = depth + 1,
-            .bits = current_bit_code
-        };
-        return;
+        if (secondary_bits[prefix] == 0)
+            continue;
+        auto offset = static_cast<uint32_t>(secondary_tables_.size());
+        secondary_tables_.resize(offset + (1U << secondary_bits[prefix]), 0);
+        primary_table_[prefix] = (1U << 31) | (secondary_bits[prefix] << 16) | offset;
     }
 
-    generate_code_table(out, node->left_child, depth + 1, current_bit_code);
+    for (int32_t sym = 0; sym < ALPHABET_SIZE; sym++)
+    {
+        int len = lengths_[sym];
+        if (len == 0)
+            continue;
 
-    current_bit_code.set(depth, true);
-    generate_code_table(out, node->right_child, depth + 1, current_bit_code);
+        auto entry = static_cast<uint32_t>((len << 16) | sym);
+        if (len <= kPrimaryBits)
+        {
+            uint32_t first = codes[sym] << (kPrimaryBits - len);
+            std::fill_n(primary_table_.begin() + first, 1U << (kPrimaryBits - len), entry);
+        }
+        else
+        {
+            int extra = len - kPrimaryBits;
+            uint32_t prefix = codes[sym] >> extra;
+            uint32_t sub_bits = (primary_table_[prefix] >> 16) & 0xff;
+            uint32_t offset = primary_table_[prefix] & 0xffff;
+            uint32_t first = (codes[sym] & ((1U << extra) - 1)) << (sub_bits - extra);
+            std::fill_n(secondary_tables_.begin() + offset + first, 1U << (sub_bits - extra), entry);
+        }
+    }
 
-    current_bit_code.set(depth, false);
+    return true;
 }
 
-} // namespace anonymous
+void HuffmanStreamDecoder::decodeBits(bool end_of_input)
+{
+    uint8_t out[OUTPUT_BUFFER_SIZE];
+    size_t out_count = 0;
 
-#define INPUT_BUFFER_SLICE_SIZE     512UL
+    while (remaining_symbols_ > 0)
+    {
+        // Refill the bit buffer byte by byte
+        while (bits_count_ <= 56 && input_ptr_ < input_end_)
+        {
+            bit_buffer_ |= static_cast<uint64_t>(*input_ptr_++) << (56 - bits_count_);
+            bits_count_ += 8;
+        }
 
-std::shared_ptr<Data> HuffmanEncode(const std::shared_ptr<Data>& input)
-{
-    PriorityQueue huffman_queue;
-    compute_symbol_frequencies(huffman_queue, input);
+        // A code may be shorter than the longest one at the end of stream,
+        // so it is only required to have enough bits before that.
+        if (bits_count_ < max_length_ && !end_of_input)
+            break;
 
-    // Huffman's algorithm. Code reference from:
-    // Thomas H. Cormen, Charles E. Leiserson, Ronald L. Rivest, Clifford Stein.
-    // Introduction to Algorithms, Third Edition[M]. Cambridge: MIT Press, 2009.pp.428-435
+        uint32_t entry = primary_table_[bit_buffer_ >> (64 - kPrimaryBits)];
+        if (entry & (1U << 31))
+        {
+            uint32_t sub_bits = (entry >> 16) & 0xff;
+            uint64_t sub_index = (bit_buffer_ << kPrimaryBits) >> (64 - sub_bits);
+            entry = secondary_tables_[(entry & 0xffff) + sub_index];
+        }
 
-    while (huffman_queue.size() > 1)
-    {
-        auto r = huffman_queue.top();
-        huffman_queue.pop();
-        auto l = huffman_queue.top();
-        huffman_queue.pop();
+        int len = static_cast<int>((entry >> 16) & 0xff);
+        if (len == 0 || len > bits_count_)
+        {
+            status_ = Status::kCorrupted;
+            break;
+        }
 
-        auto node = std::make_shared<HuffmanNode>(HuffmanNode{
-            .is_leaf_node = false,
-            .freq_count = r->freq_count + l->freq_count,
-            .left_child = r,
-            .right_child = l
-        });
+        out[out_count++] = static_cast<uint8_t>(entry & 0xff);
+        bit_buffer_ <<= len;
+        bits_count_ -= len;
+        remaining_symbols_--;
 
-        huffman_queue.push(node);
+        if (out_count == OUTPUT_BUFFER_SIZE)
+        {
+            output_.writeBytes(out, out_count);
+            out_count = 0;
+        }
     }
 
-    // Generate a huffman code for each symbol by DFS
-    BitCode cvtb[ALPHABET_SIZE];
-    std::bitset<HUFFMAN_MAX_BITS> current_bit_code;
-    generate_code_table(cvtb, huffman_queue.top(), 0, current_bit_code);
+    if (out_count > 0)
+        output_.writeBytes(out, out_count);
 
-    ScalableWriteBuffer write_buffer;
+    if (status_ != Status::kCorrupted && remaining_symbols_ == 0)
+        status_ = Status::kFinished;
+}
 
-    size_t remaining_size = input->size();
-    size_t input_offset = 0;
+HuffmanStreamDecoder::Status HuffmanStreamDecoder::feed(const uint8_t *data, size_t size)
+{
+    if (status_ != Status::kNeedMoreInput)
+        return status_;
 
-    uint8_t bits_buffer = 0;
-    int bit_offset = 0;
+    // Feeding zero bytes marks the end of input
+    bool end_of_input = (size == 0);
 
-    while (remaining_size > 0)
+    // Collect the header first
+    if (header_.size() < kHuffmanHeaderSize)
     {
-        size_t slice_size = std::min(remaining_size, INPUT_BUFFER_SLICE_SIZE);
-        std::shared_ptr<DataSlice> slice = input->slice(input_offset, slice_size);
+        size_t n = std::min(size, kHuffmanHeaderSize - header_.size());
+        header_.insert(header_.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (header_.size() < kHuffmanHeaderSize)
+            return status_;
+
+        remaining_symbols_ = 0;
+        for (int i = 0; i < 8; i++)
+            remaining_symbols_ |= static_cast<uint64_t>(header_[i]) << (i * 8);
+        std::memcpy(lengths_, header_.data() + sizeof(uint64_t), ALPHABET_SIZE);
+
+        if (!buildTables())
+        {
+            status_ = Status::kCorrupted;
+            return status_;
+        }
+    }
 
-        for (size_t i = 0; i < slice_size; i++)
+    input_ptr_ = data;
+    input_end_ = data + size;
+    decodeBits(end_of_input);
+
+    input_ptr_ = input_end_ = nullptr;
+    return status_;
+}
+
+std::shared_ptr<Data> HuffmanEncode(const std::shared_ptr<Data>& input)
+{
+    CHECK(input);
+
+    auto for_each_chunk = [&input](const std::function<void(const uint8_t*, size_t)>& func) {
+        if (input->hasAccessibleBuffer())
+        {
+            func(reinterpret_cast<const uint8_t*>(input->getAccessibleBuffer()), input->size());
+            return;
+        }
+
+        auto buffer = std::make_unique<uint8_t[]>(INPUT_BUFFER_SLICE_SIZE);
+        size_t offset = 0;
+        while (offset < input->size())
         {
-            uint8_t byte = slice->at(i);
-            int bitset_offset = 0;
-
-            while (bitset_offset < cvtb[byte].num_bits)
-            {
-                int write_bits_num = std::min(cvtb[byte].num_bits - bitset_offset, 8);
-                bitset_offset += write_bits_num;
-                // TODO(sora): complete this
-            }
+            ssize_t ret = input->readAt(static_cast<off_t>(offset), buffer.get(),
+                                        std::min(INPUT_BUFFER_SLICE_SIZE, input->size() - offset));
+            if (ret <= 0)
+                break;
+            func(buffer.get(), ret);
+            offset += ret;
         }
+    };
 
-        remaining_size -= slice_size;
-        input_offset += slice_size;
+    HuffmanStreamEncoder::FrequencyTable freqs{};
+    for_each_chunk([&freqs](const uint8_t *ptr, size_t size) {
+        HuffmanStreamEncoder::CountFrequencies(freqs, ptr, size);
+    });
+
+    ScalableWriteBuffer write_buffer;
+    HuffmanStreamEncoder encoder(freqs, write_buffer);
+    for_each_chunk([&encoder](const uint8_t *ptr, size_t size) {
+        encoder.encode(ptr, size);
+    });
+    encoder.finish();
+
+    return write_buffer.finalize();
+}
+
+std::shared_ptr<Data> HuffmanDecode(const std::shared_ptr<Data>& input)
+{
+    CHECK(input);
+
+    ScalableWriteBuffer write_buffer;
+    HuffmanStreamDecoder decoder(write_buffer);
+
+    if (input->hasAccessibleBuffer())
+    {
+        decoder.feed(reinterpret_cast<const uint8_t*>(input->getAccessibleBuffer()), input->size());
+    }
+    else
+    {
+        auto buffer = std::make_unique<uint8_t[]>(INPUT_BUFFER_SLICE_SIZE);
+        size_t offset = 0;
+        while (offset < input->size() &&
+               decoder.status() == HuffmanStreamDecoder::Status::kNeedMoreInput)
+        {
+            ssize_t ret = input->readAt(static_cast<off_t>(offset), buffer.get(),
+                                        std::min(INPUT_BUFFER_SLICE_SIZE, input->size() - offset));
+            if (ret <= 0)
+                return nullptr;
+            decoder.feed(buffer.get(), ret);
+            offset += ret;
+        }
     }
 
+    // Notify the decoder of the end of input
+    if (decoder.feed(nullptr, 0) != HuffmanStreamDecoder::Status::kFinished)
+        return nullptr;
+
     return write_buffer.finalize();
 }
 
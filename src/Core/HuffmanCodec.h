@@ -19,13 +19,114 @@
 #define COCOA_CORE_HUFFMANCODEC_H
 
 #include <memory>
+#include <array>
+#include <vector>
 
+#include "Core/Project.h"
 namespace cocoa {
 
 class Data;
+class ScalableWriteBuffer;
+
+/**
+ * Encoded data consists of a header and a bitstream:
+ *   [u64 LE] Number of symbols (bytes) in the original data
+ *   [u8 x 256] Code length of each symbol, 0 for the absent symbols
+ *   [...] Canonical Huffman codes packed from the most significant bit
+ * Code length is limited to `kHuffmanMaxCodeLength` bits.
+ */
+constexpr int kHuffmanMaxCodeLength = 20;
+constexpr size_t kHuffmanHeaderSize = sizeof(uint64_t) + 256;
 
 std::shared_ptr<Data> HuffmanEncode(const std::shared_ptr<Data>& input);
 
+// Returns nullptr if `input` is corrupted
+std::shared_ptr<Data> HuffmanDecode(const std::shared_ptr<Data>& input);
+
+class HuffmanStreamEncoder
+{
+public:
+    using FrequencyTable = std::array<uint64_t, 256>;
+
+    static void CountFrequencies(FrequencyTable& table, const uint8_t *data, size_t size);
+
+    /**
+     * Construct an encoder from the frequencies of all the symbols
+     * that will be encoded. The header is written into `output` immediately.
+     */
+    HuffmanStreamEncoder(const FrequencyTable& freqs, ScalableWriteBuffer& output);
+
+    void encode(const uint8_t *data, size_t size);
+
+    // Write the remaining bits which are padded with zeros
+    void finish();
+
+private:
+    void flushBytes();
+
+    ScalableWriteBuffer        &output_;
+    uint32_t                    codes_[256];
+    uint8_t                     lengths_[256];
+    uint64_t                    bit_accumulator_;
+    int                         bits_count_;
+    std::vector<uint8_t>        pending_bytes_;
+};
+
+/**
+ * A table-driven decoder which accepts the encoded data chunk by chunk.
+ * The leading `kPrimaryBits` bits of the bitstream index a primary table,
+ * and longer codes are resolved by a secondary table of that prefix,
+ * so every symbol is decoded by at most two lookups.
+ */
+class HuffmanStreamDecoder
+{
+public:
+    constexpr static int kPrimaryBits = 11;
+
+    enum class Status
+    {
+        kNeedMoreInput,
+        kFinished,
+        kCorrupted
+    };
+
+    explicit HuffmanStreamDecoder(ScalableWriteBuffer& output);
+
+    /**
+     * Decode as many symbols as possible from the given chunk.
+     * Feeding zero bytes notifies the decoder of the end of input,
+     * which allows the last codes to be decoded from the padded bits.
+     */
+    Status feed(const uint8_t *data, size_t size);
+
+    g_nodiscard g_inline Status status() const {
+        return status_;
+    }
+
+private:
+    bool buildTables();
+    void decodeBits(bool end_of_input);
+
+    ScalableWriteBuffer        &output_;
+    Status                      status_;
+    std::vector<uint8_t>        header_;
+    uint64_t                    remaining_symbols_;
+    uint8_t                     lengths_[256];
+    int                         max_length_;
+
+    // Entry: bits [0, 16) symbol or offset of secondary table,
+    //        bits [16, 24) code length or bits of secondary table,
+    //        bit 31 indicates a secondary table.
+    std::vector<uint32_t>       primary_table_;
+    std::vector<uint32_t>       secondary_tables_;
+
+    // Left-aligned bit buffer
+    uint64_t                    bit_buffer_;
+    int                         bits_count_;
+    const uint8_t              *input_ptr_;
+    const uint8_t              *input_end_;
+};
+
 } // namespace cocoa
 
 #endif //COCOA_CORE_HUFFMANCODEC_H
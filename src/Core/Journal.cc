@@ -21,6 +21,10 @@
 #include <sstream>
 #include "Core/Errors.h"
 #include <optional>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
 
 #include "fmt/format.h"
 #include "Core/Journal.h"
@@ -247,6 +251,8 @@ struct TranslationContext
 {
     bool enabled;
     std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point timestamp;
+    int32_t tid;
     std::shared_ptr<Decorator> decorator;
     bool enableColor;
 };
@@ -306,7 +312,7 @@ Translator translators[] = {
                 using namespace std::chrono;
                 if (!ctx->enabled)
                     return {};
-                auto duration = duration_cast<microseconds>(steady_clock::now() - ctx->startTime);
+                auto duration = duration_cast<microseconds>(ctx->timestamp - ctx->startTime);
                 double dt = static_cast<double>(duration.count()) *
                             microseconds::period::num / microseconds::period::den;
                 return TranslationResult(fmt::format("[{:12.6f}]", dt));
@@ -409,19 +415,23 @@ Translator translators[] = {
             [](TranslationContext *ctx) -> TranslationResult {
                 if (!ctx->enabled)
                     return {};
-                return TranslationResult(fmt::format("{}", gettid()));
+                return TranslationResult(fmt::format("{}", ctx->tid));
             }
         }
 };
 
 std::string translate_decorators(const std::string_view& origin,
                                  std::chrono::steady_clock::time_point startTime,
+                                 std::chrono::steady_clock::time_point timestamp,
+                                 int32_t tid,
                                  bool color)
 {
     auto tokens = parse_decorators(origin);
     TranslationContext ctx{};
     ctx.enabled = true;
     ctx.startTime = startTime;
+    ctx.timestamp = timestamp;
+    ctx.tid = tid;
     ctx.enableColor = color;
 
     std::ostringstream finalString;
@@ -479,10 +489,145 @@ std::vector<std::string_view> separate_lines(const std::string& str)
     return views;
 }
 
+std::string compose_log_lines(LogType type, const std::string& str,
+                              std::chrono::steady_clock::time_point startTime,
+                              std::chrono::steady_clock::time_point timestamp,
+                              int32_t tid, bool color)
+{
+    const char *levelStr = nullptr;
+    const char *levelColor = nullptr;
+    switch (type)
+    {
+    case LOG_DEBUG:
+        levelStr = "debug";
+        levelColor = "cy";
+        break;
+    case LOG_INFO:
+        levelStr = "info";
+        levelColor = "gr";
+        break;
+    case LOG_WARNING:
+        levelStr = "warn";
+        levelColor = "ye";
+        break;
+    case LOG_EXCEPTION:
+        levelStr = "fatal";
+        levelColor = "re,hl";
+        break;
+    case LOG_ERROR:
+        levelStr = "error";
+        levelColor = "re";
+        break;
+    default:
+        throw std::runtime_error("Unknown log level");
+    }
+
+    std::vector<std::string_view> lineViews = separate_lines(str);
+    std::string finalStr;
+    for (const auto& view : lineViews)
+    {
+        std::string formatted = fmt::format(
+                "%fg<ma>%timestamp%reset %fg<{}>[{}:%tid]%reset {}",
+                levelColor, levelStr, view);
+        finalStr.append(translate_decorators(formatted, startTime, timestamp, tid, color));
+        finalStr.push_back('\n');
+    }
+    return finalStr;
+}
+
+int32_t current_thread_tid()
+{
+    static thread_local int32_t tid = gettid();
+    return tid;
+}
+
+// Number of slots in the ring buffer of each thread
+constexpr size_t kAsyncRingSlots = 256;
+
+// The background thread wakes up with this interval even if nobody notifies it
+constexpr auto kAsyncFlushInterval = std::chrono::milliseconds(20);
+
+} // namespace anonymous
+
+static_assert(sizeof(Journal::AsyncRecord) <= Journal::AsyncRecord::kSlotSize);
+
+namespace {
+
+/**
+ * A single-producer single-consumer lock-free ring buffer. The producer is
+ * the thread which owns the ring buffer, and the consumer is the thread
+ * which is draining records (the background thread or a flushing thread).
+ */
+struct AsyncRing
+{
+    AsyncRing() : head(0), tail(0), abandoned(false) {}
+
+    Journal::AsyncRecord                slots[kAsyncRingSlots];
+    std::atomic<uint64_t>               head;
+    std::atomic<uint64_t>               tail;
+    std::atomic<bool>                   abandoned;
+};
+
+} // namespace anonymous
+
+struct Journal::AsyncContext
+{
+    explicit AsyncContext(OverflowPolicy policy_)
+        : policy(policy_), generation(++next_generation), dropped(0)
+        , pending(false), stop(false), blocked_producers(0) {}
+
+    static std::atomic<uint64_t>        next_generation;
+
+    OverflowPolicy                      policy;
+    uint64_t                            generation;
+    std::atomic<uint64_t>               dropped;
+
+    // Protects `rings`. Producers only acquire it once when registering
+    // the ring buffer of its thread.
+    std::mutex                          rings_lock;
+    std::vector<std::shared_ptr<AsyncRing>> rings;
+
+    // Only one thread can drain the ring buffers at the same time
+    std::mutex                          drain_lock;
+
+    std::mutex                          wakeup_lock;
+    std::condition_variable             wakeup_cond;
+    std::atomic<bool>                   pending;
+    bool                                stop;
+
+    // Producers blocked by `OverflowPolicy::kBlock` sleep on `space_cond`
+    // until the ring buffers are drained.
+    std::mutex                          space_lock;
+    std::condition_variable             space_cond;
+    std::atomic<int32_t>                blocked_producers;
+
+    std::thread                         worker;
+};
+
+std::atomic<uint64_t> Journal::AsyncContext::next_generation(0);
+
+namespace {
+
+struct ThreadLocalRingHolder
+{
+    ~ThreadLocalRingHolder() {
+        // Records in the ring buffer will be drained by the background
+        // thread, then the ring buffer is released.
+        if (ring)
+            ring->abandoned.store(true, std::memory_order_release);
+    }
+
+    uint64_t                    generation = 0;
+    std::shared_ptr<AsyncRing>  ring;
+};
+
+thread_local ThreadLocalRingHolder g_ring_holder;
+
 } // namespace anonymous
 
 Journal::Journal(LogLevel level, OutputDevice output,
-                 bool enableColor, const char *file)
+                 bool enableColor, const char *file,
+                 bool async, OverflowPolicy policy)
     : fEnableColor(enableColor),
       fLevel(level),
       fOutputFd(-1),
@@ -503,11 +648,28 @@ Journal::Journal(LogLevel level, OutputDevice output,
 
     if (fOutputFd < 0)
         throw std::runtime_error("Failed to open log file");
+
+    if (async)
+    {
+        fAsyncContext = std::make_unique<AsyncContext>(policy);
+        fAsyncContext->worker = std::thread(&Journal::asyncWorkerMain, this);
+    }
 }
 
 Journal::~Journal()
 {
-    if (fOutputFd != STDOUT_FILENO && fOutputFd == STDERR_FILENO)
+    if (fAsyncContext)
+    {
+        {
+            std::scoped_lock<std::mutex> lock(fAsyncContext->wakeup_lock);
+            fAsyncContext->stop = true;
+        }
+        fAsyncContext->wakeup_cond.notify_one();
+        fAsyncContext->worker.join();
+        fAsyncContext.reset();
+    }
+
+    if (fOutputFd != STDOUT_FILENO && fOutputFd != STDERR_FILENO)
         vfs::Close(fOutputFd);
 }
 
@@ -518,43 +680,162 @@ bool Journal::filter(LogType type)
 
 void Journal::commit(LogType type, const std::string& str)
 {
-    const char *levelStr = nullptr;
-    const char *levelColor = nullptr;
-    switch (type)
+    std::string finalStr = compose_log_lines(type, str, fStartTime,
+                                             std::chrono::steady_clock::now(),
+                                             current_thread_tid(), fEnableColor);
+
+    std::scoped_lock<std::mutex> lock(fWriteMutex);
+    vfs::Write(fOutputFd, finalStr.c_str(), finalStr.length());
+}
+
+Journal::AsyncRecord *Journal::acquireAsyncSlot()
+{
+    AsyncContext *ctx = fAsyncContext.get();
+    ThreadLocalRingHolder& holder = g_ring_holder;
+    if (!holder.ring || holder.generation != ctx->generation)
     {
-    case LOG_DEBUG:
-        levelStr = "debug";
-        levelColor = "cy";
-        break;
-    case LOG_INFO:
-        levelStr = "info";
-        levelColor = "gr";
-        break;
-    case LOG_WARNING:
-        levelStr = "warn";
-        levelColor = "ye";
-        break;
-    case LOG_EXCEPTION:
-        levelStr = "fatal";
-        levelColor = "re,hl";
-        break;
-    case LOG_ERROR:
-        levelStr = "error";
-        levelColor = "re";
-        break;
-    default:
-        throw std::runtime_error("Unknown log level");
+        holder.ring = std::make_shared<AsyncRing>();
+        holder.generation = ctx->generation;
+        std::scoped_lock<std::mutex> lock(ctx->rings_lock);
+        ctx->rings.push_back(holder.ring);
     }
 
-    std::vector<std::string_view> lineViews = separate_lines(str);
+    AsyncRing *ring = holder.ring.get();
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (tail - ring->head.load(std::memory_order_acquire) >= kAsyncRingSlots)
+    {
+        if (ctx->policy == OverflowPolicy::kDrop)
+        {
+            ctx->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Wake up the background thread and sleep until it has consumed
+        // some records. The timeout is only a safety net.
+        ctx->blocked_producers.fetch_add(1, std::memory_order_acq_rel);
+        ctx->pending.store(true, std::memory_order_release);
+        ctx->wakeup_cond.notify_one();
+        {
+            std::unique_lock<std::mutex> lock(ctx->space_lock);
+            ctx->space_cond.wait_for(lock, kAsyncFlushInterval, [ring, tail] {
+                return tail - ring->head.load(std::memory_order_acquire) < kAsyncRingSlots;
+            });
+        }
+        ctx->blocked_producers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    return &ring->slots[tail % kAsyncRingSlots];
+}
+
+void Journal::publishAsyncSlot(AsyncRecord *record)
+{
+    record->timestamp = std::chrono::steady_clock::now();
+    record->tid = current_thread_tid();
+
+    AsyncRing *ring = g_ring_holder.ring.get();
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed) + 1;
+    ring->tail.store(tail, std::memory_order_release);
+
+    // Wake up the background thread earlier if the ring buffer is
+    // going to be full.
+    if (tail - ring->head.load(std::memory_order_relaxed) >= kAsyncRingSlots / 2)
+    {
+        fAsyncContext->pending.store(true, std::memory_order_release);
+        fAsyncContext->wakeup_cond.notify_one();
+    }
+}
+
+void Journal::asyncWorkerMain()
+{
+    pthread_setname_np(pthread_self(), "JournalWriter");
+
+    AsyncContext *ctx = fAsyncContext.get();
+    bool stop = false;
+    while (!stop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(ctx->wakeup_lock);
+            ctx->wakeup_cond.wait_for(lock, kAsyncFlushInterval, [ctx] {
+                return ctx->stop || ctx->pending.exchange(false, std::memory_order_acq_rel);
+            });
+            stop = ctx->stop;
+        }
+        drainAsyncRecords();
+    }
+}
+
+void Journal::flush()
+{
+    if (fAsyncContext)
+        drainAsyncRecords();
+}
+
+void Journal::drainAsyncRecords()
+{
+    AsyncContext *ctx = fAsyncContext.get();
+    std::scoped_lock<std::mutex> drain_lock(ctx->drain_lock);
+
+    std::vector<std::shared_ptr<AsyncRing>> rings;
+    {
+        std::scoped_lock<std::mutex> lock(ctx->rings_lock);
+        // Rings which have been abandoned by their threads and drained
+        // completely can be released now.
+        ctx->rings.erase(std::remove_if(ctx->rings.begin(), ctx->rings.end(),
+                                        [](const std::shared_ptr<AsyncRing>& ring) {
+            return ring->abandoned.load(std::memory_order_acquire) &&
+                   ring->head.load(std::memory_order_relaxed) ==
+                   ring->tail.load(std::memory_order_acquire);
+        }), ctx->rings.end());
+        rings = ctx->rings;
+    }
+
+    using Line = std::pair<std::chrono::steady_clock::time_point, std::string>;
+    std::vector<Line> lines;
+    for (const auto& ring : rings)
+    {
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head < tail; head++)
+        {
+            const AsyncRecord& record = ring->slots[head % kAsyncRingSlots];
+            std::string str = record.format_func(
+                    fmt::string_view(record.format_str, record.format_len), record.payload);
+            lines.emplace_back(record.timestamp,
+                               compose_log_lines(record.type, str, fStartTime,
+                                                 record.timestamp, record.tid, fEnableColor));
+        }
+        // Slots are reusable by the producer since now
+        ring->head.store(head, std::memory_order_release);
+    }
+
+    if (ctx->blocked_producers.load(std::memory_order_acquire) > 0)
+    {
+        // Taking the lock makes sure that a producer which is about to
+        // sleep has either seen the new heads or is notified.
+        std::scoped_lock<std::mutex> lock(ctx->space_lock);
+        ctx->space_cond.notify_all();
+    }
+
+    uint64_t dropped = ctx->dropped.exchange(0, std::memory_order_relaxed);
+    if (lines.empty() && dropped == 0)
+        return;
+
+    // Records from different threads are interleaved by their timestamps
+    std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+        return a.first < b.first;
+    });
+
     std::string finalStr;
-    for (const auto& view : lineViews)
+    for (const auto& line : lines)
+        finalStr.append(line.second);
+
+    if (dropped > 0)
     {
-        std::string formatted = fmt::format(
-                "%fg<ma>%timestamp%reset %fg<{}>[{}:%tid]%reset {}",
-                levelColor, levelStr, view);
-        finalStr.append(translate_decorators(formatted, fStartTime, fEnableColor));
-        finalStr.push_back('\n');
+        finalStr.append(compose_log_lines(LOG_WARNING,
+                                          fmt::format("{} log record(s) were dropped as the ring buffer is full",
+                                                      dropped),
+                                          fStartTime, std::chrono::steady_clock::now(),
+                                          current_thread_tid(), fEnableColor));
     }
 
     std::scoped_lock<std::mutex> lock(fWriteMutex);
@@ -22,6 +22,10 @@
 #include <mutex>
 #include <string>
 #include <chrono>
+#include <memory>
+#include <tuple>
+#include <cstring>
+#include <type_traits>
 #endif /* COCOA_JOURNAL_DISABLED */
 
 #include "fmt/format.h"
@@ -54,6 +58,103 @@ enum LogLevel
     LOG_LEVEL_DISABLED  = 0x0000
 };
 
+namespace detail {
+
+/**
+ * Arguments of an asynchronous log record are packed into a compact binary
+ * form. Arithmetic values, enumerations and raw pointers (formatted as
+ * addresses) are copied bitwise, strings are copied with their lengths, and
+ * other values are formatted eagerly into strings. Other trivially copyable
+ * types are not copied bitwise, as they may refer to memory (like
+ * `fmt::join_view` or a struct holding a `char*`) which no longer exists
+ * when the record is formatted by the background thread.
+ * Both of the latter two are decoded as `std::string_view` which refer to
+ * the record itself.
+ */
+template<typename T>
+struct JournalArgTraits
+{
+    using Decayed = std::decay_t<T>;
+    constexpr static bool kIsString = std::is_convertible_v<const Decayed&, std::string_view>;
+    constexpr static bool kIsTrivial = !kIsString && (std::is_arithmetic_v<Decayed> ||
+                                                      std::is_enum_v<Decayed> ||
+                                                      std::is_pointer_v<Decayed>);
+    using Decoded = std::conditional_t<kIsTrivial, Decayed, std::string_view>;
+};
+
+inline bool EncodeJournalString(uint8_t *& cur, uint8_t *end, std::string_view str)
+{
+    auto length = static_cast<uint32_t>(str.length());
+    if (end - cur < static_cast<ptrdiff_t>(sizeof(uint32_t) + length))
+        return false;
+    std::memcpy(cur, &length, sizeof(uint32_t));
+    std::memcpy(cur + sizeof(uint32_t), str.data(), length);
+    cur += sizeof(uint32_t) + length;
+    return true;
+}
+
+template<typename T>
+bool EncodeJournalArg(uint8_t *& cur, uint8_t *end, const T& value)
+{
+    using Traits = JournalArgTraits<T>;
+    if constexpr (Traits::kIsTrivial)
+    {
+        if (end - cur < static_cast<ptrdiff_t>(sizeof(typename Traits::Decayed)))
+            return false;
+        std::memcpy(cur, &value, sizeof(typename Traits::Decayed));
+        cur += sizeof(typename Traits::Decayed);
+        return true;
+    }
+    else if constexpr (Traits::kIsString)
+        return EncodeJournalString(cur, end, std::string_view(value));
+    else
+        return EncodeJournalString(cur, end, fmt::format("{}", value));
+}
+
+template<typename T>
+typename JournalArgTraits<T>::Decoded DecodeJournalArg(const uint8_t *& cur)
+{
+    using Traits = JournalArgTraits<T>;
+    if constexpr (Traits::kIsTrivial)
+    {
+        typename Traits::Decayed value;
+        std::memcpy(&value, cur, sizeof(value));
+        cur += sizeof(value);
+        return value;
+    }
+    else
+    {
+        uint32_t length;
+        std::memcpy(&length, cur, sizeof(uint32_t));
+        std::string_view str(reinterpret_cast<const char*>(cur + sizeof(uint32_t)), length);
+        cur += sizeof(uint32_t) + length;
+        return str;
+    }
+}
+
+template<typename...ArgsT>
+std::string FormatJournalRecord(fmt::string_view format, const uint8_t *payload)
+{
+    // Elements in a braced initializer list are evaluated in order
+    std::tuple<typename JournalArgTraits<ArgsT>::Decoded...> args{
+        DecodeJournalArg<ArgsT>(payload)...
+    };
+    try
+    {
+        return std::apply([format](auto&...unpacked) {
+            return fmt::vformat(format, fmt::make_format_args(unpacked...));
+        }, args);
+    }
+    catch (const fmt::format_error& e)
+    {
+        // Records are formatted by the background thread, where an
+        // escaped exception would terminate the process.
+        return fmt::format("<malformed record \"{}\": {}>", format, e.what());
+    }
+}
+
+} // namespace detail
+
 class Journal : public UniquePersistent<Journal>
 {
 public:
@@ -64,18 +165,95 @@ public:
         kFile
     };
 
-    Journal(LogLevel level, OutputDevice output, bool enableColor, char const *file = nullptr);
+    // What to do when the ring buffer of a thread is full in async mode
+    enum class OverflowPolicy
+    {
+        // Discard the record and report the number of dropped records later
+        kDrop,
+        // Wait until the background thread consumes some records
+        kBlock
+    };
+
+    struct AsyncRecord
+    {
+        constexpr static size_t kSlotSize = 512;
+
+        using FormatFunc = std::string(*)(fmt::string_view, const uint8_t*);
+
+        FormatFunc                              format_func;
+        const char                             *format_str;
+        size_t                                  format_len;
+        std::chrono::steady_clock::time_point   timestamp;
+        int32_t                                 tid;
+        LogType                                 type;
+        uint8_t                                 payload[kSlotSize - 48];
+    };
+
+    struct AsyncContext;
+
+    Journal(LogLevel level, OutputDevice output, bool enableColor, char const *file = nullptr,
+            bool async = false, OverflowPolicy policy = OverflowPolicy::kDrop);
     ~Journal();
 
+    /**
+     * In async mode, the calling thread only packs the format string pointer
+     * and the arguments into its own ring buffer, and a background thread
+     * formats and writes them. The format string must have static storage
+     * duration, which is always true for `QLOG`.
+     * Exception records are always written synchronously after all the
+     * pending records are flushed, so they cannot be lost if the process
+     * aborts later. Records which are too large for a ring buffer slot are
+     * also written synchronously after a flush, so that they never overtake
+     * the records logged before them.
+     */
     template<typename...ArgsT>
     void operator()(LogType type, fmt::format_string<ArgsT...> format, ArgsT&&...args)
     {
         if (!this->filter(type))
             return;
+        if (fAsyncContext)
+        {
+            if (type != LOG_EXCEPTION && this->pushAsyncRecord<ArgsT...>(type, format, args...))
+                return;
+            this->flush();
+        }
         this->commit(type, fmt::format(format, std::forward<ArgsT>(args)...));
     }
 
+    /**
+     * Write all the pending records in ring buffers in async mode.
+     * It does nothing in sync mode.
+     */
+    void flush();
+
 private:
+    template<typename...ArgsT>
+    bool pushAsyncRecord(LogType type, fmt::format_string<ArgsT...> format, const ArgsT&...args)
+    {
+        AsyncRecord *record = this->acquireAsyncSlot();
+        // Dropped by the overflow policy
+        if (!record)
+            return true;
+
+        uint8_t *cur = record->payload;
+        uint8_t *end = record->payload + sizeof(record->payload);
+        if (!(detail::EncodeJournalArg(cur, end, args) && ...))
+            return false;
+
+        fmt::string_view format_view = format;
+        record->format_func = &detail::FormatJournalRecord<ArgsT...>;
+        record->format_str = format_view.data();
+        record->format_len = format_view.size();
+        record->type = type;
+        this->publishAsyncSlot(record);
+        return true;
+    }
+
+    AsyncRecord *acquireAsyncSlot();
+    void publishAsyncSlot(AsyncRecord *record);
+    void asyncWorkerMain();
+    void drainAsyncRecords();
+
     void commit(LogType type, const std::string& str);
     bool filter(LogType type);
 
@@ -84,6 +262,7 @@ private:
     LogLevel                                fLevel;
     int                                     fOutputFd;
     std::chrono::steady_clock::time_point   fStartTime;
+    std::unique_ptr<AsyncContext>           fAsyncContext;
 };
 
 #define QLOG(level, fmt, ...)                                                       \
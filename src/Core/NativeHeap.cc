@@ -0,0 +1,201 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+
+#include "fmt/format.h"
+
+#if defined(COCOA_USE_JEMALLOC)
+#include "jemalloc/jemalloc.h"
+#endif
+
+#include "Core/TraceEvent.h"
+#include "Core/NativeHeap.h"
+namespace cocoa {
+
+#if defined(COCOA_USE_JEMALLOC)
+
+namespace {
+
+template<typename T>
+bool read_mallctl(const char *name, T *out)
+{
+    size_t size = sizeof(T);
+    return mallctl(name, out, &size, nullptr, 0) == 0;
+}
+
+template<typename T>
+T read_mallctl_or_zero(const std::string& name)
+{
+    T value{};
+    if (!read_mallctl(name.c_str(), &value))
+        return T{};
+    return value;
+}
+
+template<typename T>
+bool write_mallctl(const char *name, T value)
+{
+    return mallctl(name, nullptr, nullptr, &value, sizeof(T)) == 0;
+}
+
+// Statistics are cached by jemalloc, and refreshed when the epoch is updated
+void refresh_stats_epoch()
+{
+    uint64_t epoch = 1;
+    size_t size = sizeof(epoch);
+    mallctl("epoch", &epoch, &size, &epoch, size);
+}
+
+} // namespace anonymous
+
+bool NativeHeap::IsAvailable()
+{
+    const char *version = nullptr;
+    return read_mallctl("version", &version);
+}
+
+std::optional<NativeHeap::Stats> NativeHeap::Collect(bool per_arena)
+{
+    refresh_stats_epoch();
+
+    Stats stats{};
+    if (!read_mallctl("stats.allocated", &stats.allocated))
+        return std::nullopt;
+    read_mallctl("stats.active", &stats.active);
+    read_mallctl("stats.resident", &stats.resident);
+    read_mallctl("stats.mapped", &stats.mapped);
+    read_mallctl("stats.metadata", &stats.metadata);
+    read_mallctl("stats.retained", &stats.retained);
+    read_mallctl("thread.allocated", &stats.thread_allocated);
+    read_mallctl("thread.deallocated", &stats.thread_deallocated);
+
+    // Merged statistics of all the arenas
+    stats.tcache_bytes = read_mallctl_or_zero<size_t>(
+            fmt::format("stats.arenas.{}.tcache_bytes", MALLCTL_ARENAS_ALL));
+
+    if (!per_arena)
+        return stats;
+
+    size_t page_size = 0;
+    uint32_t narenas = 0;
+    read_mallctl("arenas.page", &page_size);
+    read_mallctl("arenas.narenas", &narenas);
+
+    for (uint32_t i = 0; i < narenas; i++)
+    {
+        // Arenas which have not been initialized have no statistics
+        bool initialized = false;
+        if (!read_mallctl(fmt::format("arena.{}.initialized", i).c_str(), &initialized) ||
+            !initialized)
+        {
+            continue;
+        }
+
+        auto prefix = fmt::format("stats.arenas.{}.", i);
+        ArenaStats& arena = stats.arenas.emplace_back();
+        arena.index = i;
+        arena.threads = read_mallctl_or_zero<uint32_t>(prefix + "nthreads");
+        arena.active_bytes = read_mallctl_or_zero<size_t>(prefix + "pactive") * page_size;
+        arena.dirty_bytes = read_mallctl_or_zero<size_t>(prefix + "pdirty") * page_size;
+        arena.muzzy_bytes = read_mallctl_or_zero<size_t>(prefix + "pmuzzy") * page_size;
+        arena.small_allocated_bytes = read_mallctl_or_zero<size_t>(prefix + "small.allocated");
+        arena.large_allocated_bytes = read_mallctl_or_zero<size_t>(prefix + "large.allocated");
+        arena.tcache_bytes = read_mallctl_or_zero<size_t>(prefix + "tcache_bytes");
+    }
+
+    return stats;
+}
+
+bool NativeHeap::Purge()
+{
+    // Flush the thread cache of the calling thread first, so that the cached
+    // objects can be returned to arenas and then purged.
+    mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+
+    auto name = fmt::format("arena.{}.purge", MALLCTL_ARENAS_ALL);
+    return mallctl(name.c_str(), nullptr, nullptr, nullptr, 0) == 0;
+}
+
+bool NativeHeap::SetDecayTime(ssize_t dirty_decay_ms, ssize_t muzzy_decay_ms)
+{
+    // Defaults for the arenas created in the future
+    if (!write_mallctl("arenas.dirty_decay_ms", dirty_decay_ms) ||
+        !write_mallctl("arenas.muzzy_decay_ms", muzzy_decay_ms))
+    {
+        return false;
+    }
+
+    uint32_t narenas = 0;
+    read_mallctl("arenas.narenas", &narenas);
+    for (uint32_t i = 0; i < narenas; i++)
+    {
+        bool initialized = false;
+        if (!read_mallctl(fmt::format("arena.{}.initialized", i).c_str(), &initialized) ||
+            !initialized)
+        {
+            continue;
+        }
+        write_mallctl(fmt::format("arena.{}.dirty_decay_ms", i).c_str(), dirty_decay_ms);
+        write_mallctl(fmt::format("arena.{}.muzzy_decay_ms", i).c_str(), muzzy_decay_ms);
+    }
+    return true;
+}
+
+#else
+
+bool NativeHeap::IsAvailable()
+{
+    return false;
+}
+
+std::optional<NativeHeap::Stats> NativeHeap::Collect(g_maybe_unused bool per_arena)
+{
+    return std::nullopt;
+}
+
+bool NativeHeap::Purge()
+{
+    return false;
+}
+
+bool NativeHeap::SetDecayTime(g_maybe_unused ssize_t dirty_decay_ms,
+                              g_maybe_unused ssize_t muzzy_decay_ms)
+{
+    return false;
+}
+
+#endif // COCOA_USE_JEMALLOC
+
+void NativeHeap::TraceCounters()
+{
+    if (!TRACE_EVENT_CATEGORY_ENABLED("memory"))
+        return;
+
+    std::optional<Stats> stats = Collect(false);
+    if (!stats)
+        return;
+
+    TRACE_COUNTER("memory", "NativeHeap.Allocated", stats->allocated);
+    TRACE_COUNTER("memory", "NativeHeap.Active", stats->active);
+    TRACE_COUNTER("memory", "NativeHeap.Resident", stats->resident);
+    TRACE_COUNTER("memory", "NativeHeap.Mapped", stats->mapped);
+    TRACE_COUNTER("memory", "NativeHeap.TCacheBytes", stats->tcache_bytes);
+}
+
+} // namespace cocoa
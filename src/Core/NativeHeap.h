@@ -0,0 +1,106 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_CORE_NATIVEHEAP_H
+#define COCOA_CORE_NATIVEHEAP_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <sys/types.h>
+
+#include "Core/Project.h"
+namespace cocoa {
+
+/**
+ * Statistics and controls of the native heap (jemalloc), which is
+ * invisible to V8 heap snapshots. Memory allocated by Skia, FFmpeg and
+ * other native libraries is accounted here.
+ *
+ * All the methods are available only when the process is linked with
+ * jemalloc (not in sanitizer builds); otherwise, `IsAvailable` returns
+ * false and the other methods fail gracefully.
+ */
+class NativeHeap
+{
+public:
+    struct ArenaStats
+    {
+        uint32_t index;
+        uint32_t threads;
+        // Bytes in active pages
+        size_t active_bytes;
+        // Bytes in unused dirty (and muzzy) pages, which can be purged
+        size_t dirty_bytes;
+        size_t muzzy_bytes;
+        size_t small_allocated_bytes;
+        size_t large_allocated_bytes;
+        // Bytes cached by the thread caches associated with this arena
+        size_t tcache_bytes;
+    };
+
+    struct Stats
+    {
+        // Bytes allocated by the application
+        size_t allocated;
+        // Bytes in active pages, a multiple of the page size
+        size_t active;
+        // Bytes in physically resident data pages mapped by the allocator
+        size_t resident;
+        size_t mapped;
+        size_t metadata;
+        size_t retained;
+        // Bytes cached by all the thread caches
+        size_t tcache_bytes;
+        // Counters of the calling thread
+        uint64_t thread_allocated;
+        uint64_t thread_deallocated;
+        // Empty unless requested
+        std::vector<ArenaStats> arenas;
+    };
+
+    g_nodiscard static bool IsAvailable();
+
+    /**
+     * Refresh and collect the statistics.
+     * Collecting per-arena statistics is much more expensive.
+     */
+    g_nodiscard static std::optional<Stats> Collect(bool per_arena);
+
+    /**
+     * Return unused dirty pages of all the arenas to the operating
+     * system immediately, typically after a scene transition.
+     */
+    static bool Purge();
+
+    /**
+     * Set how long (in milliseconds) unused dirty/muzzy pages are kept before
+     * they are returned to the operating system. 0 means purging immediately,
+     * and -1 means never purging. Existing arenas and the arenas created
+     * in the future are both affected.
+     */
+    static bool SetDecayTime(ssize_t dirty_decay_ms, ssize_t muzzy_decay_ms);
+
+    /**
+     * Emit the main statistics as Perfetto counters (category "memory").
+     */
+    static void TraceCounters();
+};
+
+} // namespace cocoa
+#endif //COCOA_CORE_NATIVEHEAP_H
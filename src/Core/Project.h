@@ -69,5 +69,6 @@
 // Environment variables to control the behaviour of Cocoa
 #define ENV_GL_XCURSOR_THEME        "XCURSOR_THEME"
 #define ENV_GL_XCURSOR_SIZE         "XCURSOR_SIZE"
+#define ENV_CPU_DISPATCH_TIER       "COCOA_CPU_TIER"
 
 #endif // COCOA_CORE_PROJECT_H
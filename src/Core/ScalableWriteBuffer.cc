@@ -16,85 +16,234 @@
  */
 
 #include <cstring>
+#include <cerrno>
+#include <algorithm>
 
 #include "Core/Errors.h"
+#include "Core/Exception.h"
 #include "Core/ScalableWriteBuffer.h"
 #include "Core/Data.h"
 namespace cocoa {
 
-ScalableWriteBuffer::ScalableWriteBuffer(size_t cache_size)
-    : buffer_start_ptr_(nullptr)
-    , cache_start_ptr_(nullptr)
-    , offset_in_cache_(0)
-    , offset_in_buffer_(0)
-    , cache_size_(cache_size)
-{
-    CHECK(cache_size_ > 0 && "Invalid size of cache memory");
-    cache_start_ptr_ = reinterpret_cast<uint8_t*>(malloc(cache_size_));
-    CHECK(cache_start_ptr_ && "Cache allocation failed");
-}
+namespace {
 
-ScalableWriteBuffer::~ScalableWriteBuffer()
-{
-    if (cache_start_ptr_)
-        free(cache_start_ptr_);
-    if (buffer_start_ptr_)
-        free(buffer_start_ptr_);
-}
+// Same as `IOV_MAX` on Linux
+constexpr int32_t kMaxIOVecCount = 1024;
+
+class ChunkedDataSlice;
 
-void ScalableWriteBuffer::syncAndResetCacheContents()
+class ChunkedData : public Data
 {
-    if (offset_in_cache_ == 0)
-        return;
+public:
+    using Chunk = ScalableWriteBuffer::Chunk;
 
-    if (!buffer_start_ptr_)
+    ChunkedData(std::vector<Chunk> chunks, size_t size)
+        : chunks_(std::move(chunks)), size_(size), cursor_(0)
     {
-        // Buffer has not been allocated yet.
-        buffer_start_ptr_ = reinterpret_cast<uint8_t*>(malloc(offset_in_cache_));
-        CHECK(buffer_start_ptr_ && "Buffer allocation failed");
+        size_t offset = 0;
+        for (const Chunk& chunk : chunks_)
+        {
+            chunk_offsets_.push_back(offset);
+            offset += chunk.used;
+        }
     }
-    else
-    {
-        // Buffer has been allocated, then reallocate it with
-        // a proper size.
-        size_t new_size = offset_in_buffer_ + offset_in_cache_;
-        buffer_start_ptr_ = reinterpret_cast<uint8_t*>(realloc(buffer_start_ptr_, new_size));
-        CHECK(buffer_start_ptr_ && "Buffer reallocation failed");
+
+    ~ChunkedData() override {
+        for (const Chunk& chunk : chunks_)
+            std::free(chunk.ptr);
+    }
+
+    size_t size() override {
+        return size_;
+    }
+
+    off_t tell() override {
+        return static_cast<off_t>(cursor_);
+    }
+
+    off_t seek(vfs::SeekWhence whence, off_t offset) override {
+        off_t pos = 0;
+        switch (whence)
+        {
+        case vfs::SeekWhence::kSet:
+            pos = offset;
+            break;
+        case vfs::SeekWhence::kCurrent:
+            pos = static_cast<off_t>(cursor_) + offset;
+            break;
+        case vfs::SeekWhence::kEnd:
+            pos = static_cast<off_t>(size_) + offset;
+            break;
+        }
+        if (pos < 0 || static_cast<size_t>(pos) > size_)
+            throw RuntimeException(__func__, "Invalid offset");
+        cursor_ = static_cast<size_t>(pos);
+        return pos;
+    }
+
+    ssize_t read(void *buffer, size_t size) override {
+        ssize_t ret = this->readAt(static_cast<off_t>(cursor_), buffer, size);
+        if (ret > 0)
+            cursor_ += ret;
+        return ret;
+    }
+
+    ssize_t write(const void *buffer, size_t size) override {
+        throw RuntimeException(__func__, "Chunked data is readonly");
+    }
+
+    ssize_t readAt(off_t offset, void *buffer, size_t size) override {
+        if (offset < 0 || static_cast<size_t>(offset) > size_)
+            return -1;
+        size = std::min(size, size_ - static_cast<size_t>(offset));
+
+        auto *dst = reinterpret_cast<uint8_t*>(buffer);
+        size_t pos = static_cast<size_t>(offset);
+        size_t remaining = size;
+        for (size_t idx = locateChunk(pos); remaining > 0 && idx < chunks_.size(); idx++)
+        {
+            size_t in_chunk = pos - chunk_offsets_[idx];
+            size_t n = std::min(remaining, chunks_[idx].used - in_chunk);
+            std::memcpy(dst, chunks_[idx].ptr + in_chunk, n);
+            dst += n;
+            pos += n;
+            remaining -= n;
+        }
+        return static_cast<ssize_t>(size - remaining);
+    }
+
+    ssize_t readv(const vfs::IOVec *vecs, int32_t count) override {
+        ssize_t total = 0;
+        for (int32_t i = 0; i < count; i++)
+        {
+            ssize_t ret = this->read(vecs[i].base, vecs[i].length);
+            if (ret < 0)
+                return total > 0 ? total : ret;
+            total += ret;
+            if (static_cast<size_t>(ret) < vecs[i].length)
+                break;
+        }
+        return total;
+    }
+
+    bool hasAccessibleBuffer() override {
+        return (chunks_.size() == 1);
+    }
+
+    const void *getAccessibleBuffer() override {
+        return (chunks_.size() == 1) ? chunks_[0].ptr : nullptr;
+    }
+
+    void *takeBufferOwnership() override {
+        if (chunks_.size() != 1)
+            return nullptr;
+        void *ptr = chunks_[0].ptr;
+        // The buffer belongs to the caller now, so this object is empty
+        chunks_.clear();
+        chunk_offsets_.clear();
+        size_ = 0;
+        cursor_ = 0;
+        return ptr;
+    }
+
+    std::shared_ptr<DataSlice> slice(size_t offset, size_t size) override;
+
+    g_nodiscard uint8_t byteAt(size_t offset) const {
+        size_t idx = locateChunk(offset);
+        CHECK(idx < chunks_.size());
+        return chunks_[idx].ptr[offset - chunk_offsets_[idx]];
+    }
+
+private:
+    g_nodiscard size_t locateChunk(size_t offset) const {
+        // The last chunk whose starting offset is not greater than `offset`
+        auto itr = std::upper_bound(chunk_offsets_.begin(), chunk_offsets_.end(), offset);
+        return std::distance(chunk_offsets_.begin(), itr) - 1;
+    }
+
+    std::vector<Chunk>      chunks_;
+    std::vector<size_t>     chunk_offsets_;
+    size_t                  size_;
+    size_t                  cursor_;
+};
+
+class ChunkedDataSlice : public DataSlice
+{
+public:
+    ChunkedDataSlice(const std::shared_ptr<Data>& owned_data,
+                     ChunkedData *chunked, size_t offset, size_t size)
+        : DataSlice(owned_data), chunked_(chunked), offset_(offset), size_(size) {}
+    ~ChunkedDataSlice() override = default;
+
+    g_nodiscard size_t size() const override {
+        return size_;
+    }
+
+    g_nodiscard uint8_t at(size_t index) const override {
+        CHECK(index < size_ && "Index is out of range");
+        return chunked_->byteAt(offset_ + index);
     }
 
-    // Copy data and reset cache
-    std::memcpy(buffer_start_ptr_ + offset_in_buffer_, cache_start_ptr_, cache_size_);
-    offset_in_buffer_ += offset_in_cache_;
-    offset_in_cache_ = 0;
+private:
+    ChunkedData     *chunked_;
+    size_t           offset_;
+    size_t           size_;
+};
+
+std::shared_ptr<DataSlice> ChunkedData::slice(size_t offset, size_t size)
+{
+    CHECK(offset + size <= size_ && "Offset and size are out of range");
+    return std::make_shared<ChunkedDataSlice>(shared_from_this(), this, offset, size);
+}
+
+} // namespace anonymous
+
+ScalableWriteBuffer::ScalableWriteBuffer(size_t initial_chunk_size)
+    : next_chunk_size_(initial_chunk_size)
+    , total_size_(0)
+    , finalized_(false)
+{
+    CHECK(initial_chunk_size > 0 && "Invalid size of chunk");
+}
+
+ScalableWriteBuffer::~ScalableWriteBuffer()
+{
+    for (const Chunk& chunk : chunks_)
+        std::free(chunk.ptr);
+}
+
+void ScalableWriteBuffer::appendChunk()
+{
+    auto *ptr = reinterpret_cast<uint8_t*>(std::malloc(next_chunk_size_));
+    CHECK(ptr && "Chunk allocation failed");
+    chunks_.emplace_back(Chunk{ptr, next_chunk_size_, 0});
+    next_chunk_size_ = std::min(next_chunk_size_ * 2, kMaxChunkSize);
 }
 
 void ScalableWriteBuffer::writeBytes(const uint8_t *src, size_t size)
 {
-    CHECK(cache_start_ptr_ && "Operating on finalized scalable buffer");
+    CHECK(!finalized_ && "Operating on finalized scalable buffer");
 
     while (size > 0)
     {
-        size_t cache_remaining_size = cache_size_ - offset_in_cache_;
+        if (chunks_.empty() || chunks_.back().used == chunks_.back().capacity)
+            appendChunk();
 
-        size_t once_write_size = std::min(size, cache_remaining_size);
-        std::memcpy(cache_start_ptr_ + offset_in_cache_, src, once_write_size);
-        offset_in_cache_ += once_write_size;
+        Chunk& chunk = chunks_.back();
+        size_t once_write_size = std::min(size, chunk.capacity - chunk.used);
+        std::memcpy(chunk.ptr + chunk.used, src, once_write_size);
+        chunk.used += once_write_size;
+        total_size_ += once_write_size;
 
         size -= once_write_size;
         src += once_write_size;
-
-        if (offset_in_cache_ == cache_size_)
-        {
-            // This will make `offset_in_cache_ = 0`
-            syncAndResetCacheContents();
-        }
     }
 }
 
 void ScalableWriteBuffer::writeBytes(const std::shared_ptr<Data>& src, size_t size)
 {
     CHECK(size <= src->size() && "Specified data size is out of range");
-    CHECK(cache_start_ptr_ && "Operating on finalized scalable buffer");
+    CHECK(!finalized_ && "Operating on finalized scalable buffer");
 
     if (src->hasAccessibleBuffer())
     {
@@ -104,36 +253,127 @@ void ScalableWriteBuffer::writeBytes(const std::shared_ptr<Data>& src, size_t si
 
     while (size > 0)
     {
-        size_t cache_remaining_size = cache_size_ - offset_in_cache_;
+        if (chunks_.empty() || chunks_.back().used == chunks_.back().capacity)
+            appendChunk();
 
-        size_t once_write_size = std::min(size, cache_remaining_size);
-        src->read(cache_start_ptr_ + offset_in_cache_, once_write_size);
-        offset_in_cache_ += once_write_size;
+        // Read into the tail of chunk directly without an intermediate buffer
+        Chunk& chunk = chunks_.back();
+        size_t once_write_size = std::min(size, chunk.capacity - chunk.used);
+        ssize_t read_size = src->read(chunk.ptr + chunk.used, once_write_size);
+        if (read_size <= 0)
+            break;
+        chunk.used += read_size;
+        total_size_ += read_size;
 
-        size -= once_write_size;
+        size -= read_size;
+    }
+}
 
-        if (offset_in_cache_ == cache_size_)
+void ScalableWriteBuffer::forEachChunk(const ChunkVisitor& visitor) const
+{
+    CHECK(visitor);
+    for (const Chunk& chunk : chunks_)
+    {
+        if (chunk.used > 0)
+            visitor(chunk.ptr, chunk.used);
+    }
+}
+
+ssize_t ScalableWriteBuffer::writeToFile(int32_t fd) const
+{
+    std::vector<vfs::IOVec> vecs;
+    vecs.reserve(chunks_.size());
+    for (const Chunk& chunk : chunks_)
+    {
+        if (chunk.used > 0)
+            vecs.emplace_back(vfs::IOVec{chunk.ptr, chunk.used});
+    }
+
+    size_t idx = 0;
+    ssize_t total = 0;
+    while (idx < vecs.size())
+    {
+        auto count = static_cast<int32_t>(std::min<size_t>(vecs.size() - idx, kMaxIOVecCount));
+        ssize_t ret = vfs::WriteV(fd, vecs.data() + idx, count);
+        if (ret < 0)
         {
-            // This will make `offset_in_cache_ = 0`
-            syncAndResetCacheContents();
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ret == 0)
+            break;
+        total += ret;
+
+        // Skip the vectors which have been written completely, and adjust
+        // the partially written one.
+        auto written = static_cast<size_t>(ret);
+        while (idx < vecs.size() && written >= vecs[idx].length)
+        {
+            written -= vecs[idx].length;
+            idx++;
+        }
+        if (written > 0)
+        {
+            vecs[idx].base = reinterpret_cast<uint8_t*>(vecs[idx].base) + written;
+            vecs[idx].length -= written;
         }
     }
+
+    return total;
 }
 
 std::shared_ptr<Data> ScalableWriteBuffer::finalize()
 {
-    CHECK(cache_start_ptr_ && "Operating on finalized scalable buffer");
+    CHECK(!finalized_ && "Operating on finalized scalable buffer");
+    finalized_ = true;
 
-    syncAndResetCacheContents();
-    free(cache_start_ptr_);
-    cache_start_ptr_ = nullptr;
-    cache_size_ = 0;
+    if (chunks_.empty())
+        appendChunk();
 
-    auto result = Data::MakeFromPtrWithoutCopy(buffer_start_ptr_, offset_in_buffer_, true);
+    uint8_t *buffer;
+    if (chunks_.size() == 1)
+    {
+        // Transfer the only chunk directly. Shrinking a memory block
+        // by `realloc` does not move it in most cases.
+        Chunk& chunk = chunks_[0];
+        buffer = chunk.ptr;
+        if (chunk.used > 0 && chunk.used < chunk.capacity)
+        {
+            buffer = reinterpret_cast<uint8_t*>(std::realloc(chunk.ptr, chunk.used));
+            CHECK(buffer && "Buffer reallocation failed");
+        }
+    }
+    else
+    {
+        buffer = reinterpret_cast<uint8_t*>(std::malloc(total_size_));
+        CHECK(buffer && "Buffer allocation failed");
+
+        size_t offset = 0;
+        for (const Chunk& chunk : chunks_)
+        {
+            std::memcpy(buffer + offset, chunk.ptr, chunk.used);
+            offset += chunk.used;
+            std::free(chunk.ptr);
+        }
+    }
+    chunks_.clear();
+
+    auto result = Data::MakeFromPtrWithoutCopy(buffer, total_size_, true);
     CHECK(result);
+    total_size_ = 0;
+
+    return result;
+}
+
+std::shared_ptr<Data> ScalableWriteBuffer::finalizeAsChunks()
+{
+    CHECK(!finalized_ && "Operating on finalized scalable buffer");
+    finalized_ = true;
 
-    buffer_start_ptr_ = nullptr;
-    offset_in_buffer_ = 0;
+    auto result = std::make_shared<ChunkedData>(std::move(chunks_), total_size_);
+    chunks_.clear();
+    total_size_ = 0;
 
     return result;
 }
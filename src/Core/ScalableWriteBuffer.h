@@ -19,6 +19,8 @@
 #define COCOA_CORE_SCALABLEWRITEBUFFER_H
 
 #include <memory>
+#include <vector>
+#include <functional>
 
 #include "Core/Project.h"
 namespace cocoa {
@@ -27,36 +29,72 @@ class Data;
 
 /**
  * A memory buffer which can grow in size.
- * The size of buffer cannot be changed any more after calling `finalize` method,
- * and the size will equal to the number of bytes written in buffer accurately.
+ * Contents are stored in a list of chunks (a rope) whose sizes grow
+ * geometrically, so the written contents are never moved or copied
+ * when the buffer grows.
+ * The size of buffer cannot be changed any more after calling `finalize`
+ * or `finalizeAsChunks` method.
  */
 class ScalableWriteBuffer
 {
 public:
-    constexpr static size_t kDefaultCacheSize = 1024;
+    constexpr static size_t kDefaultInitialChunkSize = 4096;
+    constexpr static size_t kMaxChunkSize = 16 * 1024 * 1024;
+
+    struct Chunk
+    {
+        uint8_t        *ptr;
+        size_t          capacity;
+        size_t          used;
+    };
+
+    using ChunkVisitor = std::function<void(const uint8_t *ptr, size_t size)>;
 
     /**
-     * Construct a scalable buffer with a specified cache size.
-     * Data will be written into cache initially, then they will be copied into
-     * actual buffer when the cache space is full. If the actual is not enough to
-     * receive the contents in the cache, it will be reallocated with a proper size.
+     * Construct a scalable buffer with a specified size of the first chunk.
+     * Every newly allocated chunk is twice the size of the previous one
+     * until `kMaxChunkSize` is reached.
      */
-    explicit ScalableWriteBuffer(size_t cache_size = kDefaultCacheSize);
+    explicit ScalableWriteBuffer(size_t initial_chunk_size = kDefaultInitialChunkSize);
     ~ScalableWriteBuffer();
 
     void writeBytes(const uint8_t *src, size_t size);
     void writeBytes(const std::shared_ptr<Data>& src, size_t size);
 
+    g_nodiscard g_inline size_t size() const {
+        return total_size_;
+    }
+
+    void forEachChunk(const ChunkVisitor& visitor) const;
+
+    /**
+     * Write all the contents into file `fd` by `writev`, which means chunks
+     * are never flattened. Returns the number of bytes written or -1 on failure.
+     * The buffer is not finalized and can be used continually.
+     */
+    ssize_t writeToFile(int32_t fd) const;
+
+    /**
+     * Finalize the buffer and flatten all the chunks into a linear buffer.
+     * If there is only one chunk, the chunk itself is transferred to the
+     * returned `Data` object without copying.
+     */
     std::shared_ptr<Data> finalize();
 
+    /**
+     * Finalize the buffer and transfer all the chunks to the returned `Data`
+     * object without flattening them. The returned object is readonly, and
+     * it has no accessible buffer unless there is only one chunk.
+     */
+    std::shared_ptr<Data> finalizeAsChunks();
+
 private:
-    void syncAndResetCacheContents();
+    void appendChunk();
 
-    uint8_t                 *buffer_start_ptr_;
-    uint8_t                 *cache_start_ptr_;
-    uint64_t                 offset_in_cache_;
-    uint64_t                 offset_in_buffer_;
-    size_t                   cache_size_;
+    std::vector<Chunk>       chunks_;
+    size_t                   next_chunk_size_;
+    size_t                   total_size_;
+    bool                     finalized_;
 };
 
 } // namespace cocoa
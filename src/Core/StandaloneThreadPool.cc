@@ -15,6 +15,8 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "fmt/format.h"
 
 #include "Core/StandaloneThreadPool.h"
@@ -24,16 +26,35 @@ namespace cocoa {
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Core.StandaloneThreadPool)
 
+namespace {
+
+// Index of the current worker thread in its owner thread pool
+thread_local StandaloneThreadPool *g_current_pool = nullptr;
+thread_local uint32_t g_current_worker_index = 0;
+
+// Number of chunks per worker that `parallelFor` splits a range into
+// when the grain size is not specified. More chunks than workers make
+// the load balanced by stealing.
+constexpr size_t kParallelForChunksPerWorker = 4;
+
+} // namespace anonymous
+
 StandaloneThreadPool::StandaloneThreadPool(const std::string_view& workerName, uint32_t count)
     : ready_barrier_{}
     , worker_base_name_(workerName)
+    , next_queue_(0)
+    , pending_tasks_(0)
     , stop_(false)
 {
+    // `hardware_concurrency` returns 0 if the value is not computable
     if (count == 0)
-        count = std::thread::hardware_concurrency();
+        count = std::max(1U, std::thread::hardware_concurrency());
 
     uv_barrier_init(&ready_barrier_, count + 1);
 
+    for (uint32_t i = 0; i < count; i++)
+        queues_.emplace_back(std::make_unique<WorkerQueue>());
+
     QLOG(LOG_DEBUG, "Creating thread pool {}, concurrency is {}", fmt::ptr(this), count);
     for (int32_t i = 1; i <= count; i++)
     {
@@ -50,15 +71,87 @@ StandaloneThreadPool::StandaloneThreadPool(const std::string_view& workerName, u
 StandaloneThreadPool::~StandaloneThreadPool()
 {
     {
-        std::unique_lock<std::mutex> scopedLock(queue_lock_);
-        stop_ = true;
+        std::unique_lock<std::mutex> scopedLock(sleep_lock_);
+        stop_.store(true, std::memory_order_release);
     }
 
-    queue_condition_var_.notify_all();
+    sleep_condition_var_.notify_all();
     for (std::thread& worker : threads_)
         worker.join();
 }
 
+void StandaloneThreadPool::push(TaskRoutine routine)
+{
+    // Worker threads push tasks into their own deques to keep locality,
+    // and other threads distribute tasks among all the deques.
+    uint32_t index;
+    if (g_current_pool == this)
+        index = g_current_worker_index;
+    else
+        index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    {
+        std::scoped_lock<std::mutex> lock(queues_[index]->lock);
+        queues_[index]->tasks.emplace_back(std::move(routine));
+    }
+    pending_tasks_.fetch_add(1, std::memory_order_release);
+
+    // Acquiring the lock makes sure that a worker which is going to sleep
+    // either sees the new task or receives the notification.
+    {
+        std::scoped_lock<std::mutex> lock(sleep_lock_);
+    }
+    sleep_condition_var_.notify_one();
+}
+
+bool StandaloneThreadPool::tryPop(TaskRoutine& out)
+{
+    auto nb_queues = static_cast<uint32_t>(queues_.size());
+    uint32_t start;
+    if (g_current_pool == this)
+    {
+        // Pop from the back of our own deque (LIFO) first
+        WorkerQueue *own = queues_[g_current_worker_index].get();
+        std::scoped_lock<std::mutex> lock(own->lock);
+        if (!own->tasks.empty())
+        {
+            out = std::move(own->tasks.back());
+            own->tasks.pop_back();
+            pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        start = g_current_worker_index + 1;
+    }
+    else
+    {
+        start = next_queue_.load(std::memory_order_relaxed);
+    }
+
+    // Steal from the front of other deques (FIFO)
+    for (uint32_t i = 0; i < nb_queues; i++)
+    {
+        WorkerQueue *victim = queues_[(start + i) % nb_queues].get();
+        std::unique_lock<std::mutex> lock(victim->lock, std::try_to_lock);
+        if (!lock.owns_lock() || victim->tasks.empty())
+            continue;
+        out = std::move(victim->tasks.front());
+        victim->tasks.pop_front();
+        pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+bool StandaloneThreadPool::tryRunOneTask()
+{
+    TaskRoutine task;
+    if (!tryPop(task))
+        return false;
+    task();
+    return true;
+}
+
 void StandaloneThreadPool::workerEntrypoint(uint32_t number)
 {
     auto thread_name = fmt::format("{}#{}", worker_base_name_, number);
@@ -66,38 +159,161 @@ void StandaloneThreadPool::workerEntrypoint(uint32_t number)
     QLOG(LOG_DEBUG, "Thread %fg<gr,hl>\"{}\"%reset is started from thread pool {}",
          thread_name, fmt::ptr(this));
 
+    g_current_pool = this;
+    g_current_worker_index = number - 1;
+
     uv_barrier_wait(&ready_barrier_);
 
     while (true)
     {
-        TaskRoutine task;
+        if (tryRunOneTask())
+            continue;
+
+        std::unique_lock<std::mutex> scopedLock(sleep_lock_);
+        sleep_condition_var_.wait(scopedLock, [this] {
+            return stop_.load(std::memory_order_acquire) ||
+                   pending_tasks_.load(std::memory_order_acquire) > 0;
+        });
+
+        // Tasks which have been submitted are always finished before exiting
+        if (stop_.load(std::memory_order_acquire) &&
+            pending_tasks_.load(std::memory_order_acquire) == 0)
         {
-            std::unique_lock<std::mutex> scopedLock(queue_lock_);
-            queue_condition_var_.wait(scopedLock, [this] {
-                return this->stop_ || !this->task_queue_.empty();
-            });
+            break;
+        }
+    }
 
-            if (stop_ && task_queue_.empty())
-                break;
+    g_current_pool = nullptr;
+}
 
-            task = std::move(task_queue_.front());
-            task_queue_.pop();
+void StandaloneThreadPool::enqueueTrivial(TaskRoutine routine)
+{
+    if (stop_.load(std::memory_order_acquire))
+        throw RuntimeException(__func__, "Enqueue on stopped threadpool");
+    push(std::move(routine));
+}
+
+void StandaloneThreadPool::parallelFor(size_t begin, size_t end,
+                                       const RangeRoutine& body, size_t grain)
+{
+    TaskGroup group(this);
+    group.parallelFor(begin, end, body, grain);
+    group.wait();
+}
+
+TaskGroup::TaskGroup(StandaloneThreadPool *pool)
+    : pool_(pool)
+    , pending_(0)
+    , cancelled_(false)
+{
+    CHECK(pool_);
+}
+
+TaskGroup::~TaskGroup()
+{
+    // Tasks refer to this group, so we must wait for them even if
+    // an exception is being thrown.
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+void TaskGroup::run(StandaloneThreadPool::TaskRoutine routine)
+{
+    CHECK(routine);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    try
+    {
+        enqueueCounted(std::move(routine));
+    }
+    catch (...)
+    {
+        // The task will never run (the pool has been stopped), so nobody
+        // else would decrease the counter for it.
+        std::scoped_lock<std::mutex> lock(lock_);
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            finished_condition_var_.notify_all();
+        throw;
+    }
+}
+
+void TaskGroup::enqueueCounted(StandaloneThreadPool::TaskRoutine routine)
+{
+    pool_->enqueueTrivial([this, routine = std::move(routine)]() {
+        if (!isCancelled())
+        {
+            try
+            {
+                routine();
+            }
+            catch (...)
+            {
+                std::scoped_lock<std::mutex> lock(lock_);
+                if (!exception_)
+                    exception_ = std::current_exception();
+            }
         }
 
-        task();
+        // `pending_` is only checked by `wait()` while holding the lock,
+        // so the group cannot be destroyed before this task releases it.
+        std::scoped_lock<std::mutex> lock(lock_);
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            finished_condition_var_.notify_all();
+    });
+}
+
+void TaskGroup::parallelFor(size_t begin, size_t end,
+                            const StandaloneThreadPool::RangeRoutine& body, size_t grain)
+{
+    if (begin >= end)
+        return;
+
+    size_t count = end - begin;
+    if (grain == 0)
+    {
+        size_t nb_chunks = pool_->getWorkersCount() * kParallelForChunksPerWorker;
+        grain = std::max<size_t>(1, (count + nb_chunks - 1) / nb_chunks);
+    }
+
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain)
+    {
+        size_t chunk_end = std::min(end, chunk_begin + grain);
+        run([body, chunk_begin, chunk_end]() {
+            body(chunk_begin, chunk_end);
+        });
     }
 }
 
-void StandaloneThreadPool::enqueueTrivial(TaskRoutine routine)
+void TaskGroup::wait()
 {
+    std::unique_lock<std::mutex> lock(lock_);
+    while (pending_.load(std::memory_order_acquire) > 0)
     {
-        std::scoped_lock<std::mutex> lock(queue_lock_);
-        if (stop_)
-            throw RuntimeException(__func__, "Enqueue on stopped threadpool");
-        task_queue_.emplace(std::move(routine));
+        // Help the pool instead of blocking, which also prevents deadlocks
+        // when a worker thread waits for a group.
+        lock.unlock();
+        bool has_run_task = pool_->tryRunOneTask();
+        lock.lock();
+
+        if (!has_run_task)
+            finished_condition_var_.wait_for(lock, std::chrono::milliseconds(1));
     }
-    queue_condition_var_.notify_one();
+
+    std::exception_ptr exception;
+    std::swap(exception, exception_);
+    lock.unlock();
+
+    if (exception)
+        std::rethrow_exception(exception);
 }
 
+void TaskGroup::cancel()
+{
+    cancelled_.store(true, std::memory_order_relaxed);
+}
 
 } // namespace cocoa
@@ -23,17 +23,31 @@
 #include <condition_variable>
 #include <mutex>
 #include <functional>
-#include <queue>
+#include <deque>
+#include <atomic>
+#include <exception>
 
 #include "uv.h"
 
 #include "Core/Exception.h"
 namespace cocoa {
 
+class TaskGroup;
+
+/**
+ * Each worker owns a task deque. A worker pushes and pops tasks at the back
+ * of its own deque, and steals tasks from the front of other workers' deques
+ * when its own deque is empty. Tasks submitted by non-worker threads are
+ * distributed to the deques in round-robin order, so producers rarely
+ * contend on the same lock.
+ */
 class StandaloneThreadPool
 {
+    friend class TaskGroup;
+
 public:
     using TaskRoutine = std::function<void()>;
+    using RangeRoutine = std::function<void(size_t begin, size_t end)>;
 
     /**
      * An appropriate number depending on the number of CPU cores
@@ -42,44 +56,108 @@ public:
     explicit StandaloneThreadPool(const std::string_view& workerName, uint32_t count = 0);
     ~StandaloneThreadPool();
 
+    g_nodiscard g_inline uint32_t getWorkersCount() const {
+        return static_cast<uint32_t>(threads_.size());
+    }
+
     template<typename F, typename ...ArgsT>
     auto enqueue(F&& f, ArgsT&&... args)
         -> std::future<typename std::invoke_result<F, ArgsT...>::type>;
 
     void enqueueTrivial(TaskRoutine routine);
 
+    /**
+     * Split the range [begin, end) into chunks of `grain` elements (an
+     * appropriate grain is chosen if it is 0) and call `body` on each chunk
+     * concurrently. The calling thread also executes tasks until all the
+     * chunks are finished. The first exception thrown by `body` is rethrown.
+     */
+    void parallelFor(size_t begin, size_t end, const RangeRoutine& body, size_t grain = 0);
+
 private:
+    struct WorkerQueue
+    {
+        std::mutex                  lock;
+        std::deque<TaskRoutine>     tasks;
+    };
+
     void workerEntrypoint(uint32_t number);
+    void push(TaskRoutine routine);
+    bool tryPop(TaskRoutine& out);
+    bool tryRunOneTask();
 
     uv_barrier_t                    ready_barrier_;
     std::string                     worker_base_name_;
     std::vector<std::thread>        threads_;
-    std::queue<TaskRoutine>         task_queue_;
-    std::mutex                      queue_lock_;
-    std::condition_variable         queue_condition_var_;
-    bool                            stop_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<uint32_t>           next_queue_;
+    std::atomic<int64_t>            pending_tasks_;
+    std::mutex                      sleep_lock_;
+    std::condition_variable         sleep_condition_var_;
+    std::atomic<bool>               stop_;
+};
+
+/**
+ * A set of tasks which can be waited and cancelled as a whole.
+ * Cancelling a group skips the tasks which have not been started yet;
+ * running tasks can poll `isCancelled` to exit early.
+ * The destructor waits for all the tasks in the group.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(StandaloneThreadPool *pool);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(StandaloneThreadPool::TaskRoutine routine);
+
+    void parallelFor(size_t begin, size_t end,
+                     const StandaloneThreadPool::RangeRoutine& body, size_t grain = 0);
+
+    /**
+     * Wait until all the tasks in the group are finished or skipped.
+     * The calling thread executes pending tasks of the pool while waiting,
+     * so it is safe to wait in a worker thread of the same pool.
+     * The first exception thrown by a task is rethrown.
+     */
+    void wait();
+
+    void cancel();
+
+    g_nodiscard g_inline bool isCancelled() const {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void enqueueCounted(StandaloneThreadPool::TaskRoutine routine);
+
+    StandaloneThreadPool           *pool_;
+    std::atomic<int64_t>            pending_;
+    std::atomic<bool>               cancelled_;
+    std::mutex                      lock_;
+    std::condition_variable         finished_condition_var_;
+    std::exception_ptr              exception_;
 };
 
 template<typename F, typename...ArgsT>
 auto StandaloneThreadPool::enqueue(F&& f, ArgsT&& ...args)
     -> std::future<typename std::invoke_result<F, ArgsT...>::type>
 {
-    using ReturnType = typename std::result_of<F(ArgsT...)>::type;
+    using ReturnType = typename std::invoke_result<F, ArgsT...>::type;
 
     auto task = std::make_shared<std::packaged_task<ReturnType()>>(
             std::bind(std::forward<F>(f), std::forward<ArgsT>(args)...));
 
     std::future<ReturnType> result = task->get_future();
-    {
-        std::unique_lock<std::mutex> scopedLock(queue_lock_);
-        if (stop_)
-            throw RuntimeException(__func__, "Enqueue on stopped threadpool");
-        task_queue_.emplace([task]() { (*task)(); });
-    }
+    if (stop_.load(std::memory_order_acquire))
+        throw RuntimeException(__func__, "Enqueue on stopped threadpool");
+    push([task]() { (*task)(); });
 
-    queue_condition_var_.notify_one();
     return result;
 }
 
-} // namespace anonymous
+} // namespace cocoa
 #endif //COCOA_CORE_STANDALONETHREADPOOL_H
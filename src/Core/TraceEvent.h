@@ -18,8 +18,12 @@
 #ifndef COCOA_CORE_TRACEEVENT_H
 #define COCOA_CORE_TRACEEVENT_H
 
+#include <atomic>
+
 #include "perfetto.h"
 
+#include "Core/Project.h"
+
 PERFETTO_DEFINE_CATEGORIES(
         perfetto::Category("rendering")
                 .SetDescription("Events from the rendering subsystem"),
@@ -30,6 +34,24 @@ PERFETTO_DEFINE_CATEGORIES(
         perfetto::Category("v8")
                 .SetDescription("Trace JavaScript engine V8"),
         perfetto::Category("skia")
-                .SetDescription("Trace rendering engine Skia"));
+                .SetDescription("Trace rendering engine Skia"),
+        perfetto::Category("memory")
+                .SetDescription("Statistics of the native heap"));
+
+namespace cocoa {
+
+/**
+ * Flow IDs link trace events on different threads, typically from where
+ * a message is enqueued to where it is handled:
+ *   TRACE_EVENT("rendering", "Enqueue", perfetto::Flow::ProcessScoped(id));
+ *   TRACE_EVENT("main", "Handle", perfetto::TerminatingFlow::ProcessScoped(id));
+ */
+g_inline uint64_t TraceNewFlowId()
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace cocoa
 
 #endif //COCOA_CORE_TRACEEVENT_H
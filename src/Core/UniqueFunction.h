@@ -0,0 +1,174 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COCOA_CORE_UNIQUEFUNCTION_H
+#define COCOA_CORE_UNIQUEFUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <functional>
+
+#include "Core/Project.h"
+#include "Core/Errors.h"
+namespace cocoa {
+
+template<typename Signature>
+class UniqueFunction;
+
+/**
+ * A move-only replacement of `std::function`. Callable objects which are
+ * small enough are stored inline without any heap allocation, and callable
+ * objects which are not copyable (like lambdas capturing `std::unique_ptr`)
+ * are also accepted.
+ */
+template<typename R, typename...ArgsT>
+class UniqueFunction<R(ArgsT...)>
+{
+public:
+    constexpr static size_t kInlineStorageSize = 6 * sizeof(void*);
+
+    UniqueFunction() noexcept : vtable_(nullptr) {}
+    UniqueFunction(std::nullptr_t) noexcept : vtable_(nullptr) {} // NOLINT
+
+    template<typename F, typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<F>, UniqueFunction> &&
+            std::is_invocable_r_v<R, std::decay_t<F>&, ArgsT...>>>
+    UniqueFunction(F&& func) // NOLINT
+        : vtable_(nullptr)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (std::is_constructible_v<bool, const Callable&>)
+        {
+            // Empty function pointers and `std::function`s are treated as
+            // empty `UniqueFunction`s.
+            if (!static_cast<bool>(func))
+                return;
+        }
+
+        if constexpr (kFitsInline<Callable>)
+            new (&storage_) Callable(std::forward<F>(func));
+        else
+            *reinterpret_cast<Callable**>(&storage_) = new Callable(std::forward<F>(func));
+        vtable_ = &kVTable<Callable>;
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept
+        : vtable_(other.vtable_)
+    {
+        if (vtable_)
+        {
+            vtable_->move(&storage_, &other.storage_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.vtable_)
+            {
+                other.vtable_->move(&storage_, &other.storage_);
+                vtable_ = other.vtable_;
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~UniqueFunction() {
+        reset();
+    }
+
+    g_nodiscard g_inline explicit operator bool() const noexcept {
+        return vtable_ != nullptr;
+    }
+
+    R operator()(ArgsT...args) {
+        CHECK(vtable_ && "Calling an empty function");
+        return vtable_->invoke(&storage_, std::forward<ArgsT>(args)...);
+    }
+
+    void reset() {
+        if (vtable_)
+        {
+            vtable_->destroy(&storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+private:
+    using Storage = std::aligned_storage_t<kInlineStorageSize, alignof(std::max_align_t)>;
+
+    struct VTable
+    {
+        R (*invoke)(Storage *storage, ArgsT&&...args);
+        // Move-construct `dst` from `src`, and destroy `src`
+        void (*move)(Storage *dst, Storage *src);
+        void (*destroy)(Storage *storage);
+    };
+
+    template<typename F>
+    constexpr static bool kFitsInline = sizeof(F) <= kInlineStorageSize &&
+                                        alignof(std::max_align_t) % alignof(F) == 0 &&
+                                        std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    static F *GetCallable(Storage *storage) {
+        if constexpr (kFitsInline<F>)
+            return std::launder(reinterpret_cast<F*>(storage));
+        else
+            return *reinterpret_cast<F**>(storage);
+    }
+
+    template<typename F>
+    constexpr static VTable kVTable = {
+        [](Storage *storage, ArgsT&&...args) -> R {
+            return std::invoke(*GetCallable<F>(storage), std::forward<ArgsT>(args)...);
+        },
+        [](Storage *dst, Storage *src) {
+            if constexpr (kFitsInline<F>)
+            {
+                F *from = GetCallable<F>(src);
+                new (dst) F(std::move(*from));
+                from->~F();
+            }
+            else
+            {
+                *reinterpret_cast<F**>(dst) = GetCallable<F>(src);
+            }
+        },
+        [](Storage *storage) {
+            if constexpr (kFitsInline<F>)
+                GetCallable<F>(storage)->~F();
+            else
+                delete GetCallable<F>(storage);
+        }
+    };
+
+    const VTable    *vtable_;
+    Storage          storage_;
+};
+
+} // namespace cocoa
+#endif //COCOA_CORE_UNIQUEFUNCTION_H
@@ -0,0 +1,171 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/Data.h"
+#include "Core/ScalableWriteBuffer.h"
+#include "Core/HuffmanCodec.h"
+
+/**
+ * huffman-bench measures the throughput of `HuffmanEncode`, `HuffmanDecode`
+ * and `HuffmanStreamDecoder` (fed in 64 KB chunks) on 64 MB (or `--size-mb`
+ * megabytes) of input drawn from several symbol distributions. Throughput is
+ * computed over the uncompressed size and the best of `kRounds` rounds is
+ * reported. Results are printed as CSV.
+ */
+
+namespace cocoa {
+namespace {
+
+constexpr int32_t kRounds = 3;
+constexpr size_t kStreamChunkSize = 64 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+double throughput_mbps(size_t bytes, double ms)
+{
+    return ms > 0 ? static_cast<double>(bytes) / (1024 * 1024) / (ms / 1000) : 0;
+}
+
+struct Distribution
+{
+    const char *name;
+    std::vector<uint8_t> (*generate)(std::mt19937_64& random, size_t size);
+};
+
+const Distribution g_distributions[] = {
+    { "uniform-256", [](std::mt19937_64& random, size_t size) {
+        std::vector<uint8_t> input(size);
+        std::uniform_int_distribution<int32_t> pick(0, 255);
+        for (uint8_t& byte : input)
+            byte = static_cast<uint8_t>(pick(random));
+        return input;
+    } },
+    { "uniform-16", [](std::mt19937_64& random, size_t size) {
+        std::vector<uint8_t> input(size);
+        std::uniform_int_distribution<int32_t> pick(0, 15);
+        for (uint8_t& byte : input)
+            byte = static_cast<uint8_t>('a' + pick(random));
+        return input;
+    } },
+    { "geometric", [](std::mt19937_64& random, size_t size) {
+        std::vector<uint8_t> input(size);
+        std::geometric_distribution<int32_t> pick(0.3);
+        for (uint8_t& byte : input)
+            byte = static_cast<uint8_t>(std::min(pick(random), 255));
+        return input;
+    } },
+    { "single-symbol", [](std::mt19937_64&, size_t size) {
+        return std::vector<uint8_t>(size, 'x');
+    } }
+};
+
+template<typename F>
+double best_of_rounds(F&& func)
+{
+    double best = 0;
+    for (int32_t i = 0; i < kRounds; i++)
+    {
+        auto begin = Clock::now();
+        func();
+        double ms = elapsed_ms(begin);
+        if (i == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int bench_main(size_t size)
+{
+    std::mt19937_64 random(0x5eed);
+
+    fmt::print("distribution,ratio,encodeMBps,decodeMBps,streamDecodeMBps\n");
+    for (const Distribution& distribution : g_distributions)
+    {
+        std::vector<uint8_t> input = distribution.generate(random, size);
+        std::shared_ptr<Data> data = Data::MakeFromPtrWithoutCopy(input.data(), input.size());
+
+        std::shared_ptr<Data> encoded;
+        double encode_ms = best_of_rounds([&] {
+            encoded = HuffmanEncode(data);
+            CHECK(encoded);
+        });
+
+        double decode_ms = best_of_rounds([&] {
+            std::shared_ptr<Data> decoded = HuffmanDecode(encoded);
+            CHECK(decoded && decoded->size() == size);
+        });
+
+        std::vector<uint8_t> encoded_bytes(encoded->size());
+        CHECK(encoded->readAt(0, encoded_bytes.data(), encoded_bytes.size()) ==
+              static_cast<ssize_t>(encoded_bytes.size()));
+        double stream_ms = best_of_rounds([&] {
+            ScalableWriteBuffer output;
+            HuffmanStreamDecoder decoder(output);
+            for (size_t offset = 0; offset < encoded_bytes.size(); offset += kStreamChunkSize)
+            {
+                decoder.feed(encoded_bytes.data() + offset,
+                             std::min(kStreamChunkSize, encoded_bytes.size() - offset));
+            }
+            CHECK(decoder.feed(nullptr, 0) == HuffmanStreamDecoder::Status::kFinished);
+            CHECK(output.size() == size);
+        });
+
+        fmt::print("{},{:.3f},{:.1f},{:.1f},{:.1f}\n", distribution.name,
+                   static_cast<double>(encoded->size()) / static_cast<double>(size),
+                   throughput_mbps(size, encode_ms), throughput_mbps(size, decode_ms),
+                   throughput_mbps(size, stream_ms));
+    }
+
+    return 0;
+}
+
+} // namespace anonymous
+} // namespace cocoa
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    size_t size_mb = 64;
+    if (argc == 3 && std::strcmp(argv[1], "--size-mb") == 0)
+        size_mb = std::max(1, std::atoi(argv[2]));
+    else if (argc != 1)
+    {
+        fmt::print(stderr, "Usage: {} [--size-mb <megabytes>]\n", argv[0]);
+        return 1;
+    }
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    int ret = bench_main(size_mb * 1024 * 1024);
+    Journal::Delete();
+    return ret;
+}
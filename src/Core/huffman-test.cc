@@ -0,0 +1,220 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/Data.h"
+#include "Core/ScalableWriteBuffer.h"
+#include "Core/HuffmanCodec.h"
+
+/**
+ * huffman-test is a round-trip fuzzer of `HuffmanEncode` and the decoders.
+ * Each iteration generates a random symbol table (alphabet size, symbols and
+ * a uniform, geometric or Fibonacci-like distribution, the latter forces the
+ * code length limit) and a random input of at least one byte, then checks:
+ *
+ *  - `HuffmanDecode` reproduces the input;
+ *  - `HuffmanStreamDecoder` reproduces the input when fed in random chunks;
+ *  - truncated bitstreams are reported as corrupted;
+ *  - bit-flipped bitstreams never crash the decoder and never produce
+ *    more symbols than the header declares.
+ *
+ * Usage: huffman-test [--iterations <count>] [--seed <seed>]
+ */
+
+namespace cocoa {
+namespace {
+
+using Random = std::mt19937_64;
+using Bytes = std::vector<uint8_t>;
+
+int32_t g_failures = 0;
+
+#define TEST_EXPECT(cond, ...)                                  \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            fmt::print(stderr, "FAILED [seed={}, iteration={}] {}: {}\n", \
+                       seed, iteration, #cond, fmt::format(__VA_ARGS__)); \
+            g_failures++;                                       \
+            return;                                             \
+        }                                                       \
+    } while (false)
+
+Bytes data_to_bytes(const std::shared_ptr<Data>& data)
+{
+    Bytes bytes(data->size());
+    if (!bytes.empty())
+    {
+        ssize_t ret = data->readAt(0, bytes.data(), bytes.size());
+        bytes.resize(ret < 0 ? 0 : static_cast<size_t>(ret));
+    }
+    return bytes;
+}
+
+std::shared_ptr<Data> bytes_to_data(const Bytes& bytes)
+{
+    return Data::MakeFromPtr(const_cast<uint8_t*>(bytes.data()), bytes.size());
+}
+
+Bytes generate_input(Random& random)
+{
+    // Symbols which may appear in the input
+    std::vector<uint8_t> alphabet(256);
+    std::iota(alphabet.begin(), alphabet.end(), 0);
+    std::shuffle(alphabet.begin(), alphabet.end(), random);
+    size_t alphabet_size = std::uniform_int_distribution<size_t>(1, 256)(random);
+    alphabet.resize(alphabet_size);
+
+    Bytes input;
+    int32_t distribution = std::uniform_int_distribution<int32_t>(0, 2)(random);
+    if (distribution == 2)
+    {
+        // Fibonacci frequencies make the optimal code lengths exceed
+        // `kHuffmanMaxCodeLength`, so the lengths must be limited
+        uint64_t a = 1, b = 1;
+        for (size_t i = 0; i < std::min<size_t>(alphabet_size, 26); i++)
+        {
+            input.insert(input.end(), a, alphabet[i]);
+            uint64_t next = a + b;
+            a = b;
+            b = next;
+        }
+        std::shuffle(input.begin(), input.end(), random);
+        return input;
+    }
+
+    size_t size = std::uniform_int_distribution<size_t>(1, 1 << 16)(random);
+    input.resize(size);
+    if (distribution == 0)
+    {
+        std::uniform_int_distribution<size_t> pick(0, alphabet_size - 1);
+        for (uint8_t& byte : input)
+            byte = alphabet[pick(random)];
+    }
+    else
+    {
+        double p = std::uniform_real_distribution<double>(0.05, 0.9)(random);
+        std::geometric_distribution<size_t> pick(p);
+        for (uint8_t& byte : input)
+            byte = alphabet[std::min(pick(random), alphabet_size - 1)];
+    }
+    return input;
+}
+
+Bytes stream_decode(Random& random, const Bytes& encoded, HuffmanStreamDecoder::Status& status)
+{
+    ScalableWriteBuffer output;
+    HuffmanStreamDecoder decoder(output);
+
+    // Chunks must not be empty, as an empty chunk marks the end of input
+    size_t max_chunk = std::uniform_int_distribution<size_t>(1, 4096)(random);
+    size_t offset = 0;
+    while (offset < encoded.size() && decoder.status() == HuffmanStreamDecoder::Status::kNeedMoreInput)
+    {
+        size_t chunk = std::min(encoded.size() - offset,
+                                std::uniform_int_distribution<size_t>(1, max_chunk)(random));
+        decoder.feed(encoded.data() + offset, chunk);
+        offset += chunk;
+    }
+    status = decoder.feed(nullptr, 0);
+    return data_to_bytes(output.finalize());
+}
+
+void run_iteration(uint64_t seed, int32_t iteration)
+{
+    Random random(seed + iteration);
+    Bytes input = generate_input(random);
+    TEST_EXPECT(!input.empty(), "empty input");
+
+    std::shared_ptr<Data> encoded_data = HuffmanEncode(bytes_to_data(input));
+    TEST_EXPECT(encoded_data, "failed to encode {} bytes", input.size());
+    Bytes encoded = data_to_bytes(encoded_data);
+    TEST_EXPECT(encoded.size() > kHuffmanHeaderSize, "encoded size {}", encoded.size());
+
+    for (size_t i = 0; i < 256; i++)
+    {
+        int32_t length = encoded[sizeof(uint64_t) + i];
+        TEST_EXPECT(length <= kHuffmanMaxCodeLength, "code length {} of symbol {}", length, i);
+    }
+
+    std::shared_ptr<Data> decoded_data = HuffmanDecode(encoded_data);
+    TEST_EXPECT(decoded_data, "failed to decode {} bytes", encoded.size());
+    TEST_EXPECT(data_to_bytes(decoded_data) == input, "one-shot round trip mismatch");
+
+    HuffmanStreamDecoder::Status status;
+    Bytes streamed = stream_decode(random, encoded, status);
+    TEST_EXPECT(status == HuffmanStreamDecoder::Status::kFinished, "stream status");
+    TEST_EXPECT(streamed == input, "streaming round trip mismatch");
+
+    // Every byte of the bitstream contains code bits, so any truncation
+    // leaves the decoder short of bits.
+    Bytes truncated(encoded.begin(), encoded.end() - std::uniform_int_distribution<size_t>(
+            1, encoded.size() - kHuffmanHeaderSize)(random));
+    TEST_EXPECT(!HuffmanDecode(bytes_to_data(truncated)), "truncated input was accepted");
+
+    Bytes flipped = encoded;
+    int32_t flips = std::uniform_int_distribution<int32_t>(1, 8)(random);
+    std::uniform_int_distribution<size_t> pick_bit(kHuffmanHeaderSize * 8, encoded.size() * 8 - 1);
+    for (int32_t i = 0; i < flips; i++)
+    {
+        size_t bit = pick_bit(random);
+        flipped[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+    }
+    std::shared_ptr<Data> flipped_decoded = HuffmanDecode(bytes_to_data(flipped));
+    TEST_EXPECT(!flipped_decoded || flipped_decoded->size() == input.size(),
+                "corrupted input produced {} symbols", flipped_decoded->size());
+}
+
+} // namespace anonymous
+} // namespace cocoa
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    int32_t iterations = 500;
+    uint64_t seed = 0x5eed;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--iterations") == 0)
+            iterations = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            seed = std::strtoull(argv[i + 1], nullptr, 0);
+        else
+        {
+            fmt::print(stderr, "Usage: {} [--iterations <count>] [--seed <seed>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    for (int32_t i = 0; i < iterations; i++)
+        run_iteration(seed, i);
+    Journal::Delete();
+
+    fmt::print("{} iterations, {} failures\n", iterations, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
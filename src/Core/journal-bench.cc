@@ -0,0 +1,132 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+
+/**
+ * journal-bench measures the latency of a `QLOG` call on the calling thread,
+ * which is what logging adds to frame time, in the synchronous mode and in
+ * the asynchronous mode with both overflow policies. Records are written to
+ * /dev/null (or the file specified by `--output`), and several threads log
+ * at the same time. Results are printed as CSV.
+ */
+
+namespace cocoa {
+namespace {
+
+#define THIS_FILE_MODULE COCOA_MODULE_NAME(JournalBench)
+
+constexpr int32_t kRecordsPerThread = 200000;
+const int32_t g_threads_counts[] = { 1, 4 };
+
+struct Mode
+{
+    const char *name;
+    bool async;
+    Journal::OverflowPolicy policy;
+};
+
+const Mode g_modes[] = {
+    { "sync",       false, Journal::OverflowPolicy::kDrop  },
+    { "async-drop", true,  Journal::OverflowPolicy::kDrop  },
+    { "async-block", true, Journal::OverflowPolicy::kBlock }
+};
+
+using Clock = std::chrono::steady_clock;
+
+void log_records(std::vector<int64_t>& latencies_ns)
+{
+    latencies_ns.resize(kRecordsPerThread);
+    for (int32_t i = 0; i < kRecordsPerThread; i++)
+    {
+        auto begin = Clock::now();
+        QLOG(LOG_INFO, "Frame #{} was presented in {:.2f}ms by surface {}",
+             i, 16.6, "benchmark");
+        latencies_ns[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - begin).count();
+    }
+}
+
+int64_t percentile(const std::vector<int64_t>& sorted, double p)
+{
+    auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[idx];
+}
+
+void bench_mode(const Mode& mode, int32_t threads_count, const char *output)
+{
+    Journal::New(LOG_LEVEL_NORMAL, Journal::OutputDevice::kFile, false,
+                 output, mode.async, mode.policy);
+
+    std::vector<std::vector<int64_t>> latencies(threads_count);
+    auto begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (int32_t i = 0; i < threads_count; i++)
+        threads.emplace_back(log_records, std::ref(latencies[i]));
+    for (std::thread& thread : threads)
+        thread.join();
+    double log_ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    // Includes writing the pending records in async mode
+    Journal::Delete();
+    double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    std::vector<int64_t> merged;
+    for (const auto& samples : latencies)
+        merged.insert(merged.end(), samples.begin(), samples.end());
+    std::sort(merged.begin(), merged.end());
+
+    double records = static_cast<double>(merged.size());
+    fmt::print("{},{},{},{},{},{},{:.0f},{:.3f}\n", mode.name, threads_count,
+               percentile(merged, 0.5), percentile(merged, 0.99), percentile(merged, 0.999),
+               merged.back(), records / log_ms * 1000, total_ms);
+}
+
+} // namespace anonymous
+} // namespace cocoa
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    const char *output = "/dev/null";
+    if (argc == 3 && std::strcmp(argv[1], "--output") == 0)
+        output = argv[2];
+    else if (argc != 1)
+    {
+        fmt::print(stderr, "Usage: {} [--output <file>]\n", argv[0]);
+        return 1;
+    }
+
+    fmt::print("mode,threads,p50Ns,p99Ns,p999Ns,maxNs,recordsPerSec,totalMs\n");
+    for (const Mode& mode : g_modes)
+    {
+        for (int32_t threads_count : g_threads_counts)
+            bench_mode(mode, threads_count, output);
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/StandaloneThreadPool.h"
+
+/**
+ * threadpool-bench measures how `StandaloneThreadPool` scales from 1 to N
+ * workers (N is the number of CPU cores unless specified by `--max-workers`)
+ * on two workloads:
+ *
+ *  - parallelFor: a CPU-bound loop split into chunks by `parallelFor`;
+ *  - tasks: many fine-grained tasks submitted to a `TaskGroup` by several
+ *    producer threads at the same time, which stresses the queues.
+ *
+ * Results are printed as CSV. Speedups are relative to a single worker.
+ */
+
+namespace cocoa {
+namespace {
+
+constexpr size_t kParallelForElements = 1 << 22;
+constexpr int32_t kProducersCount = 4;
+constexpr int32_t kTasksPerProducer = 50000;
+constexpr int32_t kRepeats = 5;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+// Some arithmetic the compiler cannot fold
+uint64_t mix(uint64_t x)
+{
+    for (int32_t i = 0; i < 16; i++)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 29;
+    }
+    return x;
+}
+
+double bench_parallel_for(StandaloneThreadPool& pool, std::vector<uint64_t>& data)
+{
+    double best = 0;
+    for (int32_t r = 0; r < kRepeats; r++)
+    {
+        auto begin = Clock::now();
+        pool.parallelFor(0, data.size(), [&data](size_t from, size_t to) {
+            for (size_t i = from; i < to; i++)
+                data[i] = mix(data[i] + i);
+        });
+        double ms = elapsed_ms(begin);
+        if (r == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+double bench_tasks(StandaloneThreadPool& pool)
+{
+    double best = 0;
+    for (int32_t r = 0; r < kRepeats; r++)
+    {
+        std::atomic<uint64_t> sink(0);
+        TaskGroup group(&pool);
+
+        auto begin = Clock::now();
+        std::vector<std::thread> producers;
+        for (int32_t p = 0; p < kProducersCount; p++)
+        {
+            producers.emplace_back([&group, &sink, p] {
+                for (int32_t i = 0; i < kTasksPerProducer; i++)
+                {
+                    group.run([&sink, p, i] {
+                        sink.fetch_add(mix(p * kTasksPerProducer + i) & 1,
+                                       std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        for (std::thread& producer : producers)
+            producer.join();
+        group.wait();
+
+        double ms = elapsed_ms(begin);
+        if (r == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int bench_main(uint32_t max_workers)
+{
+    std::vector<uint64_t> data(kParallelForElements, 1);
+    double base_parallel_for = 0, base_tasks = 0;
+
+    fmt::print("workers,parallelForMs,parallelForSpeedup,tasksMs,tasksPerSec,tasksSpeedup\n");
+    for (uint32_t workers = 1; workers <= max_workers; workers++)
+    {
+        StandaloneThreadPool pool("Bench", workers);
+        double parallel_for_ms = bench_parallel_for(pool, data);
+        double tasks_ms = bench_tasks(pool);
+        if (workers == 1)
+        {
+            base_parallel_for = parallel_for_ms;
+            base_tasks = tasks_ms;
+        }
+
+        double tasks_count = kProducersCount * kTasksPerProducer;
+        fmt::print("{},{:.3f},{:.2f},{:.3f},{:.0f},{:.2f}\n",
+                   workers, parallel_for_ms, base_parallel_for / parallel_for_ms,
+                   tasks_ms, tasks_count / tasks_ms * 1000, base_tasks / tasks_ms);
+    }
+    return 0;
+}
+
+} // namespace anonymous
+} // namespace cocoa
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    uint32_t max_workers = std::max(1U, std::thread::hardware_concurrency());
+    if (argc == 3 && std::strcmp(argv[1], "--max-workers") == 0)
+        max_workers = std::max(1, std::atoi(argv[2]));
+    else if (argc != 1)
+    {
+        fmt::print(stderr, "Usage: {} [--max-workers <count>]\n", argv[0]);
+        return 1;
+    }
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    int ret = bench_main(max_workers);
+    Journal::Delete();
+    return ret;
+}
@@ -0,0 +1,164 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/Data.h"
+#include "Core/ScalableWriteBuffer.h"
+
+/**
+ * writebuffer-bench appends 1 GB (or `--size-mb` megabytes) to a
+ * `ScalableWriteBuffer` in small writes of several sizes, and reports the
+ * append throughput together with the cost of each way to consume the
+ * contents: `finalizeAsChunks` (zero-copy), `writeToFile` (writev to
+ * /dev/null) and `finalize` (a single flatten). A buffer grown by `realloc`
+ * (which is what `ScalableWriteBuffer` used to be) is measured as the
+ * baseline. Results are printed as CSV.
+ */
+
+namespace cocoa {
+namespace {
+
+const size_t g_write_sizes[] = { 16, 64, 256, 4096 };
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+double throughput_mbps(size_t bytes, double ms)
+{
+    return ms > 0 ? static_cast<double>(bytes) / (1024 * 1024) / (ms / 1000) : 0;
+}
+
+// The previous implementation: a linear buffer grown by `realloc`
+double bench_realloc_baseline(const uint8_t *src, size_t write_size, size_t total)
+{
+    auto begin = Clock::now();
+
+    size_t capacity = ScalableWriteBuffer::kDefaultInitialChunkSize, used = 0;
+    auto *buffer = reinterpret_cast<uint8_t*>(std::malloc(capacity));
+    CHECK(buffer);
+    while (used < total)
+    {
+        if (used + write_size > capacity)
+        {
+            capacity *= 2;
+            buffer = reinterpret_cast<uint8_t*>(std::realloc(buffer, capacity));
+            CHECK(buffer);
+        }
+        std::memcpy(buffer + used, src, write_size);
+        used += write_size;
+    }
+
+    double ms = elapsed_ms(begin);
+    std::free(buffer);
+    return ms;
+}
+
+void fill_buffer(ScalableWriteBuffer& buffer, const uint8_t *src,
+                 size_t write_size, size_t total)
+{
+    for (size_t written = 0; written < total; written += write_size)
+        buffer.writeBytes(src, write_size);
+}
+
+int bench_main(size_t total)
+{
+    std::vector<uint8_t> src(4096);
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = static_cast<uint8_t>(i * 31);
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd < 0)
+    {
+        fmt::print(stderr, "Failed to open /dev/null\n");
+        return 1;
+    }
+
+    fmt::print("writeSize,reallocMBps,appendMBps,finalizeAsChunksMs,writeToFileMs,finalizeMs\n");
+    for (size_t write_size : g_write_sizes)
+    {
+        double baseline_ms = bench_realloc_baseline(src.data(), write_size, total);
+
+        double append_ms, chunks_ms, file_ms, flatten_ms;
+        {
+            ScalableWriteBuffer buffer;
+            auto begin = Clock::now();
+            fill_buffer(buffer, src.data(), write_size, total);
+            append_ms = elapsed_ms(begin);
+
+            begin = Clock::now();
+            ssize_t ret = buffer.writeToFile(null_fd);
+            file_ms = elapsed_ms(begin);
+            CHECK(ret == static_cast<ssize_t>(buffer.size()));
+
+            begin = Clock::now();
+            std::shared_ptr<Data> data = buffer.finalizeAsChunks();
+            chunks_ms = elapsed_ms(begin);
+            CHECK(data->size() == total);
+        }
+        {
+            ScalableWriteBuffer buffer;
+            fill_buffer(buffer, src.data(), write_size, total);
+            auto begin = Clock::now();
+            std::shared_ptr<Data> data = buffer.finalize();
+            flatten_ms = elapsed_ms(begin);
+            CHECK(data->size() == total);
+        }
+
+        fmt::print("{},{:.1f},{:.1f},{:.3f},{:.3f},{:.3f}\n", write_size,
+                   throughput_mbps(total, baseline_ms), throughput_mbps(total, append_ms),
+                   chunks_ms, file_ms, flatten_ms);
+    }
+
+    close(null_fd);
+    return 0;
+}
+
+} // namespace anonymous
+} // namespace cocoa
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    size_t size_mb = 1024;
+    if (argc == 3 && std::strcmp(argv[1], "--size-mb") == 0)
+        size_mb = std::max(1, std::atoi(argv[2]));
+    else if (argc != 1)
+    {
+        fmt::print(stderr, "Usage: {} [--size-mb <megabytes>]\n", argv[0]);
+        return 1;
+    }
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    int ret = bench_main(size_mb * 1024 * 1024);
+    Journal::Delete();
+    return ret;
+}
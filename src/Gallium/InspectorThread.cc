@@ -299,11 +299,9 @@ void handle_normal_http_request(struct lws *wsi, WsContext *ctx)
     else if (req_uri == "/favicon" || req_uri == "/favicon.ico")
     {
         auto vfs = crpkg::ResourceManager::Ref().GetResource("@internal");
-        auto storage = vfs->GetStorage("/favicon.ico");
-        CHECK(storage.has_value());
-        respond(HTTP_STATUS_OK, "image/vnd.microsoft.icon",
-                Data::MakeFromPtrWithoutCopy(
-                        const_cast<uint8_t*>(storage->addr), storage->size, false));
+        auto data = vfs->GetData("/favicon.ico");
+        CHECK(data);
+        respond(HTTP_STATUS_OK, "image/vnd.microsoft.icon", data);
     }
     else
     {
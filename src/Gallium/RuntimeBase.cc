@@ -251,6 +251,7 @@ void RuntimeBase::Initialize()
     isolate_->SetHostImportModuleDynamicallyCallback(dynamic_import_handler);
     isolate_->SetHostInitializeImportMetaObjectCallback(on_init_import_meta_object);
     isolate_->SetPromiseHook(promise_hook);
+    isolate_->AddGCEpilogueCallback(gc_epilogue_callback);
 
     event_prepare_.Start([&] {
         PerformIdleEventCheckpoint();
@@ -637,6 +638,22 @@ void RuntimeBase::promise_hook(v8::PromiseHookType type,
     }
 }
 
+void RuntimeBase::gc_epilogue_callback(v8::Isolate *isolate,
+                                       g_maybe_unused v8::GCType type,
+                                       g_maybe_unused v8::GCCallbackFlags flags)
+{
+    // Heap statistics only change significantly after a GC cycle,
+    // so sampling them here is enough to draw the counter tracks.
+    if (!TRACE_EVENT_CATEGORY_ENABLED("v8"))
+        return;
+
+    v8::HeapStatistics stats;
+    isolate->GetHeapStatistics(&stats);
+    TRACE_COUNTER("v8", "V8.UsedHeapSize", stats.used_heap_size());
+    TRACE_COUNTER("v8", "V8.TotalHeapSize", stats.total_heap_size());
+    TRACE_COUNTER("v8", "V8.ExternalMemory", stats.external_memory());
+}
+
 void RuntimeBase::PerformTasksCheckpoint()
 {
     TRACE_EVENT("main", "RuntimeBase::PerformTasksCheckpoint");
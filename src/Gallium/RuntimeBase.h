@@ -227,6 +227,10 @@ private:
                              v8::Local<v8::Promise> promise,
                              v8::Local<v8::Value> parent);
 
+    static void gc_epilogue_callback(v8::Isolate *isolate,
+                                     v8::GCType type,
+                                     v8::GCCallbackFlags flags);
+
     std::string                  runtime_id_;
     bool                         disposed_;
     uv_loop_t                   *event_loop_;
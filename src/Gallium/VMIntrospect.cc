@@ -24,6 +24,7 @@
 #include "Core/Journal.h"
 #include "Core/Utils.h"
 #include "Core/TraceEvent.h"
+#include "Core/NativeHeap.h"
 #include "Gallium/VMIntrospect.h"
 #include "Gallium/binder/Convert.h"
 #include "Gallium/binder/ThrowExcept.h"
@@ -458,6 +459,136 @@ void introspect_finish_process_tracing(const v8::FunctionCallbackInfo<v8::Value>
     info.GetReturnValue().Set(resolver->GetPromise());
 }
 
+//! TSDecl:
+//! interface NativeHeapArenaStatistics {
+//!   index: number;
+//!   threads: number;
+//!   activeBytes: number;
+//!   dirtyBytes: number;
+//!   muzzyBytes: number;
+//!   smallAllocatedBytes: number;
+//!   largeAllocatedBytes: number;
+//!   tcacheBytes: number;
+//! }
+//!
+//! interface NativeHeapStatistics {
+//!   allocated: number;
+//!   active: number;
+//!   resident: number;
+//!   mapped: number;
+//!   metadata: number;
+//!   retained: number;
+//!   tcacheBytes: number;
+//!   threadAllocated: number;
+//!   threadDeallocated: number;
+//!   arenas: Array<NativeHeapArenaStatistics>;
+//! }
+
+//! TSDecl: function getNativeHeapStatistics(perArena?: boolean): NativeHeapStatistics
+void introspect_get_native_heap_statistics(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    v8::Isolate *isolate = get_bare_introspect_ptr(info)->getIsolate();
+    v8::HandleScope scope(isolate);
+    v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+    if (info.Length() > 1)
+        g_throw(TypeError, fmt::format("Function expects at most 1 argument but {} provided", info.Length()));
+
+    bool per_arena = false;
+    if (info.Length() == 1 && !info[0]->IsUndefined())
+    {
+        if (!info[0]->IsBoolean())
+            g_throw(TypeError, "Argument `perArena` must be a boolean");
+        per_arena = binder::from_v8<bool>(isolate, info[0]);
+    }
+
+    if (!NativeHeap::IsAvailable())
+        g_throw(Error, "Native heap statistics are not available in this build");
+
+    std::optional<NativeHeap::Stats> stats = NativeHeap::Collect(per_arena);
+    if (!stats)
+        g_throw(Error, "Failed to collect native heap statistics");
+
+    auto set = [isolate, context](v8::Local<v8::Object> obj, const char *name, auto value) {
+        obj->Set(context, binder::to_v8(isolate, name), binder::to_v8(isolate, value)).Check();
+    };
+
+    v8::Local<v8::Array> arenas = v8::Array::New(isolate, static_cast<int>(stats->arenas.size()));
+    for (uint32_t i = 0; i < stats->arenas.size(); i++)
+    {
+        const NativeHeap::ArenaStats& arena = stats->arenas[i];
+        v8::Local<v8::Object> cur = v8::Object::New(isolate);
+        set(cur, "index", arena.index);
+        set(cur, "threads", arena.threads);
+        set(cur, "activeBytes", arena.active_bytes);
+        set(cur, "dirtyBytes", arena.dirty_bytes);
+        set(cur, "muzzyBytes", arena.muzzy_bytes);
+        set(cur, "smallAllocatedBytes", arena.small_allocated_bytes);
+        set(cur, "largeAllocatedBytes", arena.large_allocated_bytes);
+        set(cur, "tcacheBytes", arena.tcache_bytes);
+        arenas->Set(context, i, cur).Check();
+    }
+
+    v8::Local<v8::Object> result = v8::Object::New(isolate);
+    set(result, "allocated", stats->allocated);
+    set(result, "active", stats->active);
+    set(result, "resident", stats->resident);
+    set(result, "mapped", stats->mapped);
+    set(result, "metadata", stats->metadata);
+    set(result, "retained", stats->retained);
+    set(result, "tcacheBytes", stats->tcache_bytes);
+    set(result, "threadAllocated", stats->thread_allocated);
+    set(result, "threadDeallocated", stats->thread_deallocated);
+    result->Set(context, binder::to_v8(isolate, "arenas"), arenas).Check();
+
+    info.GetReturnValue().Set(result);
+}
+
+//! TSDecl: function purgeNativeHeap(): void
+void introspect_purge_native_heap(g_maybe_unused const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    if (!NativeHeap::Purge())
+        g_throw(Error, "Failed to purge native heap");
+}
+
+//! TSDecl: function setNativeHeapDecayTime(dirtyMs: number, muzzyMs: number): void
+void introspect_set_native_heap_decay_time(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    v8::Isolate *isolate = get_bare_introspect_ptr(info)->getIsolate();
+    if (info.Length() != 2)
+        g_throw(TypeError, fmt::format("Function expects 2 arguments but {} provided", info.Length()));
+    if (!info[0]->IsNumber() || !info[1]->IsNumber())
+        g_throw(TypeError, "Arguments `dirtyMs` and `muzzyMs` must be numbers");
+
+    auto dirty_ms = binder::from_v8<int64_t>(isolate, info[0]);
+    auto muzzy_ms = binder::from_v8<int64_t>(isolate, info[1]);
+    if (dirty_ms < -1 || muzzy_ms < -1)
+        g_throw(RangeError, "Decay time must be -1 (never purge) or a non-negative number");
+
+    if (!NativeHeap::SetDecayTime(dirty_ms, muzzy_ms))
+        g_throw(Error, "Failed to set decay time of native heap");
+}
+
+//! TSDecl: function setNativeHeapTraceInterval(intervalMs: number): void
+void introspect_set_native_heap_trace_interval(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    VMIntrospect *introspect = get_bare_introspect_ptr(info);
+    v8::Isolate *isolate = introspect->getIsolate();
+    if (info.Length() != 1)
+        g_throw(TypeError, fmt::format("Function expects 1 argument but {} provided", info.Length()));
+    if (!info[0]->IsNumber())
+        g_throw(TypeError, "Argument `intervalMs` must be a number");
+
+    auto interval = binder::from_v8<int64_t>(isolate, info[0]);
+    if (interval < 0)
+        g_throw(RangeError, "Argument `intervalMs` must be a non-negative number");
+
+    if (interval > 0 && !NativeHeap::IsAvailable())
+        g_throw(Error, "Native heap statistics are not available in this build");
+
+    introspect->SetNativeHeapTraceInterval(static_cast<uint64_t>(interval));
+}
+
 } // namespace anonymous
 
 std::unique_ptr<VMIntrospect> VMIntrospect::InstallGlobal(v8::Isolate *isolate)
@@ -511,6 +642,18 @@ std::unique_ptr<VMIntrospect> VMIntrospect::InstallGlobal(v8::Isolate *isolate)
     object->Set(isolate,
                 "finishProcessTracing",
                 FT::New(isolate, introspect_finish_process_tracing));
+    object->Set(isolate,
+                "getNativeHeapStatistics",
+                FT::New(isolate, introspect_get_native_heap_statistics));
+    object->Set(isolate,
+                "purgeNativeHeap",
+                FT::New(isolate, introspect_purge_native_heap));
+    object->Set(isolate,
+                "setNativeHeapDecayTime",
+                FT::New(isolate, introspect_set_native_heap_decay_time));
+    object->Set(isolate,
+                "setNativeHeapTraceInterval",
+                FT::New(isolate, introspect_set_native_heap_trace_interval));
 
     auto introspect = std::make_unique<VMIntrospect>(isolate);
     CHECK(introspect);
@@ -531,6 +674,26 @@ VMIntrospect::~VMIntrospect()
         item.second.Reset();
 }
 
+void VMIntrospect::SetNativeHeapTraceInterval(uint64_t interval_ms)
+{
+    if (interval_ms == 0)
+    {
+        native_heap_trace_timer_.reset();
+        return;
+    }
+
+    if (!native_heap_trace_timer_)
+    {
+        native_heap_trace_timer_ = std::make_unique<uv::TimerHandle>(
+                EventLoop::GetCurrent()->handle());
+        // The timer should not keep the event loop alive
+        native_heap_trace_timer_->Unref();
+    }
+
+    native_heap_trace_timer_->Stop();
+    native_heap_trace_timer_->Start(0, interval_ms, NativeHeap::TraceCounters);
+}
+
 void VMIntrospect::setCallbackSlot(CallbackSlot slot, v8::Local<v8::Function> func)
 {
     callback_map_[slot].Reset();
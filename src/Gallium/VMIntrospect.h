@@ -24,6 +24,7 @@
 #include "include/v8.h"
 
 #include "Core/TraceEvent.h"
+#include "Core/EventLoop.h"
 #include "Gallium/Gallium.h"
 
 GALLIUM_NS_BEGIN
@@ -119,11 +120,18 @@ public:
         return current_tracing_session_;
     }
 
+    /**
+     * Emit native heap statistics as Perfetto counters periodically.
+     * An `interval_ms` of 0 stops the emission.
+     */
+    void SetNativeHeapTraceInterval(uint64_t interval_ms);
+
 private:
     CallbackMap                                  callback_map_;
     TaskQueue                                    scheduled_task_queue_;
     v8::Isolate                                 *isolate_;
     std::unique_ptr<perfetto::TracingSession>    current_tracing_session_;
+    std::unique_ptr<uv::TimerHandle>             native_heap_trace_timer_;
 };
 
 GALLIUM_NS_END
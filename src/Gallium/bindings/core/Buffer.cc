@@ -123,13 +123,11 @@ size_t encodeStringHex(v8::Isolate *isolate, uint8_t *dstBuf, v8::Local<v8::Stri
     uint8_t *ptr = dstBuf;
     if (p)
         *ptr++ = parse_hex_byte(hex_str[0]);
-    while (p < hex_str.length())
-    {
-        uint8_t r0 = parse_hex_byte(hex_str[p++]);
-        uint8_t r1 = parse_hex_byte(hex_str[p++]);
-        *ptr++ = (r0 << 4) | r1;
-    }
-    return (ptr - dstBuf);
+    ssize_t ret = ByteArrayCodecs::DecodeHex(hex_str.data() + p, hex_str.length() - p,
+                                             ptr, ByteArrayCodecs::DecodeMode::kStrict);
+    if (ret < 0)
+        throw std::runtime_error("Unexpected character in hex string");
+    return (ptr - dstBuf) + ret;
 }
 
 size_t encodeString(v8::Isolate *isolate, uint8_t *buf, size_t buflen,
@@ -375,7 +373,7 @@ v8::Local<v8::Promise> Buffer::MakeFromFile(const std::string& path)
                                                          nullptr);
 
         resolver->Resolve(context, buffer_obj).Check();
-    });
+    }, EventLoop::ThreadPoolLane::kIO);
 
     return resolver->GetPromise();
 }
@@ -562,6 +560,18 @@ v8::Local<v8::Value> Buffer::toString(uint32_t coding, int32_t length)
         break;
     }
 
+    case Encoding::kHex:
+    {
+        std::string hex = ByteArrayCodecs::EncodeHex(addressU8(), length);
+        auto maybe = v8::String::NewFromOneByte(isolate,
+                                                reinterpret_cast<const uint8_t*>(hex.data()),
+                                                v8::NewStringType::kNormal,
+                                                static_cast<int>(hex.length()));
+        if (!maybe.ToLocal(&result))
+            g_throw(Error, "Failed to create hex string");
+        break;
+    }
+
     default:
         g_throw(Error, "Unexpected coding name");
     }
@@ -15,6 +15,8 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "include/core/SkBBHFactory.h"
+
 #include "Core/Errors.h"
 #include "Gallium/bindings/glamor/CkPictureRecorder.h"
 #include "Gallium/bindings/glamor/Exports.h"
@@ -22,16 +24,63 @@
 #include "Gallium/bindings/glamor/TrivialInterface.h"
 GALLIUM_BINDINGS_GLAMOR_NS_BEGIN
 
-v8::Local<v8::Value> CkPictureRecorder::beginRecording(v8::Local<v8::Value> bounds)
+CkPictureRecorder::CkPictureRecorder()
+    : bbh_mode_(PictureBBHMode::kNone)
 {
-    v8::Isolate *isolate = v8::Isolate::GetCurrent();
-    SkCanvas *canvas = recorder_.beginRecording(ExtractCkRect(isolate, bounds));
+}
+
+v8::Local<v8::Value> CkPictureRecorder::BeginRecordingInternal(v8::Isolate *isolate,
+                                                               const SkRect& bounds,
+                                                               PictureBBHMode mode)
+{
+    // The R-tree is built when the recording is finished,
+    // so the factory does not need to outlive this call.
+    SkRTreeFactory rtree_factory;
+    SkCanvas *canvas = recorder_.beginRecording(
+            bounds, mode == PictureBBHMode::kRTree ? &rtree_factory : nullptr);
     CHECK(canvas);
+    bbh_mode_ = mode;
     auto obj = binder::NewObject<CkCanvas>(isolate, canvas);
     canvas_.Reset(isolate, obj);
     return obj;
 }
 
+v8::Local<v8::Value> CkPictureRecorder::beginRecording(v8::Local<v8::Value> bounds)
+{
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    return BeginRecordingInternal(isolate, ExtractCkRect(isolate, bounds),
+                                  PictureBBHMode::kNone);
+}
+
+v8::Local<v8::Value> CkPictureRecorder::beginRecordingWithBBH(v8::Local<v8::Value> bounds,
+                                                              uint32_t mode)
+{
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    if (mode > static_cast<uint32_t>(PictureBBHMode::kLast))
+        g_throw(RangeError, "Argument `mode` has an invalid enumeration value");
+    return BeginRecordingInternal(isolate, ExtractCkRect(isolate, bounds),
+                                  static_cast<PictureBBHMode>(mode));
+}
+
+sk_sp<SkPicture> CkPictureRecorder::MaybeRecordWithBBH(sk_sp<SkPicture> picture)
+{
+    if (bbh_mode_ != PictureBBHMode::kAuto ||
+        picture->approximateOpCount(false) <= kAutoBBHOpsThreshold)
+    {
+        return picture;
+    }
+
+    // Play back the operations into a new recorder which builds an R-tree.
+    // `SkCanvas::drawPicture` cannot be used here, as it would be recorded
+    // as a single operation.
+    SkRTreeFactory rtree_factory;
+    SkPictureRecorder recorder;
+    SkCanvas *canvas = recorder.beginRecording(picture->cullRect(), &rtree_factory);
+    picture->playback(canvas);
+    sk_sp<SkPicture> result = recorder.finishRecordingAsPicture();
+    return result ? result : picture;
+}
+
 v8::Local<v8::Value> CkPictureRecorder::getRecordingCanvas()
 {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
@@ -48,6 +97,7 @@ v8::Local<v8::Value> CkPictureRecorder::finishRecordingAsPicture()
 
     sk_sp<SkPicture> pict = recorder_.finishRecordingAsPicture();
     CHECK(pict);
+    pict = MaybeRecordWithBBH(std::move(pict));
     canvas_.Reset();
     return binder::NewObject<CkPictureWrap>(isolate, pict);
 }
@@ -60,6 +110,7 @@ v8::Local<v8::Value> CkPictureRecorder::finishRecordingAsPictureWithCull(v8::Loc
     sk_sp<SkPicture> pict = recorder_.finishRecordingAsPictureWithCull(
             ExtractCkRect(isolate, cull));
     CHECK(pict);
+    pict = MaybeRecordWithBBH(std::move(pict));
     canvas_.Reset();
     return binder::NewObject<CkPictureWrap>(isolate, pict);
 }
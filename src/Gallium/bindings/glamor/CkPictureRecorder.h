@@ -25,17 +25,45 @@
 #include "Gallium/bindings/glamor/TrivialInterface.h"
 GALLIUM_BINDINGS_GLAMOR_NS_BEGIN
 
+enum class PictureBBHMode : uint32_t
+{
+    // Record without a bounding box hierarchy
+    kNone,
+
+    // Record with an R-tree
+    kRTree,
+
+    // Build an R-tree for the recorded picture only if it has more than
+    // `CkPictureRecorder::kAutoBBHOpsThreshold` operations
+    kAuto,
+
+    kLast = kAuto
+};
+
 //! TSDecl: class CkPictureRecorder
 class CkPictureRecorder : public ExportableObjectBase
 {
 public:
+    constexpr static int kAutoBBHOpsThreshold = 512;
+
     //! TSDecl: constructor()
-    CkPictureRecorder() = default;
+    CkPictureRecorder();
     ~CkPictureRecorder() = default;
 
     //! TSDecl: function beginRecording(bounds: CkRect): CkCanvas
     v8::Local<v8::Value> beginRecording(v8::Local<v8::Value> bounds);
 
+    /**
+     * Pictures recorded with a bounding box hierarchy (BBH) only play back
+     * the operations which intersect with the clip of the canvas, which
+     * benefits large pictures that are mostly clipped out (e.g. scrolling
+     * contents). Building the BBH costs extra time when recording finishes.
+     */
+
+    //! TSDecl: function beginRecordingWithBBH(bounds: CkRect,
+    //!                                        mode: Enum<PictureBBHMode>): CkCanvas
+    v8::Local<v8::Value> beginRecordingWithBBH(v8::Local<v8::Value> bounds, uint32_t mode);
+
     //! TSDecl: function getRecordingCanvas(): CkCanvas | null
     v8::Local<v8::Value> getRecordingCanvas();
 
@@ -46,7 +74,13 @@ public:
     v8::Local<v8::Value> finishRecordingAsPictureWithCull(v8::Local<v8::Value> cull);
 
 private:
+    v8::Local<v8::Value> BeginRecordingInternal(v8::Isolate *isolate,
+                                                const SkRect& bounds,
+                                                PictureBBHMode mode);
+    sk_sp<SkPicture> MaybeRecordWithBBH(sk_sp<SkPicture> picture);
+
     SkPictureRecorder recorder_;
+    PictureBBHMode bbh_mode_;
     v8::Global<v8::Object> canvas_;
 };
 
@@ -21,6 +21,7 @@
 #include "fmt/format.h"
 
 #include "Glamor/PresentThread.h"
+#include "Glamor/Layers/PictureContentHash.h"
 #include "Gallium/binder/CallV8.h"
 #include "Gallium/bindings/glamor/Exports.h"
 #include "Gallium/bindings/glamor/PromiseHelper.h"
@@ -193,4 +194,16 @@ uint32_t CkPictureWrap::uniqueId()
     return picture_->uniqueID();
 }
 
+uint64_t CkPictureWrap::getContentHash()
+{
+    if (!content_hash_)
+        content_hash_ = gl::ComputePictureContentHash(picture_);
+    return *content_hash_;
+}
+
+v8::Local<v8::Value> CkPictureWrap::contentHash()
+{
+    return v8::BigInt::NewFromUnsigned(v8::Isolate::GetCurrent(), getContentHash());
+}
+
 GALLIUM_BINDINGS_GLAMOR_NS_END
@@ -19,6 +19,7 @@
 
 #include "Core/Errors.h"
 #include "Core/EventLoop.h"
+#include "Core/CpuDispatch.h"
 #include "Core/TraceEvent.h"
 #include "Gallium/bindings/glamor/ConcurrentVertexProcessor.h"
 #include "Gallium/bindings/glamor/TrivialInterface.h"
@@ -136,6 +137,42 @@ ConcurrentVertexProcessor::ConcurrentVertexProcessor(uint32_t vertexCountHint,
 
 namespace {
 
+// `affine` is in the order of `SkMatrix::asAffine()`
+CPU_DISPATCH_INLINE void map_points_affine_body(const float *__restrict src, float *__restrict dst,
+                                                int32_t count, const float *affine)
+{
+    const float sx = affine[SkMatrix::kAScaleX], ky = affine[SkMatrix::kASkewY];
+    const float kx = affine[SkMatrix::kASkewX], sy = affine[SkMatrix::kAScaleY];
+    const float tx = affine[SkMatrix::kATransX], ty = affine[SkMatrix::kATransY];
+    for (int32_t i = 0; i < count; i++)
+    {
+        float x = src[i * 2];
+        float y = src[i * 2 + 1];
+        dst[i * 2] = sx * x + kx * y + tx;
+        dst[i * 2 + 1] = ky * x + sy * y + ty;
+    }
+}
+
+CPU_DISPATCH_DEFINE_VARIANTS(map_points_affine, void,
+                             (const float *src, float *dst, int32_t count, const float *affine),
+                             (src, dst, count, affine))
+
+CpuDispatchedFunction<void(const float*, float*, int32_t, const float*)> g_map_points_affine(
+        "ConcurrentVertexProcessor::MapPointsAffine", CPU_DISPATCH_VARIANTS_LIST(map_points_affine));
+
+void map_points(const SkMatrix& matrix, SkPoint *dst, const SkPoint *src, int32_t count)
+{
+    float affine[6];
+    if (!matrix.asAffine(affine))
+    {
+        // Perspective matrices are rare for vertices
+        matrix.mapPoints(dst, src, count);
+        return;
+    }
+    g_map_points_affine(reinterpret_cast<const float*>(src),
+                        reinterpret_cast<float*>(dst), count, affine);
+}
+
 // NOLINTNEXTLINE
 struct TransformContext
 {
@@ -353,14 +390,14 @@ v8::Local<v8::Value> ConcurrentVertexProcessor::transform(v8::Local<v8::Value> b
                 auto& per_task = ctx->per_task_contexts[task_id];
                 SkPoint *src = per_task.in_pos.GetPointer();
                 SkPoint *dst = per_task.out_pos.GetPointer();
-                ctx->matrix_store[per_task.pos_mat_id].mapPoints(
-                        dst, src, per_task.in_pos.GetPointCount());
+                map_points(ctx->matrix_store[per_task.pos_mat_id],
+                           dst, src, per_task.in_pos.GetPointCount());
                 if (per_task.in_uvs.buffer)
                 {
                     src = per_task.in_uvs.GetPointer();
                     dst = per_task.out_uvs.GetPointer();
-                    ctx->matrix_store[per_task.uvs_mat_id].mapPoints(
-                            dst, src, per_task.in_uvs.GetPointCount());
+                    map_points(ctx->matrix_store[per_task.uvs_mat_id],
+                               dst, src, per_task.in_uvs.GetPointCount());
                 }
             }
         }, [ctx = transform_ctx.get()]() {
@@ -372,7 +409,7 @@ v8::Local<v8::Value> ConcurrentVertexProcessor::transform(v8::Local<v8::Value> b
 
             ctx->ResolvePromise();
             delete ctx;
-        });
+        }, EventLoop::ThreadPoolLane::kInteractive);
     }
 
     (void) transform_ctx.release();
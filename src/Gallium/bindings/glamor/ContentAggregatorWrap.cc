@@ -121,6 +121,32 @@ v8::Local<v8::Value> ContentAggregatorWrap::purgeRasterCacheResources()
             isolate, handle_, {}, GLOP_CONTENTAGGREGATOR_PURGE_RASTER_CACHE_RESOURCES);
 }
 
+v8::Local<v8::Value> ContentAggregatorWrap::startSceneRecording(const std::string& path)
+{
+    TRACE_EVENT("main", "ContentAggregatorWrap::startSceneRecording");
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    return PromisifiedRemoteCall::Call(
+            isolate, handle_, {}, GLOP_CONTENTAGGREGATOR_START_SCENE_RECORDING, path);
+}
+
+v8::Local<v8::Value> ContentAggregatorWrap::stopSceneRecording()
+{
+    TRACE_EVENT("main", "ContentAggregatorWrap::stopSceneRecording");
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    return PromisifiedRemoteCall::Call(
+            isolate, handle_, PromisifiedRemoteCall::GenericConvert<NoCast<uint32_t>>,
+            GLOP_CONTENTAGGREGATOR_STOP_SCENE_RECORDING);
+}
+
+v8::Local<v8::Value> ContentAggregatorWrap::setDedicatedRenderThread(bool enabled)
+{
+    TRACE_EVENT("main", "ContentAggregatorWrap::setDedicatedRenderThread");
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    return PromisifiedRemoteCall::Call(
+            isolate, handle_, PromisifiedRemoteCall::GenericConvert<NoCast<bool>>,
+            GLOP_CONTENTAGGREGATOR_SET_DEDICATED_RENDER_THREAD, enabled);
+}
+
 v8::Local<v8::Value> ContentAggregatorWrap::importGpuSemaphoreFd(v8::Local<v8::Value> fd)
 {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
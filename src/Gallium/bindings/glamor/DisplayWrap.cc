@@ -59,6 +59,11 @@ DisplayWrap::DisplayWrap(std::shared_ptr<gl::PresentRemoteHandle> handle)
                 }
                 return std::vector<v8::Local<v8::Value>>{result};
             }
+        },
+        {
+            "memory-pressure",
+            GLSI_DISPLAY_MEMORY_PRESSURE,
+            GenericSignalArgsConverter<AutoEnumCast<gl::MemoryPressureLevel>, NoCast<size_t>>
         }
     });
 }
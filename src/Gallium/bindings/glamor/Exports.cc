@@ -32,6 +32,7 @@
 #include "Gallium/bindings/glamor/Exports.h"
 #include "Gallium/bindings/glamor/Scene.h"
 #include "Gallium/bindings/glamor/CkFontMgrWrap.h"
+#include "Gallium/bindings/glamor/CkPictureRecorder.h"
 #include "Glamor/Monitor.h"
 #include "Glamor/Surface.h"
 GALLIUM_BINDINGS_GLAMOR_NS_BEGIN
@@ -253,6 +254,13 @@ void GlamorSetInstanceProperties(v8::Local<v8::Object> instance)
         { "IMAGE_FILTER_MAP_DIRECTION_REVERSE", EV(SkImageFilter::MapDirection::kReverse_MapDirection) },
         { "IMAGE_FILTER_MAP_DIRECTION_FORWARD", EV(SkImageFilter::MapDirection::kForward_MapDirection) },
 
+        { "PICTURE_BBH_MODE_NONE", EV(PictureBBHMode::kNone) },
+        { "PICTURE_BBH_MODE_RTREE", EV(PictureBBHMode::kRTree) },
+        { "PICTURE_BBH_MODE_AUTO", EV(PictureBBHMode::kAuto) },
+
+        { "MEMORY_PRESSURE_LEVEL_MODERATE", EV(gl::MemoryPressureLevel::kModerate) },
+        { "MEMORY_PRESSURE_LEVEL_CRITICAL", EV(gl::MemoryPressureLevel::kCritical) },
+
         { "POINTER_BUTTON_LEFT",    EV(gl::PointerButton::kLeft)        },
         { "POINTER_BUTTON_RIGHT",   EV(gl::PointerButton::kRight)       },
         { "POINTER_BUTTON_MIDDLE",  EV(gl::PointerButton::kMiddle)      },
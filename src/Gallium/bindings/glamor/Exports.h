@@ -19,6 +19,7 @@
 #define COCOA_GALLIUM_BINDINGS_GLAMOR_EXPORTS_H
 
 #include <map>
+#include <optional>
 
 #include "Gallium/bindings/Base.h"
 #include "Gallium/bindings/glamor/Types.h"
@@ -29,6 +30,7 @@
 #include "Glamor/PresentRemoteHandle.h"
 #include "Glamor/PresentRemoteCallReturn.h"
 #include "Glamor/MaybeGpuObject.h"
+#include "Glamor/PointerMotionCoalescer.h"
 
 #include "include/core/SkRRect.h"
 #include "include/core/SkImageFilter.h"
@@ -90,6 +92,14 @@ public:
     //! TSDecl: function traceResourcesJSON(): Promise<string>
     v8::Local<v8::Value> traceResourcesJSON();
 
+    // Counters are maintained incrementally and read without
+    // a roundtrip to the present thread.
+    //! TSDecl: function getResourceCounters(): ResourceCounters
+    v8::Local<v8::Value> getResourceCounters();
+
+    //! TSDecl: function getMessageQueueProfileJSON(): string | null
+    v8::Local<v8::Value> getMessageQueueProfileJSON();
+
     //! TSDecl: function collect(): void
     void collect();
 
@@ -113,6 +123,9 @@ public:
     //! TSDecl: function generateCurrentReport(): Report
     v8::Local<v8::Value> generateCurrentReport();
 
+    //! TSDecl: function generateStageHistogramsJSON(): string
+    std::string generateStageHistogramsJSON();
+
 private:
     std::shared_ptr<gl::GProfiler> profiler_;
 };
@@ -265,6 +278,16 @@ public:
     //! TSDecl: function setAttachedCursor(cursor: Cursor): Promise<void>
     g_nodiscard v8::Local<v8::Value> setAttachedCursor(v8::Local<v8::Value> cursor);
 
+    //! TSDecl:
+    //! interface PointerMotionEvent {
+    //!   time: number;
+    //!   x: number;
+    //!   y: number;
+    //! }
+
+    //! TSDecl: function getCoalescedPointerMotions(): Array<PointerMotionEvent>
+    g_nodiscard v8::Local<v8::Value> getCoalescedPointerMotions();
+
 private:
     v8::Local<v8::Object> OnGetObjectSelf(v8::Isolate *isolate) override;
 
@@ -272,6 +295,7 @@ private:
     v8::Global<v8::Object>                  display_wrapped_;
     uint32_t                                surface_closed_slot_;
     v8::Global<v8::Object>                  content_aggregator_;
+    gl::PointerMotionCoalescer::SampleVector last_coalesced_motions_;
 };
 
 //! TSDecl: class ContentAggregator extends EventEmitterBase
@@ -300,6 +324,15 @@ public:
     //! TSDecl: function purgeRasterCacheResources(): Promise<void>
     v8::Local<v8::Value> purgeRasterCacheResources();
 
+    //! TSDecl: function startSceneRecording(path: string): Promise<void>
+    v8::Local<v8::Value> startSceneRecording(const std::string& path);
+
+    //! TSDecl: function stopSceneRecording(): Promise<number>
+    v8::Local<v8::Value> stopSceneRecording();
+
+    //! TSDecl: function setDedicatedRenderThread(enabled: boolean): Promise<boolean>
+    v8::Local<v8::Value> setDedicatedRenderThread(bool enabled);
+
     //! TSDecl: function importGpuSemaphoreFd(fd: GpuExportedFd): Promise<bigint>
     v8::Local<v8::Value> importGpuSemaphoreFd(v8::Local<v8::Value> fd);
 
@@ -489,9 +522,16 @@ public:
     //! TSDecl: function uniqueId(): number
     g_nodiscard uint32_t uniqueId();
 
+    //! TSDecl: function contentHash(): bigint
+    g_nodiscard v8::Local<v8::Value> contentHash();
+
+    // The hash is computed lazily and cached, as the picture is immutable.
+    g_nodiscard uint64_t getContentHash();
+
 private:
-    sk_sp<SkPicture>    picture_;
-    size_t              picture_size_hint_;
+    sk_sp<SkPicture>         picture_;
+    size_t                   picture_size_hint_;
+    std::optional<uint64_t>  content_hash_;
 };
 
 //! TSDecl: class CkBitmap
@@ -26,6 +26,11 @@ void GProfilerWrap::purgeRecentHistorySamples(bool free_memory)
     profiler_->PurgeRecentHistorySamples(free_memory);
 }
 
+std::string GProfilerWrap::generateStageHistogramsJSON()
+{
+    return profiler_->GenerateStageHistogramsJSON();
+}
+
 namespace {
 
 std::unordered_map<gl::GProfiler::FrameMilestone, std::string_view> g_frame_milestones_tags = {
@@ -36,7 +41,8 @@ std::unordered_map<gl::GProfiler::FrameMilestone, std::string_view> g_frame_mile
     { gl::GProfiler::kPaintBegin_FrameMilestone,    "paintBegin"    },
     { gl::GProfiler::kPaintEnd_FrameMilestone,      "paintEnd"      },
     { gl::GProfiler::kBegin_FrameMilestone,         "begin"         },
-    { gl::GProfiler::kEnd_FrameMilestone,           "end"           }
+    { gl::GProfiler::kEnd_FrameMilestone,           "end"           },
+    { gl::GProfiler::kScheduled_FrameMilestone,     "scheduled"     }
 };
 
 } // namespace anonymous
@@ -71,6 +77,7 @@ v8::Local<v8::Value> GProfilerWrap::generateCurrentReport()
         }
 
         entry["milestones"] = binder::to_v8(isolate, milestones);
+        entry["frameArenaBytes"] = binder::to_v8(isolate, report->entries[i].frame_arena_bytes);
         entries[i] = binder::to_v8(isolate, entry);
     }
 
@@ -78,6 +85,8 @@ v8::Local<v8::Value> GProfilerWrap::generateCurrentReport()
     result["timebaseUsSinceEpoch"] =
             binder::to_v8(isolate, TM::duration_cast<TM::microseconds>(
                     tbase.time_since_epoch()).count());
+    result["frameArenaHighWaterMark"] =
+            binder::to_v8(isolate, report->frame_arena_high_water_mark);
     result["entries"] = binder::to_v8(isolate, entries);
 
     return binder::to_v8(isolate, result);
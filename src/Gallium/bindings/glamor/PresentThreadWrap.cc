@@ -18,6 +18,7 @@
 #include "Glamor/Glamor.h"
 #include "Glamor/PresentThread.h"
 #include "Glamor/Display.h"
+#include "Glamor/GraphicsResourcesTrackable.h"
 #include "Gallium/bindings/glamor/Exports.h"
 #include "Gallium/bindings/glamor/PromiseHelper.h"
 #include "Gallium/binder/Class.h"
@@ -82,6 +83,43 @@ v8::Local<v8::Value> PresentThreadWrap::traceResourcesJSON()
     );
 }
 
+v8::Local<v8::Value> PresentThreadWrap::getResourceCounters()
+{
+    CheckDisposeOrThrow();
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+
+    using ObjectMap = std::unordered_map<std::string_view, v8::Local<v8::Value>>;
+    ObjectMap result;
+    for (uint32_t i = 0; i <= static_cast<uint32_t>(gl::TrackableCategory::kLast); i++)
+    {
+        auto category = static_cast<gl::TrackableCategory>(i);
+        gl::GraphicsResourcesTrackable::CategoryCounters counters =
+                gl::GraphicsResourcesTrackable::GetCategoryCounters(category);
+
+        result[gl::GraphicsResourcesTrackable::GetCategoryName(category)] =
+            binder::to_v8(isolate, ObjectMap{
+                { "bytes", binder::to_v8(isolate, static_cast<double>(counters.bytes)) },
+                { "objects", binder::to_v8(isolate, static_cast<double>(counters.objects)) },
+                { "peakBytes", binder::to_v8(isolate, static_cast<double>(counters.peak_bytes)) },
+                { "peakObjects", binder::to_v8(isolate, static_cast<double>(counters.peak_objects)) }
+            });
+    }
+
+    return binder::to_v8(isolate, result);
+}
+
+v8::Local<v8::Value> PresentThreadWrap::getMessageQueueProfileJSON()
+{
+    CheckDisposeOrThrow();
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+
+    gl::PresentMessageProfiler *profiler = thread_->GetMessageProfiler();
+    if (!profiler)
+        return v8::Null(isolate);
+
+    return binder::to_v8(isolate, profiler->GenerateJSON());
+}
+
 void PresentThreadWrap::collect()
 {
     CheckDisposeOrThrow();
@@ -15,12 +15,19 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
+
 #include "include/core/SkPicture.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
 
 #include "Core/EventLoop.h"
 #include "Core/Journal.h"
+#include "Core/TraceEvent.h"
+#include "Core/StandaloneThreadPool.h"
 #include "Gallium/bindings/glamor/Scene.h"
 #include "Gallium/bindings/glamor/CkImageWrap.h"
+#include "Gallium/bindings/glamor/TrivialInterface.h"
 #include "Glamor/Layers/LayerTree.h"
 GALLIUM_BINDINGS_GLAMOR_NS_BEGIN
 
@@ -41,11 +48,122 @@ std::string Scene::toString()
     return layer_tree_->ToString();
 }
 
-v8::Local<v8::Value> Scene::toImage(int32_t width, int32_t height)
+namespace {
+
+struct ToImageOptions
+{
+    SkScalar    scale = 1;
+    SkColorType color_type = SkColorType::kN32_SkColorType;
+};
+
+ToImageOptions extract_to_image_options(v8::Isolate *isolate, v8::Local<v8::Value> value)
+{
+    ToImageOptions options;
+    if (value->IsNullOrUndefined())
+        return options;
+
+    if (!value->IsObject())
+        g_throw(TypeError, "Argument `options` must be an object or null");
+
+    v8::Local<v8::Context> ctx = isolate->GetCurrentContext();
+    v8::Local<v8::Object> object = value.As<v8::Object>();
+
+    v8::Local<v8::Value> prop = object->Get(
+            ctx, v8::String::NewFromUtf8Literal(isolate, "scale")).ToLocalChecked();
+    if (!prop->IsNullOrUndefined())
+    {
+        if (!prop->IsNumber())
+            g_throw(TypeError, "SceneToImageOptions: Property `scale` is not a number");
+        double scale = prop.As<v8::Number>()->Value();
+        if (!(scale > 0 && scale <= 1))
+            g_throw(RangeError, "SceneToImageOptions: Property `scale` must be in (0, 1]");
+        options.scale = static_cast<SkScalar>(scale);
+    }
+
+    prop = object->Get(ctx, v8::String::NewFromUtf8Literal(isolate, "colorType")).ToLocalChecked();
+    if (!prop->IsNullOrUndefined())
+    {
+        if (!prop->IsInt32())
+            g_throw(TypeError, "SceneToImageOptions: Property `colorType` is not an integer");
+        options.color_type = ExtractCkColorType(prop.As<v8::Int32>()->Value());
+        if (options.color_type == SkColorType::kUnknown_SkColorType)
+            g_throw(RangeError, "SceneToImageOptions: Property `colorType` is unknown");
+    }
+
+    return options;
+}
+
+sk_sp<SkImage> rasterize_picture_tiled(const gl::MaybeGpuObject<SkPicture>& picture,
+                                       const SkImageInfo& info,
+                                       SkScalar scale,
+                                       StandaloneThreadPool *workers)
+{
+    TRACE_EVENT("rendering", "Scene::RasterizeTiled");
+
+    SkBitmap bitmap;
+    if (!bitmap.tryAllocPixels(info))
+        return nullptr;
+
+    const int32_t tile_size = Scene::kRasterTileSize;
+    int32_t columns = (info.width() + tile_size - 1) / tile_size;
+    int32_t rows = (info.height() + tile_size - 1) / tile_size;
+    auto tiles_count = static_cast<size_t>(columns * rows);
+
+    // Tiles are disjoint regions of the same pixel buffer, so they can
+    // be written concurrently without synchronization.
+    const SkPixmap& pixmap = bitmap.pixmap();
+    std::atomic<bool> failed(false);
+    auto rasterize_tiles = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            int32_t x = static_cast<int32_t>(i % columns) * tile_size;
+            int32_t y = static_cast<int32_t>(i / columns) * tile_size;
+
+            // Tiles on the right and bottom edges are cut by the bounds
+            SkPixmap tile_pixmap;
+            if (!pixmap.extractSubset(&tile_pixmap, SkIRect::MakeXYWH(x, y, tile_size, tile_size)))
+                continue;
+
+            std::unique_ptr<SkCanvas> canvas = SkCanvas::MakeRasterDirect(
+                    tile_pixmap.info(), tile_pixmap.writable_addr(), tile_pixmap.rowBytes());
+            if (!canvas)
+            {
+                failed = true;
+                return;
+            }
+
+            // The canvas is clipped to the tile by its device bounds, and the
+            // bounding box hierarchy of the picture skips the operations outside.
+            canvas->clear(SK_ColorTRANSPARENT);
+            canvas->translate(static_cast<SkScalar>(-x), static_cast<SkScalar>(-y));
+            canvas->scale(scale, scale);
+            picture->playback(canvas.get());
+        }
+    };
+
+    if (workers && tiles_count > 1)
+        workers->parallelFor(0, tiles_count, rasterize_tiles, 1);
+    else
+        rasterize_tiles(0, tiles_count);
+
+    if (failed)
+        return nullptr;
+
+    bitmap.setImmutable();
+    return bitmap.asImage();
+}
+
+} // namespace anonymous
+
+v8::Local<v8::Value> Scene::toImage(int32_t width, int32_t height, v8::Local<v8::Value> options)
 {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     if (layer_tree_ == nullptr)
         g_throw(Error, "No layer tree was associated with current Scene");
+    if (width <= 0 || height <= 0)
+        g_throw(RangeError, "Invalid dimensions of the image");
+
+    ToImageOptions image_options = extract_to_image_options(isolate, options);
 
     // Flatten the layer tree and do an asynchronized rasterization.
     SkRect bounds = SkRect::MakeWH(static_cast<SkScalar>(width), static_cast<SkScalar>(height));
@@ -54,24 +172,33 @@ v8::Local<v8::Value> Scene::toImage(int32_t width, int32_t height)
     if (picture == nullptr)
         g_throw(Error, "Failed in flattening layer tree to generate a SkPicture recording");
 
+    // Thumbnails are rasterized at the target size directly
+    // rather than downscaling a full-size image.
+    SkISize image_size = SkISize::Make(
+            std::max(1, SkScalarCeilToInt(bounds.width() * image_options.scale)),
+            std::max(1, SkScalarCeilToInt(bounds.height() * image_options.scale)));
+    SkAlphaType alpha_type = SkColorTypeIsAlwaysOpaque(image_options.color_type)
+                             ? SkAlphaType::kOpaque_SkAlphaType
+                             : SkAlphaType::kPremul_SkAlphaType;
+    SkImageInfo info = SkImageInfo::Make(image_size, image_options.color_type, alpha_type);
+
+    // The render workers are also used by the tile-based frame generator;
+    // the pool is created on demand.
+    StandaloneThreadPool *workers = nullptr;
+    if (gl::GlobalScope::HasInstance())
+        workers = gl::GlobalScope::Ref().GetRenderWorkersThreadPool().get();
+
     v8::Local<v8::Context> context = isolate->GetCurrentContext();
     v8::Local<v8::Promise::Resolver> resolver = v8::Promise::Resolver::New(context).ToLocalChecked();
 
     auto global_resolver = std::make_shared<v8::Global<v8::Promise::Resolver>>(isolate, resolver);
 
-    // Submit a task to thread pool
-    EventLoop::GetCurrent()->enqueueThreadPoolTask<sk_sp<SkImage>>([picture]() -> sk_sp<SkImage> {
-        SkISize picture_size = SkISize::Make(static_cast<int32_t>(picture->cullRect().width()),
-                                             static_cast<int32_t>(picture->cullRect().height()));
-        SkImageInfo info = SkImageInfo::Make(picture_size,
-                                             SkColorType::kN32_SkColorType,
-                                             SkAlphaType::kPremul_SkAlphaType);
-
-        sk_sp<SkSurface> surface = SkSurfaces::Raster(info);
-        if (surface == nullptr)
-            return nullptr;
-        picture->playback(surface->getCanvas());
-        return surface->makeImageSnapshot();
+    // Submit a task to thread pool, which waits for the tiles rasterized by
+    // the render workers (and rasterizes some of them by itself).
+    SkScalar scale = image_options.scale;
+    EventLoop::GetCurrent()->enqueueThreadPoolTask<sk_sp<SkImage>>(
+            [picture, info, scale, workers]() -> sk_sp<SkImage> {
+        return rasterize_picture_tiled(picture, info, scale, workers);
 
     }, [global_resolver, isolate](sk_sp<SkImage>&& image) {
 
@@ -88,7 +215,7 @@ v8::Local<v8::Value> Scene::toImage(int32_t width, int32_t height)
             resolver->Resolve(context, binder::NewObject<CkImageWrap>(isolate, image)).Check();
         }
         global_resolver->Reset();
-    });
+    }, EventLoop::ThreadPoolLane::kInteractive);
 
     return resolver->GetPromise();
 }
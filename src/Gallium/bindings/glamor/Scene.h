@@ -36,14 +36,21 @@ public:
           const SkISize& frameSize);
     ~Scene();
 
+    // Edge length of the square tiles which are rasterized concurrently
+    constexpr static int32_t kRasterTileSize = 512;
+
     /**
      * `toImage` rasterizes current scene to a pixel image.
      * It is a slow operation which is performed by CPU rasterizer in worker
-     * thread.
+     * threads. The output image is split into tiles which are rasterized
+     * concurrently by the render workers, each of them replaying the scene
+     * clipped to the tile.
      */
 
-    //! TSDecl: function toImage(): Promise<CkImage>
-    g_nodiscard v8::Local<v8::Value> toImage(int32_t width, int32_t height);
+    //! TSDecl: function toImage(width: number, height: number,
+    //!                          options: SceneToImageOptions | null): Promise<CkImage>
+    g_nodiscard v8::Local<v8::Value> toImage(int32_t width, int32_t height,
+                                             v8::Local<v8::Value> options);
 
     //! TSDecl: function toString(): string
     g_nodiscard std::string toString();
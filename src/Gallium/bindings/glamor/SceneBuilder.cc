@@ -38,12 +38,15 @@ GALLIUM_BINDINGS_GLAMOR_NS_BEGIN
 SceneBuilder::SceneBuilder(int32_t width, int32_t height)
     : width_(width)
     , height_(height)
+    , prefers_native_resolution_(false)
 {
 }
 
 void SceneBuilder::pushLayer(const std::shared_ptr<gl::ContainerLayer>& layer)
 {
     CHECK(layer && "Invalid layer");
+    if (prefers_native_resolution_)
+        layer->SetPrefersNativeResolution(true);
 
     if (!layer_stack_.empty())
         layer_stack_.top()->AppendChildLayer(layer);
@@ -60,6 +63,8 @@ void SceneBuilder::addLayer(const std::shared_ptr<gl::Layer>& layer)
     CHECK(layer && "Invalid layer");
     if (layer_stack_.empty())
         g_throw(Error, "Inserting a container layer before adding other layers is required");
+    if (prefers_native_resolution_)
+        layer->SetPrefersNativeResolution(true);
     layer_stack_.top()->AppendChildLayer(layer);
 }
 
@@ -87,6 +92,14 @@ v8::Local<v8::Value> SceneBuilder::pop()
     return GetObjectWeakReference().Get(v8::Isolate::GetCurrent());
 }
 
+v8::Local<v8::Value> SceneBuilder::setPrefersNativeResolution(bool value)
+{
+    // Layers pushed or added after this call will be painted at native
+    // resolution even if the dynamic resolution scaling is active.
+    prefers_native_resolution_ = value;
+    return GetObjectWeakReference().Get(v8::Isolate::GetCurrent());
+}
+
 v8::Local<v8::Value> SceneBuilder::pushOffset(SkScalar x, SkScalar y)
 {
     pushLayer(std::make_shared<gl::TransformLayer>(SkMatrix::Translate(x, y)));
@@ -196,7 +209,8 @@ v8::Local<v8::Value> SceneBuilder::addPicture(v8::Local<v8::Value> picture, bool
     if (unwrapped == nullptr)
         g_throw(TypeError, "Argument `picture` must be a CkPicture");
 
-    addLayer(std::make_shared<gl::PictureLayer>(autoFastClip, unwrapped->getPicture()));
+    addLayer(std::make_shared<gl::PictureLayer>(autoFastClip, unwrapped->getPicture(),
+                                                unwrapped->getContentHash()));
     return GetObjectWeakReference().Get(isolate);
 }
 
@@ -41,6 +41,9 @@ public:
     //! TSDecl: function pop(): SceneBuilder
     v8::Local<v8::Value> pop();
 
+    //! TSDecl: function setPrefersNativeResolution(value: boolean): SceneBuilder
+    v8::Local<v8::Value> setPrefersNativeResolution(bool value);
+
     //! TSDecl: function pushOffset(x: number, y: number): SceneBuilder
     v8::Local<v8::Value> pushOffset(SkScalar x, SkScalar y);
 
@@ -105,6 +108,7 @@ private:
 
     int32_t     width_;
     int32_t     height_;
+    bool        prefers_native_resolution_;
     std::shared_ptr<gl::ContainerLayer> layer_tree_;
     std::stack<std::shared_ptr<gl::ContainerLayer>> layer_stack_;
 };
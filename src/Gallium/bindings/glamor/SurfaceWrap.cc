@@ -15,6 +15,8 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <unordered_map>
+
 #include "fmt/format.h"
 
 #include "Core/EnumClassBitfield.h"
@@ -44,7 +46,13 @@ SurfaceWrap::SurfaceWrap(std::shared_ptr<gl::PresentRemoteHandle> handle,
         { "pointer-hovering", GLSI_SURFACE_POINTER_HOVERING,
           GenericSignalArgsConverter<NoCast<bool>> },
         { "pointer-motion", GLSI_SURFACE_POINTER_MOTION,
-          GenericSignalArgsConverter<NoCast<double>, NoCast<double>> },
+          [this](v8::Isolate *isolate, gl::PresentSignalArgs& info) -> SignalArgsVector {
+              // Coalesced events are kept until the next motion signal,
+              // and converted only when they are requested.
+              last_coalesced_motions_ = std::move(
+                      info.Get<gl::PointerMotionCoalescer::SampleVector>(2));
+              return GenericSignalArgsConverter<NoCast<double>, NoCast<double>>(isolate, info);
+          }},
         { "pointer-button", GLSI_SURFACE_POINTER_BUTTON,
           GenericSignalArgsConverter<AutoEnumCast<gl::PointerButton>, NoCast<bool>> },
         { "pointer-axis", GLSI_SURFACE_POINTER_AXIS,
@@ -130,6 +138,26 @@ v8::Local<v8::Value> SurfaceWrap::getBuffersDescriptor()
             GLOP_SURFACE_GET_BUFFERS_DESCRIPTOR);
 }
 
+v8::Local<v8::Value> SurfaceWrap::getCoalescedPointerMotions()
+{
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+    v8::Local<v8::Array> result = v8::Array::New(
+            isolate, static_cast<int>(last_coalesced_motions_.size()));
+    for (uint32_t i = 0; i < last_coalesced_motions_.size(); i++)
+    {
+        const gl::PointerMotionSample& sample = last_coalesced_motions_[i];
+        std::unordered_map<std::string_view, v8::Local<v8::Value>> fields{
+            { "time", binder::to_v8(isolate, sample.time) },
+            { "x", binder::to_v8(isolate, sample.x) },
+            { "y", binder::to_v8(isolate, sample.y) }
+        };
+        result->Set(context, i, binder::to_v8(isolate, fields)).Check();
+    }
+    return result;
+}
+
 v8::Local<v8::Value> SurfaceWrap::requestNextFrame()
 {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
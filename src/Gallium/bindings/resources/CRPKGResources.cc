@@ -102,7 +102,8 @@ v8::Local<v8::Value> CRPKGStorageWrap::read(size_t src_offset, v8::Local<v8::Val
                         i, static_cast<double>(async_read_ctx->size))).ToChecked();
 
                 delete async_read_ctx;
-            }
+            },
+            EventLoop::ThreadPoolLane::kIO
     );
 
     return resolver->GetPromise();
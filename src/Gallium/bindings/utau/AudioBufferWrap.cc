@@ -17,6 +17,7 @@
 
 #include <cstring>
 
+#include "Core/CpuDispatch.h"
 #include "Gallium/bindings/utau/Exports.h"
 #include "Utau/AudioBuffer.h"
 GALLIUM_BINDINGS_UTAU_NS_BEGIN
@@ -103,6 +104,43 @@ int32_t AudioBufferWrap::read(int32_t plane, int32_t sample_count, int32_t sampl
 
 namespace {
 
+template<typename T>
+CPU_DISPATCH_INLINE void deinterleave_body(const T *__restrict src, T *__restrict dst,
+                                           int32_t num_channels, int32_t count)
+{
+    for (int32_t i = 0; i < count; i++)
+        dst[i] = src[i * num_channels];
+}
+
+// Samples are copied as unsigned integers of the same size
+#define DEFINE_DEINTERLEAVE_KERNEL(bits)                                                    \
+    using uint##bits##_ptr = uint##bits##_t*;                                               \
+    using const_uint##bits##_ptr = const uint##bits##_t*;                                   \
+    CPU_DISPATCH_INLINE void deinterleave##bits##_body(const_uint##bits##_ptr src,          \
+                                                       uint##bits##_ptr dst,                \
+                                                       int32_t num_channels,                \
+                                                       int32_t count) {                     \
+        deinterleave_body(src, dst, num_channels, count);                                   \
+    }                                                                                       \
+    CPU_DISPATCH_DEFINE_VARIANTS(deinterleave##bits, void,                                  \
+                                 (const_uint##bits##_ptr src, uint##bits##_ptr dst,         \
+                                  int32_t num_channels, int32_t count),                     \
+                                 (src, dst, num_channels, count))                           \
+    CpuDispatchedFunction<void(const_uint##bits##_ptr, uint##bits##_ptr, int32_t, int32_t)> \
+        g_deinterleave##bits("AudioBufferWrap::Deinterleave" #bits,                         \
+                             CPU_DISPATCH_VARIANTS_LIST(deinterleave##bits));               \
+    void deinterleave(const_uint##bits##_ptr src, uint##bits##_ptr dst,                     \
+                      int32_t num_channels, int32_t count) {                                \
+        g_deinterleave##bits(src, dst, num_channels, count);                                \
+    }
+
+DEFINE_DEINTERLEAVE_KERNEL(8)
+DEFINE_DEINTERLEAVE_KERNEL(16)
+DEFINE_DEINTERLEAVE_KERNEL(32)
+DEFINE_DEINTERLEAVE_KERNEL(64)
+
+#undef DEFINE_DEINTERLEAVE_KERNEL
+
 template<typename T>
 void copy_interleaved_channel(const uint8_t *src, uint8_t *dst, int32_t ch,
                               int32_t size_per_sample, int32_t num_channels,
@@ -118,8 +156,7 @@ void copy_interleaved_channel(const uint8_t *src, uint8_t *dst, int32_t ch,
 
     auto *dptr = reinterpret_cast<T*>(dst);
 
-    for (int32_t i = 0; i < sample_count; i++)
-        dptr[i] = sptr[i * num_channels + ch];
+    deinterleave(sptr + ch, dptr, num_channels, sample_count);
 }
 
 } // namespace anonymous
@@ -164,14 +201,14 @@ int32_t AudioBufferWrap::readChannel(int32_t ch, int32_t sample_count, int32_t s
         COPY_SAMPLES(uint8_t);
         break;
     case utau::SampleFormat::kS16:
-        COPY_SAMPLES(int16_t);
+        COPY_SAMPLES(uint16_t);
         break;
     case utau::SampleFormat::kS32:
     case utau::SampleFormat::kF32:
-        COPY_SAMPLES(int32_t);
+        COPY_SAMPLES(uint32_t);
         break;
     case utau::SampleFormat::kF64:
-        COPY_SAMPLES(int64_t);
+        COPY_SAMPLES(uint64_t);
         break;
     default:
         MARK_UNREACHABLE();
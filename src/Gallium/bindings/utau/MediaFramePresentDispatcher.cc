@@ -88,6 +88,16 @@ struct MediaFramePresentDispatcher::PresentThreadContext
             audio_queue.pop();
         while (!video_queue.empty())
             video_queue.pop();
+        TraceQueueFill();
+    }
+
+    // Caller must hold `queue_lock` or have stopped the decoding thread
+    void TraceQueueFill()
+    {
+        TRACE_COUNTER("multimedia", "MediaFramePresentDispatcher.AudioQueueFrames",
+                      audio_queue.size());
+        TRACE_COUNTER("multimedia", "MediaFramePresentDispatcher.VideoQueueFrames",
+                      video_queue.size());
     }
 
     void ClearLastFrameStates()
@@ -200,6 +210,7 @@ void MediaFramePresentDispatcher::PresentThreadContext::DecodingThreadRoutine()
             video_queue.back().pts = av_q2d(tb) * static_cast<double>(pts);
             video_queue.back().buffer = std::move(result.video);
         }
+        TraceQueueFill();
     }
 }
 
@@ -437,11 +448,13 @@ void MediaFramePresentDispatcher::TimerCallback(uv_timer_t *timer)
     else
     {
         // No frames available
+        thread_ctx->TraceQueueFill();
         thread_ctx->queue_cond.notify_one();
         uv_timer_start(timer, TimerCallback, 0, 0);
         return;
     }
 
+    thread_ctx->TraceQueueFill();
     thread_ctx->queue_cond.notify_one();
 
     if (thread_ctx->seek_requested_)
@@ -20,6 +20,7 @@
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkColorSpace.h"
+#include "include/core/SkSurface.h"
 #include "include/utils/SkNWayCanvas.h"
 
 #include "Core/StandaloneThreadPool.h"
@@ -30,10 +31,14 @@
 #include "Glamor/Surface.h"
 #include "Glamor/HWComposeSwapchain.h"
 #include "Glamor/GProfiler.h"
+#include "Glamor/RenderThread.h"
+#include "Glamor/PresentThread.h"
+#include "Glamor/MemoryPressureManager.h"
 
 #include "Glamor/Layers/LayerTree.h"
 #include "Glamor/Layers/ContainerLayer.h"
 #include "Glamor/Layers/RasterDrawOpObserver.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.ContentAggregator)
@@ -71,6 +76,31 @@ GLAMOR_TRAMPOLINE_IMPL(ContentAggregator, PurgeRasterCacheResources)
     info.SetReturnStatus(PresentRemoteCall::Status::kOpSuccess);
 }
 
+GLAMOR_TRAMPOLINE_IMPL(ContentAggregator, StartSceneRecording)
+{
+    GLAMOR_TRAMPOLINE_CHECK_ARGS_NUMBER(1);
+    auto bl = info.GetThis()->As<ContentAggregator>();
+    bool success = bl->StartSceneRecording(info.Get<std::string>(0));
+    info.SetReturnStatus(success ? PresentRemoteCall::Status::kOpSuccess
+                                 : PresentRemoteCall::Status::kOpFailed);
+}
+
+GLAMOR_TRAMPOLINE_IMPL(ContentAggregator, StopSceneRecording)
+{
+    GLAMOR_TRAMPOLINE_CHECK_ARGS_NUMBER(0);
+    auto bl = info.GetThis()->As<ContentAggregator>();
+    info.SetReturnValue(bl->StopSceneRecording());
+    info.SetReturnStatus(PresentRemoteCall::Status::kOpSuccess);
+}
+
+GLAMOR_TRAMPOLINE_IMPL(ContentAggregator, SetDedicatedRenderThread)
+{
+    GLAMOR_TRAMPOLINE_CHECK_ARGS_NUMBER(1);
+    auto bl = info.GetThis()->As<ContentAggregator>();
+    info.SetReturnValue(bl->SetDedicatedRenderThread(info.Get<bool>(0)));
+    info.SetReturnStatus(PresentRemoteCall::Status::kOpSuccess);
+}
+
 GLAMOR_TRAMPOLINE_IMPL(ContentAggregator, ImportGpuSemaphoreFromFd)
 {
     GLAMOR_TRAMPOLINE_CHECK_ARGS_NUMBER(2);
@@ -120,13 +150,14 @@ ContentAggregator::ContentAggregator(const std::shared_ptr<Surface>& surface)
     : PresentRemoteHandle(RealType::kContentAggregator)
     , disposed_(false)
     , surface_resize_slot_id_(0)
-    , surface_frame_slot_id_(0)
     , weak_surface_(surface)
     , current_dirty_rect_(SkIRect::MakeEmpty())
     , frame_schedule_state_(FrameScheduleState::kIdle)
     , should_capture_next_frame_(false)
     , capture_next_frame_serial_(0)
+    , current_frame_arena_(0)
     , imported_resources_ids_cnt_(0)
+    , render_in_flight_(false)
 {
     CHECK(surface);
 
@@ -142,10 +173,26 @@ ContentAggregator::ContentAggregator(const std::shared_ptr<Surface>& surface)
     }
 
     auto device = surface->GetRenderTarget()->GetRenderDeviceType();
+    if (options.GetEnableDynamicResolution())
+    {
+        if (device == RenderTarget::RenderDevice::kRaster)
+        {
+            dynamic_resolution_scaler_ = std::make_unique<DynamicResolutionScaler>(
+                    options.GetDynamicResolutionMinScale(),
+                    options.GetDynamicResolutionFrameBudget());
+        }
+        else
+        {
+            QLOG(LOG_WARNING, "Dynamic resolution is only available for raster backend");
+        }
+    }
+
     std::shared_ptr<SkiaGpuContextOwner> gpu_context_owner;
     if (device == RenderTarget::RenderDevice::kHWComposer)
         gpu_context_owner = surface->GetRenderTarget()->GetHWComposeSwapchain();
     layer_generation_cache_ = std::make_unique<LayerGenerationCache>(gpu_context_owner);
+    filter_result_cache_ = std::make_unique<FilterResultCache>(
+            gpu_context_owner, options.GetFilterCacheBudget());
 
     SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_DISPOSE, ContentAggregator_Dispose_Trampoline);
     SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_UPDATE, ContentAggregator_Update_Trampoline);
@@ -153,6 +200,12 @@ ContentAggregator::ContentAggregator(const std::shared_ptr<Surface>& surface)
                         ContentAggregator_CaptureNextFrameAsPicture_Trampoline);
     SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_PURGE_RASTER_CACHE_RESOURCES,
                         ContentAggregator_PurgeRasterCacheResources_Trampoline);
+    SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_START_SCENE_RECORDING,
+                        ContentAggregator_StartSceneRecording_Trampoline);
+    SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_STOP_SCENE_RECORDING,
+                        ContentAggregator_StopSceneRecording_Trampoline);
+    SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_SET_DEDICATED_RENDER_THREAD,
+                        ContentAggregator_SetDedicatedRenderThread_Trampoline);
     SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_IMPORT_GPU_SEMAPHORE_FROM_FD,
                         ContentAggregator_ImportGpuSemaphoreFromFd_Trampoline);
     SetMethodTrampoline(GLOP_CONTENTAGGREGATOR_DELETE_IMPORTED_GPU_SEMAPHORE,
@@ -169,14 +222,6 @@ ContentAggregator::ContentAggregator(const std::shared_ptr<Surface>& surface)
         },
         true
     );
-
-    surface_frame_slot_id_ = surface->Connect(
-        GLSI_SURFACE_FRAME,
-        [this](PresentSignalArgs& info) {
-            this->SurfaceFrameSlot();
-        },
-        true
-    );
 }
 
 ContentAggregator::~ContentAggregator()
@@ -227,15 +272,16 @@ SkColorInfo ContentAggregator::GetOutputColorInfo() const
         gfx_profiler_->EndFrame();      \
     }
 
-void ContentAggregator::SurfaceFrameSlot()
+void ContentAggregator::PresentPendingFrame()
 {
-    TRACE_EVENT("rendering", "ContentAggregator::SurfaceFrameSlot");
+    TRACE_EVENT("rendering", "ContentAggregator::PresentPendingFrame");
 
     if (frame_schedule_state_ != FrameScheduleState::kPendingFrame)
         return;
 
     auto rt = GetSurfaceChecked()->GetRenderTarget();
     rt->Present();
+    frame_pacer_.ReportFramePresented(FramePacer::Clock::now());
 
     for (const auto& observer : layer_tree_->GetObservers())
         observer->EndFrame();
@@ -257,16 +303,53 @@ int32_t ContentAggregator::CaptureNextFrameAsPicture()
     return capture_next_frame_serial_;
 }
 
+bool ContentAggregator::StartSceneRecording(const std::string& path)
+{
+    StopSceneRecording();
+    scene_stream_writer_ = SceneStreamWriter::Make(path);
+    if (!scene_stream_writer_)
+        return false;
+    QLOG(LOG_INFO, "Recording scene stream to {}", path);
+    return true;
+}
+
+uint32_t ContentAggregator::StopSceneRecording()
+{
+    if (!scene_stream_writer_)
+        return 0;
+    uint32_t frames = scene_stream_writer_->GetFramesCount();
+    QLOG(LOG_INFO, "Scene recording stopped, {} frames ({} bytes) were recorded",
+         frames, scene_stream_writer_->GetBytesWritten());
+    scene_stream_writer_.reset();
+    return frames;
+}
+
 ContentAggregator::UpdateResult
 ContentAggregator::Update(const std::shared_ptr<LayerTree> &layer_tree)
 {
     TRACE_EVENT("rendering", "ContentAggregator::Update");
 
-    if (frame_schedule_state_ == FrameScheduleState::kPendingFrame)
+    if (frame_schedule_state_ == FrameScheduleState::kPendingFrame || render_in_flight_)
         return UpdateResult::kFrameDropped;
 
+    // Record the tree before it is merged into the current one by diffing.
+    // Serialization is recording overhead rather than frame work, so it
+    // stays outside of the profiled Begin -> Requested window.
+    if (scene_stream_writer_)
+        scene_stream_writer_->WriteFrame(layer_tree);
+
     GPROFILER_TRY_BEGIN_FRAME()
 
+    auto frame_begin_time = std::chrono::steady_clock::now();
+    if (gfx_profiler_)
+    {
+        // The frame was started by the user when the frame signal was emitted
+        gfx_profiler_->MarkMilestoneInFrame(
+                GProfiler::kScheduled_FrameMilestone,
+                frame_pacer_.GetFrameStartTime().value_or(frame_begin_time));
+    }
+    BumpArena *frame_arena = AcquireFrameArena();
+
     int32_t vp_width = this->GetWidth();
     int32_t vp_height = this->GetHeight();
 
@@ -285,10 +368,13 @@ ContentAggregator::Update(const std::shared_ptr<LayerTree> &layer_tree)
     }
 
     // Prepare to preroll the layer tree
+    prerolled_layers_.clear();
     Layer::PrerollContext preroll_context {
         .gr_context = gr_context,
+        .frame_arena = frame_arena,
         .root_surface_transformation = GetSurfaceChecked()->GetRootTransformation(),
-        .cull_rect = SkRect::MakeEmpty()
+        .cull_rect = SkRect::MakeEmpty(),
+        .prerolled_layers = &prerolled_layers_
     };
 
     GPROFILER_TRY_MARK(PrerollBegin)
@@ -301,12 +387,83 @@ ContentAggregator::Update(const std::shared_ptr<LayerTree> &layer_tree)
 
     GPROFILER_TRY_MARK(PrerollEnd)
 
+    // Frame buffers are always acquired and submitted on this thread,
+    // as they may involve the window system protocol.
+    auto frame = std::make_shared<FrameState>();
+    frame->frame_surface = rt->BeginFrame();
+    frame->viewport = SkISize::Make(vp_width, vp_height);
+    frame->root_transformation = surface->GetRootTransformation();
+    frame->frame_arena = frame_arena;
+    frame->gr_context = gr_context;
+    frame->cull_rect = preroll_context.cull_rect;
+    frame->capture_picture = should_capture_next_frame_;
+    frame->capture_serial = capture_next_frame_serial_;
+    frame->begin_time = frame_begin_time;
+    should_capture_next_frame_ = false;
+
+    if (render_thread_)
+    {
+        // The frame is painted on the dedicated render thread, and it will be
+        // submitted once painting has finished. Before that, no other frames
+        // can be accepted.
+        render_in_flight_ = true;
+        render_thread_->PostTask([this, frame] { PaintFrame(frame.get()); },
+                                 [this, frame] {
+            render_in_flight_ = false;
+            SubmitFrame(frame.get());
+        });
+        return UpdateResult::kSuccess;
+    }
+
+    PaintFrame(frame.get());
+    SubmitFrame(frame.get());
+    return UpdateResult::kSuccess;
+}
+
+void ContentAggregator::PaintFrame(FrameState *frame)
+{
+    TRACE_EVENT("rendering", "ContentAggregator::PaintFrame");
+
+    // Only the states captured in `frame` and the states owned by
+    // the aggregator can be accessed here, as this may be called on
+    // the dedicated render thread.
+    int32_t vp_width = frame->viewport.width();
+    int32_t vp_height = frame->viewport.height();
+    GrDirectContext *gr_context = frame->gr_context;
+    BumpArena *frame_arena = frame->frame_arena;
+
     // Prepare canvases
-    SkSurface *frame_surface = rt->BeginFrame();
+    SkSurface *frame_surface = frame->frame_surface;
     frame_surface->getCanvas()->clear(SK_ColorBLACK);
 
-    SkNWayCanvas multiplexer_canvas(GetWidth(), GetHeight());
-    multiplexer_canvas.addCanvas(frame_surface->getCanvas());
+    // With dynamic resolution scaling, the layer tree is painted into
+    // an offscreen surface at a reduced scale, which will be upscaled into
+    // the frame surface later. Other canvases (observers, recorder) still
+    // receive the drawing operations at native resolution.
+    SkSurface *paint_surface = frame_surface;
+    std::optional<Layer::NativeResolutionDeferral> native_resolution_deferral;
+    if (dynamic_resolution_scaler_ && dynamic_resolution_scaler_->IsScaling())
+    {
+        float scale = dynamic_resolution_scaler_->GetScale();
+        SkISize scaled_size = dynamic_resolution_scaler_->GetScaledSize(
+                SkISize::Make(vp_width, vp_height));
+        SkSurface *scaled_surface = GetDynamicResolutionSurface(frame_surface, scaled_size);
+        if (scaled_surface)
+        {
+            // Drop the states of the last frame, which were saved on the
+            // second level.
+            SkCanvas *canvas = scaled_surface->getCanvas();
+            canvas->restoreToCount(1);
+            canvas->clear(SK_ColorBLACK);
+            canvas->save();
+            canvas->scale(scale, scale);
+            paint_surface = scaled_surface;
+            native_resolution_deferral.emplace(scale, frame_arena);
+        }
+    }
+
+    SkNWayCanvas multiplexer_canvas(vp_width, vp_height);
+    multiplexer_canvas.addCanvas(paint_surface->getCanvas());
     for (const auto& observer : layer_tree_->GetObservers())
     {
         SkCanvas *observer_canvas = observer->BeginFrame(
@@ -323,67 +480,195 @@ ContentAggregator::Update(const std::shared_ptr<LayerTree> &layer_tree)
     }
 
     SkPictureRecorder picture_recorder;
-    if (should_capture_next_frame_)
+    if (frame->capture_picture)
     {
         auto width = static_cast<SkScalar>(vp_width);
         auto height = static_cast<SkScalar>(vp_height);
         SkCanvas *canvas = picture_recorder.beginRecording(width, height);
         multiplexer_canvas.addCanvas(canvas);
     }
-    should_capture_next_frame_ = false;
 
     Layer::PaintContext paint_context {
         .gr_context = gr_context,
         .is_generating_cache = false,
-        .root_surface_transformation = surface->GetRootTransformation(),
-        .frame_surface = frame_surface,
-        .frame_canvas = frame_surface->getCanvas(),
+        .root_surface_transformation = frame->root_transformation,
+        .frame_surface = paint_surface,
+        .frame_canvas = paint_surface->getCanvas(),
         .multiplexer_canvas = &multiplexer_canvas,
-        .cull_rect = preroll_context.cull_rect,
+        .cull_rect = frame->cull_rect,
+        .paints_stack = Layer::PaintContext::PaintsStack(
+                Layer::PaintContext::PaintsStack::container_type(
+                        BumpArenaAllocator<SkPaint>(frame_arena))),
         .cache = layer_generation_cache_.get(),
-        .content_aggregator = this
+        .filter_cache = filter_result_cache_.get(),
+        .save_layer_depth = 0,
+        .content_aggregator = this,
+        .native_resolution_deferral = native_resolution_deferral
+                                      ? &native_resolution_deferral.value() : nullptr,
+        .frame_arena = frame_arena
     };
 
     layer_generation_cache_->BeginFrame();
+    filter_result_cache_->BeginFrame();
 
     GPROFILER_TRY_MARK(PaintBegin)
     layer_tree_->Paint(&paint_context);
+    if (native_resolution_deferral)
+    {
+        PaintNativeResolutionLayers(&paint_context,
+                                    &native_resolution_deferral.value(),
+                                    &multiplexer_canvas,
+                                    frame_surface);
+    }
     GPROFILER_TRY_MARK(PaintEnd)
 
     layer_generation_cache_->EndFrame();
+    filter_result_cache_->EndFrame();
 
     if (picture_recorder.getRecordingCanvas())
+        frame->captured_picture = picture_recorder.finishRecordingAsPicture();
+    frame->gpu_resource_usage =
+            paint_context.resource_usage_flags & Layer::PaintContext::kGpu_ResourceUsage;
+    frame->gpu_finished_semaphores = std::move(paint_context.gpu_finished_semaphores);
+}
+
+void ContentAggregator::SubmitFrame(FrameState *frame)
+{
+    TRACE_EVENT("rendering", "ContentAggregator::SubmitFrame");
+
+    // Signals can only be emitted on the present thread
+    if (frame->captured_picture)
     {
-        MaybeGpuObject<SkPicture> picture(
-                paint_context.resource_usage_flags & Layer::PaintContext::kGpu_ResourceUsage,
-                picture_recorder.finishRecordingAsPicture());
+        MaybeGpuObject<SkPicture> picture(frame->gpu_resource_usage,
+                                          std::move(frame->captured_picture));
 
         PresentSignal info;
         info.EmplaceBack<MaybeGpuObject<SkPicture>>(std::move(picture));
-        info.EmplaceBack<int32_t>(capture_next_frame_serial_);
+        info.EmplaceBack<int32_t>(frame->capture_serial);
         Emit(GLSI_CONTENTAGGREGATOR_PICTURE_CAPTURED, std::move(info));
     }
 
+    auto surface = GetSurfaceChecked();
+    BumpArena *frame_arena = frame->frame_arena;
+
     // At last, we request a new frame from WSI layer. We will be notified
-    // (slot function `SurfaceFrameSlot` will be called) later
+    // (`PresentPendingFrame` will be called by the surface) later
     // when it is a good time to present a new frame (VSync).
-    current_dirty_rect_ = preroll_context.cull_rect.roundOut();
+    current_dirty_rect_ = frame->cull_rect.roundOut();
     surface->RequestNextFrame();
 
     surface->GetRenderTarget()->Submit({
         .damage_region = SkRegion(current_dirty_rect_),
-        .hw_signal_semaphores = std::move(paint_context.gpu_finished_semaphores)
+        .hw_signal_semaphores = std::move(frame->gpu_finished_semaphores)
     });
 
     GPROFILER_TRY_MARK(Requested)
 
+    frame_pacer_.ReportFrameSubmitted(std::chrono::steady_clock::now());
+
+    if (gfx_profiler_)
+    {
+        gfx_profiler_->SetFrameArenaUsage(frame_arena->GetBytesAllocated(),
+                                          frame_arena->GetHighWaterMark());
+    }
+
+    if (dynamic_resolution_scaler_)
+    {
+        std::chrono::duration<float, std::milli> frame_time =
+                std::chrono::steady_clock::now() - frame->begin_time;
+        if (dynamic_resolution_scaler_->ReportFrameTime(frame_time.count()))
+        {
+            float scale = dynamic_resolution_scaler_->GetScale();
+            QLOG(LOG_DEBUG, "Dynamic resolution: internal scale changed to {}", scale);
+            TRACE_COUNTER("rendering", "ContentAggregator.ResolutionScale", scale);
+            if (!dynamic_resolution_scaler_->IsScaling())
+                dynamic_resolution_surface_.reset();
+        }
+    }
+
     frame_schedule_state_ = FrameScheduleState::kPendingFrame;
-    return UpdateResult::kSuccess;
+}
+
+BumpArena *ContentAggregator::AcquireFrameArena()
+{
+    // Nothing allocated in the frame before the last one can be referenced
+    // now, so the arena is recycled.
+    current_frame_arena_ ^= 1;
+    BumpArena *arena = &frame_arenas_[current_frame_arena_];
+    arena->Reset();
+    return arena;
+}
+
+SkSurface *ContentAggregator::GetDynamicResolutionSurface(SkSurface *frame_surface,
+                                                          SkISize scaled_size)
+{
+    if (dynamic_resolution_surface_ &&
+        dynamic_resolution_surface_->imageInfo().dimensions() == scaled_size)
+    {
+        return dynamic_resolution_surface_.get();
+    }
+
+    SkImageInfo info = frame_surface->imageInfo().makeDimensions(scaled_size);
+    dynamic_resolution_surface_ = SkSurfaces::Raster(info);
+    if (!dynamic_resolution_surface_)
+    {
+        QLOG(LOG_ERROR, "Failed to allocate an offscreen surface for dynamic resolution");
+        return nullptr;
+    }
+    return dynamic_resolution_surface_.get();
+}
+
+void ContentAggregator::PaintNativeResolutionLayers(Layer::PaintContext *context,
+                                                    Layer::NativeResolutionDeferral *deferral,
+                                                    SkNWayCanvas *multiplexer,
+                                                    SkSurface *frame_surface)
+{
+    TRACE_EVENT("rendering", "ContentAggregator::PaintNativeResolutionLayers");
+
+    // Upscale the frame painted at the reduced resolution
+    SkCanvas *frame_canvas = frame_surface->getCanvas();
+    SkSurface *scaled_surface = context->frame_surface;
+    sk_sp<SkImage> scaled_image = scaled_surface->makeImageSnapshot();
+    frame_canvas->drawImageRect(scaled_image,
+                                SkRect::Make(scaled_image->bounds()),
+                                SkRect::MakeWH(frame_surface->width(), frame_surface->height()),
+                                SkSamplingOptions(SkFilterMode::kLinear),
+                                nullptr,
+                                SkCanvas::kFast_SrcRectConstraint);
+    scaled_image.reset();
+
+    if (deferral->entries.empty())
+        return;
+
+    // Then paint the deferred layers on top of it. Other canvases in the
+    // multiplexer have been receiving drawing operations at native resolution,
+    // so only the offscreen canvas is replaced by the frame canvas.
+    multiplexer->removeCanvas(scaled_surface->getCanvas());
+    multiplexer->addCanvas(frame_canvas);
+
+    context->frame_surface = frame_surface;
+    context->frame_canvas = frame_canvas;
+    context->native_resolution_deferral = nullptr;
+
+    for (Layer::NativeResolutionDeferral::Entry& entry : deferral->entries)
+    {
+        SkAutoCanvasRestore auto_restore(multiplexer, true);
+        multiplexer->resetMatrix();
+        multiplexer->clipIRect(entry.device_clip);
+        multiplexer->setMatrix(entry.matrix);
+
+        if (entry.paint)
+            context->paints_stack.emplace(*entry.paint);
+        entry.layer->Paint(context);
+        if (entry.paint)
+            context->paints_stack.pop();
+    }
 }
 
 void ContentAggregator::SurfaceResizeSlot(int32_t width, int32_t height)
 {
     TRACE_EVENT("rendering", "ContentAggregator::SurfaceResizeSlot");
+    FlushRenderThread();
     layer_tree_->SetFrameSize(SkISize::Make(width, height));
 }
 
@@ -395,16 +680,19 @@ void ContentAggregator::Dispose()
     auto surface = GetSurfaceChecked();
 
     surface->Disconnect(surface_resize_slot_id_);
-    surface->Disconnect(surface_frame_slot_id_);
+
+    // The frame being painted on the render thread (if any) is submitted
+    // before the thread exits.
+    SetDedicatedRenderThread(false);
 
     // That the frame is in pending state means we have called the
     // `RenderTarget::Begin` function, which expects a corresponding
-    // `RenderTarget::Submit` call. But the slot of `frame` signal
-    // has been disconnected and `Submit` will never be called,
+    // `RenderTarget::Present` call. But the surface will not notify us
+    // after we are disposed and `Present` will never be called,
     // so call it manually here to make sure every `Begin` call has a
-    // corresponding `Submit` call.
+    // corresponding `Present` call.
     if (frame_schedule_state_ == FrameScheduleState::kPendingFrame)
-        SurfaceFrameSlot();
+        PresentPendingFrame();
 
     // Delete all the imported resources
     if (!imported_resources_ids_.empty())
@@ -413,6 +701,7 @@ void ContentAggregator::Dispose()
                 ->GetHWComposeSwapchain()->GetVkDevice();
         for (auto& pair : imported_resources_ids_)
         {
+            AccountImportedResource(pair.second, -1);
             if (pair.second.type == ImportedResourceEntry::kSemaphore)
                 vkDestroySemaphore(device, pair.second.semaphore, nullptr);
             else if (pair.second.type == ImportedResourceEntry::kSkSurface)
@@ -421,9 +710,13 @@ void ContentAggregator::Dispose()
                 pair.second.surface.reset();
             }
         }
+        imported_resources_ids_.clear();
     }
 
+    StopSceneRecording();
     layer_generation_cache_.reset();
+    filter_result_cache_.reset();
+    dynamic_resolution_surface_.reset();
 
     frame_schedule_state_ = FrameScheduleState::kDisposed;
     disposed_ = true;
@@ -432,13 +725,88 @@ void ContentAggregator::Dispose()
 void ContentAggregator::Trace(GraphicsResourcesTrackable::Tracer *tracer) noexcept
 {
     CHECK(!disposed_);
+    FlushRenderThread();
     tracer->TraceMember("LayerGenerationCache", layer_generation_cache_.get());
+    tracer->TraceMember("FilterResultCache", filter_result_cache_.get());
 }
 
 void ContentAggregator::PurgeRasterCacheResources()
 {
     TRACE_EVENT("rendering", "ContentAggregator::PurgeRasterCacheResources");
+    FlushRenderThread();
     layer_generation_cache_->PurgeCacheResources(true);
+    filter_result_cache_->PurgeCacheResources();
+}
+
+bool ContentAggregator::SetDedicatedRenderThread(bool enabled)
+{
+    TRACE_EVENT("rendering", "ContentAggregator::SetDedicatedRenderThread");
+    if (disposed_)
+        return false;
+
+    if (!enabled)
+    {
+        if (!render_thread_)
+            return true;
+
+        FlushRenderThread();
+        render_thread_.reset();
+
+        // The caches are accessed on this thread only, from now on.
+        MemoryPressureManager::Unregister(this);
+        MemoryPressureManager::Register(layer_generation_cache_.get(),
+                                        MemoryPressureManager::PurgePriority::kLayerSnapshots);
+        MemoryPressureManager::Register(filter_result_cache_.get(),
+                                        MemoryPressureManager::PurgePriority::kFilterResults);
+        return true;
+    }
+
+    if (render_thread_)
+        return true;
+
+    // GPU contexts cannot be shared with other threads
+    if (GetRenderDeviceType() != RenderTarget::RenderDevice::kRaster)
+    {
+        QLOG(LOG_WARNING, "Dedicated render thread is only available for raster backend");
+        return false;
+    }
+
+    static std::atomic<int32_t> render_threads_count(0);
+    auto *thread_ctx = PresentThread::LocalContext::GetCurrent();
+    render_thread_ = std::make_unique<RenderThread>(
+            thread_ctx->GetEventLoop(),
+            fmt::format("GlRender#{}", render_threads_count.fetch_add(1)));
+
+    // The caches may be accessed by the render thread. Memory pressure
+    // manager purges them through us, so that the render thread is
+    // flushed first.
+    MemoryPressureManager::Unregister(layer_generation_cache_.get());
+    MemoryPressureManager::Unregister(filter_result_cache_.get());
+    MemoryPressureManager::Register(this, MemoryPressureManager::PurgePriority::kLayerSnapshots);
+    return true;
+}
+
+void ContentAggregator::FlushRenderThread()
+{
+    if (render_thread_)
+        render_thread_->Flush();
+}
+
+size_t ContentAggregator::GetPurgeableBytes() noexcept
+{
+    // Only registered when bound to a render thread. The caches keep their
+    // sizes in atomic counters, so they can be read while a frame is being
+    // painted without waiting for the render thread (the memory pressure
+    // manager polls this regularly, which must not stall other surfaces).
+    return layer_generation_cache_->GetPurgeableBytes() +
+           filter_result_cache_->GetPurgeableBytes();
+}
+
+void ContentAggregator::PurgeResources(MemoryPressureLevel level) noexcept
+{
+    FlushRenderThread();
+    layer_generation_cache_->PurgeResources(level);
+    filter_result_cache_->PurgeResources(level);
 }
 
 std::shared_ptr<HWComposeSwapchain> ContentAggregator::TryGetSwapchain()
@@ -451,6 +819,22 @@ std::shared_ptr<HWComposeSwapchain> ContentAggregator::TryGetSwapchain()
     return render_target->GetHWComposeSwapchain();
 }
 
+void ContentAggregator::AccountImportedResource(const ImportedResourceEntry& entry, int64_t sign)
+{
+    if (entry.type == ImportedResourceEntry::kSemaphore)
+    {
+        // Semaphores do not have a meaningful memory footprint
+        GraphicsResourcesTrackable::AccountResource(
+                TrackableCategory::kImportedSemaphores, 0, sign);
+    }
+    else if (entry.type == ImportedResourceEntry::kSkSurface)
+    {
+        auto bytes = static_cast<int64_t>(entry.surface->imageInfo().computeMinByteSize());
+        GraphicsResourcesTrackable::AccountResource(
+                TrackableCategory::kTextures, sign * bytes, sign);
+    }
+}
+
 ContentAggregator::ImportedResourcesId ContentAggregator::ImportGpuSemaphoreFromFd(int32_t fd, bool auto_close)
 {
     CHECK(!disposed_);
@@ -470,6 +854,7 @@ ContentAggregator::ImportedResourcesId ContentAggregator::ImportGpuSemaphoreFrom
         .semaphore = swapchain->ImportSemaphoreFromFd(fd),
         .surface = nullptr
     };
+    AccountImportedResource(imported_resources_ids_[id], 1);
     return id;
 }
 
@@ -486,6 +871,7 @@ void ContentAggregator::DeleteImportedGpuSemaphore(ImportedResourcesId id)
     if (entry.type != ImportedResourceEntry::kSemaphore)
         return;
     vkDestroySemaphore(swapchain->GetVkDevice(), entry.semaphore, nullptr);
+    AccountImportedResource(entry, -1);
     imported_resources_ids_.erase(id);
 }
 
@@ -512,6 +898,7 @@ ContentAggregator::ImportGpuSkSurface(const SkiaGpuContextOwner::ExportedSkSurfa
         .semaphore = VK_NULL_HANDLE,
         .surface = std::move(sk_surface)
     };
+    AccountImportedResource(imported_resources_ids_[id], 1);
     return id;
 }
 
@@ -523,6 +910,7 @@ void ContentAggregator::DeleteImportedGpuSkSurface(ImportedResourcesId id)
     ImportedResourceEntry& entry = imported_resources_ids_[id];
     if (entry.type != ImportedResourceEntry::kSkSurface)
         return;
+    AccountImportedResource(entry, -1);
     imported_resources_ids_.erase(id);
 }
 
@@ -24,21 +24,29 @@
 #include "include/core/SkImage.h"
 
 #include "Core/Data.h"
+#include "Core/BumpArena.h"
 #include "Glamor/Glamor.h"
 #include "Glamor/PresentRemoteHandle.h"
 #include "Glamor/RenderTarget.h"
 #include "Glamor/GraphicsResourcesTrackable.h"
+#include "Glamor/DynamicResolutionScaler.h"
+#include "Glamor/FramePacer.h"
+#include "Glamor/Layers/Layer.h"
 #include "Glamor/Layers/LayerGenerationCache.h"
+#include "Glamor/Layers/FilterResultCache.h"
 
 class SkSurface;
+class SkNWayCanvas;
 
 GLAMOR_NAMESPACE_BEGIN
 
 class Surface;
+class RenderThread;
 
 class ContentAggregator;
 class LayerTree;
 class GProfiler;
+class SceneStreamWriter;
 
 #define GLOP_CONTENTAGGREGATOR_DISPOSE                            1
 #define GLOP_CONTENTAGGREGATOR_UPDATE                             2
@@ -48,6 +56,9 @@ class GProfiler;
 #define GLOP_CONTENTAGGREGATOR_DELETE_IMPORTED_GPU_SEMAPHORE      11
 #define GLOP_CONTENTAGGREGATOR_IMPORT_GPU_SKSURFACE               12
 #define GLOP_CONTENTAGGREGATOR_DELETE_IMPORTED_GPU_SKSURFACE      13
+#define GLOP_CONTENTAGGREGATOR_START_SCENE_RECORDING              14
+#define GLOP_CONTENTAGGREGATOR_STOP_SCENE_RECORDING               15
+#define GLOP_CONTENTAGGREGATOR_SET_DEDICATED_RENDER_THREAD        16
 
 #define GLSI_CONTENTAGGREGATOR_PICTURE_CAPTURED                   8
 
@@ -116,6 +127,27 @@ public:
 
     g_async_api void PurgeRasterCacheResources();
 
+    /**
+     * Record the layer trees submitted by `Update` into a scene stream file
+     * until `StopSceneRecording` is called. The recording can be replayed
+     * offline by the `scene-replay` tool. A recording in progress is stopped
+     * and replaced by the new one.
+     */
+    g_async_api bool StartSceneRecording(const std::string& path);
+
+    // Returns the number of recorded frames
+    g_async_api uint32_t StopSceneRecording();
+
+    /**
+     * Bind the aggregator to its own `RenderThread`, where the layer trees
+     * are painted, or unbind it (painting on the present thread). Frames
+     * submitted while the previous frame is still being painted are dropped.
+     * Only raster surfaces can be bound; returns false otherwise.
+     * See `RenderThread` for the objects which may be shared across
+     * render threads.
+     */
+    g_async_api bool SetDedicatedRenderThread(bool enabled);
+
     using ImportedResourcesId = int64_t;
 
     g_async_api ImportedResourcesId ImportGpuSemaphoreFromFd(int32_t fd, bool auto_close);
@@ -124,30 +156,100 @@ public:
     g_async_api ImportedResourcesId ImportGpuSkSurface(const SkiaGpuContextOwner::ExportedSkSurfaceInfo& info);
     g_async_api void DeleteImportedGpuSkSurface(ImportedResourcesId id);
 
+    g_private_api FramePacer& GetFramePacer() {
+        return frame_pacer_;
+    }
+
+    /**
+     * Called by the output surface when it is a good time to present
+     * a new frame (VSync). The frame which has been submitted by `Update`
+     * (if any) is presented.
+     */
+    g_private_api void PresentPendingFrame();
+
+    /**
+     * Wait for the frame being painted on the dedicated render thread (if any)
+     * and submit it. It must be called before anything that may touch the
+     * frame buffers of the render target (resizing, for example) is done.
+     */
+    g_private_api void FlushRenderThread();
+
     g_private_api VkSemaphore GetImportedGpuSemaphore(ImportedResourcesId id);
     g_private_api SkSurface *GetImportedSkSurface(ImportedResourcesId id);
 
     void Trace(GraphicsResourcesTrackable::Tracer *tracer) noexcept override;
 
+    size_t GetPurgeableBytes() noexcept override;
+    void PurgeResources(MemoryPressureLevel level) noexcept override;
+
 private:
+    // The states of a frame passed from the preroll stage (present thread),
+    // to the paint stage (present thread or render thread), and then to
+    // the submission stage (present thread).
+    struct FrameState
+    {
+        SkSurface                      *frame_surface = nullptr;
+        SkISize                         viewport;
+        SkMatrix                        root_transformation;
+        BumpArena                      *frame_arena = nullptr;
+        GrDirectContext                *gr_context = nullptr;
+        SkRect                          cull_rect;
+        bool                            capture_picture = false;
+        int32_t                         capture_serial = 0;
+        std::chrono::steady_clock::time_point
+                                        begin_time;
+
+        // Filled by the paint stage
+        sk_sp<SkPicture>                captured_picture;
+        bool                            gpu_resource_usage = false;
+        std::vector<GrBackendSemaphore> gpu_finished_semaphores;
+    };
+
+    void PaintFrame(FrameState *frame);
+    void SubmitFrame(FrameState *frame);
+
     void SurfaceResizeSlot(int32_t width, int32_t height);
-    void SurfaceFrameSlot();
 
     std::shared_ptr<HWComposeSwapchain> TryGetSwapchain();
 
+    BumpArena *AcquireFrameArena();
+
+    SkSurface *GetDynamicResolutionSurface(SkSurface *frame_surface, SkISize scaled_size);
+    void PaintNativeResolutionLayers(Layer::PaintContext *context,
+                                     Layer::NativeResolutionDeferral *deferral,
+                                     SkNWayCanvas *multiplexer,
+                                     SkSurface *frame_surface);
+
     std::shared_ptr<Surface> GetSurfaceChecked() const;
 
     bool                           disposed_;
     uint32_t                       surface_resize_slot_id_;
-    uint32_t                       surface_frame_slot_id_;
     std::weak_ptr<Surface>         weak_surface_;
     std::shared_ptr<LayerTree>     layer_tree_;
     SkIRect                        current_dirty_rect_;
     FrameScheduleState             frame_schedule_state_;
     std::unique_ptr<LayerGenerationCache>
                                    layer_generation_cache_;
+    std::unique_ptr<FilterResultCache>
+                                   filter_result_cache_;
+    std::vector<Layer::PrerolledLayer>
+                                   prerolled_layers_;
     std::shared_ptr<GProfiler>     gfx_profiler_;
 
+    // Short-lived objects of a frame (paint states, deferred layers, etc.)
+    // are allocated from one of the arenas, which is released at once when
+    // it is reused two frames later. Allocations of the previous frame
+    // therefore stay valid until the next frame begins.
+    BumpArena                      frame_arenas_[2];
+    uint32_t                       current_frame_arena_;
+    std::unique_ptr<DynamicResolutionScaler>
+                                   dynamic_resolution_scaler_;
+    sk_sp<SkSurface>               dynamic_resolution_surface_;
+    FramePacer                     frame_pacer_;
+
+    std::unique_ptr<SceneStreamWriter>
+                                   scene_stream_writer_;
+
     bool                           should_capture_next_frame_;
     int32_t                        capture_next_frame_serial_;
 
@@ -163,10 +265,15 @@ private:
         sk_sp<SkSurface> surface;
     };
 
+    static void AccountImportedResource(const ImportedResourceEntry& entry, int64_t sign);
+
     using ImportedResourcesIdMap =
             std::unordered_map<ImportedResourcesId, ImportedResourceEntry>;
     ImportedResourcesIdMap         imported_resources_ids_;
     int64_t                        imported_resources_ids_cnt_;
+
+    std::unique_ptr<RenderThread>  render_thread_;
+    bool                           render_in_flight_;
 };
 
 GLAMOR_NAMESPACE_END
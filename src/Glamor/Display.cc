@@ -255,6 +255,14 @@ bool Display::RemoveMonitor(const std::shared_ptr<Monitor>& monitor)
     return false;
 }
 
+void Display::NotifyMemoryPressure(MemoryPressureLevel level, size_t released_bytes)
+{
+    PresentSignal info;
+    info.EmplaceBack<MemoryPressureLevel>(level);
+    info.EmplaceBack<size_t>(released_bytes);
+    Emit(GLSI_DISPLAY_MEMORY_PRESSURE, std::move(info));
+}
+
 std::list<std::shared_ptr<Monitor>> Display::RequestMonitorList()
 {
     // Return a copy of monitors' list
@@ -40,6 +40,7 @@ GLAMOR_NAMESPACE_BEGIN
 #define GLSI_DISPLAY_CLOSED     1
 #define GLSI_DISPLAY_MONITOR_ADDED      2
 #define GLSI_DISPLAY_MONITOR_REMOVED    3
+#define GLSI_DISPLAY_MEMORY_PRESSURE    4
 
 class Surface;
 class Monitor;
@@ -106,6 +107,9 @@ protected:
     void AppendMonitor(const std::shared_ptr<Monitor>& monitor);
     bool RemoveMonitor(const std::shared_ptr<Monitor>& monitor);
 
+    // Called by `MemoryPressureManager` after the graphics caches are purged
+    void NotifyMemoryPressure(MemoryPressureLevel level, size_t released_bytes);
+
     void AppendDefaultCursorTheme(const std::shared_ptr<CursorTheme>& theme);
 
     uv_loop_t                               *event_loop_;
@@ -0,0 +1,116 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "Core/Errors.h"
+#include "Glamor/DynamicResolutionScaler.h"
+GLAMOR_NAMESPACE_BEGIN
+
+namespace {
+
+// Weight of the newest sample in the exponential moving average
+constexpr float kAverageWeight = 0.25f;
+
+float quantize_scale(float scale, float min_scale)
+{
+    // The small bias absorbs rounding errors of floating point division
+    float q = std::floor(scale / DynamicResolutionScaler::kScaleGranularity + 1e-3f)
+              * DynamicResolutionScaler::kScaleGranularity;
+    return std::clamp(q, min_scale, 1.0f);
+}
+
+} // namespace anonymous
+
+DynamicResolutionScaler::DynamicResolutionScaler(float min_scale, float frame_budget_ms)
+    : min_scale_(std::clamp(min_scale, kScaleGranularity, 1.0f))
+    , frame_budget_ms_(frame_budget_ms)
+    , scale_(1.0f)
+    , averaged_frame_time_ms_(0)
+    , overloaded_frames_(0)
+    , idle_frames_(0)
+{
+    CHECK(frame_budget_ms_ > 0);
+}
+
+SkISize DynamicResolutionScaler::GetScaledSize(const SkISize& native_size) const
+{
+    return SkISize::Make(
+        std::max(1, static_cast<int32_t>(std::ceil(native_size.width() * scale_))),
+        std::max(1, static_cast<int32_t>(std::ceil(native_size.height() * scale_))));
+}
+
+void DynamicResolutionScaler::Reset()
+{
+    scale_ = 1.0f;
+    averaged_frame_time_ms_ = 0;
+    overloaded_frames_ = 0;
+    idle_frames_ = 0;
+}
+
+bool DynamicResolutionScaler::ReportFrameTime(float frame_time_ms)
+{
+    if (averaged_frame_time_ms_ == 0)
+        averaged_frame_time_ms_ = frame_time_ms;
+    else
+        averaged_frame_time_ms_ += kAverageWeight * (frame_time_ms - averaged_frame_time_ms_);
+
+    if (averaged_frame_time_ms_ > frame_budget_ms_ * kHighWatermark)
+    {
+        idle_frames_ = 0;
+        overloaded_frames_++;
+    }
+    else if (averaged_frame_time_ms_ < frame_budget_ms_ * kLowWatermark)
+    {
+        overloaded_frames_ = 0;
+        idle_frames_++;
+    }
+    else
+    {
+        overloaded_frames_ = 0;
+        idle_frames_ = 0;
+    }
+
+    float new_scale = scale_;
+    if (overloaded_frames_ >= kDownscaleFrames && scale_ > min_scale_)
+    {
+        // Rasterization cost is roughly proportional to the number of pixels,
+        // that is, the square of the scale. Aim at a little bit under the budget.
+        float ratio = std::sqrt(frame_budget_ms_ * 0.9f / averaged_frame_time_ms_);
+        new_scale = quantize_scale(std::min(scale_ * ratio, scale_ - kScaleGranularity),
+                                   min_scale_);
+    }
+    else if (idle_frames_ >= kUpscaleFrames && scale_ < 1.0f)
+    {
+        new_scale = quantize_scale(scale_ + kScaleGranularity,
+                                   min_scale_);
+    }
+
+    if (new_scale == scale_)
+        return false;
+
+    // Frame times measured at the old scale are meaningless now
+    scale_ = new_scale;
+    averaged_frame_time_ms_ = 0;
+    overloaded_frames_ = 0;
+    idle_frames_ = 0;
+    return true;
+}
+
+GLAMOR_NAMESPACE_END
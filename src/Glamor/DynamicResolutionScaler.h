@@ -0,0 +1,84 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_DYNAMICRESOLUTIONSCALER_H
+#define COCOA_GLAMOR_DYNAMICRESOLUTIONSCALER_H
+
+#include "include/core/SkSize.h"
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * Decides the internal resolution scale at which `ContentAggregator`
+ * renders the layer tree, according to the time spent on recent frames.
+ *
+ * The scale decreases quickly when frames keep exceeding the budget,
+ * and recovers slowly after frames have been well under the budget for
+ * a while. The gap between the two watermarks and the different numbers
+ * of required frames provide the hysteresis which prevents the scale from
+ * oscillating between two values.
+ */
+class DynamicResolutionScaler
+{
+public:
+    // Frames slower than `budget * kHighWatermark` are considered to be overloaded,
+    // and frames faster than `budget * kLowWatermark` are considered to be idle.
+    constexpr static float kHighWatermark = 1.0f;
+    constexpr static float kLowWatermark = 0.7f;
+
+    // Number of successive overloaded (idle) frames to decrease (increase) the scale
+    constexpr static int32_t kDownscaleFrames = 3;
+    constexpr static int32_t kUpscaleFrames = 30;
+
+    // The scale is always a multiple of `kScaleGranularity`, so that
+    // the offscreen surface is not reallocated for tiny changes.
+    constexpr static float kScaleGranularity = 0.05f;
+
+    DynamicResolutionScaler(float min_scale, float frame_budget_ms);
+    ~DynamicResolutionScaler() = default;
+
+    g_nodiscard g_inline float GetScale() const {
+        return scale_;
+    }
+
+    g_nodiscard g_inline bool IsScaling() const {
+        return scale_ < 1.0f;
+    }
+
+    g_nodiscard SkISize GetScaledSize(const SkISize& native_size) const;
+
+    /**
+     * Report the time spent on a frame rendered at the current scale.
+     * @return  True if the scale has been changed for the next frame.
+     */
+    bool ReportFrameTime(float frame_time_ms);
+
+    void Reset();
+
+private:
+    float       min_scale_;
+    float       frame_budget_ms_;
+    float       scale_;
+    float       averaged_frame_time_ms_;
+    int32_t     overloaded_frames_;
+    int32_t     idle_frames_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_DYNAMICRESOLUTIONSCALER_H
@@ -0,0 +1,141 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include "Core/TraceEvent.h"
+#include "Glamor/FramePacer.h"
+GLAMOR_NAMESPACE_BEGIN
+
+namespace {
+
+// Weight of the newest interval in the exponential moving average
+constexpr double kIntervalAverageWeight = 0.1;
+
+double to_ms(FramePacer::Clock::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // namespace anonymous
+
+FramePacer::FramePacer()
+    : costs_next_(0)
+    , refresh_interval_(Clock::duration::zero())
+    , last_start_to_present_(Clock::duration::zero())
+{
+    costs_.reserve(kHistorySize);
+}
+
+void FramePacer::ReportFrameCallback(Clock::time_point now)
+{
+    if (last_callback_)
+    {
+        Clock::duration interval = now - *last_callback_;
+        if (interval < kMaxFrameInterval)
+        {
+            if (refresh_interval_ == Clock::duration::zero())
+            {
+                refresh_interval_ = interval;
+            }
+            else
+            {
+                refresh_interval_ = std::chrono::duration_cast<Clock::duration>(
+                        refresh_interval_ * (1 - kIntervalAverageWeight)
+                        + interval * kIntervalAverageWeight);
+            }
+        }
+    }
+    last_callback_ = now;
+}
+
+void FramePacer::MarkFrameStart(Clock::time_point now)
+{
+    frame_start_ = now;
+}
+
+void FramePacer::ReportFrameSubmitted(Clock::time_point now)
+{
+    // A frame may be submitted without a frame signal (the first frame, or
+    // the user updates the contents spontaneously); it has no cost to measure.
+    if (!frame_start_)
+        return;
+
+    Clock::duration cost = now - *frame_start_;
+    if (costs_.size() < kHistorySize)
+        costs_.push_back(cost);
+    else
+        costs_[costs_next_] = cost;
+    costs_next_ = (costs_next_ + 1) % kHistorySize;
+
+    submitted_frame_start_ = frame_start_;
+    frame_start_.reset();
+
+    TRACE_COUNTER("rendering", "FramePacer.FrameCostMs", to_ms(cost));
+}
+
+void FramePacer::ReportFramePresented(Clock::time_point now)
+{
+    if (!submitted_frame_start_)
+        return;
+
+    last_start_to_present_ = now - *submitted_frame_start_;
+    submitted_frame_start_.reset();
+
+    TRACE_COUNTER("rendering", "FramePacer.StartToPresentLatencyMs",
+                  to_ms(last_start_to_present_));
+}
+
+FramePacer::Clock::duration FramePacer::GetPredictedCost() const
+{
+    if (costs_.empty())
+        return Clock::duration::zero();
+
+    std::vector<Clock::duration> sorted(costs_);
+    auto nth = sorted.begin() + static_cast<ptrdiff_t>(
+            static_cast<double>(sorted.size() - 1) * kCostPercentile);
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+FramePacer::Clock::duration FramePacer::ComputeStartDelay() const
+{
+    if (costs_.size() < kMinHistorySize || refresh_interval_ == Clock::duration::zero())
+        return Clock::duration::zero();
+
+    Clock::duration predicted = GetPredictedCost();
+    Clock::duration delay = refresh_interval_ - predicted - kSafetyMargin;
+
+    TRACE_COUNTER("rendering", "FramePacer.PredictedCostMs", to_ms(predicted));
+    TRACE_COUNTER("rendering", "FramePacer.StartDelayMs",
+                  to_ms(std::max(delay, Clock::duration::zero())));
+
+    return std::max(delay, Clock::duration::zero());
+}
+
+void FramePacer::Reset()
+{
+    costs_.clear();
+    costs_next_ = 0;
+    last_callback_.reset();
+    refresh_interval_ = Clock::duration::zero();
+    frame_start_.reset();
+    submitted_frame_start_.reset();
+}
+
+GLAMOR_NAMESPACE_END
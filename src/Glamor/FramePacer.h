@@ -0,0 +1,107 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_FRAMEPACER_H
+#define COCOA_GLAMOR_FRAMEPACER_H
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * Predicts the cost of the next frame from the recent frames, and decides
+ * how long the frame signal (which tells the user to start producing a new
+ * frame) can be delayed after a frame callback, so that the frame starts
+ * as late as possible but is still submitted before the next frame callback.
+ * Starting later means the contents are fresher when they are presented.
+ *
+ * The cost of a frame is measured from the time when the frame signal is
+ * emitted (frame start) to the time when the contents have been submitted
+ * by `ContentAggregator::Update`, so the time spent by the user on the
+ * main thread and the cross-thread messaging are all included.
+ *
+ * The time from frame start to presentation is also measured, which is the
+ * latency that pacing reduces.
+ */
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Number of recent frames used to predict the cost
+    constexpr static size_t kHistorySize = 32;
+    // Frames are not delayed until enough frames have been measured
+    constexpr static size_t kMinHistorySize = 8;
+    // The predicted cost is a high percentile of the recent frames,
+    // so that occasional slow frames do not miss the deadline
+    constexpr static double kCostPercentile = 0.9;
+    // Extra time reserved for the scheduling jitter
+    constexpr static auto kSafetyMargin = std::chrono::microseconds(2000);
+    // Frame callbacks further apart than this are not considered to be
+    // successive (the surface was idle), and are not used to estimate
+    // the refresh interval.
+    constexpr static auto kMaxFrameInterval = std::chrono::milliseconds(100);
+
+    FramePacer();
+    ~FramePacer() = default;
+
+    void ReportFrameCallback(Clock::time_point now);
+
+    void MarkFrameStart(Clock::time_point now);
+
+    void ReportFrameSubmitted(Clock::time_point now);
+
+    void ReportFramePresented(Clock::time_point now);
+
+    /**
+     * How long the frame signal should be delayed after the latest frame
+     * callback. Zero if there is not enough history or no slack.
+     */
+    g_nodiscard Clock::duration ComputeStartDelay() const;
+
+    g_nodiscard Clock::duration GetPredictedCost() const;
+
+    g_nodiscard g_inline Clock::duration GetRefreshInterval() const {
+        return refresh_interval_;
+    }
+
+    g_nodiscard g_inline std::optional<Clock::time_point> GetFrameStartTime() const {
+        return frame_start_;
+    }
+
+    g_nodiscard g_inline Clock::duration GetLastStartToPresentLatency() const {
+        return last_start_to_present_;
+    }
+
+    void Reset();
+
+private:
+    std::vector<Clock::duration>        costs_;
+    size_t                              costs_next_;
+    std::optional<Clock::time_point>    last_callback_;
+    Clock::duration                     refresh_interval_;
+    std::optional<Clock::time_point>    frame_start_;
+    std::optional<Clock::time_point>    submitted_frame_start_;
+    Clock::duration                     last_start_to_present_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_FRAMEPACER_H
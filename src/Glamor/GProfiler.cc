@@ -15,22 +15,64 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <sstream>
+
 #include "fmt/format.h"
+#include "json/json.h"
 
 #include "Core/Journal.h"
 #include "Core/Errors.h"
+#include "Core/TraceEvent.h"
 #include "Glamor/Glamor.h"
 #include "Glamor/GProfiler.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.GProfiler)
 
+namespace {
+
+struct FrameStageInfo
+{
+    const char *name;
+    GProfiler::FrameMilestone from;
+    GProfiler::FrameMilestone to;
+    // Perfetto counter tracks (names must be static strings)
+    const char *p50_track;
+    const char *p90_track;
+    const char *p99_track;
+    const char *max_track;
+};
+
+#define STAGE(name, from, to, track)                                \
+    { name, GProfiler::k##from##_FrameMilestone,                    \
+      GProfiler::k##to##_FrameMilestone,                            \
+      "GProfiler." track ".P50Us", "GProfiler." track ".P90Us",     \
+      "GProfiler." track ".P99Us", "GProfiler." track ".MaxUs" }
+
+const FrameStageInfo g_frame_stages[GProfiler::kLast_FrameStage] = {
+    STAGE("preroll",        PrerollBegin, PrerollEnd, "Preroll"),
+    STAGE("paint",          PaintBegin,   PaintEnd,   "Paint"),
+    STAGE("submit",         PaintEnd,     Requested,  "Submit"),
+    STAGE("update",         Begin,        Requested,  "Update"),
+    STAGE("presentWait",    Requested,    Presented,  "PresentWait"),
+    STAGE("startToPresent", Scheduled,    Presented,  "StartToPresent")
+};
+
+#undef STAGE
+
+} // namespace anonymous
+
 GProfiler::GProfiler()
     : timebase_(std::chrono::steady_clock::now())
     , rb_samples_threshold_(0)
     , rb_head_(nullptr)
     , frame_counter_(1)
     , current_sample_(nullptr)
+    , frame_arena_high_water_mark_(0)
+    , histogram_current_slot_(0)
+    , histogram_slot_begin_(timebase_)
+    , histogram_last_trace_(timebase_)
 {
     CHECK(GlobalScope::Instance());
     rb_samples_threshold_ = GlobalScope::Ref()
@@ -96,6 +138,7 @@ GProfiler::Sample *GProfiler::CreateNewSample()
     current->pending = true;
     current->alive = true;
     current->frame = frame_counter_++;
+    current->frame_arena_bytes = 0;
     return current;
 }
 
@@ -122,6 +165,10 @@ void GProfiler::EndFrame()
     CHECK(current_sample_);
     MarkMilestoneInFrame(kEnd_FrameMilestone);
 
+    // Histograms are lock-free and never block the readers
+    RecordStageHistograms(current_sample_);
+    TraceStageHistograms();
+
     std::scoped_lock<std::mutex> lock(rb_lock_);
     current_sample_->pending = false;
     current_sample_ = nullptr;
@@ -155,10 +202,122 @@ void GProfiler::PurgeRecentHistorySamples(bool free_memory)
 }
 
 void GProfiler::MarkMilestoneInFrame(FrameMilestone milestone)
+{
+    MarkMilestoneInFrame(milestone, std::chrono::steady_clock::now());
+}
+
+void GProfiler::MarkMilestoneInFrame(FrameMilestone milestone, Timepoint timepoint)
 {
     CHECK(milestone < kLast_FrameMilestone);
     CHECK(current_sample_);
-    current_sample_->timestamp[milestone] = std::chrono::steady_clock::now();
+    current_sample_->timestamp[milestone] = timepoint;
+}
+
+void GProfiler::SetFrameArenaUsage(size_t bytes, size_t high_water_mark)
+{
+    CHECK(current_sample_);
+    current_sample_->frame_arena_bytes = bytes;
+
+    std::scoped_lock<std::mutex> lock(rb_lock_);
+    frame_arena_high_water_mark_ = std::max(frame_arena_high_water_mark_, high_water_mark);
+}
+
+const char *GProfiler::GetFrameStageName(FrameStage stage)
+{
+    CHECK(stage < kLast_FrameStage);
+    return g_frame_stages[stage].name;
+}
+
+void GProfiler::RecordStageHistograms(const Sample *sample)
+{
+    Timepoint now = sample->timestamp[kEnd_FrameMilestone];
+    uint32_t current = histogram_current_slot_.load(std::memory_order_relaxed);
+    if (now - histogram_slot_begin_ >= kHistogramWindow)
+    {
+        current ^= 1;
+        for (GProfilerHistogram& histogram : histogram_slots_[current].stages)
+            histogram.Clear();
+        histogram_current_slot_.store(current, std::memory_order_release);
+        histogram_slot_begin_ = now;
+    }
+
+    HistogramSlot& slot = histogram_slots_[current];
+    for (int32_t i = 0; i < kLast_FrameStage; i++)
+    {
+        const FrameStageInfo& info = g_frame_stages[i];
+        Timepoint from = sample->timestamp[info.from];
+        Timepoint to = sample->timestamp[info.to];
+        if (to < from)
+            continue;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(to - from);
+        slot.stages[i].Record(us.count());
+    }
+}
+
+void GProfiler::SummarizeStageHistograms(GProfilerHistogram::Summary *out) const
+{
+    CHECK(out);
+    for (int32_t i = 0; i < kLast_FrameStage; i++)
+    {
+        GProfilerHistogram::Counts counts{};
+        uint64_t max = 0;
+        for (const HistogramSlot& slot : histogram_slots_)
+            slot.stages[i].AccumulateInto(counts, max);
+        out[i] = GProfilerHistogram::Summarize(counts, max);
+    }
+}
+
+void GProfiler::TraceStageHistograms()
+{
+    Timepoint now = std::chrono::steady_clock::now();
+    if (now - histogram_last_trace_ < kHistogramTraceInterval)
+        return;
+    histogram_last_trace_ = now;
+
+    if (!TRACE_EVENT_CATEGORY_ENABLED("rendering"))
+        return;
+
+    GProfilerHistogram::Summary summaries[kLast_FrameStage];
+    SummarizeStageHistograms(summaries);
+    for (int32_t i = 0; i < kLast_FrameStage; i++)
+    {
+        const FrameStageInfo& info = g_frame_stages[i];
+        TRACE_COUNTER("rendering", info.p50_track, summaries[i].p50);
+        TRACE_COUNTER("rendering", info.p90_track, summaries[i].p90);
+        TRACE_COUNTER("rendering", info.p99_track, summaries[i].p99);
+        TRACE_COUNTER("rendering", info.max_track, summaries[i].max);
+    }
+}
+
+std::string GProfiler::GenerateStageHistogramsJSON() const
+{
+    GProfilerHistogram::Summary summaries[kLast_FrameStage];
+    SummarizeStageHistograms(summaries);
+
+    Json::Value root(Json::objectValue);
+    root["windowMs"] = Json::Value::UInt64(
+            std::chrono::duration_cast<std::chrono::milliseconds>(kHistogramWindow).count());
+
+    Json::Value& stages = root["stages"] = Json::Value(Json::objectValue);
+    for (int32_t i = 0; i < kLast_FrameStage; i++)
+    {
+        Json::Value& stage = stages[g_frame_stages[i].name] = Json::Value(Json::objectValue);
+        stage["count"] = Json::Value::UInt64(summaries[i].count);
+        stage["p50Us"] = Json::Value::UInt64(summaries[i].p50);
+        stage["p90Us"] = Json::Value::UInt64(summaries[i].p90);
+        stage["p99Us"] = Json::Value::UInt64(summaries[i].p99);
+        stage["maxUs"] = Json::Value::UInt64(summaries[i].max);
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    builder["commentStyle"] = "None";
+
+    std::ostringstream oss;
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &oss);
+
+    return oss.str();
 }
 
 GProfiler::Report::Ptr GProfiler::GenerateCurrentReport()
@@ -191,6 +350,7 @@ GProfiler::Report::Ptr GProfiler::GenerateCurrentReport()
     CHECK(report);
 
     report->timebase = timebase_;
+    report->frame_arena_high_water_mark = frame_arena_high_water_mark_;
     report->n_entries = n_entries;
 
     Sample *cur = rb_head_->p_next;
@@ -198,6 +358,7 @@ GProfiler::Report::Ptr GProfiler::GenerateCurrentReport()
     while(true)
     {
         p_entry->frame = cur->frame;
+        p_entry->frame_arena_bytes = cur->frame_arena_bytes;
         std::copy(&cur->timestamp[0],
                   &cur->timestamp[kLast_FrameMilestone],
                   &p_entry->milestones[0]);
@@ -19,8 +19,10 @@
 #define COCOA_GLAMOR_GPROFILER_H
 
 #include <chrono>
+#include <string>
 
 #include "Glamor/Glamor.h"
+#include "Glamor/GProfilerHistogram.h"
 GLAMOR_NAMESPACE_BEGIN
 
 class GProfiler
@@ -40,19 +42,49 @@ public:
         kPaintEnd_FrameMilestone,
         kBegin_FrameMilestone,
         kEnd_FrameMilestone,
+        // The frame signal was emitted and the user started producing
+        // the frame (before `kBegin_FrameMilestone`)
+        kScheduled_FrameMilestone,
         kLast_FrameMilestone
     };
 
+    // Durations between milestones which are recorded into histograms
+    enum FrameStage
+    {
+        // PrerollBegin -> PrerollEnd
+        kPreroll_FrameStage = 0,
+        // PaintBegin -> PaintEnd
+        kPaint_FrameStage,
+        // PaintEnd -> Requested
+        kSubmit_FrameStage,
+        // Begin -> Requested, the whole `ContentAggregator::Update`
+        kUpdate_FrameStage,
+        // Requested -> Presented
+        kPresentWait_FrameStage,
+        // Scheduled -> Presented
+        kStartToPresent_FrameStage,
+        kLast_FrameStage
+    };
+
+    // Histograms cover the frames in the recent `kHistogramWindow` at least
+    // and `2 * kHistogramWindow` at most.
+    constexpr static auto kHistogramWindow = std::chrono::seconds(10);
+    // Interval to emit the percentiles as Perfetto counters
+    constexpr static auto kHistogramTraceInterval = std::chrono::seconds(1);
+
     struct Report
     {
         using Ptr = std::unique_ptr<Report, std::function<void(Report*)>>;
 
         Timepoint timebase;
+        // Maximum bytes ever allocated from a frame arena in a single frame
+        size_t frame_arena_high_water_mark;
         size_t n_entries;
         struct Entry
         {
             uint64_t frame;
             Timepoint milestones[kLast_FrameMilestone];
+            size_t frame_arena_bytes;
         } entries[];
     };
 
@@ -63,11 +95,25 @@ public:
     g_private_api void EndFrame();
 
     g_private_api void MarkMilestoneInFrame(FrameMilestone milestone);
+    g_private_api void MarkMilestoneInFrame(FrameMilestone milestone, Timepoint timepoint);
+
+    // Record bytes allocated from the frame arena in current frame
+    g_private_api void SetFrameArenaUsage(size_t bytes, size_t high_water_mark);
 
     g_locked_sync_api void PurgeRecentHistorySamples(bool free_memory);
 
     g_locked_sync_api Report::Ptr GenerateCurrentReport();
 
+    /**
+     * Summarize the stage histograms in the rolling window (in microseconds).
+     * This does not block the rendering thread.
+     */
+    g_sync_api void SummarizeStageHistograms(GProfilerHistogram::Summary *out) const;
+
+    g_sync_api std::string GenerateStageHistogramsJSON() const;
+
+    g_nodiscard static const char *GetFrameStageName(FrameStage stage);
+
 private:
     // NOLINTNEXTLINE
     struct Sample
@@ -75,13 +121,21 @@ private:
         bool alive;
         Timepoint timestamp[kLast_FrameMilestone + 1];
         uint64_t frame;
+        size_t frame_arena_bytes;
         bool pending;
         Sample *p_next;
         Sample *p_prev;
     };
 
+    struct HistogramSlot
+    {
+        GProfilerHistogram stages[kLast_FrameStage];
+    };
+
     Sample *CreateNewSample();
     void PopFirstSample();
+    void RecordStageHistograms(const Sample *sample);
+    void TraceStageHistograms();
 
     std::mutex rb_lock_;
     Timepoint timebase_;
@@ -90,6 +144,15 @@ private:
     Sample *rb_head_;
     uint64_t frame_counter_;
     Sample *current_sample_;
+    size_t frame_arena_high_water_mark_;
+
+    // Recording happens in the current slot, and the other slot keeps
+    // the previous window. The oldest slot is cleared and becomes the
+    // current one when the current window expires.
+    HistogramSlot histogram_slots_[2];
+    std::atomic<uint32_t> histogram_current_slot_;
+    Timepoint histogram_slot_begin_;
+    Timepoint histogram_last_trace_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -0,0 +1,116 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include "Core/Errors.h"
+#include "Glamor/GProfilerHistogram.h"
+GLAMOR_NAMESPACE_BEGIN
+
+GProfilerHistogram::GProfilerHistogram()
+    : max_(0)
+{
+    for (auto& bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+int32_t GProfilerHistogram::GetBucketIndex(uint64_t value)
+{
+    value = std::min(value, kMaxValue);
+    if (value < kSubBuckets)
+        return static_cast<int32_t>(value);
+
+    // Index of the most significant bit, which is at least `kSubBucketBits`
+    int32_t msb = 63 - __builtin_clzll(value);
+    int32_t shift = msb - kSubBucketBits;
+    auto sub = static_cast<int32_t>(value >> shift) - kSubBuckets;
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t GProfilerHistogram::GetBucketValue(int32_t index)
+{
+    CHECK(index >= 0 && index < kBucketsCount);
+    if (index < kSubBuckets)
+        return index;
+
+    int32_t shift = index / kSubBuckets - 1;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t lower = (kSubBuckets + sub) << shift;
+    // Middle of the bucket
+    return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void GProfilerHistogram::Record(uint64_t value)
+{
+    buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        ;
+}
+
+void GProfilerHistogram::Clear()
+{
+    for (auto& bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void GProfilerHistogram::AccumulateInto(Counts& counts, uint64_t& max) const
+{
+    for (int32_t i = 0; i < kBucketsCount; i++)
+        counts[i] += buckets_[i].load(std::memory_order_relaxed);
+    max = std::max(max, max_.load(std::memory_order_relaxed));
+}
+
+GProfilerHistogram::Summary GProfilerHistogram::Summarize(const Counts& counts, uint64_t max)
+{
+    Summary summary{};
+    for (uint64_t count : counts)
+        summary.count += count;
+    summary.max = max;
+    if (summary.count == 0)
+        return summary;
+
+    // Rank (1-based) of the value at each percentile
+    auto rank = [&summary](uint64_t percent) {
+        return std::max<uint64_t>(1, (summary.count * percent + 99) / 100);
+    };
+    std::pair<uint64_t, uint64_t*> percentiles[] = {
+        { rank(50), &summary.p50 },
+        { rank(90), &summary.p90 },
+        { rank(99), &summary.p99 }
+    };
+
+    uint64_t accumulated = 0;
+    size_t next = 0;
+    for (int32_t i = 0; i < kBucketsCount && next < std::size(percentiles); i++)
+    {
+        accumulated += counts[i];
+        while (next < std::size(percentiles) && accumulated >= percentiles[next].first)
+        {
+            // A bucket value may exceed the real maximum value
+            *percentiles[next].second = std::min(GetBucketValue(i), max);
+            next++;
+        }
+    }
+
+    return summary;
+}
+
+GLAMOR_NAMESPACE_END
@@ -0,0 +1,87 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_GPROFILERHISTOGRAM_H
+#define COCOA_GLAMOR_GPROFILERHISTOGRAM_H
+
+#include <atomic>
+#include <array>
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * A fixed-size histogram of durations (in microseconds) with log-linear
+ * buckets, similar to HdrHistogram: each power-of-two range is divided into
+ * `kSubBuckets` linear sub-buckets, so the relative error of a recorded value
+ * is always below `1 / kSubBuckets` while the whole range of frame timings
+ * only needs a few hundred buckets.
+ *
+ * Recording is lock-free and can be performed concurrently with reading.
+ * A reader may observe a histogram in the middle of recording or clearing,
+ * which only makes the statistics slightly stale.
+ */
+class GProfilerHistogram
+{
+public:
+    constexpr static int32_t kSubBucketBits = 4;
+    constexpr static int32_t kSubBuckets = 1 << kSubBucketBits;
+    // Values are clamped to [0, 2^(kMaxValueBits + 1)), about 67 seconds
+    constexpr static int32_t kMaxValueBits = 25;
+    constexpr static uint64_t kMaxValue = (uint64_t(1) << (kMaxValueBits + 1)) - 1;
+    constexpr static int32_t kBucketsCount =
+            (kMaxValueBits - kSubBucketBits + 2) * kSubBuckets;
+
+    using Counts = std::array<uint64_t, kBucketsCount>;
+
+    struct Summary
+    {
+        uint64_t count;
+        uint64_t p50;
+        uint64_t p90;
+        uint64_t p99;
+        uint64_t max;
+    };
+
+    GProfilerHistogram();
+    ~GProfilerHistogram() = default;
+
+    void Record(uint64_t value);
+
+    void Clear();
+
+    /**
+     * Accumulate the counts of this histogram into `counts`, so that
+     * several histograms can be summarized together.
+     */
+    void AccumulateInto(Counts& counts, uint64_t& max) const;
+
+    static Summary Summarize(const Counts& counts, uint64_t max);
+
+    g_nodiscard static int32_t GetBucketIndex(uint64_t value);
+
+    // The value which represents all the values in a bucket
+    g_nodiscard static uint64_t GetBucketValue(int32_t index);
+
+private:
+    std::atomic<uint32_t>   buckets_[kBucketsCount];
+    std::atomic<uint64_t>   max_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_GPROFILERHISTOGRAM_H
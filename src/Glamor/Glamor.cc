@@ -36,6 +36,13 @@ ContextOptions::ContextOptions()
     , show_tile_boundaries_(false)
     , enable_profiler_(false)
     , profiler_rb_threshold_(GLAMOR_PROFILER_RINGBUFFER_THRESHOLD_DEFAULT)
+    , enable_dynamic_resolution_(false)
+    , dynamic_resolution_min_scale_(GLAMOR_DYNRES_MIN_SCALE_DEFAULT)
+    , dynamic_resolution_frame_budget_(GLAMOR_DYNRES_FRAME_BUDGET_DEFAULT)
+    , enable_pointer_resampling_(false)
+    , enable_frame_pacing_(false)
+    , filter_cache_budget_(GLAMOR_FILTER_CACHE_BUDGET_DEFAULT)
+    , memory_budget_(GLAMOR_MEMORY_BUDGET_DEFAULT)
     , disable_hw_compose_(false)
     , disable_hw_compose_present_(false)
     , enable_vkdbg_(false)
@@ -119,6 +126,10 @@ ContextOptions& GlobalScope::GetOptions()
 
 const std::unique_ptr<StandaloneThreadPool>& GlobalScope::GetRenderWorkersThreadPool()
 {
+    // The pool is shared by the present thread (tiled rasterization) and
+    // the main thread (`Scene.toImage`), which may create it concurrently.
+    // Once created, it is never replaced until the scope is destroyed.
+    std::scoped_lock<std::mutex> lock(render_workers_creation_lock_);
     if (!render_workers_)
     {
         uint32_t count = options_.GetRenderWorkersConcurrencyCount();
@@ -44,6 +44,10 @@ class SkEventTracerImpl;
 #define GLAMOR_TILE_HEIGHT_DEFAULT  200
 #define GLAMOR_WORKERS_CONCURRENCY  4
 #define GLAMOR_PROFILER_RINGBUFFER_THRESHOLD_DEFAULT 32
+#define GLAMOR_DYNRES_MIN_SCALE_DEFAULT     0.5f
+#define GLAMOR_DYNRES_FRAME_BUDGET_DEFAULT  16.6f
+#define GLAMOR_FILTER_CACHE_BUDGET_DEFAULT  (32 * 1024 * 1024)
+#define GLAMOR_MEMORY_BUDGET_DEFAULT        0
 
 enum class Backends
 {
@@ -135,6 +139,75 @@ public:
         return profiler_rb_threshold_;
     }
 
+    // Render the layer tree at a reduced internal resolution and upscale it
+    // when frames take longer than the budget (raster backend only).
+    g_inline void SetEnableDynamicResolution(bool v) {
+        enable_dynamic_resolution_ = v;
+    }
+
+    g_nodiscard g_inline bool GetEnableDynamicResolution() const {
+        return enable_dynamic_resolution_;
+    }
+
+    // The lower bound of the internal resolution scale, in (0, 1]
+    g_inline void SetDynamicResolutionMinScale(float v) {
+        dynamic_resolution_min_scale_ = v;
+    }
+
+    g_nodiscard g_inline float GetDynamicResolutionMinScale() const {
+        return dynamic_resolution_min_scale_;
+    }
+
+    // Frame time budget in milliseconds
+    g_inline void SetDynamicResolutionFrameBudget(float ms) {
+        dynamic_resolution_frame_budget_ = ms;
+    }
+
+    g_nodiscard g_inline float GetDynamicResolutionFrameBudget() const {
+        return dynamic_resolution_frame_budget_;
+    }
+
+    // Report the pointer position resampled at the frame time rather than
+    // the position of the latest motion event.
+    g_inline void SetEnablePointerResampling(bool v) {
+        enable_pointer_resampling_ = v;
+    }
+
+    g_nodiscard g_inline bool GetEnablePointerResampling() const {
+        return enable_pointer_resampling_;
+    }
+
+    // Delay the frame signal after a frame callback to the latest safe
+    // start time predicted from the cost of recent frames.
+    g_inline void SetEnableFramePacing(bool v) {
+        enable_frame_pacing_ = v;
+    }
+
+    g_nodiscard g_inline bool GetEnableFramePacing() const {
+        return enable_frame_pacing_;
+    }
+
+    // Memory budget in bytes for caching the results of image filters and
+    // backdrop filters. Zero disables the cache.
+    g_inline void SetFilterCacheBudget(size_t bytes) {
+        filter_cache_budget_ = bytes;
+    }
+
+    g_nodiscard g_inline size_t GetFilterCacheBudget() const {
+        return filter_cache_budget_;
+    }
+
+    // Memory budget in bytes for all the purgeable graphics caches managed
+    // by `MemoryPressureManager`. Zero means unlimited, and the caches are
+    // only purged when the system reports memory pressure.
+    g_inline void SetMemoryBudget(size_t bytes) {
+        memory_budget_ = bytes;
+    }
+
+    g_nodiscard g_inline size_t GetMemoryBudget() const {
+        return memory_budget_;
+    }
+
     g_nodiscard g_inline bool GetDisableHWCompose() const {
         return disable_hw_compose_;
     }
@@ -196,6 +269,13 @@ private:
     bool        show_tile_boundaries_;
     bool        enable_profiler_;
     size_t      profiler_rb_threshold_;
+    bool        enable_dynamic_resolution_;
+    float       dynamic_resolution_min_scale_;
+    float       dynamic_resolution_frame_budget_;
+    bool        enable_pointer_resampling_;
+    bool        enable_frame_pacing_;
+    size_t      filter_cache_budget_;
+    size_t      memory_budget_;
     bool        disable_hw_compose_;
     bool        disable_hw_compose_present_;
 
@@ -247,6 +327,7 @@ private:
     ContextOptions                          options_;
     ApplicationInfo                         application_info_;
     EventLoop                              *event_loop_;
+    std::mutex                              render_workers_creation_lock_;
     std::unique_ptr<StandaloneThreadPool>   render_workers_;
     SkEventTracerImpl                      *skia_event_tracer_impl_;
     std::mutex                              hw_compose_creation_lock_;
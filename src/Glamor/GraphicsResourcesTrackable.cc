@@ -16,13 +16,105 @@
  */
 
 #include <sstream>
+#include <atomic>
+#include <algorithm>
 
 #include "json/json.h"
 
 #include "Core/Errors.h"
+#include "Core/TraceEvent.h"
 #include "Glamor/GraphicsResourcesTrackable.h"
 GLAMOR_NAMESPACE_BEGIN
 
+namespace {
+
+struct CategoryInfo
+{
+    const char *name;
+    // Perfetto counter tracks (names must be static strings)
+    const char *bytes_track;
+    const char *objects_track;
+};
+
+constexpr size_t kCategoriesCount = static_cast<size_t>(TrackableCategory::kLast) + 1;
+
+const CategoryInfo g_categories[kCategoriesCount] = {
+    { "layerCache", "Resources.LayerCache.Bytes", "Resources.LayerCache.Objects" },
+    { "shmBuffers", "Resources.ShmBuffers.Bytes", "Resources.ShmBuffers.Objects" },
+    { "textures", "Resources.Textures.Bytes", "Resources.Textures.Objects" },
+    { "importedSemaphores", "Resources.ImportedSemaphores.Bytes",
+      "Resources.ImportedSemaphores.Objects" },
+    { "videoFrames", "Resources.VideoFrames.Bytes", "Resources.VideoFrames.Objects" }
+};
+
+struct AtomicCategoryCounters
+{
+    std::atomic<int64_t> bytes;
+    std::atomic<int64_t> objects;
+    std::atomic<int64_t> peak_bytes;
+    std::atomic<int64_t> peak_objects;
+};
+
+AtomicCategoryCounters g_counters[kCategoriesCount];
+
+int64_t update_counter(std::atomic<int64_t>& counter, std::atomic<int64_t>& peak, int64_t delta)
+{
+    int64_t value = counter.fetch_add(delta, std::memory_order_relaxed) + delta;
+
+    int64_t current_peak = peak.load(std::memory_order_relaxed);
+    while (value > current_peak &&
+           !peak.compare_exchange_weak(current_peak, value, std::memory_order_relaxed))
+        ;
+
+    return value;
+}
+
+size_t load_counter(const std::atomic<int64_t>& counter)
+{
+    // A counter may be transiently negative if the resources are
+    // released on another thread before they have been accounted.
+    return static_cast<size_t>(std::max<int64_t>(counter.load(std::memory_order_relaxed), 0));
+}
+
+} // namespace anonymous
+
+void GraphicsResourcesTrackable::AccountResource(TrackableCategory category,
+                                                 int64_t bytes_delta,
+                                                 int64_t objects_delta)
+{
+    auto index = static_cast<size_t>(category);
+    CHECK(index < kCategoriesCount);
+
+    AtomicCategoryCounters& counters = g_counters[index];
+    int64_t bytes = update_counter(counters.bytes, counters.peak_bytes, bytes_delta);
+    int64_t objects = update_counter(counters.objects, counters.peak_objects, objects_delta);
+
+    TRACE_COUNTER("rendering", g_categories[index].bytes_track, bytes);
+    TRACE_COUNTER("rendering", g_categories[index].objects_track, objects);
+}
+
+GraphicsResourcesTrackable::CategoryCounters
+GraphicsResourcesTrackable::GetCategoryCounters(TrackableCategory category)
+{
+    auto index = static_cast<size_t>(category);
+    CHECK(index < kCategoriesCount);
+
+    const AtomicCategoryCounters& counters = g_counters[index];
+    return CategoryCounters{
+        .bytes = load_counter(counters.bytes),
+        .objects = load_counter(counters.objects),
+        .peak_bytes = load_counter(counters.peak_bytes),
+        .peak_objects = load_counter(counters.peak_objects)
+    };
+}
+
+const char *GraphicsResourcesTrackable::GetCategoryName(TrackableCategory category)
+{
+    auto index = static_cast<size_t>(category);
+    CHECK(index < kCategoriesCount);
+    return g_categories[index].name;
+}
+
 GraphicsResourcesTrackable::Tracer::Tracer()
     : tracings_(nullptr)
 {
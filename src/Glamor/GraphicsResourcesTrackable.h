@@ -41,6 +41,43 @@ GLAMOR_NAMESPACE_BEGIN
 #define TRACKABLE_OWNERSHIP_SHARED            "Shared"
 #define TRACKABLE_OWNERSHIP_WEAK              "WeakReference"
 
+enum class MemoryPressureLevel : uint32_t
+{
+    // Release the resources which are cheap to regenerate
+    kModerate,
+
+    // Release everything that can be released without breaking rendering
+    kCritical,
+
+    kLast = kCritical
+};
+
+/**
+ * Categories of the resources whose usage is accounted incrementally
+ * by `GraphicsResourcesTrackable::AccountResource`. Unlike the tracing
+ * mechanism, reading the counters of a category is cheap enough to be
+ * done for every frame.
+ */
+enum class TrackableCategory : uint32_t
+{
+    // Image snapshots held by `LayerGenerationCache`
+    kLayerCache,
+
+    // Wayland shared memory pools (mapped memory)
+    kShmBuffers,
+
+    // GPU textures (surfaces) imported from other GPU contexts
+    kTextures,
+
+    // GPU semaphores imported from other GPU contexts
+    kImportedSemaphores,
+
+    // Video frames referenced by external texture layers
+    kVideoFrames,
+
+    kLast = kVideoFrames
+};
+
 class GraphicsResourcesTrackable
 {
 public:
@@ -75,9 +112,41 @@ public:
         return reinterpret_cast<uint64_t>(pointer);
     }
 
+    struct CategoryCounters
+    {
+        size_t bytes;
+        size_t objects;
+        size_t peak_bytes;
+        size_t peak_objects;
+    };
+
+    /**
+     * Update the counters of `category` when resources are created
+     * (positive deltas) or destroyed (negative deltas). It is thread-safe
+     * and the new values are also emitted as Perfetto counters.
+     */
+    static void AccountResource(TrackableCategory category,
+                                int64_t bytes_delta, int64_t objects_delta);
+
+    static CategoryCounters GetCategoryCounters(TrackableCategory category);
+
+    static const char *GetCategoryName(TrackableCategory category);
+
     virtual ~GraphicsResourcesTrackable() = default;
 
     virtual void Trace(Tracer *tracer) noexcept = 0;
+
+    /**
+     * Trackables which hold caches can register themselves on
+     * `MemoryPressureManager` and implement the following methods.
+     * `GetPurgeableBytes` returns the size of resources that would be
+     * released by `PurgeResources` with `MemoryPressureLevel::kCritical`.
+     */
+    virtual size_t GetPurgeableBytes() noexcept {
+        return 0;
+    }
+
+    virtual void PurgeResources(g_maybe_unused MemoryPressureLevel level) noexcept {}
 };
 
 GLAMOR_NAMESPACE_END
@@ -0,0 +1,60 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Core/Journal.h"
+#include "Glamor/HeadlessSurface.h"
+#include "Glamor/ContentAggregator.h"
+GLAMOR_NAMESPACE_BEGIN
+
+HeadlessRenderTarget::HeadlessRenderTarget(int32_t width, int32_t height)
+    : RenderTarget(nullptr, RenderDevice::kRaster, width, height, kN32_SkColorType)
+    , surface_(SkSurfaces::Raster(SkImageInfo::MakeN32Premul(width, height)))
+    , frame_sequence_(0)
+{
+    CHECK(surface_);
+}
+
+SkSurface *HeadlessRenderTarget::OnBeginFrame()
+{
+    return surface_.get();
+}
+
+void HeadlessRenderTarget::OnResize(int32_t width, int32_t height)
+{
+    surface_ = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(width, height));
+    CHECK(surface_);
+}
+
+sk_sp<SkSurface> HeadlessRenderTarget::OnCreateOffscreenBackendSurface(const SkImageInfo& info)
+{
+    return SkSurfaces::Raster(info);
+}
+
+uint32_t HeadlessRenderTarget::OnRequestNextFrame()
+{
+    return ++frame_sequence_;
+}
+
+std::shared_ptr<HeadlessSurface> HeadlessSurface::Make(int32_t width, int32_t height)
+{
+    auto surface = std::make_shared<HeadlessSurface>(
+            std::make_shared<HeadlessRenderTarget>(width, height));
+    surface->SetContentAggregator(ContentAggregator::Make(surface));
+    return surface;
+}
+
+GLAMOR_NAMESPACE_END
@@ -0,0 +1,79 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COCOA_GLAMOR_HEADLESSSURFACE_H
+#define COCOA_GLAMOR_HEADLESSSURFACE_H
+
+#include "include/core/SkSurface.h"
+
+#include "Glamor/Glamor.h"
+#include "Glamor/RenderTarget.h"
+#include "Glamor/Surface.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * A raster render target which is not backed by any window system.
+ * Frames are painted into a single raster surface, and submitting or
+ * presenting a frame does nothing. It is used by the offline tools
+ * (`scene-replay`, `render-thread-test`) and is not a part of Glamor.
+ */
+class HeadlessRenderTarget : public RenderTarget
+{
+public:
+    HeadlessRenderTarget(int32_t width, int32_t height);
+    ~HeadlessRenderTarget() override = default;
+
+    // The surface which the latest frame has been painted into
+    g_nodiscard SkSurface *GetFrameSurface() const {
+        return surface_.get();
+    }
+
+protected:
+    SkSurface *OnBeginFrame() override;
+    void OnSubmitFrame(SkSurface *surface, const FrameSubmitInfo& submit_info) override {}
+    void OnPresentFrame(SkSurface *surface, const FrameSubmitInfo& submit_info) override {}
+    void OnResize(int32_t width, int32_t height) override;
+    sk_sp<SkSurface> OnCreateOffscreenBackendSurface(const SkImageInfo& info) override;
+    uint32_t OnRequestNextFrame() override;
+
+private:
+    sk_sp<SkSurface>    surface_;
+    uint32_t            frame_sequence_;
+};
+
+class HeadlessSurface : public Surface
+{
+public:
+    // Create a surface and its `ContentAggregator`
+    static std::shared_ptr<HeadlessSurface> Make(int32_t width, int32_t height);
+
+    explicit HeadlessSurface(const std::shared_ptr<RenderTarget>& rt) : Surface(rt) {}
+    ~HeadlessSurface() override = default;
+
+protected:
+    void OnClose() override {}
+    void OnSetTitle(const std::string_view& title) override {}
+    void OnSetMaxSize(int32_t width, int32_t height) override {}
+    void OnSetMinSize(int32_t width, int32_t height) override {}
+    void OnSetMaximized(bool value) override {}
+    void OnSetMinimized(bool value) override {}
+    void OnSetFullscreen(bool value, const std::shared_ptr<Monitor>& monitor) override {}
+    void OnSetCursor(const std::shared_ptr<Cursor>& cursor) override {}
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_HEADLESSSURFACE_H
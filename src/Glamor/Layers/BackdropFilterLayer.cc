@@ -15,8 +15,11 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "include/core/SkSurface.h"
 #include "fmt/format.h"
+
 #include "Glamor/Layers/BackdropFilterLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 BackdropFilterLayer::BackdropFilterLayer(const sk_sp<SkImageFilter>& filter,
@@ -49,14 +52,19 @@ BackdropFilterLayer::OnContainerDiffUpdateAttributes(const std::shared_ptr<Conta
 
     this->image_filter_ = layer->image_filter_;
 
-    // FIXME(sora): BackdropFilterLayer is not cachable, because its
-    //              content depends on the current backdrop, whose change
-    //              of content cannot be detected by checking the subtree.
+    // BackdropFilterLayer is not cachable by `LayerGenerationCache`, because
+    // its content depends on the current backdrop, whose change of content
+    // cannot be detected by checking the subtree. The filtered backdrop is
+    // cached by `FilterResultCache` with the backdrop signature instead.
     return ContainerAttributeChanged::kYes;
 }
 
 void BackdropFilterLayer::Preroll(PrerollContext *context, const SkMatrix& matrix)
 {
+    // Layers prerolled so far will be painted before this layer
+    size_t backdrop_layers_count = context->prerolled_layers
+                                   ? context->prerolled_layers->size() : 0;
+
     SkRect child_paint_bounds = SkRect::MakeEmpty();
     PrerollChildren(context, matrix, &child_paint_bounds);
 
@@ -67,6 +75,40 @@ void BackdropFilterLayer::Preroll(PrerollContext *context, const SkMatrix& matri
     // by image filter.
     child_paint_bounds.join(context->cull_rect);
     SetPaintBounds(child_paint_bounds);
+
+    ComputeBackdropSignature(context, matrix, backdrop_layers_count);
+}
+
+void BackdropFilterLayer::ComputeBackdropSignature(PrerollContext *context,
+                                                   const SkMatrix& matrix,
+                                                   size_t backdrop_layers_count)
+{
+    backdrop_signature_.reset();
+    if (!context->prerolled_layers)
+        return;
+
+    // The backdrop filter may read the backdrop out of the paint bounds
+    // (e.g. a blur filter samples the neighbouring pixels).
+    SkIRect device_bounds = matrix.mapRect(GetPaintBounds()).roundOut();
+    SkRect input_bounds = SkRect::Make(image_filter_->filterBounds(
+            device_bounds, matrix, SkImageFilter::kReverse_MapDirection));
+
+    // The backdrop only changes when a layer painted below it, which
+    // intersects with it, is changed, added or removed.
+    uint64_t signature = 0;
+    for (size_t i = 0; i < backdrop_layers_count; i++)
+    {
+        const PrerolledLayer& layer = (*context->prerolled_layers)[i];
+        if (!SkRect::Intersects(layer.device_bounds, input_bounds))
+            continue;
+        if (layer.is_volatile)
+            return;
+
+        signature = FilterResultCache::CombineSignature(signature, layer.unique_id);
+        signature = FilterResultCache::CombineSignature(signature, layer.generation);
+    }
+
+    backdrop_signature_ = signature;
 }
 
 void BackdropFilterLayer::Paint(PaintContext *context)
@@ -75,6 +117,8 @@ void BackdropFilterLayer::Paint(PaintContext *context)
     CHECK(canvas);
 
     SkAutoCanvasRestore auto_restore(canvas, true);
+    sk_sp<SkImage> filtered_backdrop;
+    FilterResultCache::Key key{};
 
     // Graphics state stored in `PaintContext::paints_stack` can be overwritten
     // (consider there are multiple container layers linked serially, and each of
@@ -89,19 +133,107 @@ void BackdropFilterLayer::Paint(PaintContext *context)
         if (auto_child_clip_)
             canvas->clipRect(child_paint_bounds);
 
-        SkCanvas::SaveLayerRec save_layer_rec(&child_paint_bounds,
-                                              context->GetCurrentPaintPtr(),
-                                              image_filter_.get(),
-                                              SkCanvas::kInitWithPrevious_SaveLayerFlag);
-        canvas->saveLayer(save_layer_rec);
+        filtered_backdrop = FindCachedFilteredBackdrop(context, &key);
+        if (filtered_backdrop)
+        {
+            // The new layer is initialized with the cached filtered backdrop
+            // instead of applying the backdrop filter.
+            canvas->saveLayer(&child_paint_bounds, context->GetCurrentPaintPtr());
+        }
+        else
+        {
+            SkCanvas::SaveLayerRec save_layer_rec(&child_paint_bounds,
+                                                  context->GetCurrentPaintPtr(),
+                                                  image_filter_.get(),
+                                                  SkCanvas::kInitWithPrevious_SaveLayerFlag);
+            canvas->saveLayer(save_layer_rec);
+        }
     }
 
+    if (filtered_backdrop)
+        FilterResultCache::DrawResult(context, filtered_backdrop, key, nullptr);
+
+    context->save_layer_depth++;
     PaintChildren(context);
+    context->save_layer_depth--;
 
     // Restore the `saveLayer`
     canvas->restore();
 }
 
+sk_sp<SkImage> BackdropFilterLayer::FindCachedFilteredBackdrop(PaintContext *context,
+                                                               FilterResultCache::Key *out_key)
+{
+    // The backdrop can only be read from the frame surface when there is
+    // no pending layer created by an ancestor.
+    if (!context->filter_cache || context->is_generating_cache ||
+        context->save_layer_depth > 0 || !backdrop_signature_)
+    {
+        return nullptr;
+    }
+
+    SkCanvas *frame_canvas = context->frame_canvas;
+    SkMatrix matrix = frame_canvas->getTotalMatrix();
+    SkMatrix inverse;
+    if (matrix.hasPerspective() || !matrix.invert(&inverse))
+        return nullptr;
+
+    SkIRect device_bounds = matrix.mapRect(GetPaintBounds()).roundOut();
+    if (!device_bounds.intersect(frame_canvas->getDeviceClipBounds()) ||
+        !device_bounds.intersect(SkIRect::MakeSize(context->frame_surface->imageInfo().dimensions())))
+    {
+        return nullptr;
+    }
+
+    *out_key = {
+        .filter = image_filter_.get(),
+        .content_signature = *backdrop_signature_,
+        .device_bounds = device_bounds,
+        .matrix = matrix
+    };
+
+    return context->filter_cache->FindOrGenerate(
+            this, image_filter_, *out_key, [this, context, out_key] {
+        return GenerateFilteredBackdrop(context, *out_key);
+    });
+}
+
+sk_sp<SkImage> BackdropFilterLayer::GenerateFilteredBackdrop(PaintContext *context,
+                                                             const FilterResultCache::Key& key)
+{
+    SkIRect input_bounds = image_filter_->filterBounds(
+            key.device_bounds, key.matrix, SkImageFilter::kReverse_MapDirection);
+    input_bounds.join(key.device_bounds);
+    if (!input_bounds.intersect(SkIRect::MakeSize(context->frame_surface->imageInfo().dimensions())))
+        return nullptr;
+
+    sk_sp<SkImage> backdrop = context->frame_surface->makeImageSnapshot(input_bounds);
+    if (!backdrop)
+        return nullptr;
+
+    sk_sp<SkSurface> surface = context->filter_cache->CreateSurface(
+            input_bounds.size(), context->frame_surface);
+    if (!surface)
+        return nullptr;
+
+    // Apply the backdrop filter in the same way as `SkCanvas` does, and
+    // replace the backdrop with the filtered one.
+    SkCanvas *canvas = surface->getCanvas();
+    canvas->translate(-SkIntToScalar(input_bounds.left()), -SkIntToScalar(input_bounds.top()));
+    canvas->drawImage(backdrop, SkIntToScalar(input_bounds.left()),
+                      SkIntToScalar(input_bounds.top()));
+    canvas->clipIRect(key.device_bounds);
+    canvas->concat(key.matrix);
+
+    SkPaint replace_paint;
+    replace_paint.setBlendMode(SkBlendMode::kSrc);
+    canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, &replace_paint, image_filter_.get(), 0));
+    canvas->restore();
+
+    return surface->makeImageSnapshot(key.device_bounds.makeOffset(-input_bounds.left(),
+                                                                   -input_bounds.top()));
+}
+
 void BackdropFilterLayer::ToString(std::ostream& out)
 {
     out << fmt::format("(backdrop-filter#{}:{} '(typename \"{}\") '(auto-child-clipping {})",
@@ -117,4 +249,13 @@ void BackdropFilterLayer::ToString(std::ostream& out)
     out << ')';
 }
 
+void BackdropFilterLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kBackdropFilter_LayerTag, this);
+    writer->WriteImageFilter(image_filter_);
+    writer->WriteU8(static_cast<uint8_t>(blend_mode_));
+    writer->WriteBool(auto_child_clip_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
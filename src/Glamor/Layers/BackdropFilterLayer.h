@@ -23,6 +23,7 @@
 
 #include "Glamor/Layers/Layer.h"
 #include "Glamor/Layers/ContainerLayer.h"
+#include "Glamor/Layers/FilterResultCache.h"
 GLAMOR_NAMESPACE_BEGIN
 
 class BackdropFilterLayer : public ContainerLayer
@@ -35,6 +36,7 @@ public:
     void Preroll(PrerollContext *context, const SkMatrix &matrix) override;
     void Paint(PaintContext *context) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     ContainerAttributeChanged OnContainerDiffUpdateAttributes(
             const std::shared_ptr<ContainerLayer>& other) override;
@@ -44,9 +46,21 @@ public:
     }
 
 private:
+    void ComputeBackdropSignature(PrerollContext *context, const SkMatrix& matrix,
+                                  size_t backdrop_layers_count);
+    sk_sp<SkImage> FindCachedFilteredBackdrop(PaintContext *context,
+                                              FilterResultCache::Key *out_key);
+    sk_sp<SkImage> GenerateFilteredBackdrop(PaintContext *context,
+                                            const FilterResultCache::Key& key);
+
     bool                    auto_child_clip_;
     sk_sp<SkImageFilter>    image_filter_;
     SkBlendMode             blend_mode_;
+
+    // Identifies the contents painted below this layer, which are the input
+    // of the backdrop filter. It is not available if the contents cannot be
+    // tracked by layer generations (e.g. external textures).
+    std::optional<uint64_t> backdrop_signature_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -16,6 +16,7 @@
  */
 
 #include "Glamor/Layers/ContainerLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 ContainerLayer::ContainerLayer(ContainerType container_type)
@@ -49,6 +50,17 @@ void ContainerLayer::PrerollChildren(PrerollContext *context,
         // to child layer is reasonable.
         layer->Preroll(context, matrix);
 
+        if (context->prerolled_layers)
+        {
+            Type type = layer->GetType();
+            context->prerolled_layers->push_back({
+                .device_bounds = matrix.mapRect(layer->GetPaintBounds()),
+                .unique_id = layer->GetUniqueId(),
+                .generation = layer->GetGenerationId(),
+                .is_volatile = (type == Type::kExternalTexture || type == Type::kGpuSurfaceView)
+            });
+        }
+
         // The dirty boundary of a ContainerLayer is just the union of all its
         // children's dirty boundaries.
         child_paint_bounds->join(layer->GetPaintBounds());
@@ -65,7 +77,12 @@ void ContainerLayer::PaintChildren(PaintContext *context) const
     // Iterate each child layer and paint them respectively
     for (const std::shared_ptr<Layer>& layer : child_layers_)
     {
-        if (layer->NeedsPainting(context))
+        if (!layer->NeedsPainting(context))
+            continue;
+
+        if (context->native_resolution_deferral && layer->GetPrefersNativeResolution())
+            context->native_resolution_deferral->Defer(layer.get(), context);
+        else
             layer->Paint(context);
     }
 }
@@ -95,6 +112,7 @@ void ContainerLayer::DiffUpdate(const std::shared_ptr<Layer>& other)
         }
 
         std::shared_ptr<Layer> reusable_old_layer = *reusable_old_itr;
+        reusable_old_layer->SetPrefersNativeResolution((*itr)->GetPrefersNativeResolution());
         uint64_t old_gen_id = reusable_old_layer->GetGenerationId();
         reusable_old_layer->DiffUpdate(*itr);
         subtree_dirty = subtree_dirty || (old_gen_id != reusable_old_layer->GetGenerationId());
@@ -111,6 +129,13 @@ void ContainerLayer::DiffUpdate(const std::shared_ptr<Layer>& other)
         IncreaseGenerationId();
 }
 
+void ContainerLayer::SerializeChildren(SceneStreamWriter *writer)
+{
+    writer->WriteU32(child_layers_.size());
+    for (const std::shared_ptr<Layer>& layer : child_layers_)
+        layer->Serialize(writer);
+}
+
 void ContainerLayer::ChildrenToString(std::ostream& out)
 {
     bool is_first_child = true;
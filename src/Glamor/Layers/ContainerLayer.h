@@ -65,6 +65,7 @@ protected:
     void PrerollChildren(PrerollContext *context, const SkMatrix& matrix, SkRect *child_paint_bounds);
     void PaintChildren(PaintContext *context) const;
     void ChildrenToString(std::ostream& out);
+    void SerializeChildren(SceneStreamWriter *writer);
 
     enum class ContainerAttributeChanged
     {
@@ -20,8 +20,23 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/ExternalTextureLayer.h"
+#include "Glamor/Layers/SceneStream.h"
+#include "Glamor/GraphicsResourcesTrackable.h"
 GLAMOR_NAMESPACE_BEGIN
 
+namespace {
+
+// The accessor produces an RGBA texture of the scaled size, which is
+// the best estimation we can make without knowing the decoder's format.
+void account_video_frame(const SkISize& size, int64_t sign)
+{
+    int64_t bytes = static_cast<int64_t>(size.width()) * size.height() * 4;
+    GraphicsResourcesTrackable::AccountResource(
+            TrackableCategory::kVideoFrames, sign * bytes, sign);
+}
+
+} // namespace anonymous
+
 ExternalTextureLayer::ExternalTextureLayer(std::unique_ptr<Accessor> frame_accessor,
                                            const SkPoint& offset,
                                            const SkISize& size,
@@ -32,6 +47,14 @@ ExternalTextureLayer::ExternalTextureLayer(std::unique_ptr<Accessor> frame_acces
         , scale_size_(size)
         , scale_sampling_(sampling)
 {
+    if (frame_accessor_)
+        account_video_frame(scale_size_, 1);
+}
+
+ExternalTextureLayer::~ExternalTextureLayer()
+{
+    if (frame_accessor_)
+        account_video_frame(scale_size_, -1);
 }
 
 void ExternalTextureLayer::DiffUpdate(const std::shared_ptr<Layer>& other)
@@ -39,6 +62,11 @@ void ExternalTextureLayer::DiffUpdate(const std::shared_ptr<Layer>& other)
     CHECK(other->GetType() == Type::kExternalTexture);
     auto layer = std::static_pointer_cast<ExternalTextureLayer>(other);
 
+    // The accounted frame is transferred from `other` together with
+    // its accessor, and the frame we are holding now is released.
+    if (frame_accessor_)
+        account_video_frame(scale_size_, -1);
+
     frame_accessor_ = std::move(layer->frame_accessor_);
     offset_ = layer->offset_;
     scale_size_ = layer->scale_size_;
@@ -109,4 +137,13 @@ void ExternalTextureLayer::ToString(std::ostream& out)
                        offset_.x(), offset_.y());
 }
 
+void ExternalTextureLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kExternalTexture_LayerTag, this);
+    writer->WritePoint(offset_);
+    writer->WriteI32(scale_size_.width());
+    writer->WriteI32(scale_size_.height());
+    writer->WriteSampling(scale_sampling_);
+}
+
 GLAMOR_NAMESPACE_END
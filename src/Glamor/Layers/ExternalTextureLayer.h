@@ -85,13 +85,14 @@ public:
                          const SkPoint& offset,
                          const SkISize& size,
                          const SkSamplingOptions& sampling);
-    ~ExternalTextureLayer() override = default;
+    ~ExternalTextureLayer() override;
 
     void DiffUpdate(const std::shared_ptr<Layer>& other) override;
 
     void Preroll(PrerollContext *context, const SkMatrix& matrix) override;
     void Paint(PaintContext *context) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char * GetLayerTypeName() override {
         return "ExternalTextureLayer";
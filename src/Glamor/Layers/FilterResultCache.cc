@@ -0,0 +1,294 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "include/core/SkCanvas.h"
+#include "include/gpu/ganesh/SkSurfaceGanesh.h"
+#include "fmt/format.h"
+
+#include "Core/TraceEvent.h"
+#include "Glamor/Layers/FilterResultCache.h"
+#include "Glamor/MemoryPressureManager.h"
+GLAMOR_NAMESPACE_BEGIN
+
+uint64_t FilterResultCache::CombineSignature(uint64_t seed, uint64_t value)
+{
+    // boost::hash_combine
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+FilterResultCache::FilterResultCache(std::shared_ptr<SkiaGpuContextOwner> gpu_context,
+                                     size_t budget_bytes)
+    : gpu_context_owner_(std::move(gpu_context))
+    , budget_bytes_(budget_bytes)
+    , cached_bytes_(0)
+    , frame_counter_(0)
+{
+    MemoryPressureManager::Register(this, MemoryPressureManager::PurgePriority::kFilterResults);
+}
+
+FilterResultCache::~FilterResultCache()
+{
+    MemoryPressureManager::Unregister(this);
+}
+
+void FilterResultCache::BeginFrame()
+{
+    frame_counter_++;
+}
+
+void FilterResultCache::EndFrame()
+{
+    // Entries of the layers which have not been painted for a while are
+    // considered to be dead (layers are not painted when they are culled,
+    // so the entries are not dropped immediately).
+    auto itr = entries_.begin();
+    while (itr != entries_.end())
+    {
+        if (frame_counter_ - itr->second.last_used_frame >= kEntryOverdueFrames)
+        {
+            ReleaseEntryImage(itr->second);
+            itr = entries_.erase(itr);
+        }
+        else
+        {
+            itr++;
+        }
+    }
+    TraceCachedBytes();
+}
+
+void FilterResultCache::PurgeCacheResources()
+{
+    entries_.clear();
+    cached_bytes_ = 0;
+    TraceCachedBytes();
+}
+
+size_t FilterResultCache::GetPurgeableBytes() noexcept
+{
+    return GetCachedBytes();
+}
+
+void FilterResultCache::PurgeResources(MemoryPressureLevel level) noexcept
+{
+    if (level == MemoryPressureLevel::kCritical)
+    {
+        PurgeCacheResources();
+        return;
+    }
+
+    // Entries are kept, so the results of the stable filters
+    // will be generated again in the next frame.
+    for (auto& [layer_id, entry] : entries_)
+        ReleaseEntryImage(entry);
+    TraceCachedBytes();
+}
+
+void FilterResultCache::ReleaseEntryImage(CacheEntry& entry)
+{
+    if (!entry.image)
+        return;
+    CHECK(cached_bytes_ >= entry.image_bytes);
+    cached_bytes_ -= entry.image_bytes;
+    entry.image_bytes = 0;
+    entry.image.reset();
+}
+
+bool FilterResultCache::MakeRoomForBytes(size_t bytes)
+{
+    if (bytes > budget_bytes_)
+        return false;
+
+    // Evict the least recently used results, except those which have
+    // been used in the current frame.
+    while (cached_bytes_ + bytes > budget_bytes_)
+    {
+        CacheEntry *victim = nullptr;
+        for (auto& [layer_id, entry] : entries_)
+        {
+            if (!entry.image || entry.last_used_frame == frame_counter_)
+                continue;
+            if (!victim || entry.last_used_frame < victim->last_used_frame)
+                victim = &entry;
+        }
+
+        if (!victim)
+            return false;
+        ReleaseEntryImage(*victim);
+    }
+
+    return true;
+}
+
+sk_sp<SkImage> FilterResultCache::FindOrGenerate(Layer *layer,
+                                                 const sk_sp<SkImageFilter>& filter,
+                                                 const Key& key,
+                                                 const Generator& generator)
+{
+    if (budget_bytes_ == 0 || key.device_bounds.isEmpty())
+        return nullptr;
+
+    uint32_t layer_id = layer->GetUniqueId();
+    auto itr = entries_.find(layer_id);
+    if (itr == entries_.end())
+    {
+        entries_[layer_id] = {
+            .key = key,
+            .filter = filter,
+            .stable_count = 1,
+            .last_used_frame = frame_counter_,
+            .image_bytes = 0,
+            .image = nullptr
+        };
+        return nullptr;
+    }
+
+    CacheEntry& entry = itr->second;
+    entry.last_used_frame = frame_counter_;
+    if (!(entry.key == key))
+    {
+        // The filter or its input has changed, so the cached result
+        // is invalidated.
+        ReleaseEntryImage(entry);
+        entry.key = key;
+        entry.filter = filter;
+        entry.stable_count = 1;
+        TraceCachedBytes();
+        return nullptr;
+    }
+
+    if (entry.image)
+        return entry.image;
+
+    if (++entry.stable_count < kStableFramesThreshold)
+        return nullptr;
+
+    // Estimated with 32-bit pixels before the result is generated
+    size_t estimated_bytes = key.device_bounds.width() * key.device_bounds.height() * 4;
+    if (!MakeRoomForBytes(estimated_bytes))
+        return nullptr;
+
+    TRACE_EVENT("rendering", "FilterResultCache::Generate");
+    sk_sp<SkImage> image = generator();
+    if (!image)
+        return nullptr;
+
+    entry.image = image;
+    entry.image_bytes = image->imageInfo().computeMinByteSize();
+    cached_bytes_ += entry.image_bytes;
+    TraceCachedBytes();
+
+    return image;
+}
+
+sk_sp<SkSurface> FilterResultCache::CreateSurface(SkISize size, SkSurface *format_hint_surface)
+{
+    CHECK(format_hint_surface);
+    SkImageInfo image_info = format_hint_surface->imageInfo().makeDimensions(size);
+
+    GrDirectContext *direct_ctx = gpu_context_owner_
+                                  ? gpu_context_owner_->GetSkiaGpuContext()
+                                  : nullptr;
+    if (direct_ctx)
+        return SkSurfaces::RenderTarget(direct_ctx, skgpu::Budgeted::kNo, image_info);
+    return SkSurfaces::Raster(image_info);
+}
+
+Layer::PaintContext
+FilterResultCache::MakeGeneratingPaintContext(Layer::PaintContext *context, SkSurface *surface)
+{
+    SkCanvas *canvas = surface->getCanvas();
+    return Layer::PaintContext{
+        .gr_context = context->gr_context,
+        .is_generating_cache = true,
+        .root_surface_transformation = SkMatrix::I(),
+        .frame_surface = surface,
+        .frame_canvas = canvas,
+        .multiplexer_canvas = canvas,
+        .cull_rect = context->cull_rect,
+        .resource_usage_flags = Layer::PaintContext::kNone_ResourceUsage,
+        .cache = context->cache,
+        .filter_cache = nullptr,
+        .save_layer_depth = 0,
+        .content_aggregator = context->content_aggregator,
+        .gpu_finished_semaphores = {},
+        .native_resolution_deferral = nullptr,
+        .frame_arena = context->frame_arena
+    };
+}
+
+void FilterResultCache::FinishGeneratingPaintContext(Layer::PaintContext *context,
+                                                     Layer::PaintContext *generating_context,
+                                                     SkSurface *surface)
+{
+    context->resource_usage_flags |= generating_context->resource_usage_flags;
+
+    // See `LayerGenerationCache::TakeLayerImageSnapshot`
+    auto& signal_semaphores = generating_context->gpu_finished_semaphores;
+    if (context->gr_context && !signal_semaphores.empty())
+    {
+        GrFlushInfo info;
+        info.fNumSemaphores = signal_semaphores.size();
+        info.fSignalSemaphores = signal_semaphores.data();
+        context->gr_context->flush(surface, info, nullptr);
+    }
+}
+
+void FilterResultCache::DrawResult(Layer::PaintContext *context,
+                                   const sk_sp<SkImage>& image,
+                                   const Key& key,
+                                   const SkPaint *paint)
+{
+    SkMatrix inverse;
+    CHECK(key.matrix.invert(&inverse));
+
+    SkCanvas *canvas = context->multiplexer_canvas;
+    SkAutoCanvasRestore auto_restore(canvas, true);
+    canvas->concat(inverse);
+    canvas->drawImage(image, SkIntToScalar(key.device_bounds.left()),
+                      SkIntToScalar(key.device_bounds.top()), SkSamplingOptions(), paint);
+
+    if (image->isTextureBacked())
+        context->resource_usage_flags |= Layer::PaintContext::kGpu_ResourceUsage;
+}
+
+void FilterResultCache::TraceCachedBytes()
+{
+    TRACE_COUNTER("rendering", "FilterResultCache.CachedBytes", GetCachedBytes());
+}
+
+void FilterResultCache::Trace(Tracer *tracer) noexcept
+{
+    for (const auto& [layer_id, entry] : entries_)
+    {
+        if (!entry.image)
+            continue;
+
+        tracer->TraceResource(
+            fmt::format("FilterCache[Layer#{}]", layer_id),
+            TRACKABLE_TYPE_TEXTURE,
+            entry.image->isTextureBacked() ? TRACKABLE_DEVICE_GPU : TRACKABLE_DEVICE_CPU,
+            TRACKABLE_OWNERSHIP_SHARED,
+            TraceIdFromPointer(entry.image.get()),
+            entry.image_bytes
+        );
+    }
+}
+
+GLAMOR_NAMESPACE_END
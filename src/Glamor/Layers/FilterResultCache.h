@@ -0,0 +1,169 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_LAYERS_FILTERRESULTCACHE_H
+#define COCOA_GLAMOR_LAYERS_FILTERRESULTCACHE_H
+
+#include <functional>
+#include <atomic>
+#include <unordered_map>
+
+#include "include/core/SkImage.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkSurface.h"
+
+#include "Glamor/Glamor.h"
+#include "Glamor/SkiaGpuContextOwner.h"
+#include "Glamor/GraphicsResourcesTrackable.h"
+#include "Glamor/Layers/Layer.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * Caches the outputs of image filters applied by `ImageFilterLayer` and
+ * `BackdropFilterLayer` in device space, so that an expensive filter
+ * (typically a large blur) is not performed again on each paint when
+ * neither the filter nor its input contents have changed.
+ *
+ * Each layer owns at most one cached result, which is identified by a `Key`.
+ * A result is only generated after its key has been stable for
+ * `kStableFramesThreshold` frames, and the total size of the cached images
+ * is limited by a memory budget.
+ */
+class FilterResultCache : public GraphicsResourcesTrackable
+{
+public:
+    constexpr static uint32_t kStableFramesThreshold = 2;
+    constexpr static uint64_t kEntryOverdueFrames = 60;
+
+    struct Key
+    {
+        // Identity of the filter, which is kept alive by the cache entry
+        const SkImageFilter    *filter;
+
+        // Generation of the filter input: the generation of `ImageFilterLayer`
+        // or the signature of the backdrop of `BackdropFilterLayer`
+        uint64_t                content_signature;
+
+        SkIRect                 device_bounds;
+        SkMatrix                matrix;
+
+        bool operator==(const Key& other) const {
+            return (filter == other.filter &&
+                    content_signature == other.content_signature &&
+                    device_bounds == other.device_bounds &&
+                    matrix == other.matrix);
+        }
+    };
+
+    using Generator = std::function<sk_sp<SkImage>(void)>;
+
+    static uint64_t CombineSignature(uint64_t seed, uint64_t value);
+
+    FilterResultCache(std::shared_ptr<SkiaGpuContextOwner> gpu_context,
+                      size_t budget_bytes);
+    ~FilterResultCache() override;
+
+    void BeginFrame();
+    void EndFrame();
+
+    void PurgeCacheResources();
+
+    g_nodiscard g_inline size_t GetBudgetBytes() const {
+        return budget_bytes_;
+    }
+
+    g_nodiscard g_inline size_t GetCachedBytes() const {
+        return cached_bytes_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Find the cached filter result of `layer` identified by `key`.
+     * If there is no such a result but the key has been stable for enough frames,
+     * `generator` is called to generate it. The result is only cached when it
+     * fits into the memory budget.
+     *
+     * @return  The filter result whose origin is at the top-left corner of
+     *          `key.device_bounds`, or null if the caller should apply the
+     *          filter by itself.
+     */
+    sk_sp<SkImage> FindOrGenerate(Layer *layer,
+                                  const sk_sp<SkImageFilter>& filter,
+                                  const Key& key,
+                                  const Generator& generator);
+
+    /**
+     * Create an offscreen surface to generate a filter result, whose color
+     * format is up to `format_hint_surface`.
+     */
+    sk_sp<SkSurface> CreateSurface(SkISize size, SkSurface *format_hint_surface);
+
+    /**
+     * Create a subcontext to paint layers into `surface` when a filter result
+     * is being generated. Field `paints_stack` of `context` is ignored, as the
+     * paint effects will be applied when the filter result is drawn.
+     */
+    static Layer::PaintContext MakeGeneratingPaintContext(Layer::PaintContext *context,
+                                                          SkSurface *surface);
+
+    // Flush the subcontext and propagate its resource usages to `context`
+    static void FinishGeneratingPaintContext(Layer::PaintContext *context,
+                                             Layer::PaintContext *generating_context,
+                                             SkSurface *surface);
+
+    /**
+     * Draw a filter result on the canvas in device space. `key.matrix` must be
+     * the invertible total matrix of `context->frame_canvas`, which is not equal
+     * to the matrix of `context->multiplexer_canvas` when the frame is painted
+     * at a reduced scale.
+     */
+    static void DrawResult(Layer::PaintContext *context,
+                           const sk_sp<SkImage>& image,
+                           const Key& key,
+                           const SkPaint *paint);
+
+    void Trace(Tracer *tracer) noexcept override;
+    size_t GetPurgeableBytes() noexcept override;
+    void PurgeResources(MemoryPressureLevel level) noexcept override;
+
+private:
+    struct CacheEntry
+    {
+        Key                     key;
+        sk_sp<SkImageFilter>    filter;
+        uint32_t                stable_count;
+        uint64_t                last_used_frame;
+        size_t                  image_bytes;
+        sk_sp<SkImage>          image;
+    };
+
+    void ReleaseEntryImage(CacheEntry& entry);
+    bool MakeRoomForBytes(size_t bytes);
+    void TraceCachedBytes();
+
+    std::shared_ptr<SkiaGpuContextOwner>            gpu_context_owner_;
+    size_t                                          budget_bytes_;
+    // Only modified by the painting thread, but it can be read by any thread
+    // (see `GetPurgeableBytes`)
+    std::atomic<size_t>                             cached_bytes_;
+    uint64_t                                        frame_counter_;
+    std::unordered_map<uint32_t, CacheEntry>        entries_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_LAYERS_FILTERRESULTCACHE_H
@@ -20,6 +20,7 @@
 #include "Core/Journal.h"
 #include "Glamor/ContentAggregator.h"
 #include "Glamor/Layers/GpuSurfaceViewLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.Layers.GpuSurfaceViewLayer)
@@ -157,4 +158,13 @@ void GpuSurfaceViewLayer::ToString(std::ostream& out)
                        dst_rect_.x(), dst_rect_.y(), dst_rect_.width(), dst_rect_.height());
 }
 
+void GpuSurfaceViewLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kGpuSurfaceView_LayerTag, this);
+    writer->WriteI64(surface_id_);
+    writer->WriteRect(dst_rect_);
+    writer->WriteI64(wait_semaphore_id_);
+    writer->WriteI64(signal_semaphore_id_);
+}
+
 GLAMOR_NAMESPACE_END
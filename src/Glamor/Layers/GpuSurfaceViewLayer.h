@@ -62,6 +62,7 @@ public:
     void Paint(PaintContext *context) override;
     void DiffUpdate(const std::shared_ptr<Layer>& other) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "GpuSurfaceViewLayer";
@@ -16,11 +16,12 @@
  */
 
 #include "include/core/SkImageFilter.h"
+#include "include/core/SkSurface.h"
 #include "fmt/format.h"
 
 #include "Core/Errors.h"
 #include "Glamor/Layers/ImageFilterLayer.h"
-#include "Glamor/Layers/LayerGenerationCache.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 ImageFilterLayer::ImageFilterLayer(const sk_sp<SkImageFilter>& filter)
@@ -62,7 +63,7 @@ void ImageFilterLayer::Paint(PaintContext *context)
     SkCanvas *canvas = context->multiplexer_canvas;
     CHECK(canvas);
 
-    if (context->cache->TryDrawCacheImageSnapshot(this, context))
+    if (TryDrawCachedFilterResult(context))
         return;
 
     // Graphics state stored in `PaintContext::paints_stack` can be overwritten
@@ -76,11 +77,75 @@ void ImageFilterLayer::Paint(PaintContext *context)
         canvas->saveLayer(GetPaintBounds(), context->GetCurrentPaintPtr());
     }
 
+    context->save_layer_depth++;
     PaintChildren(context);
+    context->save_layer_depth--;
 
     canvas->restore();
 }
 
+bool ImageFilterLayer::TryDrawCachedFilterResult(PaintContext *context)
+{
+    if (!context->filter_cache || context->is_generating_cache)
+        return false;
+
+    SkMatrix matrix = context->frame_canvas->getTotalMatrix();
+    SkMatrix inverse;
+    if (matrix.hasPerspective() || !matrix.invert(&inverse))
+        return false;
+
+    // Parts of the filter result out of the surface are never visible
+    SkIRect device_bounds = matrix.mapRect(GetPaintBounds()).roundOut();
+    if (!device_bounds.intersect(SkIRect::MakeSize(context->frame_surface->imageInfo().dimensions())))
+        return false;
+
+    // The generation of this layer increases when either the filter or
+    // the subtree changes.
+    FilterResultCache::Key key{
+        .filter = filter_.get(),
+        .content_signature = GetGenerationId(),
+        .device_bounds = device_bounds,
+        .matrix = matrix
+    };
+
+    sk_sp<SkImage> result = context->filter_cache->FindOrGenerate(
+            this, filter_, key, [this, context, &key] {
+        return GenerateFilterResult(context, key);
+    });
+    if (!result)
+        return false;
+
+    FilterResultCache::DrawResult(context, result, key, context->GetCurrentPaintPtr());
+    return true;
+}
+
+sk_sp<SkImage> ImageFilterLayer::GenerateFilterResult(PaintContext *context,
+                                                      const FilterResultCache::Key& key)
+{
+    sk_sp<SkSurface> surface = context->filter_cache->CreateSurface(
+            key.device_bounds.size(), context->frame_surface);
+    if (!surface)
+        return nullptr;
+
+    SkCanvas *canvas = surface->getCanvas();
+    canvas->clear(SK_ColorTRANSPARENT);
+    canvas->translate(-SkIntToScalar(key.device_bounds.left()),
+                      -SkIntToScalar(key.device_bounds.top()));
+    canvas->concat(key.matrix);
+
+    SkPaint paint;
+    paint.setImageFilter(filter_);
+    canvas->saveLayer(GetPaintBounds(), &paint);
+
+    PaintContext generating_context =
+            FilterResultCache::MakeGeneratingPaintContext(context, surface.get());
+    PaintChildren(&generating_context);
+    canvas->restore();
+
+    FilterResultCache::FinishGeneratingPaintContext(context, &generating_context, surface.get());
+    return surface->makeImageSnapshot();
+}
+
 void ImageFilterLayer::ToString(std::ostream& out)
 {
     out << fmt::format("(imagefilter#{}:{} '(typename \"{}\")",
@@ -93,4 +158,11 @@ void ImageFilterLayer::ToString(std::ostream& out)
     out << ')';
 }
 
+void ImageFilterLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kImageFilter_LayerTag, this);
+    writer->WriteImageFilter(filter_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
@@ -19,6 +19,7 @@
 #define COCOA_GLAMOR_LAYERS_IMAGEFILTERLAYER_H
 
 #include "Glamor/Layers/ContainerLayer.h"
+#include "Glamor/Layers/FilterResultCache.h"
 GLAMOR_NAMESPACE_BEGIN
 
 class ImageFilterLayer : public ContainerLayer
@@ -33,12 +34,17 @@ public:
     void Preroll(PrerollContext *context, const SkMatrix &matrix) override;
     void Paint(PaintContext *context) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "ImageFilterLayer";
     }
 
 private:
+    bool TryDrawCachedFilterResult(PaintContext *context);
+    sk_sp<SkImage> GenerateFilterResult(PaintContext *context,
+                                        const FilterResultCache::Key& key);
+
     sk_sp<SkImageFilter> filter_;
 };
 
@@ -33,6 +33,7 @@ Layer::Layer(Type type)
     , paint_bounds_(SkRect::MakeEmpty())
     , unique_id_(get_next_unique_id())
     , generation_id_(0)
+    , prefers_native_resolution_(false)
 {
 }
 
@@ -48,6 +49,31 @@ bool Layer::IsComparableWith(Layer *other) const
 
 void Layer::Preroll(PrerollContext *context, const SkMatrix& matrix) {}
 
+void Layer::NativeResolutionDeferral::Defer(Layer *layer, PaintContext *context)
+{
+    CHECK(layer && scale > 0);
+
+    // `frame_canvas` is the offscreen canvas, whose base matrix is the
+    // downscaling matrix. Map its states back to native resolution.
+    SkCanvas *canvas = context->frame_canvas;
+    SkM44 matrix = SkM44::Scale(1 / scale, 1 / scale) * canvas->getLocalToDevice();
+
+    SkRect clip = SkRect::Make(canvas->getDeviceClipBounds());
+    clip = SkRect::MakeLTRB(clip.left() / scale, clip.top() / scale,
+                            clip.right() / scale, clip.bottom() / scale);
+
+    std::optional<SkPaint> paint;
+    if (context->HasCurrentPaint())
+        paint = context->GetCurrentPaint();
+
+    entries.push_back(Entry{
+        .layer = layer,
+        .matrix = matrix,
+        .device_clip = clip.roundOut(),
+        .paint = std::move(paint)
+    });
+}
+
 void Layer::ToString(std::ostream& out)
 {
     out << "(unknown-layer)";
@@ -19,16 +19,21 @@
 #define COCOA_GLAMOR_LAYERS_LAYER_H
 
 #include <stack>
+#include <deque>
+#include <vector>
 #include <utility>
 #include <sstream>
+#include <optional>
 
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/GrBackendSemaphore.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkMatrix.h"
+#include "include/core/SkM44.h"
 
 #include "Core/Errors.h"
+#include "Core/BumpArena.h"
 #include "Glamor/Glamor.h"
 GLAMOR_NAMESPACE_BEGIN
 
@@ -37,8 +42,10 @@ GLAMOR_NAMESPACE_BEGIN
 static constexpr SkRect kGiantRect = SkRect::MakeLTRB(-1E9F, -1E9F, 1E9F, 1E9F);
 
 class LayerGenerationCache;
+class FilterResultCache;
 class HWComposeSwapchain;
 class ContentAggregator;
+class SceneStreamWriter;
 
 class Layer
 {
@@ -54,21 +61,71 @@ public:
         kGpuSurfaceView
     };
 
+    // A layer whose preroll has finished. See `PrerollContext::prerolled_layers`.
+    struct PrerolledLayer
+    {
+        SkRect device_bounds;
+        uint32_t unique_id;
+        uint64_t generation;
+
+        // Contents of the layer may change without increasing its generation
+        // (external textures, GPU surface views).
+        bool is_volatile;
+    };
+
     // NOLINTNEXTLINE
     struct PrerollContext
     {
         GrDirectContext *gr_context;
 
+        // Scratch memory which is released after the frame; may be null.
+        BumpArena *frame_arena;
+
         SkMatrix root_surface_transformation;
 
         // Calculated when we are prerolling the layer tree and will be available
         // after finishing prerolling.
         SkRect cull_rect;
+
+        // Layers are appended in paint order when their preroll has finished,
+        // so that a layer can know which contents will have been painted
+        // below it (e.g. the backdrop of `BackdropFilterLayer`). May be null.
+        std::vector<PrerolledLayer> *prerolled_layers;
+    };
+
+    struct PaintContext;
+
+    // When dynamic resolution scaling is active, the layer tree is painted
+    // into an offscreen surface at a reduced scale. Layers which prefer native
+    // resolution are not painted there; they are collected with the canvas
+    // states (matrix, clip and current paint) instead, and `ContentAggregator`
+    // paints them on top of the upscaled frame at native resolution.
+    // Effects of the ancestor save-layers (opacity, image filters) are not
+    // inherited by the deferred layers.
+    struct NativeResolutionDeferral
+    {
+        struct Entry
+        {
+            Layer *layer;
+            SkM44 matrix;
+            SkIRect device_clip;
+            std::optional<SkPaint> paint;
+        };
+
+        NativeResolutionDeferral(SkScalar s, BumpArena *arena)
+            : scale(s), entries(BumpArenaAllocator<Entry>(arena)) {}
+
+        void Defer(Layer *layer, PaintContext *context);
+
+        SkScalar scale;
+        std::vector<Entry, BumpArenaAllocator<Entry>> entries;
     };
 
     // NOLINTNEXTLINE
     struct PaintContext
     {
+        using PaintsStack = std::stack<SkPaint, std::deque<SkPaint, BumpArenaAllocator<SkPaint>>>;
+
         enum ResourceUsageFlags
         {
             kNone_ResourceUsage = 0,
@@ -95,12 +152,21 @@ public:
         // An exact copy of `PrerollContext::cull_rect`
         SkRect cull_rect;
 
-        std::stack<SkPaint> paints_stack;
+        // Allocated from `frame_arena` if it is available
+        PaintsStack paints_stack;
 
         uint32_t resource_usage_flags;
 
+        // May be null when the layer tree is flattened into a picture
         LayerGenerationCache *cache;
 
+        // May be null; results of image filters are not cached in that case
+        FilterResultCache *filter_cache;
+
+        // The number of `saveLayer` calls made by the ancestor layers.
+        // If it is zero, the contents painted so far are in `frame_surface`.
+        uint32_t save_layer_depth;
+
         ContentAggregator *content_aggregator;
 
         // Layers can set this to let Skia signal the specified semaphores
@@ -110,6 +176,12 @@ public:
         // When raster backend is used, this is ignored.
         std::vector<GrBackendSemaphore> gpu_finished_semaphores;
 
+        // Not null only when the layer tree is painted at a reduced resolution.
+        NativeResolutionDeferral *native_resolution_deferral;
+
+        // Scratch memory which is released after the frame; may be null.
+        BumpArena *frame_arena;
+
         g_nodiscard bool HasCurrentPaint() const {
             return !paints_stack.empty();
         }
@@ -139,7 +211,7 @@ public:
         {
             CHECK(mutating_callback);
 
-            std::stack<SkPaint>& stack = paint_context_->paints_stack;
+            PaintContext::PaintsStack& stack = paint_context_->paints_stack;
             SkPaint *paint;
             if (stack.empty())
                 paint = &stack.emplace();
@@ -184,6 +256,17 @@ public:
         return unique_id_;
     }
 
+    // Whether the layer (and its subtree) should always be painted at
+    // native resolution, even if dynamic resolution scaling is active.
+    // Text and UI elements usually prefer this.
+    g_nodiscard bool GetPrefersNativeResolution() const {
+        return prefers_native_resolution_;
+    }
+
+    void SetPrefersNativeResolution(bool value) {
+        prefers_native_resolution_ = value;
+    }
+
     // Determine if the `Paint` method is necessary for this layer according to
     // the `paint_bound_` and properties in `PaintContext`.
     g_nodiscard bool NeedsPainting(PaintContext *context) const {
@@ -211,6 +294,10 @@ public:
 
     virtual void ToString(std::ostream& out);
 
+    // Write the layer (and its subtree) into the payload of a frame
+    // in the scene stream. See `SceneStream` for more details.
+    virtual void Serialize(SceneStreamWriter *writer) = 0;
+
     virtual const char *GetLayerTypeName() = 0;
 
 protected:
@@ -221,6 +308,7 @@ private:
     SkRect              paint_bounds_;
     uint32_t            unique_id_;
     uint64_t            generation_id_;
+    bool                prefers_native_resolution_;
 };
 
 GLAMOR_NAMESPACE_END
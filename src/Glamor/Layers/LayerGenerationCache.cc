@@ -22,11 +22,45 @@
 
 #include "Glamor/Layers/LayerGenerationCache.h"
 #include "Glamor/Layers/ContainerLayer.h"
+#include "Glamor/MemoryPressureManager.h"
 GLAMOR_NAMESPACE_BEGIN
 
+namespace {
+
+size_t compute_image_snapshot_bytes(const sk_sp<SkImage>& image)
+{
+    if (image->isTextureBacked())
+        return image->textureSize();
+
+    SkPixmap pixmap;
+    CHECK(image->peekPixels(&pixmap));
+    return pixmap.computeByteSize();
+}
+
+void release_image_snapshot(sk_sp<SkImage>& image, std::atomic<size_t>& snapshot_bytes)
+{
+    if (!image)
+        return;
+    size_t bytes = compute_image_snapshot_bytes(image);
+    snapshot_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    GraphicsResourcesTrackable::AccountResource(
+            TrackableCategory::kLayerCache, -static_cast<int64_t>(bytes), -1);
+    image.reset();
+}
+
+} // namespace anonymous
+
 LayerGenerationCache::LayerGenerationCache(std::shared_ptr<SkiaGpuContextOwner> gpu_context)
     : gpu_context_owner_(std::move(gpu_context))
+    , snapshot_bytes_(0)
+{
+    MemoryPressureManager::Register(this, MemoryPressureManager::PurgePriority::kLayerSnapshots);
+}
+
+LayerGenerationCache::~LayerGenerationCache()
 {
+    MemoryPressureManager::Unregister(this);
+    PurgeCacheResources(true);
 }
 
 void LayerGenerationCache::BeginFrame()
@@ -51,7 +85,7 @@ void LayerGenerationCache::EndFrame()
         if (itr->second.evicted)
         {
             // Destruct the cached resources
-            itr->second.image_snapshot.reset();
+            release_image_snapshot(itr->second.image_snapshot, snapshot_bytes_);
             itr = cache_recording_map_.erase(itr);
         }
         else
@@ -99,7 +133,7 @@ LayerGenerationCache::UpdateCacheRecording(Layer *layer, Layer::PaintContext *pa
     {
         // When the generation of a layer changes, the cached image-snapshot
         // is invalidated, then it should be destructed as soon as possible.
-        record_entry.image_snapshot.reset();
+        release_image_snapshot(record_entry.image_snapshot, snapshot_bytes_);
 
         record_entry.generation_stable_count = 0;
         record_entry.layer_generation = layer_generation;
@@ -119,6 +153,10 @@ LayerGenerationCache::UpdateCacheRecording(Layer *layer, Layer::PaintContext *pa
     if (!record_entry.image_snapshot)
         return CacheState::kRenderError;
 
+    size_t snapshot_bytes = compute_image_snapshot_bytes(record_entry.image_snapshot);
+    snapshot_bytes_.fetch_add(snapshot_bytes, std::memory_order_relaxed);
+    AccountResource(TrackableCategory::kLayerCache, static_cast<int64_t>(snapshot_bytes), 1);
+
     return CacheState::kJustCached;
 }
 
@@ -132,8 +170,8 @@ uint32_t LayerGenerationCache::GetLayerGenerationStableCountThreshold(Layer *lay
     {
         ContainerLayer *container = static_cast<ContainerLayer*>(layer);
         ContainerLayer::ContainerType container_type = container->GetContainerType();
-        if (container_type == ContainerLayer::ContainerType::kImageFilter)
-            return kMaxImageFilterGenerationStableCount;
+
+        // Results of image filters are cached by `FilterResultCache` in device space
         if (container_type == ContainerLayer::ContainerType::kOpacity)
             return kMaxOpacityGenerationStableCount;
         else
@@ -179,7 +217,8 @@ sk_sp<SkImage> LayerGenerationCache::TakeLayerImageSnapshot(Layer *layer, Layer:
         .cull_rect = paint_context->cull_rect,
         .resource_usage_flags = Layer::PaintContext::kNone_ResourceUsage,
         .cache = this,
-        .gpu_finished_semaphores = {}
+        .gpu_finished_semaphores = {},
+        .frame_arena = paint_context->frame_arena
     };
 
     layer->Paint(&sub_paint_context);
@@ -269,7 +308,7 @@ void LayerGenerationCache::PrintCacheStat(const std::function<void(std::string)>
 void LayerGenerationCache::PurgeCacheResources(bool reset_recordings)
 {
     for (auto& [layer_id, record] : cache_recording_map_)
-        record.image_snapshot.reset();
+        release_image_snapshot(record.image_snapshot, snapshot_bytes_);
     if (reset_recordings)
         cache_recording_map_.clear();
 }
@@ -281,25 +320,27 @@ void LayerGenerationCache::Trace(Tracer *tracer) noexcept
         if (!record.image_snapshot)
             continue;
 
-        size_t texture_size;
-        if (record.image_snapshot->isTextureBacked())
-            texture_size = record.image_snapshot->textureSize();
-        else
-        {
-            SkPixmap pixmap;
-            CHECK(record.image_snapshot->peekPixels(&pixmap));
-            texture_size = pixmap.computeByteSize();
-        }
-
         tracer->TraceResource(
             fmt::format("Cache[Layer#{}:{}]", record.layer_id, record.layer_generation),
             TRACKABLE_TYPE_TEXTURE,
             record.image_snapshot ? TRACKABLE_DEVICE_GPU : TRACKABLE_DEVICE_CPU,
             TRACKABLE_OWNERSHIP_SHARED,
             TraceIdFromPointer(record.image_snapshot.get()),
-            texture_size
+            compute_image_snapshot_bytes(record.image_snapshot)
         );
     }
 }
 
+size_t LayerGenerationCache::GetPurgeableBytes() noexcept
+{
+    return snapshot_bytes_.load(std::memory_order_relaxed);
+}
+
+void LayerGenerationCache::PurgeResources(MemoryPressureLevel level) noexcept
+{
+    // Under moderate pressure, the recordings are kept so that the snapshots
+    // of the layers which are still stable can be taken again immediately.
+    PurgeCacheResources(level == MemoryPressureLevel::kCritical);
+}
+
 GLAMOR_NAMESPACE_END
@@ -19,6 +19,7 @@
 #define COCOA_GLAMOR_LAYER_LAYERGENERATIONCACHE_H
 
 #include <unordered_map>
+#include <atomic>
 
 #include "include/core/SkImage.h"
 #include "include/core/SkPicture.h"
@@ -33,13 +34,12 @@ class LayerGenerationCache : public GraphicsResourcesTrackable
 {
 public:
     constexpr static uint32_t kMaxPictureGenerationStableCount = 32;
-    constexpr static uint32_t kMaxImageFilterGenerationStableCount = 16;
     constexpr static uint32_t kMaxOpacityGenerationStableCount = 24;
 
     static uint32_t GetLayerGenerationStableCountThreshold(Layer *layer);
 
     explicit LayerGenerationCache(std::shared_ptr<SkiaGpuContextOwner> gpu_context);
-    ~LayerGenerationCache() override = default;
+    ~LayerGenerationCache() override;
 
     void BeginFrame();
     void EndFrame();
@@ -65,6 +65,8 @@ public:
     void PrintCacheStat(const std::function<void(std::string)>& line_printer);
 
     void Trace(Tracer *tracer) noexcept override;
+    size_t GetPurgeableBytes() noexcept override;
+    void PurgeResources(MemoryPressureLevel level) noexcept override;
 
 private:
     CacheState UpdateCacheRecording(Layer *layer, Layer::PaintContext *paint_context);
@@ -87,6 +89,9 @@ private:
 
     std::shared_ptr<SkiaGpuContextOwner>    gpu_context_owner_;
     CacheRecordingMap                       cache_recording_map_;
+    // Only modified by the painting thread, but it can be read by any thread
+    // (see `GetPurgeableBytes`)
+    std::atomic<size_t>                     snapshot_bytes_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -17,6 +17,7 @@
 
 #include "include/core/SkPicture.h"
 #include "include/core/SkPictureRecorder.h"
+#include "include/core/SkBBHFactory.h"
 #include "include/utils/SkNWayCanvas.h"
 
 #include "Core/TraceEvent.h"
@@ -75,54 +76,67 @@ std::string LayerTree::ToString()
 
 MaybeGpuObject<SkPicture> LayerTree::Flatten(const SkRect& bounds)
 {
-    // TODO(sora): implement this.
+    TRACE_EVENT("rendering", "LayerTree::Flatten");
 
-#if 0
     if (root_layer_ == nullptr)
         return nullptr;
 
-    SkMatrix root_surface_transformation;
     // Identity matrix
+    SkMatrix root_surface_transformation;
     root_surface_transformation.reset();
 
-    SkPictureRecorder recorder;
-    SkCanvas *canvas = recorder.beginRecording(bounds);
+    Layer::PrerollContext preroll_context {
+        .gr_context = nullptr,
+        .frame_arena = nullptr,
+        .root_surface_transformation = root_surface_transformation,
+        .cull_rect = SkRect::MakeEmpty(),
+        .prerolled_layers = nullptr
+    };
+    if (!Preroll(&preroll_context))
+        return nullptr;
+
+    SkRect cull_rect = preroll_context.cull_rect;
+    if (!cull_rect.intersect(bounds))
+        cull_rect.setEmpty();
 
+    // The picture is usually played back for several times (e.g. once for
+    // each tile by `Scene.toImage`), so a bounding box hierarchy is built
+    // to skip the operations outside the clip.
+    SkRTreeFactory rtree_factory;
+    SkPictureRecorder recorder;
+    SkCanvas *canvas = recorder.beginRecording(bounds, &rtree_factory);
     if (!canvas)
         return nullptr;
 
     SkISize canvas_size = canvas->getBaseLayerSize();
-    SkNWayCanvas composed_canvas(canvas_size.width(), canvas_size.height());
-    composed_canvas.addCanvas(canvas);
-
-    Layer::PrerollContext prerollContext {
-        .gr_context = nullptr,
-        .root_surface_transformation = root_surface_transformation,
-        .cull_rect = bounds
-    };
+    SkNWayCanvas multiplexer_canvas(canvas_size.width(), canvas_size.height());
+    multiplexer_canvas.addCanvas(canvas);
 
-    Layer::PaintContext paintContext {
+    // There is no frame surface to read back from, and the caches are
+    // owned by `ContentAggregator`. Layers which can only be painted with
+    // a GPU context (like `GpuSurfaceViewLayer`) are skipped.
+    Layer::PaintContext paint_context {
         .gr_context = nullptr,
+        .is_generating_cache = true,
         .root_surface_transformation = root_surface_transformation,
+        .frame_surface = nullptr,
         .frame_canvas = canvas,
-        .composed_canvas = &composed_canvas,
-        .cull_rect = bounds,
-        .texture_manager = ,
-        .paint = nullptr,
-        .has_gpu_retained_resource = false
+        .multiplexer_canvas = &multiplexer_canvas,
+        .cull_rect = cull_rect,
+        .cache = nullptr,
+        .filter_cache = nullptr,
+        .save_layer_depth = 0,
+        .content_aggregator = nullptr,
+        .native_resolution_deferral = nullptr,
+        .frame_arena = nullptr
     };
 
-    root_layer_->Preroll(&prerollContext, root_surface_transformation);
-    if (root_layer_->NeedsPainting(&paintContext))
-    {
-        root_layer_->Paint(&paintContext);
-    }
-
-    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
-    return {paintContext.has_gpu_retained_resource, picture};
-#endif
+    if (!cull_rect.isEmpty())
+        Paint(&paint_context);
 
-    return nullptr;
+    bool has_gpu_resources =
+            paint_context.resource_usage_flags & Layer::PaintContext::kGpu_ResourceUsage;
+    return {has_gpu_resources, recorder.finishRecordingAsPicture()};
 }
 
 GLAMOR_NAMESPACE_END
@@ -18,6 +18,7 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/OpacityLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 #include "Glamor/Layers/LayerGenerationCache.h"
 GLAMOR_NAMESPACE_BEGIN
 
@@ -54,7 +55,7 @@ void OpacityLayer::Paint(PaintContext *context)
     SkCanvas *canvas = context->multiplexer_canvas;
     CHECK(canvas);
 
-    if (context->cache->TryDrawCacheImageSnapshot(this, context))
+    if (context->cache && context->cache->TryDrawCacheImageSnapshot(this, context))
         return;
 
     SkRect child_bounds = GetPaintBounds();
@@ -62,7 +63,9 @@ void OpacityLayer::Paint(PaintContext *context)
     SkAutoCanvasRestore scoped_restore(canvas, false);
     canvas->saveLayerAlpha(&child_bounds, alpha_);
 
+    context->save_layer_depth++;
     PaintChildren(context);
+    context->save_layer_depth--;
 }
 
 void OpacityLayer::ToString(std::ostream& out)
@@ -76,4 +79,11 @@ void OpacityLayer::ToString(std::ostream& out)
     out << ')';
 }
 
+void OpacityLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kOpacity_LayerTag, this);
+    writer->WriteU8(alpha_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
@@ -34,6 +34,7 @@ public:
 
     void Paint(PaintContext *context) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "OpacityLayer";
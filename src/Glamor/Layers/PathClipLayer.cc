@@ -19,6 +19,7 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/PathClipLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 PathClipLayer::PathClipLayer(const SkPath &path, SkClipOp op, bool AA)
@@ -73,4 +74,13 @@ void PathClipLayer::ToString(std::ostream &out)
     out << ')';
 }
 
+void PathClipLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kPathClip_LayerTag, this);
+    writer->WritePath(GetClipShape());
+    writer->WriteU8(static_cast<uint8_t>(clip_op_));
+    writer->WriteBool(perform_anti_alias_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
@@ -37,6 +37,7 @@ public:
     void OnApplyClipShape(const SkPath &shape, PaintContext *ctx) const override;
 
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "PathClipLayer";
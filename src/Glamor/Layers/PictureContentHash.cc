@@ -0,0 +1,152 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "include/core/SkStream.h"
+#include "include/core/SkSerialProcs.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkTypeface.h"
+#include "include/core/SkData.h"
+
+#include "Core/TraceEvent.h"
+#include "Glamor/Layers/PictureContentHash.h"
+GLAMOR_NAMESPACE_BEGIN
+
+namespace {
+
+/**
+ * A write-only stream which hashes the data written into it without
+ * buffering it. It runs a single lane of the XXH64 round function over
+ * each 8-byte word.
+ */
+class HashingWStream : public SkWStream
+{
+public:
+    constexpr static uint64_t kPrime1 = 11400714785074694791ULL;
+    constexpr static uint64_t kPrime2 = 14029467366897019727ULL;
+    constexpr static uint64_t kPrime3 = 1609587929392839161ULL;
+    constexpr static uint64_t kPrime5 = 2870177450012600261ULL;
+
+    HashingWStream()
+        : hash_(kPrime5), tail_{}, tail_size_(0), bytes_written_(0) {}
+    ~HashingWStream() override = default;
+
+    bool write(const void *buffer, size_t size) override
+    {
+        auto *ptr = static_cast<const uint8_t*>(buffer);
+        bytes_written_ += size;
+
+        if (tail_size_ > 0)
+        {
+            size_t n = std::min(size, sizeof(tail_) - tail_size_);
+            std::memcpy(tail_ + tail_size_, ptr, n);
+            tail_size_ += n;
+            ptr += n;
+            size -= n;
+            if (tail_size_ < sizeof(tail_))
+                return true;
+            Round(tail_);
+            tail_size_ = 0;
+        }
+
+        while (size >= sizeof(uint64_t))
+        {
+            Round(ptr);
+            ptr += sizeof(uint64_t);
+            size -= sizeof(uint64_t);
+        }
+
+        std::memcpy(tail_, ptr, size);
+        tail_size_ = size;
+        return true;
+    }
+
+    void flush() override {}
+
+    g_nodiscard size_t bytesWritten() const override {
+        return bytes_written_;
+    }
+
+    uint64_t Finish()
+    {
+        uint64_t h = hash_ + bytes_written_;
+        for (size_t i = 0; i < tail_size_; i++)
+        {
+            h ^= tail_[i] * kPrime5;
+            h = Rotl(h, 11) * kPrime1;
+        }
+
+        // Avalanche
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static uint64_t Rotl(uint64_t v, int r) {
+        return (v << r) | (v >> (64 - r));
+    }
+
+    void Round(const uint8_t *word)
+    {
+        uint64_t v;
+        std::memcpy(&v, word, sizeof(v));
+        hash_ += v * kPrime2;
+        hash_ = Rotl(hash_, 31) * kPrime1;
+    }
+
+    uint64_t    hash_;
+    uint8_t     tail_[8];
+    size_t      tail_size_;
+    size_t      bytes_written_;
+};
+
+sk_sp<SkData> serialize_image_id(SkImage *image, g_maybe_unused void *ctx)
+{
+    uint32_t id = image->uniqueID();
+    return SkData::MakeWithCopy(&id, sizeof(id));
+}
+
+sk_sp<SkData> serialize_typeface_id(SkTypeface *typeface, g_maybe_unused void *ctx)
+{
+    SkTypefaceID id = typeface->uniqueID();
+    return SkData::MakeWithCopy(&id, sizeof(id));
+}
+
+} // namespace anonymous
+
+uint64_t ComputePictureContentHash(const sk_sp<SkPicture>& picture)
+{
+    TRACE_EVENT("rendering", "ComputePictureContentHash");
+    CHECK(picture);
+
+    SkSerialProcs procs;
+    procs.fImageProc = serialize_image_id;
+    procs.fTypefaceProc = serialize_typeface_id;
+
+    HashingWStream stream;
+    picture->serialize(&stream, &procs);
+    return stream.Finish();
+}
+
+GLAMOR_NAMESPACE_END
@@ -0,0 +1,39 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_LAYERS_PICTURECONTENTHASH_H
+#define COCOA_GLAMOR_LAYERS_PICTURECONTENTHASH_H
+
+#include "include/core/SkPicture.h"
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * Compute a 64-bit hash of the contents of `picture`, which is equal for
+ * pictures recorded with the same drawing operations, even if they are
+ * different `SkPicture` objects (with different unique IDs).
+ *
+ * The hash is computed over the serialized operation stream. Images and
+ * typefaces are represented by their unique IDs instead of their data,
+ * so it is cheap to compute and never reads back GPU textures.
+ */
+uint64_t ComputePictureContentHash(const sk_sp<SkPicture>& picture);
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_LAYERS_PICTURECONTENTHASH_H
@@ -21,12 +21,15 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/PictureLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 #include "Glamor/Layers/LayerGenerationCache.h"
 GLAMOR_NAMESPACE_BEGIN
 
-PictureLayer::PictureLayer(bool auto_fast_clip, const sk_sp<SkPicture>& picture)
+PictureLayer::PictureLayer(bool auto_fast_clip, const sk_sp<SkPicture>& picture,
+                           uint64_t content_hash)
     : Layer(Type::kPicture)
     , sk_picture_(picture)
+    , content_hash_(content_hash)
 {
 }
 
@@ -37,11 +40,16 @@ void PictureLayer::DiffUpdate(const std::shared_ptr<Layer>& other)
     CHECK(other->GetType() == Type::kPicture);
     auto layer = std::static_pointer_cast<PictureLayer>(other);
 
-    // TODO(sora): Do we need to deep-compare the picture?
-    if (layer->sk_picture_->uniqueID() != sk_picture_->uniqueID())
+    // Pictures are usually recorded again for each frame even if nothing
+    // has changed, so they are compared by contents rather than unique IDs.
+    if (layer->sk_picture_->uniqueID() != sk_picture_->uniqueID() &&
+        layer->content_hash_ != content_hash_)
+    {
         IncreaseGenerationId();
+    }
 
     sk_picture_ = layer->sk_picture_;
+    content_hash_ = layer->content_hash_;
 }
 
 void PictureLayer::Preroll(PrerollContext *context, const SkMatrix& matrix)
@@ -54,9 +62,12 @@ void PictureLayer::Paint(PaintContext *context)
     SkCanvas *canvas = context->multiplexer_canvas;
     CHECK(canvas);
 
-    if (context->cache->TryDrawCacheImageSnapshot(this, context))
+    if (context->cache && context->cache->TryDrawCacheImageSnapshot(this, context))
         return;
 
+    // If the picture has been recorded with a bounding box hierarchy,
+    // Skia queries it with the clip bounds of each canvas in the multiplexer,
+    // and only the operations intersecting with the clip are played back.
     SkAutoCanvasRestore canvas_restore(canvas, true);
     canvas->clipRect(sk_picture_->cullRect());
     canvas->drawPicture(sk_picture_, nullptr, context->GetCurrentPaintPtr());
@@ -65,10 +76,16 @@ void PictureLayer::Paint(PaintContext *context)
 void PictureLayer::ToString(std::ostream& out)
 {
     SkRect bounds = sk_picture_->cullRect();
-    out << fmt::format("(picture#{}:{} '(bounds {} {} {} {}) '(id {}))",
+    out << fmt::format("(picture#{}:{} '(bounds {} {} {} {}) '(id {}) '(hash #x{:016x}))",
                        GetUniqueId(), GetGenerationId(),
                        bounds.x(), bounds.y(), bounds.width(), bounds.height(),
-                       sk_picture_->uniqueID());
+                       sk_picture_->uniqueID(), content_hash_);
+}
+
+void PictureLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kPicture_LayerTag, this);
+    writer->WritePicture(sk_picture_);
 }
 
 GLAMOR_NAMESPACE_END
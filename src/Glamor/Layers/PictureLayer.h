@@ -27,7 +27,11 @@ GLAMOR_NAMESPACE_BEGIN
 class PictureLayer : public Layer
 {
 public:
-    PictureLayer(bool auto_fast_clip, const sk_sp<SkPicture>& picture);
+    // `content_hash` should be computed by `ComputePictureContentHash`.
+    // Pictures with the same content hash are considered to be identical
+    // when the layer is updated, so the generation of the layer is kept
+    // and its cached snapshot remains valid.
+    PictureLayer(bool auto_fast_clip, const sk_sp<SkPicture>& picture, uint64_t content_hash);
     ~PictureLayer() override;
 
     void DiffUpdate(const std::shared_ptr<Layer>& other) override;
@@ -35,6 +39,7 @@ public:
     void Preroll(PrerollContext *context, const SkMatrix &matrix) override;
     void Paint(PaintContext *context) override;
     void ToString(std::ostream& out) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "PictureLayer";
@@ -42,6 +47,7 @@ public:
 
 private:
     sk_sp<SkPicture> sk_picture_;
+    uint64_t         content_hash_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -18,6 +18,7 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/RRectClipLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 RRectClipLayer::RRectClipLayer(const SkRRect& rrect, bool AA)
@@ -78,4 +79,12 @@ void RRectClipLayer::ToString(std::ostream& os)
     os << ')';
 }
 
+void RRectClipLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kRRectClip_LayerTag, this);
+    writer->WriteRRect(GetClipShape());
+    writer->WriteBool(perform_anti_alias_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
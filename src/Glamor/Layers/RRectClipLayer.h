@@ -37,6 +37,7 @@ public:
     void OnApplyClipShape(const SkRRect& shape, PaintContext *ctx) const override;
 
     void ToString(std::ostream& os) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "RRectClipLayer";
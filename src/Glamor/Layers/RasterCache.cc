@@ -22,6 +22,7 @@
 #include "include/gpu/ganesh/SkSurfaceGanesh.h"
 #include "fmt/format.h"
 
+#include "Core/TraceEvent.h"
 #include "Glamor/Layers/RasterCacheKey.h"
 #include "Glamor/Layers/RasterCache.h"
 #include "Glamor/Layers/Layer.h"
@@ -52,6 +53,18 @@ uint64_t RasterCacheLayerId::ComputeHashValue() const
     return result;
 }
 
+size_t RasterCacheItem::ComputeByteSize() const
+{
+    if (type_ == Type::kImageSnapshot && image_snapshot_)
+        return image_snapshot_->imageInfo().computeMinByteSize();
+    return 0;
+}
+
+void RasterCache::TraceCachedBytes()
+{
+    TRACE_COUNTER("rendering", "RasterCache.CachedBytes", cached_bytes_);
+}
+
 void RasterCache::Trace(Tracer *tracer) noexcept
 {
     for (const auto& pair : cache_map_)
@@ -88,6 +101,8 @@ void RasterCache::PurgeAllCaches()
 {
     picture_use_tracing_.clear();
     cache_map_.clear();
+    cached_bytes_ = 0;
+    TraceCachedBytes();
 }
 
 void RasterCache::IncreaseFrameCount()
@@ -141,6 +156,11 @@ bool RasterCache::GeneratePictureCache(const sk_sp<SkPicture>& picture,
     RasterCacheKey cache_key(RasterCacheLayerId(picture->uniqueID()), matrix);
 
     auto insert = cache_map_.try_emplace(cache_key, image_snapshot);
+    if (insert.second)
+    {
+        cached_bytes_ += insert.first->second.ComputeByteSize();
+        TraceCachedBytes();
+    }
     return insert.second;
 }
 
@@ -176,11 +196,13 @@ void RasterCache::PurgeOverduePictureCaches()
         uint64_t pict_id = itr->first.GetLayerId().GetPictureUniqueId();
         if (picture_use_tracing_.count(pict_id) == 0)
         {
+            cached_bytes_ -= itr->second.ComputeByteSize();
             itr = cache_map_.erase(itr);
             if (itr == cache_map_.end())
                 break;
         }
     }
+    TraceCachedBytes();
 }
 
 bool RasterCache::MarkPictureUsedInCurrentFrame(const sk_sp<SkPicture>& picture)
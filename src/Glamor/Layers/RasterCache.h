@@ -43,6 +43,8 @@ public:
     explicit RasterCacheItem(const sk_sp<SkImage>& image)
         : type_(Type::kImageSnapshot), image_snapshot_(image) {}
 
+    g_nodiscard size_t ComputeByteSize() const;
+
     g_nodiscard g_inline Type GetType() const {
         return type_;
     }
@@ -65,7 +67,8 @@ public:
 
     explicit RasterCache(GrDirectContext *direct_context = nullptr)
         : direct_context_(direct_context)
-        , frame_counter_(0) {}
+        , frame_counter_(0)
+        , cached_bytes_(0) {}
 
     g_nodiscard g_inline bool HasDirectContext() const {
         return direct_context_;
@@ -114,10 +117,12 @@ private:
     sk_sp<SkSurface> CreateSurface(SkISize size, SkSurface *format_hint_surface);
     void PurgeOverduePictureTracingInfo();
     void PurgeOverduePictureCaches();
+    void TraceCachedBytes();
 
     GrDirectContext *direct_context_;
     RasterCacheKey::Map<RasterCacheItem> cache_map_;
     uint64_t frame_counter_;
+    size_t cached_bytes_;
 
     struct PictureTraceInfo
     {
@@ -18,6 +18,7 @@
 #include "fmt/format.h"
 
 #include "Glamor/Layers/RectClipLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 RectClipLayer::RectClipLayer(const SkRect &rect, bool AA)
@@ -69,4 +70,12 @@ void RectClipLayer::ToString(std::ostream& os)
     os << ')';
 }
 
+void RectClipLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kRectClip_LayerTag, this);
+    writer->WriteRect(GetClipShape());
+    writer->WriteBool(perform_anti_alias_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
@@ -35,6 +35,7 @@ public:
     void OnApplyClipShape(const SkRect& shape, PaintContext *ctx) const override;
 
     void ToString(std::ostream& os) override;
+    void Serialize(SceneStreamWriter *writer) override;
 
     const char *GetLayerTypeName() override {
         return "RectClipLayer";
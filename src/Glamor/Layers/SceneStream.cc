@@ -0,0 +1,633 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "include/core/SkSurface.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkData.h"
+
+#include "Core/Journal.h"
+#include "Core/TraceEvent.h"
+#include "Glamor/Layers/SceneStream.h"
+#include "Glamor/Layers/LayerTree.h"
+#include "Glamor/Layers/PictureLayer.h"
+#include "Glamor/Layers/PictureContentHash.h"
+#include "Glamor/Layers/ExternalTextureLayer.h"
+#include "Glamor/Layers/GpuSurfaceViewLayer.h"
+#include "Glamor/Layers/OpacityLayer.h"
+#include "Glamor/Layers/TransformLayer.h"
+#include "Glamor/Layers/RectClipLayer.h"
+#include "Glamor/Layers/RRectClipLayer.h"
+#include "Glamor/Layers/PathClipLayer.h"
+#include "Glamor/Layers/ImageFilterLayer.h"
+#include "Glamor/Layers/BackdropFilterLayer.h"
+GLAMOR_NAMESPACE_BEGIN
+
+#define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.Layers.SceneStream)
+
+namespace {
+
+// Protects the reader from corrupted streams
+constexpr int32_t kMaxLayerDepth = 512;
+
+template<typename T>
+bool read_value(SkStream *stream, T *out)
+{
+    return stream->read(out, sizeof(T)) == sizeof(T);
+}
+
+template<>
+bool read_value<bool>(SkStream *stream, bool *out)
+{
+    return stream->readBool(out);
+}
+
+sk_sp<SkData> read_data(SkStream *stream)
+{
+    uint32_t size;
+    if (!read_value(stream, &size))
+        return nullptr;
+    // The stream length may be unknown (e.g. reading from a pipe)
+    if (stream->hasLength() && size > stream->getLength() - stream->getPosition())
+        return nullptr;
+    sk_sp<SkData> data = SkData::MakeUninitialized(size);
+    if (stream->read(data->writable_data(), size) != size)
+        return nullptr;
+    return data;
+}
+
+/**
+ * External textures are provided by the user (video frames, etc.) and are
+ * not recorded. When replaying, they are replaced by an opaque gray texture
+ * of the same size, so that the cost of sampling is preserved.
+ */
+class PlaceholderTextureAccessor : public ExternalTextureAccessor
+{
+public:
+    explicit PlaceholderTextureAccessor(const SkISize& size) : size_(size) {}
+    ~PlaceholderTextureAccessor() override = default;
+
+    bool IsGpuBackedTexture(bool has_gpu_context) override {
+        return false;
+    }
+
+    void Prefetch() override {}
+
+    sk_sp<SkImage> Acquire(GrDirectContext *direct_context) override
+    {
+        if (size_.isEmpty())
+            return nullptr;
+        sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(size_));
+        if (!surface)
+            return nullptr;
+        surface->getCanvas()->clear(SK_ColorGRAY);
+        return surface->makeImageSnapshot();
+    }
+
+    void Release() override {}
+
+private:
+    SkISize size_;
+};
+
+} // namespace anonymous
+
+std::unique_ptr<SceneStreamWriter> SceneStreamWriter::Make(const std::string& path)
+{
+    auto stream = std::make_unique<SkFILEWStream>(path.c_str());
+    if (!stream->isValid())
+    {
+        QLOG(LOG_ERROR, "Failed to open {} to record the scene stream", path);
+        return nullptr;
+    }
+
+    if (!stream->write32(SceneStream::kMagic) || !stream->write32(SceneStream::kVersion))
+        return nullptr;
+
+    return std::make_unique<SceneStreamWriter>(std::move(stream));
+}
+
+SceneStreamWriter::SceneStreamWriter(std::unique_ptr<SkFILEWStream> stream)
+    : stream_(std::move(stream))
+    , frames_count_(0)
+    , failed_(false)
+    , image_filter_ids_cnt_(0)
+{
+    CHECK(stream_);
+}
+
+SceneStreamWriter::~SceneStreamWriter()
+{
+    if (!failed_)
+        stream_->write8(SceneStream::kEnd_RecordType);
+    stream_->flush();
+}
+
+bool SceneStreamWriter::WriteFrame(const std::shared_ptr<LayerTree>& layer_tree)
+{
+    TRACE_EVENT("rendering", "SceneStreamWriter::WriteFrame");
+
+    if (failed_)
+        return false;
+    if (!layer_tree->GetRootLayer())
+        return true;
+
+    Clock::time_point now = Clock::now();
+    if (!first_frame_time_)
+        first_frame_time_ = now;
+
+    // New resources are written to the file directly while serializing
+    // the layer tree, so they always precede the frame record.
+    frame_payload_.reset();
+    layer_tree->GetRootLayer()->Serialize(this);
+    if (failed_)
+        return false;
+
+    int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - *first_frame_time_).count();
+    const SkISize& frame_size = layer_tree->GetFrameSize();
+
+    bool ok = stream_->write8(SceneStream::kFrame_RecordType) &&
+              stream_->write(&timestamp, sizeof(timestamp)) &&
+              stream_->write32(frame_size.width()) &&
+              stream_->write32(frame_size.height()) &&
+              stream_->write32(frame_payload_.bytesWritten()) &&
+              frame_payload_.writeToAndReset(stream_.get());
+    if (!ok)
+    {
+        QLOG(LOG_ERROR, "Failed to write a frame to the scene stream, recording stopped");
+        failed_ = true;
+        return false;
+    }
+
+    frames_count_++;
+    return true;
+}
+
+bool SceneStreamWriter::WriteResourceRecord(SceneStream::RecordType type, uint32_t id,
+                                            const sk_sp<SkData>& data)
+{
+    if (!data)
+    {
+        QLOG(LOG_ERROR, "Failed to serialize a resource for the scene stream, recording stopped");
+        failed_ = true;
+        return false;
+    }
+
+    bool ok = stream_->write8(type) &&
+              stream_->write32(id) &&
+              stream_->write32(data->size()) &&
+              stream_->write(data->data(), data->size());
+    if (!ok)
+    {
+        QLOG(LOG_ERROR, "Failed to write a resource to the scene stream, recording stopped");
+        failed_ = true;
+    }
+    return ok;
+}
+
+void SceneStreamWriter::WriteLayerHeader(SceneStream::LayerTag tag, Layer *layer)
+{
+    WriteU8(tag);
+    WriteBool(layer->GetPrefersNativeResolution());
+}
+
+void SceneStreamWriter::WriteBool(bool value)
+{
+    frame_payload_.writeBool(value);
+}
+
+void SceneStreamWriter::WriteU8(uint8_t value)
+{
+    frame_payload_.write8(value);
+}
+
+void SceneStreamWriter::WriteU32(uint32_t value)
+{
+    frame_payload_.write32(value);
+}
+
+void SceneStreamWriter::WriteI32(int32_t value)
+{
+    frame_payload_.write(&value, sizeof(value));
+}
+
+void SceneStreamWriter::WriteI64(int64_t value)
+{
+    frame_payload_.write(&value, sizeof(value));
+}
+
+void SceneStreamWriter::WriteScalar(SkScalar value)
+{
+    frame_payload_.writeScalar(value);
+}
+
+void SceneStreamWriter::WritePoint(const SkPoint& point)
+{
+    frame_payload_.write(&point, sizeof(SkPoint));
+}
+
+void SceneStreamWriter::WriteRect(const SkRect& rect)
+{
+    frame_payload_.write(&rect, sizeof(SkRect));
+}
+
+void SceneStreamWriter::WriteRRect(const SkRRect& rrect)
+{
+    uint8_t buffer[SkRRect::kSizeInMemory];
+    rrect.writeToMemory(buffer);
+    frame_payload_.write(buffer, sizeof(buffer));
+}
+
+void SceneStreamWriter::WritePath(const SkPath& path)
+{
+    sk_sp<SkData> data = path.serialize();
+    frame_payload_.write32(data->size());
+    frame_payload_.write(data->data(), data->size());
+}
+
+void SceneStreamWriter::WriteMatrix(const SkMatrix& matrix)
+{
+    SkScalar values[9];
+    matrix.get9(values);
+    frame_payload_.write(values, sizeof(values));
+}
+
+void SceneStreamWriter::WriteSampling(const SkSamplingOptions& sampling)
+{
+    WriteBool(sampling.useCubic);
+    WriteScalar(sampling.cubic.B);
+    WriteScalar(sampling.cubic.C);
+    WriteU8(static_cast<uint8_t>(sampling.filter));
+    WriteU8(static_cast<uint8_t>(sampling.mipmap));
+}
+
+void SceneStreamWriter::WritePicture(const sk_sp<SkPicture>& picture)
+{
+    CHECK(picture);
+    uint32_t id = picture->uniqueID();
+    if (written_pictures_.count(id) == 0)
+    {
+        if (!WriteResourceRecord(SceneStream::kPicture_RecordType, id, picture->serialize()))
+            return;
+        written_pictures_.insert(id);
+    }
+    WriteU32(id);
+}
+
+void SceneStreamWriter::WriteImageFilter(const sk_sp<SkImageFilter>& filter)
+{
+    if (!filter)
+    {
+        WriteU32(0);
+        return;
+    }
+
+    auto itr = written_image_filters_.find(filter.get());
+    if (itr != written_image_filters_.end())
+    {
+        WriteU32(itr->second.first);
+        return;
+    }
+
+    uint32_t id = ++image_filter_ids_cnt_;
+    if (!WriteResourceRecord(SceneStream::kImageFilter_RecordType, id, filter->serialize()))
+        return;
+    written_image_filters_[filter.get()] = std::make_pair(id, filter);
+    WriteU32(id);
+}
+
+std::unique_ptr<SceneStreamReader> SceneStreamReader::Make(const std::string& path)
+{
+    auto stream = std::make_unique<SkFILEStream>(path.c_str());
+    if (!stream->isValid())
+    {
+        QLOG(LOG_ERROR, "Failed to open scene stream {}", path);
+        return nullptr;
+    }
+
+    uint32_t magic, version;
+    if (!read_value(stream.get(), &magic) || magic != SceneStream::kMagic)
+    {
+        QLOG(LOG_ERROR, "{} is not a scene stream", path);
+        return nullptr;
+    }
+    if (!read_value(stream.get(), &version) || version != SceneStream::kVersion)
+    {
+        QLOG(LOG_ERROR, "Unsupported scene stream version in {}", path);
+        return nullptr;
+    }
+
+    return std::make_unique<SceneStreamReader>(std::move(stream));
+}
+
+SceneStreamReader::SceneStreamReader(std::unique_ptr<SkFILEStream> stream)
+    : stream_(std::move(stream))
+    , error_(false)
+{
+    CHECK(stream_);
+}
+
+bool SceneStreamReader::ReadResourceRecord(SceneStream::RecordType type)
+{
+    uint32_t id;
+    if (!read_value(stream_.get(), &id))
+        return false;
+    sk_sp<SkData> data = read_data(stream_.get());
+    if (!data)
+        return false;
+
+    if (type == SceneStream::kPicture_RecordType)
+    {
+        sk_sp<SkPicture> picture = SkPicture::MakeFromData(data.get());
+        if (!picture)
+            return false;
+        pictures_[id] = std::move(picture);
+    }
+    else
+    {
+        sk_sp<SkImageFilter> filter = SkImageFilter::Deserialize(data->data(), data->size());
+        if (!filter)
+            return false;
+        image_filters_[id] = std::move(filter);
+    }
+    return true;
+}
+
+std::optional<SceneStreamReader::Frame> SceneStreamReader::ReadNextFrame()
+{
+    TRACE_EVENT("rendering", "SceneStreamReader::ReadNextFrame");
+
+    if (error_)
+        return {};
+
+    while (true)
+    {
+        uint8_t type;
+        if (!read_value(stream_.get(), &type))
+        {
+            // Recording was interrupted before the end record was written;
+            // all the complete frames are still available.
+            QLOG(LOG_WARNING, "Scene stream ends unexpectedly");
+            return {};
+        }
+
+        switch (type)
+        {
+        case SceneStream::kEnd_RecordType:
+            return {};
+
+        case SceneStream::kPicture_RecordType:
+        case SceneStream::kImageFilter_RecordType:
+            if (!ReadResourceRecord(static_cast<SceneStream::RecordType>(type)))
+            {
+                QLOG(LOG_ERROR, "Corrupted resource record in the scene stream");
+                error_ = true;
+                return {};
+            }
+            break;
+
+        case SceneStream::kFrame_RecordType:
+        {
+            Frame frame{};
+            int32_t width, height;
+            sk_sp<SkData> payload_data;
+            if (!read_value(stream_.get(), &frame.timestamp_us) ||
+                !read_value(stream_.get(), &width) ||
+                !read_value(stream_.get(), &height) ||
+                !(payload_data = read_data(stream_.get())))
+            {
+                error_ = true;
+                return {};
+            }
+
+            SkMemoryStream payload(std::move(payload_data));
+            std::shared_ptr<Layer> root = ReadLayer(&payload, 0);
+            if (!root || root->GetType() != Layer::Type::kContainer)
+            {
+                QLOG(LOG_ERROR, "Corrupted frame record in the scene stream");
+                error_ = true;
+                return {};
+            }
+
+            frame.layer_tree = std::make_shared<LayerTree>(SkISize::Make(width, height));
+            frame.layer_tree->SetRootLayer(std::static_pointer_cast<ContainerLayer>(root));
+            return frame;
+        }
+
+        default:
+            QLOG(LOG_ERROR, "Unknown record type {} in the scene stream", type);
+            error_ = true;
+            return {};
+        }
+    }
+}
+
+std::shared_ptr<Layer> SceneStreamReader::ReadLayer(SkStream *payload, int32_t depth)
+{
+    if (depth > kMaxLayerDepth)
+        return nullptr;
+
+    uint8_t tag;
+    bool prefers_native_resolution;
+    if (!read_value(payload, &tag) || !read_value(payload, &prefers_native_resolution))
+        return nullptr;
+
+    auto read_picture = [this, payload]() -> sk_sp<SkPicture> {
+        uint32_t id;
+        if (!read_value(payload, &id))
+            return nullptr;
+        auto itr = pictures_.find(id);
+        return itr != pictures_.end() ? itr->second : nullptr;
+    };
+
+    auto read_image_filter = [this, payload]() -> sk_sp<SkImageFilter> {
+        uint32_t id;
+        if (!read_value(payload, &id))
+            return nullptr;
+        auto itr = image_filters_.find(id);
+        return itr != image_filters_.end() ? itr->second : nullptr;
+    };
+
+    std::shared_ptr<Layer> layer;
+    std::shared_ptr<ContainerLayer> container;
+
+    switch (tag)
+    {
+    case SceneStream::kPicture_LayerTag:
+    {
+        sk_sp<SkPicture> picture = read_picture();
+        if (!picture)
+            return nullptr;
+        layer = std::make_shared<PictureLayer>(false, picture, ComputePictureContentHash(picture));
+        break;
+    }
+
+    case SceneStream::kExternalTexture_LayerTag:
+    {
+        SkPoint offset;
+        SkISize size;
+        bool use_cubic;
+        SkScalar B, C;
+        uint8_t filter, mipmap;
+        if (!read_value(payload, &offset) || !read_value(payload, &size) ||
+            !read_value(payload, &use_cubic) || !read_value(payload, &B) ||
+            !read_value(payload, &C) || !read_value(payload, &filter) ||
+            !read_value(payload, &mipmap))
+        {
+            return nullptr;
+        }
+        if (filter > static_cast<uint8_t>(SkFilterMode::kLast) ||
+            mipmap > static_cast<uint8_t>(SkMipmapMode::kLast))
+        {
+            return nullptr;
+        }
+        SkSamplingOptions sampling = use_cubic
+                ? SkSamplingOptions(SkCubicResampler{B, C})
+                : SkSamplingOptions(static_cast<SkFilterMode>(filter),
+                                    static_cast<SkMipmapMode>(mipmap));
+        layer = std::make_shared<ExternalTextureLayer>(
+                std::make_unique<PlaceholderTextureAccessor>(size), offset, size, sampling);
+        break;
+    }
+
+    case SceneStream::kGpuSurfaceView_LayerTag:
+    {
+        // Imported GPU resources are not available when replaying; the layer
+        // is only painted when the IDs are resolved by a GPU backend.
+        int64_t surface_id, wait_semaphore_id, signal_semaphore_id;
+        SkRect dst_rect;
+        if (!read_value(payload, &surface_id) || !read_value(payload, &dst_rect) ||
+            !read_value(payload, &wait_semaphore_id) || !read_value(payload, &signal_semaphore_id))
+        {
+            return nullptr;
+        }
+        layer = std::make_shared<GpuSurfaceViewLayer>(surface_id, dst_rect, wait_semaphore_id,
+                                                      signal_semaphore_id, nullptr);
+        break;
+    }
+
+    case SceneStream::kOpacity_LayerTag:
+    {
+        uint8_t alpha;
+        if (!read_value(payload, &alpha))
+            return nullptr;
+        container = std::make_shared<OpacityLayer>(alpha);
+        break;
+    }
+
+    case SceneStream::kTransform_LayerTag:
+    {
+        SkScalar values[9];
+        if (payload->read(values, sizeof(values)) != sizeof(values))
+            return nullptr;
+        SkMatrix matrix;
+        matrix.set9(values);
+        container = std::make_shared<TransformLayer>(matrix);
+        break;
+    }
+
+    case SceneStream::kRectClip_LayerTag:
+    {
+        SkRect rect;
+        bool AA;
+        if (!read_value(payload, &rect) || !read_value(payload, &AA))
+            return nullptr;
+        container = std::make_shared<RectClipLayer>(rect, AA);
+        break;
+    }
+
+    case SceneStream::kRRectClip_LayerTag:
+    {
+        uint8_t buffer[SkRRect::kSizeInMemory];
+        SkRRect rrect;
+        bool AA;
+        if (payload->read(buffer, sizeof(buffer)) != sizeof(buffer) ||
+            rrect.readFromMemory(buffer, sizeof(buffer)) != sizeof(buffer) ||
+            !read_value(payload, &AA))
+        {
+            return nullptr;
+        }
+        container = std::make_shared<RRectClipLayer>(rrect, AA);
+        break;
+    }
+
+    case SceneStream::kPathClip_LayerTag:
+    {
+        sk_sp<SkData> path_data = read_data(payload);
+        SkPath path;
+        uint8_t op;
+        bool AA;
+        if (!path_data || path.readFromMemory(path_data->data(), path_data->size()) == 0 ||
+            !read_value(payload, &op) || !read_value(payload, &AA) ||
+            op > static_cast<uint8_t>(SkClipOp::kMax_EnumValue))
+        {
+            return nullptr;
+        }
+        container = std::make_shared<PathClipLayer>(path, static_cast<SkClipOp>(op), AA);
+        break;
+    }
+
+    case SceneStream::kImageFilter_LayerTag:
+    {
+        sk_sp<SkImageFilter> filter = read_image_filter();
+        if (!filter)
+            return nullptr;
+        container = std::make_shared<ImageFilterLayer>(filter);
+        break;
+    }
+
+    case SceneStream::kBackdropFilter_LayerTag:
+    {
+        sk_sp<SkImageFilter> filter = read_image_filter();
+        uint8_t blend_mode;
+        bool auto_child_clip;
+        if (!filter || !read_value(payload, &blend_mode) ||
+            !read_value(payload, &auto_child_clip) ||
+            blend_mode > static_cast<uint8_t>(SkBlendMode::kLastMode))
+        {
+            return nullptr;
+        }
+        container = std::make_shared<BackdropFilterLayer>(
+                filter, static_cast<SkBlendMode>(blend_mode), auto_child_clip);
+        break;
+    }
+
+    default:
+        return nullptr;
+    }
+
+    if (container)
+    {
+        uint32_t children_count;
+        if (!read_value(payload, &children_count))
+            return nullptr;
+        for (uint32_t i = 0; i < children_count; i++)
+        {
+            std::shared_ptr<Layer> child = ReadLayer(payload, depth + 1);
+            if (!child)
+                return nullptr;
+            container->AppendChildLayer(child);
+        }
+        layer = container;
+    }
+
+    layer->SetPrefersNativeResolution(prefers_native_resolution);
+    return layer;
+}
+
+GLAMOR_NAMESPACE_END
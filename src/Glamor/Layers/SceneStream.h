@@ -0,0 +1,200 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_LAYERS_SCENESTREAM_H
+#define COCOA_GLAMOR_LAYERS_SCENESTREAM_H
+
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "include/core/SkStream.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkMatrix.h"
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+class Layer;
+class LayerTree;
+
+/**
+ * A scene stream records the sequence of layer trees submitted to
+ * a `ContentAggregator`, and can be replayed offline (see `scene-replay`)
+ * to reproduce the temporal behaviours of a workload, like layer reuse,
+ * raster cache warm-up and DiffUpdate churn.
+ *
+ * Layout (integers are stored in host byte order):
+ *   Header:  u32 magic, u32 version
+ *   Records: u8 record type, followed by the payload:
+ *     kPicture:     u32 id, u32 size, serialized SkPicture
+ *     kImageFilter: u32 id, u32 size, serialized SkImageFilter
+ *     kFrame:       i64 timestamp (us), i32 width, i32 height,
+ *                   u32 size, serialized layer tree
+ *     kEnd:         (no payload)
+ *
+ * Pictures and image filters are deduplicated: each of them is written
+ * only once, before the first frame which references it, and layers refer
+ * to it by ID. Replaying preserves the identities of those objects, so that
+ * the layer trees are diffed exactly as they were when recording.
+ */
+struct SceneStream
+{
+    constexpr static uint32_t kMagic = 0x53536f43;  // "CoSS"
+    constexpr static uint32_t kVersion = 1;
+
+    enum RecordType : uint8_t
+    {
+        kEnd_RecordType = 0,
+        kPicture_RecordType,
+        kImageFilter_RecordType,
+        kFrame_RecordType
+    };
+
+    enum LayerTag : uint8_t
+    {
+        kPicture_LayerTag = 1,
+        kExternalTexture_LayerTag,
+        kGpuSurfaceView_LayerTag,
+        kOpacity_LayerTag,
+        kTransform_LayerTag,
+        kRectClip_LayerTag,
+        kRRectClip_LayerTag,
+        kPathClip_LayerTag,
+        kImageFilter_LayerTag,
+        kBackdropFilter_LayerTag
+    };
+};
+
+class SceneStreamWriter
+{
+public:
+    CO_NONCOPYABLE(SceneStreamWriter)
+    CO_NONASSIGNABLE(SceneStreamWriter)
+
+    using Clock = std::chrono::steady_clock;
+
+    // Returns nullptr if the file could not be opened for writing
+    static std::unique_ptr<SceneStreamWriter> Make(const std::string& path);
+
+    explicit SceneStreamWriter(std::unique_ptr<SkFILEWStream> stream);
+    ~SceneStreamWriter();
+
+    /**
+     * Append a frame to the stream. Pictures and image filters referenced by
+     * the layer tree for the first time are written before the frame.
+     * Once it fails (e.g. disk is full), the writer stops working and all
+     * the following calls fail.
+     */
+    bool WriteFrame(const std::shared_ptr<LayerTree>& layer_tree);
+
+    g_nodiscard uint32_t GetFramesCount() const {
+        return frames_count_;
+    }
+
+    g_nodiscard size_t GetBytesWritten() const {
+        return stream_->bytesWritten();
+    }
+
+    // Primitives used by `Layer::Serialize` implementations.
+    // They write to the payload of the current frame.
+    void WriteLayerHeader(SceneStream::LayerTag tag, Layer *layer);
+    void WriteBool(bool value);
+    void WriteU8(uint8_t value);
+    void WriteU32(uint32_t value);
+    void WriteI32(int32_t value);
+    void WriteI64(int64_t value);
+    void WriteScalar(SkScalar value);
+    void WritePoint(const SkPoint& point);
+    void WriteRect(const SkRect& rect);
+    void WriteRRect(const SkRRect& rrect);
+    void WritePath(const SkPath& path);
+    void WriteMatrix(const SkMatrix& matrix);
+    void WriteSampling(const SkSamplingOptions& sampling);
+    void WritePicture(const sk_sp<SkPicture>& picture);
+    void WriteImageFilter(const sk_sp<SkImageFilter>& filter);
+
+private:
+    bool WriteResourceRecord(SceneStream::RecordType type, uint32_t id,
+                             const sk_sp<SkData>& data);
+
+    std::unique_ptr<SkFILEWStream>      stream_;
+    SkDynamicMemoryWStream              frame_payload_;
+    std::optional<Clock::time_point>    first_frame_time_;
+    uint32_t                            frames_count_;
+    bool                                failed_;
+    std::unordered_set<uint32_t>        written_pictures_;
+
+    // Image filters have no unique ID; they are identified by address
+    // and kept alive so that the address cannot be reused by another one.
+    std::unordered_map<SkImageFilter*, std::pair<uint32_t, sk_sp<SkImageFilter>>>
+                                        written_image_filters_;
+    uint32_t                            image_filter_ids_cnt_;
+};
+
+class SceneStreamReader
+{
+public:
+    CO_NONCOPYABLE(SceneStreamReader)
+    CO_NONASSIGNABLE(SceneStreamReader)
+
+    struct Frame
+    {
+        // Microseconds since the first frame was recorded
+        int64_t timestamp_us;
+        std::shared_ptr<LayerTree> layer_tree;
+    };
+
+    // Returns nullptr if the file could not be opened or is not a scene stream
+    static std::unique_ptr<SceneStreamReader> Make(const std::string& path);
+
+    explicit SceneStreamReader(std::unique_ptr<SkFILEStream> stream);
+    ~SceneStreamReader() = default;
+
+    /**
+     * Read records until the next frame is found, and build a new layer tree
+     * from it. Returns nullopt at the end of stream or if the stream is
+     * corrupted (`HasError()` tells which one).
+     */
+    std::optional<Frame> ReadNextFrame();
+
+    g_nodiscard bool HasError() const {
+        return error_;
+    }
+
+    g_nodiscard size_t GetPicturesCount() const {
+        return pictures_.size();
+    }
+
+private:
+    bool ReadResourceRecord(SceneStream::RecordType type);
+    std::shared_ptr<Layer> ReadLayer(SkStream *payload, int32_t depth);
+
+    std::unique_ptr<SkFILEStream>       stream_;
+    bool                                error_;
+    std::unordered_map<uint32_t, sk_sp<SkPicture>>      pictures_;
+    std::unordered_map<uint32_t, sk_sp<SkImageFilter>>  image_filters_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_LAYERS_SCENESTREAM_H
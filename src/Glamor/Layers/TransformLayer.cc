@@ -17,6 +17,7 @@
 
 #include "Core/Journal.h"
 #include "Glamor/Layers/TransformLayer.h"
+#include "Glamor/Layers/SceneStream.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.Layers.TransformLayer)
@@ -104,4 +105,11 @@ void TransformLayer::ToString(std::ostream& out)
 #undef M
 }
 
+void TransformLayer::Serialize(SceneStreamWriter *writer)
+{
+    writer->WriteLayerHeader(SceneStream::kTransform_LayerTag, this);
+    writer->WriteMatrix(transform_);
+    SerializeChildren(writer);
+}
+
 GLAMOR_NAMESPACE_END
@@ -0,0 +1,336 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+#include "include/core/SkGraphics.h"
+
+#include "Core/Journal.h"
+#include "Core/TraceEvent.h"
+#include "Glamor/MemoryPressureManager.h"
+#include "Glamor/PresentThread.h"
+#include "Glamor/Display.h"
+GLAMOR_NAMESPACE_BEGIN
+
+#define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.MemoryPressureManager)
+
+namespace {
+
+const char *level_name(MemoryPressureLevel level)
+{
+    return (level == MemoryPressureLevel::kCritical ? "critical" : "moderate");
+}
+
+// Find the directory of the cgroup (v2) which this process belongs to
+std::optional<std::string> get_cgroup_directory()
+{
+    std::ifstream fs("/proc/self/cgroup");
+    if (!fs.is_open())
+        return {};
+
+    // The unified hierarchy is always described by a line like "0::/path"
+    std::string line;
+    while (std::getline(fs, line))
+    {
+        if (line.compare(0, 3, "0::") == 0)
+            return "/sys/fs/cgroup" + line.substr(3);
+    }
+    return {};
+}
+
+} // namespace anonymous
+
+void MemoryPressureManager::Register(GraphicsResourcesTrackable *trackable,
+                                     PurgePriority priority)
+{
+    // Trackables may be created out of the present thread
+    // (like the scene replaying tool), where there is no manager.
+    if (!HasInstance())
+        return;
+
+    CHECK(trackable);
+    std::vector<Registrant>& registrants = GetCurrent()->registrants_;
+    auto itr = std::find_if(registrants.begin(), registrants.end(),
+                            [priority](const Registrant& r) { return r.priority > priority; });
+    registrants.insert(itr, Registrant{ trackable, priority });
+}
+
+void MemoryPressureManager::Unregister(GraphicsResourcesTrackable *trackable)
+{
+    if (!HasInstance())
+        return;
+
+    std::vector<Registrant>& registrants = GetCurrent()->registrants_;
+    registrants.erase(std::remove_if(registrants.begin(), registrants.end(),
+                                     [trackable](const Registrant& r) {
+        return r.trackable == trackable;
+    }), registrants.end());
+}
+
+MemoryPressureManager::MemoryPressureManager(uv_loop_t *loop, size_t budget_bytes)
+    : budget_bytes_(budget_bytes)
+    , check_timer_(loop)
+{
+    std::optional<std::string> cgroup_dir = get_cgroup_directory();
+    if (cgroup_dir)
+    {
+        // `memory.events` only exists when the memory controller is enabled
+        std::string events_path = *cgroup_dir + "/memory.events";
+        if (access(events_path.c_str(), R_OK) == 0)
+        {
+            cgroup_events_path_ = events_path;
+            cgroup_event_counters_ = ReadCgroupEventCounters();
+        }
+    }
+
+    OpenPsiTriggers(loop, cgroup_dir);
+
+    if (budget_bytes_ > 0 || cgroup_events_path_)
+    {
+        check_timer_.Start(kCheckInterval.count(), kCheckInterval.count(), [this] {
+            OnCheckTimer();
+        });
+    }
+
+    // The manager should not keep the event loop alive
+    check_timer_.Unref();
+}
+
+MemoryPressureManager::~MemoryPressureManager()
+{
+    for (PsiTrigger& trigger : psi_triggers_)
+    {
+        // The poll handle must be closed before the file descriptor
+        trigger.poll.reset();
+        close(trigger.fd);
+    }
+}
+
+void MemoryPressureManager::OpenPsiTriggers(uv_loop_t *loop,
+                                            const std::optional<std::string>& cgroup_dir)
+{
+    // Stalls in the cgroup are preferred, as the limits of a container
+    // are usually much lower than the memory of the whole system.
+    std::vector<std::string> candidates;
+    if (cgroup_dir)
+        candidates.emplace_back(*cgroup_dir + "/memory.pressure");
+    candidates.emplace_back("/proc/pressure/memory");
+
+    for (const std::string& path : candidates)
+    {
+        if (!OpenPsiTrigger(loop, path, kPsiModerateTrigger, MemoryPressureLevel::kModerate))
+            continue;
+        OpenPsiTrigger(loop, path, kPsiCriticalTrigger, MemoryPressureLevel::kCritical);
+        QLOG(LOG_INFO, "Monitoring memory pressure stalls by PSI triggers on {}", path);
+        return;
+    }
+
+    QLOG(LOG_INFO, "PSI is not available, memory pressure stalls will not be monitored");
+}
+
+bool MemoryPressureManager::OpenPsiTrigger(uv_loop_t *loop,
+                                           const std::string& path,
+                                           const char *trigger,
+                                           MemoryPressureLevel level)
+{
+    int32_t fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // The terminating null character is also written (see Documentation/accounting/psi.rst)
+    if (write(fd, trigger, std::strlen(trigger) + 1) < 0)
+    {
+        QLOG(LOG_DEBUG, "Failed to create PSI trigger on {}: {}", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    PsiTrigger& psi = psi_triggers_.emplace_back(PsiTrigger{
+        fd, level, std::make_unique<uv::PollHandle>(loop, fd)
+    });
+
+    uv::PollHandle *poll = psi.poll.get();
+    poll->Start(UV_PRIORITIZED, [this, poll, level](int status, int events) {
+        if (status < 0 || (events & UV_DISCONNECT))
+        {
+            // The monitored cgroup has been removed
+            poll->Stop();
+            return;
+        }
+        OnPressureReported(level, "PSI trigger");
+    });
+    poll->Unref();
+
+    return true;
+}
+
+std::optional<MemoryPressureManager::CgroupEventCounters>
+MemoryPressureManager::ReadCgroupEventCounters()
+{
+    std::ifstream fs(*cgroup_events_path_);
+    if (!fs.is_open())
+        return {};
+
+    CgroupEventCounters counters{};
+    std::string key;
+    uint64_t value;
+    while (fs >> key >> value)
+    {
+        if (key == "high")
+            counters.high = value;
+        else if (key == "max")
+            counters.max = value;
+        else if (key == "oom")
+            counters.oom = value;
+    }
+    return counters;
+}
+
+size_t MemoryPressureManager::GetPurgeableBytes() const
+{
+    size_t total = 0;
+    for (const Registrant& registrant : registrants_)
+        total += registrant.trackable->GetPurgeableBytes();
+    return total;
+}
+
+void MemoryPressureManager::OnCheckTimer()
+{
+    if (cgroup_events_path_)
+    {
+        std::optional<CgroupEventCounters> counters = ReadCgroupEventCounters();
+        if (counters && cgroup_event_counters_)
+        {
+            // Counters are increased each time the usage of the cgroup reaches
+            // the limit. Reaching `memory.high` makes the cgroup throttled and
+            // reclaimed heavily, and reaching `memory.max` invokes the OOM killer
+            // if the kernel fails to reclaim enough memory.
+            if (counters->max > cgroup_event_counters_->max ||
+                counters->oom > cgroup_event_counters_->oom)
+            {
+                OnPressureReported(MemoryPressureLevel::kCritical, "cgroup memory.max");
+            }
+            else if (counters->high > cgroup_event_counters_->high)
+            {
+                OnPressureReported(MemoryPressureLevel::kModerate, "cgroup memory.high");
+            }
+        }
+        cgroup_event_counters_ = counters;
+    }
+
+    if (budget_bytes_ == 0)
+        return;
+
+    size_t purgeable = GetPurgeableBytes();
+    TRACE_COUNTER("rendering", "MemoryPressureManager.PurgeableBytes", purgeable);
+    if (purgeable <= budget_bytes_)
+        return;
+
+    TRACE_EVENT("rendering", "MemoryPressureManager::EnforceBudget");
+
+    auto target = static_cast<size_t>(static_cast<double>(budget_bytes_) * kBudgetLowWatermark);
+    MemoryPressureLevel level = MemoryPressureLevel::kModerate;
+    size_t released = PurgeRegistrants(level, target);
+    if (GetPurgeableBytes() > target)
+    {
+        level = MemoryPressureLevel::kCritical;
+        released += PurgeRegistrants(level, target);
+    }
+
+    QLOG(LOG_INFO, "Purgeable resources ({} bytes) exceeded the budget, released {} bytes",
+         purgeable, released);
+    NotifyDisplays(level, released);
+}
+
+void MemoryPressureManager::OnPressureReported(MemoryPressureLevel level, const char *source)
+{
+    if (level == MemoryPressureLevel::kModerate)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (last_moderate_purge_ && now - *last_moderate_purge_ < kModeratePurgeCooldown)
+            return;
+        last_moderate_purge_ = now;
+    }
+
+    QLOG(LOG_INFO, "Memory pressure ({}) was reported by {}", level_name(level), source);
+
+    // Moderate pressure releases half of the purgeable resources,
+    // and critical pressure releases all of them.
+    size_t target = 0;
+    if (level == MemoryPressureLevel::kModerate)
+        target = GetPurgeableBytes() / 2;
+    Purge(level, target);
+}
+
+size_t MemoryPressureManager::Purge(MemoryPressureLevel level, size_t target_bytes)
+{
+    TRACE_EVENT("rendering", "MemoryPressureManager::Purge", "level", level_name(level));
+
+    size_t released = PurgeRegistrants(level, target_bytes);
+
+    // Caches of Skia which are not owned by any trackables
+    // (glyph caches, decoded images, etc.)
+    if (level == MemoryPressureLevel::kCritical)
+        SkGraphics::PurgeAllCaches();
+
+    QLOG(LOG_INFO, "Released {} bytes of graphics resources", released);
+    NotifyDisplays(level, released);
+    return released;
+}
+
+size_t MemoryPressureManager::PurgeRegistrants(MemoryPressureLevel level, size_t target_bytes)
+{
+    size_t total = GetPurgeableBytes();
+    size_t released = 0;
+    for (const Registrant& registrant : registrants_)
+    {
+        if (total <= target_bytes)
+            break;
+
+        GraphicsResourcesTrackable *trackable = registrant.trackable;
+        size_t before = trackable->GetPurgeableBytes();
+        if (before == 0)
+            continue;
+        trackable->PurgeResources(level);
+
+        // Some trackables can only release their resources when the next
+        // frame begins, so the released size may be less than expected.
+        size_t after = trackable->GetPurgeableBytes();
+        size_t freed = before > after ? before - after : 0;
+        released += freed;
+        total -= std::min(total, freed);
+    }
+    return released;
+}
+
+void MemoryPressureManager::NotifyDisplays(MemoryPressureLevel level, size_t released_bytes)
+{
+    if (!PresentThread::LocalContext::HasInstance())
+        return;
+
+    auto *thread_ctx = PresentThread::LocalContext::GetCurrent();
+    for (const std::shared_ptr<Display>& display : thread_ctx->GetActiveDisplays())
+        display->NotifyMemoryPressure(level, released_bytes);
+}
+
+GLAMOR_NAMESPACE_END
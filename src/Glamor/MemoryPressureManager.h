@@ -0,0 +1,146 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_MEMORYPRESSUREMANAGER_H
+#define COCOA_GLAMOR_MEMORYPRESSUREMANAGER_H
+
+#include <vector>
+#include <chrono>
+#include <optional>
+
+#include "Core/UniquePersistent.h"
+#include "Core/EventLoop.h"
+#include "Glamor/Glamor.h"
+#include "Glamor/GraphicsResourcesTrackable.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * Central memory budget of the caches on the present thread. Caches
+ * (layer snapshots, filter results, SHM buffer pools, Skia GPU resources)
+ * register themselves here, and they are purged in the order of their
+ * priorities when:
+ *
+ * - the total size of purgeable resources exceeds the configured budget;
+ * - the kernel reports memory stalls through a PSI trigger, either on the
+ *   cgroup of this process or on the whole system (`/proc/pressure/memory`);
+ * - the cgroup v2 `memory.events` file reports the memory usage of the
+ *   cgroup has reached its `memory.high` or `memory.max` limit.
+ *
+ * Each purge is notified to all the active displays, which emit the
+ * `memory-pressure` signal so that applications can drop their own caches.
+ */
+class MemoryPressureManager : public ThreadLocalUniquePersistent<MemoryPressureManager>
+{
+public:
+    // Registered trackables are purged in the ascending order of priorities
+    enum class PurgePriority : uint32_t
+    {
+        // Results of filters, which are regenerated in a few frames
+        kFilterResults,
+
+        // Snapshots of layers, which are regenerated when the layers stay unchanged
+        kLayerSnapshots,
+
+        // Scratch and unlocked resources of Skia GPU contexts
+        kGpuResources,
+
+        // Oversized buffer pools of render targets, whose shrinking causes
+        // reallocations of buffers
+        kBufferPools
+    };
+
+    constexpr static auto kCheckInterval = std::chrono::milliseconds(1000);
+
+    // PSI triggers fire at most once in each window. Moderate pressure
+    // is reported when some tasks are stalled for 150ms in 2s, and critical
+    // pressure is reported when all the tasks are stalled for 100ms in 2s.
+    // Unprivileged processes are only allowed to use windows which
+    // are multiples of 2s.
+    constexpr static const char *kPsiModerateTrigger = "some 150000 2000000";
+    constexpr static const char *kPsiCriticalTrigger = "full 100000 2000000";
+
+    // Moderate pressures reported within this interval after the previous
+    // purge are ignored, as the caches have not been refilled yet.
+    constexpr static auto kModeratePurgeCooldown = std::chrono::seconds(5);
+
+    // When the budget is exceeded, caches are purged until the total size
+    // of purgeable resources is under this fraction of the budget.
+    constexpr static double kBudgetLowWatermark = 0.75;
+
+    static void Register(GraphicsResourcesTrackable *trackable, PurgePriority priority);
+    static void Unregister(GraphicsResourcesTrackable *trackable);
+
+    // `budget_bytes` is the limit of the total size of purgeable resources,
+    // and zero means unlimited.
+    MemoryPressureManager(uv_loop_t *loop, size_t budget_bytes);
+    ~MemoryPressureManager();
+
+    g_nodiscard size_t GetPurgeableBytes() const;
+
+    /**
+     * Purge the registered trackables in the order of priorities until the
+     * total size of purgeable resources is not greater than `target_bytes`.
+     * Then notify the active displays.
+     *
+     * @return  The size of released resources.
+     */
+    size_t Purge(MemoryPressureLevel level, size_t target_bytes);
+
+private:
+    struct Registrant
+    {
+        GraphicsResourcesTrackable *trackable;
+        PurgePriority               priority;
+    };
+
+    struct PsiTrigger
+    {
+        int32_t                         fd;
+        MemoryPressureLevel             level;
+        std::unique_ptr<uv::PollHandle> poll;
+    };
+
+    struct CgroupEventCounters
+    {
+        uint64_t high;
+        uint64_t max;
+        uint64_t oom;
+    };
+
+    void OpenPsiTriggers(uv_loop_t *loop, const std::optional<std::string>& cgroup_dir);
+    bool OpenPsiTrigger(uv_loop_t *loop, const std::string& path,
+                        const char *trigger, MemoryPressureLevel level);
+    std::optional<CgroupEventCounters> ReadCgroupEventCounters();
+
+    void OnCheckTimer();
+    void OnPressureReported(MemoryPressureLevel level, const char *source);
+    size_t PurgeRegistrants(MemoryPressureLevel level, size_t target_bytes);
+    void NotifyDisplays(MemoryPressureLevel level, size_t released_bytes);
+
+    size_t                                  budget_bytes_;
+    uv::TimerHandle                         check_timer_;
+    std::vector<Registrant>                 registrants_;
+    std::vector<PsiTrigger>                 psi_triggers_;
+    std::optional<std::string>              cgroup_events_path_;
+    std::optional<CgroupEventCounters>      cgroup_event_counters_;
+    std::optional<std::chrono::steady_clock::time_point>
+                                            last_moderate_purge_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_MEMORYPRESSUREMANAGER_H
@@ -0,0 +1,141 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+
+#include "Glamor/PointerMotionCoalescer.h"
+GLAMOR_NAMESPACE_BEGIN
+
+PointerMotionCoalescer::PointerMotionCoalescer() = default;
+
+void PointerMotionCoalescer::Push(uint32_t time, double x, double y)
+{
+    group_.push_back(PointerMotionSample{ time, x, y });
+}
+
+void PointerMotionCoalescer::CommitGroup(Clock::time_point now)
+{
+    if (group_.empty())
+        return;
+
+    if (pending_.empty())
+        pending_since_ = now;
+    latest_committed_time_ = now;
+
+    for (const PointerMotionSample& sample : group_)
+    {
+        pending_.push_back(sample);
+        history_.push_back(sample);
+    }
+    if (history_.size() > kHistorySize)
+        history_.erase(history_.begin(), history_.end() - kHistorySize);
+    group_.clear();
+}
+
+PointerMotionCoalescer::Clock::duration
+PointerMotionCoalescer::GetPendingAge(Clock::time_point now) const
+{
+    if (pending_.empty())
+        return Clock::duration::zero();
+    return now - pending_since_;
+}
+
+std::optional<PointerMotionSample>
+PointerMotionCoalescer::Resample(const PointerMotionSample& latest,
+                                 Clock::time_point now) const
+{
+    // Map the flush time into the time domain of the events by the
+    // receiving time of the latest sample.
+    double since_latest = std::chrono::duration<double, std::milli>(
+            now - latest_committed_time_).count();
+    double offset = since_latest - kResampleLatencyMs;
+
+    // Find the latest sample which is far enough from the latest one:
+    // it should precede the resampling time so that we interpolate
+    // rather than extrapolate backwards, and adjacent samples of high
+    // frequency devices are too close to estimate a stable velocity.
+    double min_delta = std::max(kMinSampleDeltaMs, -offset);
+    const PointerMotionSample *prev = nullptr;
+    for (auto itr = history_.rbegin(); itr != history_.rend(); itr++)
+    {
+        if (static_cast<double>(latest.time - itr->time) >= min_delta)
+        {
+            prev = &(*itr);
+            break;
+        }
+    }
+    if (!prev)
+        return std::nullopt;
+
+    double delta = static_cast<double>(latest.time - prev->time);
+    if (delta > kMaxSampleDeltaMs)
+        return std::nullopt;
+
+    // Predict forward no further than half of the sample interval
+    offset = std::min(offset, std::min(kMaxPredictionMs, delta * 0.5));
+
+    double t = offset / delta;
+    return PointerMotionSample{
+        .time = static_cast<uint32_t>(static_cast<int64_t>(latest.time) + std::lround(offset)),
+        .x = latest.x + (latest.x - prev->x) * t,
+        .y = latest.y + (latest.y - prev->y) * t
+    };
+}
+
+std::optional<PointerMotionCoalescer::Flushed>
+PointerMotionCoalescer::Flush(Clock::time_point now, bool resample)
+{
+    if (pending_.empty())
+    {
+        // The pointer has stopped after a resampled position was reported;
+        // report the real position so that the pointer does not rest at
+        // a predicted position.
+        if (!unsettled_)
+            return std::nullopt;
+        Flushed result{ .position = *unsettled_, .coalesced = {} };
+        unsettled_.reset();
+        return result;
+    }
+
+    Flushed result{ .position = pending_.back(), .coalesced = std::move(pending_) };
+    pending_.clear();
+    unsettled_.reset();
+
+    if (resample)
+    {
+        std::optional<PointerMotionSample> resampled =
+                Resample(result.position, now);
+        if (resampled)
+        {
+            unsettled_ = result.position;
+            result.position = *resampled;
+        }
+    }
+
+    return result;
+}
+
+void PointerMotionCoalescer::Reset()
+{
+    group_.clear();
+    pending_.clear();
+    unsettled_.reset();
+    history_.clear();
+}
+
+GLAMOR_NAMESPACE_END
@@ -0,0 +1,123 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COCOA_GLAMOR_POINTERMOTIONCOALESCER_H
+#define COCOA_GLAMOR_POINTERMOTIONCOALESCER_H
+
+#include <vector>
+#include <optional>
+#include <chrono>
+
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+struct PointerMotionSample
+{
+    // Timestamp of the event in milliseconds, provided by the windowing
+    // system. It has an undefined base and is only used for the differences.
+    uint32_t time;
+    double   x;
+    double   y;
+};
+
+/**
+ * Collects the motion events of a pointer device between two frames,
+ * so that only one motion signal is delivered to the main thread for
+ * each frame instead of one signal for each event. High frequency pointer
+ * devices may generate several events in a single frame interval.
+ *
+ * Motion events are collected in groups (a group corresponds to the
+ * events between two `wl_pointer.frame` events on Wayland), and a group
+ * becomes visible to `Flush` only after it is committed.
+ *
+ * When resampling is requested, the reported position is predicted
+ * (or interpolated) for a point in time slightly before the flush
+ * time instead of the position of the latest event, which eliminates
+ * the jitter caused by the phase difference between the device
+ * and the display refresh.
+ */
+class PointerMotionCoalescer
+{
+public:
+    using SampleVector = std::vector<PointerMotionSample>;
+    using Clock = std::chrono::steady_clock;
+
+    // The resampled point in time is behind the flush time by this latency
+    constexpr static double kResampleLatencyMs = 5.0;
+    // Maximum time to predict forward from the latest sample
+    constexpr static double kMaxPredictionMs = 8.0;
+    // Samples which are too close or too far to each other are not
+    // reliable to estimate the velocity.
+    constexpr static double kMinSampleDeltaMs = 2.0;
+    constexpr static double kMaxSampleDeltaMs = 20.0;
+    // Number of the latest samples kept for estimating the velocity
+    constexpr static size_t kHistorySize = 8;
+
+    struct Flushed
+    {
+        // The position which should be reported to the user
+        PointerMotionSample position;
+        // All the motion events since the last flush, in order
+        SampleVector coalesced;
+    };
+
+    PointerMotionCoalescer();
+    ~PointerMotionCoalescer() = default;
+
+    void Push(uint32_t time, double x, double y);
+
+    void CommitGroup(Clock::time_point now);
+
+    g_nodiscard g_inline bool HasPendingMotion() const {
+        return !pending_.empty() || unsettled_;
+    }
+
+    /**
+     * Time elapsed since the oldest pending motion was committed.
+     */
+    g_nodiscard Clock::duration GetPendingAge(Clock::time_point now) const;
+
+    /**
+     * Take all the pending motion events. If a resampled position was reported
+     * by the last flush and there are no more events, the real position of the
+     * pointer is reported (with no coalesced events) to settle the pointer.
+     */
+    std::optional<Flushed> Flush(Clock::time_point now, bool resample);
+
+    /**
+     * Drop all the pending events and the history used for resampling,
+     * typically when the pointer leaves the surface.
+     */
+    void Reset();
+
+private:
+    g_nodiscard std::optional<PointerMotionSample>
+    Resample(const PointerMotionSample& latest, Clock::time_point now) const;
+
+    SampleVector                        group_;
+    SampleVector                        pending_;
+    Clock::time_point                   pending_since_;
+    Clock::time_point                   latest_committed_time_;
+    // The latest samples, which are kept across flushes for resampling
+    SampleVector                        history_;
+    // The real position of the pointer if a resampled position was reported
+    std::optional<PointerMotionSample>  unsettled_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_POINTERMOTIONCOALESCER_H
@@ -32,7 +32,7 @@ public:
 
     using Timepoint = std::chrono::steady_clock::time_point;
 
-    explicit PresentMessage(Type type) : type_(type) {}
+    explicit PresentMessage(Type type) : type_(type), trace_flow_id_(0) {}
     virtual ~PresentMessage() = default;
 
     g_nodiscard g_inline bool IsRemoteCall() const {
@@ -51,12 +51,22 @@ public:
         return profile_milestones_[static_cast<uint8_t>(tag)];
     }
 
+    // Links the trace events of enqueuing and handling this message
+    g_inline void SetTraceFlowId(uint64_t id) {
+        trace_flow_id_ = id;
+    }
+
+    g_nodiscard g_inline uint64_t GetTraceFlowId() const {
+        return trace_flow_id_;
+    }
+
 private:
     static constexpr size_t kMilestonesSize =
             static_cast<uint8_t>(PresentMessageMilestone::kLast) + 1;
 
     Type        type_;
     Timepoint   profile_milestones_[kMilestonesSize];
+    uint64_t    trace_flow_id_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -0,0 +1,198 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+
+#include "json/json.h"
+
+#include "Core/Errors.h"
+#include "Glamor/PresentMessageProfiler.h"
+#include "Glamor/PresentRemoteCallMessage.h"
+#include "Glamor/PresentSignalMessage.h"
+GLAMOR_NAMESPACE_BEGIN
+
+namespace {
+
+struct IntervalInfo
+{
+    const char *name;
+    PresentMessageMilestone from;
+    PresentMessageMilestone to;
+};
+
+const IntervalInfo g_intervals[PresentMessageProfiler::kLast_Interval] = {
+    { "queued", PresentMessageMilestone::kHostEnqueued, PresentMessageMilestone::kClientReceived },
+    { "execution", PresentMessageMilestone::kClientReceived, PresentMessageMilestone::kClientProcessed },
+    { "return", PresentMessageMilestone::kClientProcessed, PresentMessageMilestone::kHostReceived },
+    { "roundTrip", PresentMessageMilestone::kHostConstruction, PresentMessageMilestone::kHostReceived }
+};
+
+const char *g_queue_names[PresentMessageProfiler::kLast_QueueKind] = {
+    "presentThread",
+    "mainThread"
+};
+
+uint64_t elapsed_us(PresentMessage::Timepoint from, PresentMessage::Timepoint to)
+{
+    // Milestones are marked on different threads, and a clock read
+    // racing with the enqueue may be slightly earlier than the previous one.
+    if (to <= from)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+Json::Value summarize_histogram(const GProfilerHistogram& histogram)
+{
+    GProfilerHistogram::Counts counts{};
+    uint64_t max = 0;
+    histogram.AccumulateInto(counts, max);
+    GProfilerHistogram::Summary summary = GProfilerHistogram::Summarize(counts, max);
+
+    Json::Value value(Json::objectValue);
+    value["p50"] = Json::Value::UInt64(summary.p50);
+    value["p90"] = Json::Value::UInt64(summary.p90);
+    value["p99"] = Json::Value::UInt64(summary.p99);
+    value["max"] = Json::Value::UInt64(summary.max);
+    return value;
+}
+
+} // namespace anonymous
+
+PresentMessageProfiler::PresentMessageProfiler()
+    : profile_start_(std::chrono::steady_clock::now())
+    , total_messages_(0)
+{
+}
+
+void PresentMessageProfiler::MarkMessage(Timepoint received)
+{
+    if (!first_message_)
+        first_message_ = received;
+    last_message_ = received;
+    total_messages_++;
+}
+
+void PresentMessageProfiler::RecordRemoteCall(PresentRemoteCallMessage *message)
+{
+    CHECK(message);
+
+    EntryKey key(message->GetReceiver()->GetRealType(),
+                 message->GetClientCallInfo().GetOpCode());
+    std::unique_ptr<RemoteCallEntry>& entry = remote_calls_[key];
+    if (!entry)
+        entry = std::make_unique<RemoteCallEntry>();
+
+    entry->count++;
+    for (int32_t i = 0; i < kLast_Interval; i++)
+    {
+        entry->intervals[i].Record(elapsed_us(message->GetProfileMilestone(g_intervals[i].from),
+                                              message->GetProfileMilestone(g_intervals[i].to)));
+    }
+
+    MarkMessage(message->GetProfileMilestone(PresentMessageMilestone::kHostReceived));
+}
+
+void PresentMessageProfiler::RecordSignal(PresentSignalMessage *message)
+{
+    CHECK(message);
+
+    EntryKey key(message->GetEmitter()->GetRealType(), message->GetSignalCode());
+    std::unique_ptr<SignalEntry>& entry = signals_[key];
+    if (!entry)
+        entry = std::make_unique<SignalEntry>();
+
+    entry->count++;
+    entry->delivery.Record(elapsed_us(message->GetProfileMilestone(PresentMessageMilestone::kClientEmitted),
+                                      message->GetProfileMilestone(PresentMessageMilestone::kHostReceived)));
+
+    MarkMessage(message->GetProfileMilestone(PresentMessageMilestone::kHostReceived));
+}
+
+void PresentMessageProfiler::SampleQueueDepth(QueueKind queue, size_t depth)
+{
+    CHECK(queue < kLast_QueueKind);
+    QueueDepthSamples& samples = queue_depths_[queue];
+    samples.samples++;
+    samples.total_depth += depth;
+    samples.depth.Record(depth);
+}
+
+std::string PresentMessageProfiler::GenerateJSON() const
+{
+    Json::Value root(Json::objectValue);
+    root["type"] = "cocoa.gl.profile.messagequeue";
+    root["unit"] = "us";
+    root["durationMs"] = Json::Value::UInt64(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - profile_start_).count());
+    root["totalMessages"] = Json::Value::UInt64(total_messages_);
+
+    // Throughput is measured between the first and the last received messages
+    double throughput = 0;
+    if (first_message_ && last_message_ && *last_message_ > *first_message_)
+    {
+        std::chrono::duration<double> span = *last_message_ - *first_message_;
+        throughput = static_cast<double>(total_messages_) / span.count();
+    }
+    root["messagesPerSecond"] = throughput;
+
+    Json::Value& remote_calls = root["remoteCalls"] = Json::Value(Json::arrayValue);
+    for (const auto& [key, entry] : remote_calls_)
+    {
+        Json::Value value(Json::objectValue);
+        value["receiver"] = PresentRemoteHandle::GetTypeName(key.first);
+        value["opcode"] = key.second;
+        value["count"] = Json::Value::UInt64(entry->count);
+        for (int32_t i = 0; i < kLast_Interval; i++)
+            value[g_intervals[i].name] = summarize_histogram(entry->intervals[i]);
+        remote_calls.append(value);
+    }
+
+    Json::Value& signals = root["signals"] = Json::Value(Json::arrayValue);
+    for (const auto& [key, entry] : signals_)
+    {
+        Json::Value value(Json::objectValue);
+        value["emitter"] = PresentRemoteHandle::GetTypeName(key.first);
+        value["signal"] = key.second;
+        value["count"] = Json::Value::UInt64(entry->count);
+        value["delivery"] = summarize_histogram(entry->delivery);
+        signals.append(value);
+    }
+
+    Json::Value& queues = root["queueDepths"] = Json::Value(Json::objectValue);
+    for (int32_t i = 0; i < kLast_QueueKind; i++)
+    {
+        const QueueDepthSamples& samples = queue_depths_[i];
+        Json::Value value = summarize_histogram(samples.depth);
+        value["samples"] = Json::Value::UInt64(samples.samples);
+        value["mean"] = samples.samples > 0
+                        ? static_cast<double>(samples.total_depth) / static_cast<double>(samples.samples)
+                        : 0.0;
+        queues[g_queue_names[i]] = value;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    builder["commentStyle"] = "None";
+
+    std::ostringstream oss;
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &oss);
+
+    return oss.str();
+}
+
+GLAMOR_NAMESPACE_END
@@ -0,0 +1,119 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COCOA_GLAMOR_PRESENTMESSAGEPROFILER_H
+#define COCOA_GLAMOR_PRESENTMESSAGEPROFILER_H
+
+#include <map>
+#include <memory>
+#include <optional>
+
+#include "Glamor/Glamor.h"
+#include "Glamor/PresentMessage.h"
+#include "Glamor/PresentRemoteHandle.h"
+#include "Glamor/GProfilerHistogram.h"
+GLAMOR_NAMESPACE_BEGIN
+
+class PresentRemoteCallMessage;
+class PresentSignalMessage;
+
+/**
+ * Aggregates the milestones of the messages transferred between the main
+ * thread and the present thread (enabled by `--gl-transfer-queue-profile`).
+ * For each remote call, the time it spent in the present thread queue,
+ * executing on the present thread, and returning to the main thread is
+ * recorded into histograms keyed by the receiver type and opcode.
+ * Signals are keyed by the emitter type and signal code.
+ *
+ * All the methods must be called on the main thread, after the message
+ * has been received by the main thread (so all the milestones before
+ * `kHostReceived` have been marked).
+ */
+class PresentMessageProfiler
+{
+public:
+    enum Interval
+    {
+        // [kHostEnqueued, kClientReceived]
+        kQueued,
+        // [kClientReceived, kClientProcessed]
+        kExecution,
+        // [kClientProcessed, kHostReceived]
+        kReturn,
+        // [kHostConstruction, kHostReceived]
+        kRoundTrip,
+
+        kLast_Interval
+    };
+
+    enum QueueKind
+    {
+        kPresentThreadQueue,
+        kMainThreadQueue,
+
+        kLast_QueueKind
+    };
+
+    PresentMessageProfiler();
+    ~PresentMessageProfiler() = default;
+
+    void RecordRemoteCall(PresentRemoteCallMessage *message);
+    void RecordSignal(PresentSignalMessage *message);
+
+    void SampleQueueDepth(QueueKind queue, size_t depth);
+
+    g_nodiscard std::string GenerateJSON() const;
+
+private:
+    using Timepoint = PresentMessage::Timepoint;
+    using EntryKey = std::pair<PresentRemoteHandle::RealType, uint32_t>;
+
+    struct RemoteCallEntry
+    {
+        uint64_t            count = 0;
+        GProfilerHistogram  intervals[kLast_Interval];
+    };
+
+    struct SignalEntry
+    {
+        uint64_t            count = 0;
+        // [kClientEmitted, kHostReceived]
+        GProfilerHistogram  delivery;
+    };
+
+    struct QueueDepthSamples
+    {
+        uint64_t            samples = 0;
+        uint64_t            total_depth = 0;
+        GProfilerHistogram  depth;
+    };
+
+    void MarkMessage(Timepoint received);
+
+    Timepoint                        profile_start_;
+    std::optional<Timepoint>         first_message_;
+    std::optional<Timepoint>         last_message_;
+    uint64_t                         total_messages_;
+    std::map<EntryKey, std::unique_ptr<RemoteCallEntry>>
+                                     remote_calls_;
+    std::map<EntryKey, std::unique_ptr<SignalEntry>>
+                                     signals_;
+    QueueDepthSamples                queue_depths_[kLast_QueueKind];
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_PRESENTMESSAGEPROFILER_H
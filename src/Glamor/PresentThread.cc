@@ -16,9 +16,11 @@
  */
 
 #include <unistd.h>
+#include <fstream>
 
 #include "Core/Journal.h"
 #include "Core/EventLoop.h"
+#include "Core/TraceEvent.h"
 #include "Glamor/PresentThread.h"
 #include "Glamor/PresentRemoteCallMessage.h"
 #include "Glamor/PresentSignalMessage.h"
@@ -26,6 +28,7 @@
 #include "Glamor/GraphicsResourcesTrackable.h"
 #include "Glamor/MaybeGpuObject.h"
 #include "Glamor/Display.h"
+#include "Glamor/MemoryPressureManager.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.PresentThread)
@@ -78,9 +81,19 @@ PresentThread::LocalContext::EnqueueSignal(const std::shared_ptr<PresentRemoteHa
     auto shared_signal_info = std::make_shared<PresentSignal>(std::move(signal_info));
     auto message = std::make_unique<PresentSignalMessage>(
             shared_signal_info, emitter, signal_code);
+
+    uint64_t flow_id = TraceNewFlowId();
+    TRACE_EVENT("rendering", "PresentThread::EnqueueSignal",
+                perfetto::Flow::ProcessScoped(flow_id),
+                "emitter", PresentRemoteHandle::GetTypeName(emitter->GetRealType()),
+                "signal", signal_code);
+    message->SetTraceFlowId(flow_id);
+
     main_thread_queue_->Enqueue(std::move(message), [](const Queue::Message& msg) {
         msg->MarkProfileMilestone(PresentMessageMilestone::kClientEmitted);
     });
+    TRACE_COUNTER("rendering", "PresentThread.MainThreadQueueDepth",
+                  main_thread_queue_->GetPendingCount());
 
     // Schedule local signals. If the signal is being listened by
     // listeners on this thread, they should be called in the next
@@ -188,12 +201,23 @@ void *present_thread_entrypoint(void *args)
         auto *remote_call = static_cast<PresentRemoteCallMessage*>(message.get());
         auto receiver = remote_call->GetReceiver();
 
+        // The flow started by `PresentThread::EnqueueRemoteCall` passes through
+        // here and terminates when the main thread handles the feedback.
+        TRACE_EVENT("rendering", "PresentThread::HandleRemoteCall",
+                    perfetto::Flow::ProcessScoped(remote_call->GetTraceFlowId()),
+                    "receiver", PresentRemoteHandle::GetTypeName(receiver->GetRealType()),
+                    "opcode", remote_call->GetClientCallInfo().GetOpCode());
+        TRACE_COUNTER("rendering", "PresentThread.PresentThreadQueueDepth",
+                      present_thread_queue->GetPendingCount());
+
         remote_call->MarkProfileMilestone(PresentMessageMilestone::kClientReceived);
         receiver->DoRemoteCall(remote_call->GetClientCallInfo());
         remote_call->MarkProfileMilestone(PresentMessageMilestone::kClientProcessed);
         main_thread_queue->Enqueue(std::move(message), [](const Queue::Message& msg) {
             msg->MarkProfileMilestone(PresentMessageMilestone::kClientFeedback);
         });
+        TRACE_COUNTER("rendering", "PresentThread.MainThreadQueueDepth",
+                      main_thread_queue->GetPendingCount());
     });
 
     // Now we can notify the main thread, which is waiting for
@@ -209,6 +233,8 @@ void *present_thread_entrypoint(void *args)
     PresentThread::LocalContext::New(event_loop->handle(),
                                      main_thread_queue,
                                      remote_collector);
+    MemoryPressureManager::New(event_loop->handle(),
+                               GlobalScope::Ref().GetOptions().GetMemoryBudget());
 
     event_loop->run();
     QLOG(LOG_INFO, "Present thread has exited");
@@ -217,6 +243,7 @@ void *present_thread_entrypoint(void *args)
     // thread has exited.
     main_thread_queue->Enqueue(nullptr, {});
 
+    MemoryPressureManager::Delete();
     PresentThread::LocalContext::Delete();
     EventLoop::Delete();
     return nullptr;
@@ -260,6 +287,9 @@ PresentThread::PresentThread(std::weak_ptr<Queue> present_thread_queue,
     , task_runner_(std::make_shared<PresentThreadTaskRunner>())
     , remote_destroyables_collector_(std::move(collector))
 {
+    if (GlobalScope::Ref().GetOptions().GetProfileRenderHostTransfer())
+        message_profiler_ = std::make_unique<PresentMessageProfiler>();
+
     main_thread_queue_->SetMessageHandler([this](Queue::Message message, Queue*) {
         OnMainThreadMessage(std::move(message));
     });
@@ -275,12 +305,26 @@ void PresentThread::EnqueueRemoteCall(std::shared_ptr<PresentRemoteHandle> recei
         QLOG(LOG_ERROR, "Failed to enqueue remote call: queue is not available");
         return;
     }
+    uint64_t flow_id = TraceNewFlowId();
+    TRACE_EVENT("main", "PresentThread::EnqueueRemoteCall",
+                perfetto::Flow::ProcessScoped(flow_id),
+                "receiver", PresentRemoteHandle::GetTypeName(receiver->GetRealType()),
+                "opcode", call_info.GetOpCode());
+
     auto message = std::make_unique<PresentRemoteCallMessage>(
             std::move(receiver), std::move(call_info), std::move(result_callback));
     message->MarkProfileMilestone(PresentMessageMilestone::kHostConstruction);
+    message->SetTraceFlowId(flow_id);
     queue->Enqueue(std::move(message), [](const Queue::Message& msg) {
         msg->MarkProfileMilestone(PresentMessageMilestone::kHostEnqueued);
     });
+    TRACE_COUNTER("rendering", "PresentThread.PresentThreadQueueDepth",
+                  queue->GetPendingCount());
+    if (message_profiler_)
+    {
+        message_profiler_->SampleQueueDepth(PresentMessageProfiler::kPresentThreadQueue,
+                                            queue->GetPendingCount());
+    }
 }
 
 void PresentThread::OnMainThreadMessage(Queue::Message message)
@@ -295,14 +339,29 @@ void PresentThread::OnMainThreadMessage(Queue::Message message)
         thread_has_exited_ = true;
         // Allow the main thread event loop to exit.
         main_thread_queue_->SetNonBlocking(true);
+        if (message_profiler_)
+            DumpMessageProfile();
         return;
     }
 
+    TRACE_EVENT("main", "PresentThread::OnMainThreadMessage",
+                perfetto::TerminatingFlow::ProcessScoped(message->GetTraceFlowId()));
+    TRACE_COUNTER("rendering", "PresentThread.MainThreadQueueDepth",
+                  main_thread_queue_->GetPendingCount());
+
     message->MarkProfileMilestone(PresentMessageMilestone::kHostReceived);
+    if (message_profiler_)
+    {
+        message_profiler_->SampleQueueDepth(PresentMessageProfiler::kMainThreadQueue,
+                                            main_thread_queue_->GetPendingCount());
+    }
+
     if (message->IsRemoteCall())
     {
         // NOLINTNEXTLINE
         auto *remote_call = static_cast<PresentRemoteCallMessage*>(message.get());
+        if (message_profiler_)
+            message_profiler_->RecordRemoteCall(remote_call);
         PresentRemoteCallReturn call_return(remote_call);
         remote_call->GetHostCallback()(call_return);
     }
@@ -310,11 +369,25 @@ void PresentThread::OnMainThreadMessage(Queue::Message message)
     {
         // NOLINTNEXTLINE
         auto *signal = static_cast<PresentSignalMessage*>(message.get());
+        if (message_profiler_)
+            message_profiler_->RecordSignal(signal);
         signal->GetEmitter()->DoEmitSignal(
                 signal->GetSignalCode(), *signal->GetSignalInfo(), false);
     }
+}
 
-    // TODO(sora): collect messaging samples for profiling
+void PresentThread::DumpMessageProfile()
+{
+    // The file is stored in the working directory
+    std::string path = fmt::format("glamor-message-queue-profile-{}.json", getpid());
+    std::ofstream stream(path, std::ios::out | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        QLOG(LOG_ERROR, "Failed to write message queue profile to {}", path);
+        return;
+    }
+    stream << message_profiler_->GenerateJSON();
+    QLOG(LOG_INFO, "Message queue profile has been written to {}", path);
 }
 
 void PresentThread::SubmitTaskNoRet(std::function<void()> task_func,
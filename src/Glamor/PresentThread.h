@@ -27,6 +27,7 @@
 #include "Core/UniquePersistent.h"
 #include "Glamor/Glamor.h"
 #include "Glamor/PresentMessage.h"
+#include "Glamor/PresentMessageProfiler.h"
 #include "Glamor/PresentRemoteHandle.h"
 #include "Glamor/PresentThreadTaskRunner.h"
 GLAMOR_NAMESPACE_BEGIN
@@ -65,6 +66,10 @@ public:
         void AddActiveDisplay(std::shared_ptr<Display> display);
         void RemoveActiveDisplay(const std::shared_ptr<Display>& display);
 
+        g_nodiscard const std::list<std::shared_ptr<Display>>& GetActiveDisplays() const {
+            return active_displays_;
+        }
+
         std::string TraceResourcesJSON();
 
     private:
@@ -103,10 +108,18 @@ public:
                          std::function<void()> result_callback,
                          std::function<void(std::string)> caught_callback);
 
-    // TODO(sora): implement message queue profiling API
+    /**
+     * Available only if the message queue profiling is enabled
+     * (`ContextOptions::GetProfileRenderHostTransfer`); nullptr otherwise.
+     * The profiler can only be accessed on the main thread.
+     */
+    g_nodiscard PresentMessageProfiler *GetMessageProfiler() const {
+        return message_profiler_.get();
+    }
 
 private:
     void OnMainThreadMessage(Queue::Message message);
+    void DumpMessageProfile();
 
     std::weak_ptr<Queue>        present_thread_queue_;
     std::shared_ptr<Queue>      main_thread_queue_;
@@ -116,6 +129,8 @@ private:
                                 task_runner_;
     std::shared_ptr<RemoteDestroyablesCollector>
                                 remote_destroyables_collector_;
+    std::unique_ptr<PresentMessageProfiler>
+                                message_profiler_;
 };
 
 template<typename Ret>
@@ -0,0 +1,132 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <future>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "Core/Journal.h"
+#include "Core/TraceEvent.h"
+#include "Glamor/RenderThread.h"
+GLAMOR_NAMESPACE_BEGIN
+
+#define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.RenderThread)
+
+RenderThread::RenderThread(uv_loop_t *reply_loop, const std::string& name)
+    : loop_{}
+    , pending_replies_(0)
+{
+    CHECK(reply_loop);
+    uv_loop_init(&loop_);
+
+    // The render thread has not started yet, so it is safe to create
+    // the handles on its event loop here.
+    task_queue_ = std::make_unique<Queue>(&loop_, [this](Queue::Message message, Queue*) {
+        if (message == nullptr)
+        {
+            // A null message requests the thread to exit. The loop exits
+            // once the queue does not keep it alive anymore.
+            task_queue_->SetNonBlocking(true);
+            return;
+        }
+
+        message->task();
+        reply_queue_->Enqueue(std::move(message));
+    });
+
+    reply_queue_ = std::make_unique<Queue>(reply_loop, [this](Queue::Message message, Queue*) {
+        CHECK(message);
+        if (message->reply)
+            message->reply();
+        if (message->counted)
+            pending_replies_.fetch_sub(1, std::memory_order_acq_rel);
+    });
+
+    thread_ = std::thread(&RenderThread::ThreadEntrypoint, this, name);
+}
+
+RenderThread::~RenderThread()
+{
+    // Tasks which have been posted are still performed, but their
+    // replies are dropped.
+    task_queue_->Enqueue(nullptr);
+    thread_.join();
+
+    reply_queue_.reset();
+    int ret = uv_loop_close(&loop_);
+    if (ret < 0)
+        QLOG(LOG_WARNING, "Failed to close the event loop of render thread: {}", uv_strerror(ret));
+}
+
+void RenderThread::ThreadEntrypoint(std::string name)
+{
+    // Thread names are limited to 16 bytes including the terminator
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    QLOG(LOG_INFO, "Render thread {} has been started, tid={}", name, gettid());
+
+    uv_run(&loop_, UV_RUN_DEFAULT);
+
+    // Run the loop once more to finish closing the queue handle
+    task_queue_.reset();
+    uv_run(&loop_, UV_RUN_DEFAULT);
+
+    QLOG(LOG_INFO, "Render thread {} has exited", name);
+}
+
+void RenderThread::PostTask(Task task, Task reply)
+{
+    CHECK(task);
+    pending_replies_.fetch_add(1, std::memory_order_acq_rel);
+    task_queue_->Enqueue(std::make_unique<TaskMessage>(TaskMessage{
+        .task = std::move(task),
+        .reply = std::move(reply),
+        .counted = true
+    }));
+}
+
+void RenderThread::Flush()
+{
+    int32_t pending = pending_replies_.load(std::memory_order_acquire);
+    if (pending == 0)
+        return;
+
+    TRACE_EVENT("rendering", "RenderThread::Flush");
+
+    // Tasks are run in order, so all the posted tasks have finished
+    // once the fence task runs.
+    std::promise<void> fence;
+    task_queue_->Enqueue(std::make_unique<TaskMessage>(TaskMessage{
+        .task = [&fence] { fence.set_value(); },
+        .reply = {},
+        .counted = false
+    }));
+    fence.get_future().wait();
+
+    // The replies (including the fence's) are all in the reply queue now,
+    // as the queue is only handled on this thread, which is blocked.
+    // Messages taken by `WaitOnce` will not be handled by the queue again.
+    for (int32_t i = 0; i <= pending; i++)
+    {
+        Queue::Message message = reply_queue_->WaitOnce();
+        if (message->reply)
+            message->reply();
+        if (message->counted)
+            pending_replies_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+GLAMOR_NAMESPACE_END
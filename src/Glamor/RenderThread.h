@@ -0,0 +1,107 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COCOA_GLAMOR_RENDERTHREAD_H
+#define COCOA_GLAMOR_RENDERTHREAD_H
+
+#include <functional>
+#include <atomic>
+#include <thread>
+
+#include "Core/AsyncMessageQueue.h"
+#include "Glamor/Glamor.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * A dedicated thread with its own event loop and message queue, which
+ * a `ContentAggregator` can be bound to (see
+ * `ContentAggregator::SetDedicatedRenderThread`), so that painting the
+ * layer tree of one surface does not delay the frames of other surfaces.
+ * Only the painting stage is performed on the render thread. Display,
+ * surfaces, render targets and all the Wayland protocol handling stay on
+ * the present thread: frame buffers are acquired and submitted there.
+ *
+ * Objects which may be shared across render threads (and the present
+ * thread) are the immutable Skia objects: `SkPicture`, raster-backed
+ * `SkImage`, `SkImageFilter`, `SkShader`, `SkTypeface` and `SkTextBlob`.
+ * Layers, layer trees and the raster caches are owned by exactly one
+ * `ContentAggregator` and must never be painted by two render threads
+ * at the same time, which means a `Scene` must not be submitted to more
+ * than one `ContentAggregator` bound to render threads. GPU objects
+ * (textures, semaphores, `GrDirectContext`) cannot be shared at all,
+ * so only raster surfaces can be bound to a render thread.
+ *
+ * Video frames are another shared object: the texture accessors of the
+ * `ExternalTextureLayer`s committed by one `utau::VideoFrameGLEmbedder`
+ * share the swscale contexts of the embedder, which may therefore be used
+ * by several render threads showing the same video. They are guarded by
+ * a lock in the embedder, so frame conversions of one embedder are
+ * serialized across render threads.
+ */
+class RenderThread
+{
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * `reply_loop` is the event loop of the caller thread (the present
+     * thread), where the replies of the tasks will be run.
+     */
+    RenderThread(uv_loop_t *reply_loop, const std::string& name);
+    ~RenderThread();
+
+    /**
+     * Run `task` on the render thread, and then run `reply` on the reply
+     * thread after `task` has finished. Tasks are run in the order
+     * they are posted.
+     */
+    void PostTask(Task task, Task reply);
+
+    /**
+     * Block the caller (reply) thread until all the posted tasks have
+     * finished, and run their pending replies synchronously.
+     * After that, the states touched by the tasks can be accessed
+     * safely on the caller thread.
+     */
+    void Flush();
+
+    g_nodiscard g_inline bool HasPendingTasks() const {
+        return pending_replies_.load(std::memory_order_acquire) > 0;
+    }
+
+private:
+    struct TaskMessage
+    {
+        Task task;
+        Task reply;
+        // Whether the message is counted by `pending_replies_`
+        bool counted;
+    };
+
+    using Queue = AsyncMessageQueue<TaskMessage>;
+
+    void ThreadEntrypoint(std::string name);
+
+    uv_loop_t                   loop_;
+    std::unique_ptr<Queue>      task_queue_;
+    std::unique_ptr<Queue>      reply_queue_;
+    std::atomic<int32_t>        pending_replies_;
+    std::thread                 thread_;
+};
+
+GLAMOR_NAMESPACE_END
+#endif //COCOA_GLAMOR_RENDERTHREAD_H
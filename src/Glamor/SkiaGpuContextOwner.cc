@@ -26,6 +26,7 @@
 #include "include/gpu/vk/GrVkBackendContext.h"
 
 #include "Glamor/SkiaGpuContextOwner.h"
+#include "Glamor/MemoryPressureManager.h"
 #include "Glamor/HWComposeDevice.h"
 #include "Glamor/HWComposeContext.h"
 GLAMOR_NAMESPACE_BEGIN
@@ -40,6 +41,11 @@ SkiaGpuContextOwner::SkiaGpuContextOwner()
 {
 }
 
+SkiaGpuContextOwner::~SkiaGpuContextOwner()
+{
+    MemoryPressureManager::Unregister(this);
+}
+
 namespace {
 
 PFN_vkVoidFunction vk_skia_proc_getter(const char *sym, VkInstance instance, VkDevice device)
@@ -161,6 +167,7 @@ bool SkiaGpuContextOwner::InitializeSkiaGpuContext(const SkiaGpuContextCreateInf
 
 #undef GET_PFN
 
+    MemoryPressureManager::Register(this, MemoryPressureManager::PurgePriority::kGpuResources);
     return true;
 }
 
@@ -168,6 +175,7 @@ void SkiaGpuContextOwner::DisposeSkiaGpuContext()
 {
     if (!direct_context_)
         return;
+    MemoryPressureManager::Unregister(this);
     direct_context_ = nullptr;
     vk_allocator_.reset();
     hw_device_.reset();
@@ -442,6 +450,27 @@ SkiaGpuContextOwner::ImportSkSurface(const ExportedSkSurfaceInfo& exported_info)
     return surface;
 }
 
+size_t SkiaGpuContextOwner::GetPurgeableBytes() noexcept
+{
+    if (!direct_context_)
+        return 0;
+    return direct_context_->getResourceCachePurgeableBytes();
+}
+
+void SkiaGpuContextOwner::PurgeResources(MemoryPressureLevel level) noexcept
+{
+    if (!direct_context_)
+        return;
+
+    // Scratch resources (render targets and textures which are not bound
+    // to any unique keys) are cheap to recreate, while other resources
+    // like uploaded images and glyph atlases are kept unless the pressure
+    // is critical.
+    direct_context_->purgeUnlockedResources(
+            level == MemoryPressureLevel::kCritical ? GrPurgeResourceOptions::kAllResources
+                                                    : GrPurgeResourceOptions::kScratchResourcesOnly);
+}
+
 void SkiaGpuContextOwner::Trace(Tracer *tracer) noexcept
 {
     if (!direct_context_)
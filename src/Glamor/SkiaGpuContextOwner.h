@@ -44,7 +44,7 @@ class SkiaGpuContextOwner : public GraphicsResourcesTrackable
 {
 public:
     SkiaGpuContextOwner();
-    ~SkiaGpuContextOwner() override = default;
+    ~SkiaGpuContextOwner() override;
 
     g_nodiscard GrDirectContext *GetSkiaGpuContext() const {
         return direct_context_.get();
@@ -85,6 +85,8 @@ public:
     }
 
     void Trace(Tracer *tracer) noexcept override;
+    size_t GetPurgeableBytes() noexcept override;
+    void PurgeResources(MemoryPressureLevel level) noexcept override;
 
 protected:
     bool InitializeSkiaGpuContext(const SkiaGpuContextCreateInfo& create_info);
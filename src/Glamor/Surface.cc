@@ -17,6 +17,7 @@
 
 #include "Core/Journal.h"
 #include "Glamor/Surface.h"
+#include "Glamor/PresentThread.h"
 #include "Glamor/RenderTarget.h"
 #include "Glamor/Display.h"
 #include "Glamor/ContentAggregator.h"
@@ -25,6 +26,15 @@ GLAMOR_NAMESPACE_BEGIN
 
 #define THIS_FILE_MODULE COCOA_MODULE_NAME(Glamor.Surface)
 
+namespace {
+
+// Pending pointer motion is delivered anyway if it has been held for
+// such a long time, in case the requested frame is never presented
+// (e.g. the compositor throttles frames of an invisible surface).
+constexpr auto kMaxPointerMotionHoldTime = std::chrono::milliseconds(100);
+
+} // namespace anonymous
+
 GLAMOR_TRAMPOLINE_IMPL(Surface, Close)
 {
     auto this_ = info.GetThis()->Cast<Surface>();
@@ -112,6 +122,7 @@ Surface::Surface(std::shared_ptr<RenderTarget> rt)
     , has_disposed_(false)
     , render_target_(std::move(rt))
     , display_(render_target_->GetDisplay())
+    , pending_frame_requests_(0)
 {
     CHECK(render_target_ && "Invalid RenderTarget object");
 
@@ -162,11 +173,15 @@ void Surface::Close()
     // Notify implementor to close the window.
     this->OnClose();
     has_disposed_ = true;
+    frame_pacing_timer_.reset();
+    paced_frame_sequence_.reset();
     render_target_.reset();
 
     // Notify that the window has been closed.
     Emit(GLSI_SURFACE_CLOSED, PresentSignal());
-    GetDisplay()->RemoveSurfaceFromList(Self()->Cast<Surface>());
+    // Headless surfaces (see `scene-replay`) are not attached to a display
+    if (std::shared_ptr<Display> display = GetDisplay())
+        display->RemoveSurfaceFromList(Self()->Cast<Surface>());
     QLOG(LOG_DEBUG, "Surface has been disposed");
 }
 
@@ -179,6 +194,10 @@ bool Surface::Resize(int32_t width, int32_t height)
     if (width <= 0 || height <= 0)
         return false;
 
+    // Resizing rebuilds the frame buffers, one of which may still be
+    // painted by the render thread of the content aggregator.
+    if (content_aggregator_)
+        content_aggregator_->FlushRenderThread();
     render_target_->Resize(width, height);
 
     PresentSignal info;
@@ -197,11 +216,14 @@ void Surface::SetTitle(const std::string_view& title)
 
 std::string Surface::GetBuffersDescriptor()
 {
+    if (content_aggregator_)
+        content_aggregator_->FlushRenderThread();
     return render_target_->GetBufferStateDescriptor();
 }
 
 uint32_t Surface::RequestNextFrame()
 {
+    pending_frame_requests_++;
     return render_target_->RequestNextFrame();
 }
 
@@ -217,11 +239,92 @@ const SkMatrix& Surface::OnGetRootTransformation() const
 
 void Surface::OnFrameNotification(uint32_t sequence)
 {
+    if (has_disposed_)
+        return;
+
+    if (pending_frame_requests_ > 0)
+        pending_frame_requests_--;
+
+    FramePacer& pacer = content_aggregator_->GetFramePacer();
+    pacer.ReportFrameCallback(FramePacer::Clock::now());
+
+    // Contents submitted in the last frame should be presented right now,
+    // while the frame signal may be delayed by pacing.
+    content_aggregator_->PresentPendingFrame();
+
+    // The previous frame signal is still waiting for its start time;
+    // it is late already.
+    if (paced_frame_sequence_)
+    {
+        frame_pacing_timer_->Stop();
+        EmitFrameSignal(*paced_frame_sequence_);
+    }
+
+    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+            GlobalScope::Ref().GetOptions().GetEnableFramePacing()
+            ? pacer.ComputeStartDelay() : FramePacer::Clock::duration::zero());
+    if (delay.count() <= 0)
+    {
+        EmitFrameSignal(sequence);
+        return;
+    }
+
+    if (!frame_pacing_timer_)
+    {
+        frame_pacing_timer_ = std::make_unique<uv::TimerHandle>(
+                PresentThread::LocalContext::GetCurrent()->GetEventLoop());
+    }
+
+    paced_frame_sequence_ = sequence;
+    frame_pacing_timer_->Start(delay.count(), 0, [this] {
+        CHECK(paced_frame_sequence_);
+        EmitFrameSignal(*paced_frame_sequence_);
+    });
+}
+
+void Surface::EmitFrameSignal(uint32_t sequence)
+{
+    paced_frame_sequence_.reset();
+
+    // Deliver the motion coalesced during the last frame interval first,
+    // so that the user sees the latest pointer position when drawing
+    // the next frame.
+    FlushPointerMotion(GlobalScope::Ref().GetOptions().GetEnablePointerResampling());
+
+    content_aggregator_->GetFramePacer().MarkFrameStart(FramePacer::Clock::now());
+
     PresentSignal info;
     info.EmplaceBack<uint32_t>(sequence);
     Emit(GLSI_SURFACE_FRAME, std::move(info));
 }
 
+void Surface::CommitPointerMotionGroup(bool force_flush)
+{
+    auto now = PointerMotionCoalescer::Clock::now();
+    pointer_motion_coalescer_.CommitGroup(now);
+
+    bool frame_pending = pending_frame_requests_ > 0 || paced_frame_sequence_;
+    if (force_flush || !frame_pending ||
+        pointer_motion_coalescer_.GetPendingAge(now) > kMaxPointerMotionHoldTime)
+    {
+        FlushPointerMotion(false);
+    }
+}
+
+void Surface::FlushPointerMotion(bool resample)
+{
+    std::optional<PointerMotionCoalescer::Flushed> flushed =
+            pointer_motion_coalescer_.Flush(PointerMotionCoalescer::Clock::now(), resample);
+    if (!flushed)
+        return;
+
+    PresentSignal info;
+    info.EmplaceBack<double>(flushed->position.x);
+    info.EmplaceBack<double>(flushed->position.y);
+    info.EmplaceBack<PointerMotionCoalescer::SampleVector>(std::move(flushed->coalesced));
+    Emit(GLSI_SURFACE_POINTER_MOTION, std::move(info));
+}
+
 void Surface::SetMaxSize(int32_t width, int32_t height)
 {
     this->OnSetMaxSize(width, height);
@@ -266,6 +369,8 @@ void Surface::SetAttachedCursor(const std::shared_ptr<Cursor>& cursor)
 
 void Surface::Trace(GraphicsResourcesTrackable::Tracer *tracer) noexcept
 {
+    if (content_aggregator_)
+        content_aggregator_->FlushRenderThread();
     if (render_target_)
         tracer->TraceMember("RenderTarget", render_target_.get());
     if (!display_.expired())
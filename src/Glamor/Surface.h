@@ -22,10 +22,13 @@
 #include "include/core/SkSurface.h"
 #include "include/core/SkRegion.h"
 
+#include "Core/EventLoop.h"
+
 #include "Glamor/Glamor.h"
 #include "Glamor/PresentRemoteHandle.h"
 #include "Glamor/FrameNotificationRouter.h"
 #include "Glamor/GraphicsResourcesTrackable.h"
+#include "Glamor/PointerMotionCoalescer.h"
 GLAMOR_NAMESPACE_BEGIN
 
 #define GLOP_SURFACE_CLOSE                          1
@@ -65,8 +68,11 @@ GLAMOR_NAMESPACE_BEGIN
 //! @prototype (bool hovered) -> void
 #define GLSI_SURFACE_POINTER_HOVERING   6
 
-//! Emitted when a pointer moves on the corresponding surface
-//! @prototype (double x, double y) -> void
+//! Emitted when a pointer moves on the corresponding surface.
+//! Motion events are coalesced and emitted at most once for each frame
+//! if a frame has been requested; `coalesced` contains all the events
+//! since the last emission.
+//! @prototype (double x, double y, PointerMotionCoalescer::SampleVector coalesced) -> void
 #define GLSI_SURFACE_POINTER_MOTION     7
 
 //! Emitted when a button of the hovering pointer device is pressed or released
@@ -161,6 +167,18 @@ public:
         return content_aggregator_;
     }
 
+    g_private_api PointerMotionCoalescer& GetPointerMotionCoalescer() {
+        return pointer_motion_coalescer_;
+    }
+
+    /**
+     * Called by the implementation when a group of pointer events has been
+     * received. Pending motion is delivered immediately if no frame has been
+     * requested (or `force_flush` is true), and is delivered right before the
+     * next `GLSI_SURFACE_FRAME` signal otherwise.
+     */
+    g_private_api void CommitPointerMotionGroup(bool force_flush);
+
     void Trace(GraphicsResourcesTrackable::Tracer *tracer) noexcept override;
 
 protected:
@@ -184,11 +202,18 @@ protected:
     }
 
 private:
+    void FlushPointerMotion(bool resample);
+    void EmitFrameSignal(uint32_t sequence);
+
     bool                                has_disposed_;
     std::shared_ptr<RenderTarget>       render_target_;
     std::weak_ptr<Display>              display_;
     std::shared_ptr<Cursor>             attached_cursor_;
     std::shared_ptr<ContentAggregator>  content_aggregator_;
+    uint32_t                            pending_frame_requests_;
+    PointerMotionCoalescer              pointer_motion_coalescer_;
+    std::unique_ptr<uv::TimerHandle>    frame_pacing_timer_;
+    std::optional<uint32_t>             paced_frame_sequence_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -15,10 +15,14 @@
  * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstring>
+#include <utility>
+
 #include "include/core/SkCanvas.h"
 
 #include "Core/Journal.h"
 #include "Core/TraceEvent.h"
+#include "Glamor/MemoryPressureManager.h"
 #include "Glamor/Wayland/WaylandUtils.h"
 #include "Glamor/Wayland/WaylandDisplay.h"
 #include "Glamor/Wayland/WaylandSHMRenderTarget.h"
@@ -31,6 +35,27 @@ GLAMOR_NAMESPACE_BEGIN
 #define RT_INITIAL_BUFFERS  3
 #define RT_EMPTY_INDEX      (-1)
 
+// Slots in a shared memory pool. Besides the initial buffers, there are
+// slots for the buffers which are still held by the compositor after
+// resizing, or which are appended when all the buffers are busy.
+#define RT_POOL_SLOTS       5
+
+namespace {
+
+// The pool is shrunk if more than a half of each slot is wasted
+// for this period, which avoids reallocating it repeatedly
+// while the window is being resized interactively.
+constexpr auto kPoolShrinkDelay = std::chrono::seconds(2);
+
+constexpr size_t kPoolSlotAlignment = 4096;
+
+size_t align_pool_slot_size(size_t size)
+{
+    return (size + kPoolSlotAlignment - 1) & ~(kPoolSlotAlignment - 1);
+}
+
+} // namespace anonymous
+
 std::shared_ptr<WaylandSHMRenderTarget>
 WaylandSHMRenderTarget::Make(const std::shared_ptr<WaylandDisplay>& display,
                              int32_t width, int32_t height, SkColorType format)
@@ -59,10 +84,7 @@ WaylandSHMRenderTarget::Make(const std::shared_ptr<WaylandDisplay>& display,
     renderTarget->wl_event_queue_ = wl_display_create_queue(display->GetWaylandDisplay());
 
     /* Allocate shm buffers */
-    renderTarget->AllocateAppendBuffers(RT_INITIAL_BUFFERS, width, height, format);
-    renderTarget->buffers_[0]->state = BufferState::kDrawing;
-    renderTarget->drawing_buffer_idx_ = 0;
-    renderTarget->committed_buffer_idx_ = RT_EMPTY_INDEX;
+    renderTarget->RebuildBuffers(width, height);
 
     wl_compositor *compositor = display->GetGlobalsRef()->wl_compositor_;
     renderTarget->wl_surface_ = wl_compositor_create_surface(compositor);
@@ -85,11 +107,17 @@ WaylandSHMRenderTarget::WaylandSHMRenderTarget(const std::shared_ptr<WaylandDisp
     : WaylandRenderTarget(display, RenderDevice::kRaster, width, height, format)
     , drawing_buffer_idx_(RT_EMPTY_INDEX)
     , committed_buffer_idx_(RT_EMPTY_INDEX)
+    , pool_slot_size_(0)
+    , pool_shrink_requested_(false)
+    , pool_stats_{}
 {
+    MemoryPressureManager::Register(this, MemoryPressureManager::PurgePriority::kBufferPools);
 }
 
 WaylandSHMRenderTarget::~WaylandSHMRenderTarget()
 {
+    MemoryPressureManager::Unregister(this);
+
     if (wl_surface_)
         wl_surface_destroy(wl_surface_);
     ReleaseAllBuffers(true);
@@ -112,19 +140,28 @@ void WaylandSHMRenderTarget::BufferReleaseCallback(void *data, g_maybe_unused wl
 
     if (self->state == WaylandSHMRenderTarget::BufferState::kDeferredDestroying)
     {
-        CHECK(self->surface->unique());
-        wl_buffer_destroy(self->buffer);
-        self->surface.reset();
-        self->shared_pool_helper.reset();
-
-        auto itr = std::find_if(self->rt->deferred_destructing_buffers_.begin(),
-                                self->rt->deferred_destructing_buffers_.end(),
+        WaylandSHMRenderTarget *rt = self->rt;
+        auto itr = std::find_if(rt->deferred_destructing_buffers_.begin(),
+                                rt->deferred_destructing_buffers_.end(),
                                 [self](const std::unique_ptr<Buffer>& v) -> bool {
             return (v.get() == self);
         });
+        CHECK(itr != rt->deferred_destructing_buffers_.end());
 
-        CHECK(itr != self->rt->deferred_destructing_buffers_.end());
-        self->rt->deferred_destructing_buffers_.erase(itr);
+        // The window may have been resized back to the size of this buffer
+        // before the compositor released it.
+        if (rt->IsReusableBuffer(self) && rt->buffers_.size() < RT_POOL_SLOTS)
+        {
+            self->state = WaylandSHMRenderTarget::BufferState::kFree;
+            self->damage.setEmpty();
+            rt->buffers_.push_back(std::move(*itr));
+            rt->pool_stats_.reused_buffers++;
+        }
+        else
+        {
+            rt->DestroyBuffer(self);
+        }
+        rt->deferred_destructing_buffers_.erase(itr);
     }
     else
     {
@@ -132,28 +169,195 @@ void WaylandSHMRenderTarget::BufferReleaseCallback(void *data, g_maybe_unused wl
     }
 }
 
+void WaylandSHMRenderTarget::DestroyBuffer(Buffer *buffer)
+{
+    CHECK(buffer->surface->unique());
+    wl_buffer_destroy(buffer->buffer);
+    buffer->surface.reset();
+    buffer->shared_pool_helper.reset();
+}
+
+void WaylandSHMRenderTarget::RetireBuffer(std::unique_ptr<Buffer> buffer)
+{
+    // The compositor may be reading from a committed buffer
+    if (buffer->state == BufferState::kCommitted)
+    {
+        buffer->state = BufferState::kDeferredDestroying;
+        deferred_destructing_buffers_.push_back(std::move(buffer));
+    }
+    else
+    {
+        DestroyBuffer(buffer.get());
+    }
+}
+
 void WaylandSHMRenderTarget::ReleaseAllBuffers(bool forceRelease)
 {
     for (std::unique_ptr<Buffer>& ptr : buffers_)
     {
-        if (!forceRelease && ptr->state == BufferState::kCommitted)
+        if (forceRelease)
+            DestroyBuffer(ptr.get());
+        else
+            RetireBuffer(std::move(ptr));
+    }
+    buffers_.clear();
+}
+
+size_t WaylandSHMRenderTarget::GetBufferBytes(int32_t width, int32_t height) const
+{
+    return SkColorTypeBytesPerPixel(GetColorType()) * width * height;
+}
+
+bool WaylandSHMRenderTarget::IsReusableBuffer(const Buffer *buffer) const
+{
+    return buffer->width == GetWidth() && buffer->height == GetHeight() &&
+           buffer->shared_pool_helper == pool_;
+}
+
+void WaylandSHMRenderTarget::RebuildBuffers(int32_t width, int32_t height)
+{
+    // Buffers of the same size in the current pool are kept (e.g. the window
+    // is resized back), and the others are retired, which frees their slots
+    // for the new buffers.
+    std::vector<std::unique_ptr<Buffer>> kept_buffers;
+    for (std::unique_ptr<Buffer>& ptr : buffers_)
+    {
+        if (ptr->width == width && ptr->height == height && ptr->shared_pool_helper == pool_)
         {
-            ptr->state = BufferState::kDeferredDestroying;
-            deferred_destructing_buffers_.push_back(std::move(ptr));
+            if (ptr->state == BufferState::kDrawing)
+                ptr->state = BufferState::kFree;
+            ptr->damage.setEmpty();
+            kept_buffers.push_back(std::move(ptr));
+            pool_stats_.reused_buffers++;
         }
         else
         {
-            CHECK(ptr->surface->unique());
-            wl_buffer_destroy(ptr->buffer);
-            ptr->surface.reset();
-            ptr->shared_pool_helper.reset();
+            RetireBuffer(std::move(ptr));
         }
     }
-    buffers_.clear();
+    buffers_ = std::move(kept_buffers);
+
+    while (buffers_.size() < RT_INITIAL_BUFFERS)
+        buffers_.push_back(CreateBuffer(width, height));
+
+    committed_buffer_idx_ = RT_EMPTY_INDEX;
+    drawing_buffer_idx_ = GetNextDrawingBuffer();
 }
 
-void WaylandSHMRenderTarget::AllocateAppendBuffers(int32_t count, int32_t width, int32_t height,
-                                                   SkColorType format)
+void WaylandSHMRenderTarget::ReallocatePool(size_t slot_size)
+{
+    TRACE_EVENT("rendering", "WaylandSHMRenderTarget::ReallocatePool");
+
+    // Buffers allocated from the previous pool keep it alive until
+    // they are destroyed.
+    auto wl_shm = GetDisplay()->As<WaylandDisplay>()->GetGlobalsRef()->wl_shm_;
+    pool_ = WaylandSharedMemoryHelper::Make(wl_shm, slot_size * RT_POOL_SLOTS,
+                                            WaylandSharedMemoryHelper::kRasterRenderTarget_Role);
+    CHECK(pool_ && "Failed to allocate shared memory pool");
+
+    pool_slot_size_ = slot_size;
+    pool_oversized_since_.reset();
+    pool_stats_.reallocations++;
+
+    QLOG(LOG_DEBUG, "Reallocated shared memory pool: {} slots of {} bytes",
+         RT_POOL_SLOTS, slot_size);
+}
+
+int32_t WaylandSHMRenderTarget::AcquirePoolSlot(size_t size)
+{
+    if (!pool_ || size > pool_slot_size_)
+    {
+        // Grow geometrically so that enlarging the window interactively
+        // only reallocates the pool for a few times. New pools have 25%
+        // headroom; untouched pages do not consume physical memory.
+        size_t grown = pool_ ? pool_slot_size_ + pool_slot_size_ / 2 : 0;
+        // Offsets of buffers in the pool are 32-bit signed integers.
+        constexpr size_t kMaxSlotSize = (INT32_MAX / RT_POOL_SLOTS) & ~(kPoolSlotAlignment - 1);
+        CHECK(size <= kMaxSlotSize && "Buffer is too large for a shared memory pool");
+
+        size_t slot_size = std::max(size + size / 4, grown);
+        ReallocatePool(std::min(align_pool_slot_size(slot_size), kMaxSlotSize));
+    }
+
+    bool used_slots[RT_POOL_SLOTS] = {};
+    auto mark_used = [this, &used_slots](const std::unique_ptr<Buffer>& buffer) {
+        if (buffer->shared_pool_helper == pool_)
+            used_slots[buffer->pool_slot] = true;
+    };
+    std::for_each(buffers_.begin(), buffers_.end(), mark_used);
+    std::for_each(deferred_destructing_buffers_.begin(),
+                  deferred_destructing_buffers_.end(), mark_used);
+
+    for (int32_t i = 0; i < RT_POOL_SLOTS; i++)
+    {
+        if (!used_slots[i])
+            return i;
+    }
+
+    // All the slots are occupied (by the buffers held by the compositor)
+    ReallocatePool(pool_slot_size_);
+    return 0;
+}
+
+size_t WaylandSHMRenderTarget::GetPurgeableBytes() noexcept
+{
+    if (!pool_)
+        return 0;
+
+    // Size of each slot if the pool is reallocated for the current size
+    size_t size = GetBufferBytes(GetWidth(), GetHeight());
+    size_t shrunk_slot_size = align_pool_slot_size(size + size / 4);
+    if (pool_slot_size_ <= shrunk_slot_size)
+        return 0;
+    return (pool_slot_size_ - shrunk_slot_size) * RT_POOL_SLOTS;
+}
+
+void WaylandSHMRenderTarget::PurgeResources(g_maybe_unused MemoryPressureLevel level) noexcept
+{
+    // The drawing buffer may be in use now, so the pool is shrunk
+    // when the next frame begins.
+    if (GetPurgeableBytes() > 0)
+        pool_shrink_requested_ = true;
+}
+
+void WaylandSHMRenderTarget::MaybeShrinkPool()
+{
+    size_t size = GetBufferBytes(GetWidth(), GetHeight());
+    bool requested = std::exchange(pool_shrink_requested_, false) && GetPurgeableBytes() > 0;
+    if (!pool_ || (!requested && pool_slot_size_ <= size * 2))
+    {
+        pool_oversized_since_.reset();
+        return;
+    }
+
+    if (!requested)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (!pool_oversized_since_)
+        {
+            pool_oversized_since_ = now;
+            return;
+        }
+        if (now - *pool_oversized_since_ < kPoolShrinkDelay)
+            return;
+    }
+
+    // Contents of the drawing buffer are preserved, as the caller
+    // may only repaint the damaged region of it.
+    std::unique_ptr<Buffer> previous = std::move(buffers_[drawing_buffer_idx_]);
+    buffers_.erase(buffers_.begin() + drawing_buffer_idx_);
+
+    // A new pool will be allocated for the current size
+    pool_.reset();
+    pool_stats_.shrinks++;
+    RebuildBuffers(GetWidth(), GetHeight());
+
+    std::memcpy(buffers_[drawing_buffer_idx_]->ptr, previous->ptr, previous->size);
+    DestroyBuffer(previous.get());
+}
+
+std::unique_ptr<WaylandSHMRenderTarget::Buffer>
+WaylandSHMRenderTarget::CreateBuffer(int32_t width, int32_t height)
 {
     std::optional<MonitorSubpixel> subpixel;
     for (const auto& monitor : GetDisplay()->RequestMonitorList())
@@ -168,7 +372,7 @@ void WaylandSHMRenderTarget::AllocateAppendBuffers(int32_t count, int32_t width,
     }
 
     SkPixelGeometry sk_subpixel;
-    switch (*subpixel)
+    switch (subpixel.value_or(MonitorSubpixel::kUnknown))
     {
     case MonitorSubpixel::kUnknown:
     case MonitorSubpixel::kNone:
@@ -188,38 +392,35 @@ void WaylandSHMRenderTarget::AllocateAppendBuffers(int32_t count, int32_t width,
         break;
     }
 
-    size_t allocSingleSize = SkColorTypeBytesPerPixel(format) * width * height;
+    SkColorType format = GetColorType();
+    size_t allocSingleSize = GetBufferBytes(width, height);
     size_t stride = SkColorTypeBytesPerPixel(format) * width;
-    size_t poolAllocSize = allocSingleSize * count;
 
-    auto wl_shm = GetDisplay()->As<WaylandDisplay>()->GetGlobalsRef()->wl_shm_;
-    auto sharedPool = WaylandSharedMemoryHelper::Make(wl_shm, poolAllocSize,
-                                                      WaylandSharedMemoryHelper::kRasterRenderTarget_Role);
-    void *poolStartAddress = sharedPool->GetMappedAddress();
-
-    for (uint32_t n = 0; n < count; n++)
-    {
-        auto offset = static_cast<int32_t>(allocSingleSize * n);
-
-        auto buffer = std::make_unique<Buffer>();
-        buffer->state = BufferState::kFree;
-        buffer->shared_pool_helper = sharedPool;
-        buffer->size = allocSingleSize;
-        buffer->ptr = reinterpret_cast<uint8_t *>(poolStartAddress) + offset;
-        buffer->damage.setEmpty();
-        buffer->buffer = wl_shm_pool_create_buffer(sharedPool->GetShmPool(),
-                                                   offset, width, height, static_cast<int32_t>(stride),
-                                                   SkColorTypeToWlShmFormat(format));
-        buffer->rt = this;
-
-        SkImageInfo info = SkImageInfo::Make(width, height, format, SkAlphaType::kPremul_SkAlphaType);
-        SkSurfaceProps props(0, sk_subpixel);
-        buffer->surface = SkSurfaces::WrapPixels(info, buffer->ptr, stride, &props);
-
-        wl_buffer_add_listener(buffer->buffer, &g_buffer_listener, buffer.get());
-
-        buffers_.push_back(std::move(buffer));
-    }
+    int32_t slot = AcquirePoolSlot(allocSingleSize);
+    auto offset = static_cast<int32_t>(pool_slot_size_ * slot);
+
+    auto buffer = std::make_unique<Buffer>();
+    buffer->state = BufferState::kFree;
+    buffer->shared_pool_helper = pool_;
+    buffer->size = allocSingleSize;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->pool_slot = slot;
+    buffer->ptr = reinterpret_cast<uint8_t *>(pool_->GetMappedAddress()) + offset;
+    buffer->damage.setEmpty();
+    buffer->buffer = wl_shm_pool_create_buffer(pool_->GetShmPool(),
+                                               offset, width, height, static_cast<int32_t>(stride),
+                                               SkColorTypeToWlShmFormat(format));
+    buffer->rt = this;
+
+    SkImageInfo info = SkImageInfo::Make(width, height, format, SkAlphaType::kPremul_SkAlphaType);
+    SkSurfaceProps props(0, sk_subpixel);
+    buffer->surface = SkSurfaces::WrapPixels(info, buffer->ptr, stride, &props);
+
+    wl_buffer_add_listener(buffer->buffer, &g_buffer_listener, buffer.get());
+
+    pool_stats_.created_buffers++;
+    return buffer;
 }
 
 int32_t WaylandSHMRenderTarget::GetNextDrawingBuffer()
@@ -234,7 +435,8 @@ int32_t WaylandSHMRenderTarget::GetNextDrawingBuffer()
     }
 
     auto last = static_cast<int32_t>(buffers_.size());
-    AllocateAppendBuffers(2, GetWidth(), GetHeight(), GetColorType());
+    for (int32_t i = 0; i < 2; i++)
+        buffers_.push_back(CreateBuffer(GetWidth(), GetHeight()));
 
     buffers_[last]->state = BufferState::kDrawing;
     return last;
@@ -247,6 +449,10 @@ SkSurface *WaylandSHMRenderTarget::OnBeginFrame()
     if (drawing_buffer_idx_ < 0)
         return nullptr;
 
+    // Nothing has been drawn into the drawing buffer yet,
+    // so it is a good time to replace the buffers.
+    MaybeShrinkPool();
+
     std::unique_ptr<Buffer>& buf = buffers_[drawing_buffer_idx_];
     return buf->surface.get();
 }
@@ -313,19 +519,31 @@ void WaylandSHMRenderTarget::OnPresentFrame(SkSurface *surface,
 
 void WaylandSHMRenderTarget::OnResize(int32_t width, int32_t height)
 {
-    ReleaseAllBuffers(false);
-    AllocateAppendBuffers(RT_INITIAL_BUFFERS, width, height, GetColorType());
-    buffers_[0]->state = BufferState::kDrawing;
-    drawing_buffer_idx_ = 0;
-    committed_buffer_idx_ = RT_EMPTY_INDEX;
+    RebuildBuffers(width, height);
     OnClearFrameBuffers();
 }
 
 std::string WaylandSHMRenderTarget::GetBufferStateDescriptor()
 {
+    // [pool=<pool>:pool_size=<size>:slot_size=<size>:wasted=<bytes>:reallocations=<n>:
+    //  shrinks=<n>:created=<n>:reused=<n>]
     // #<idx>:pool=<pool>:addr=<addr>:size=<size>:<status>
 
-    std::string out;
+    size_t pool_size = pool_ ? pool_->GetPoolSize() : 0;
+    size_t used_size = 0;
+    for (const std::unique_ptr<Buffer>& buffer : buffers_)
+    {
+        if (buffer->shared_pool_helper == pool_)
+            used_size += buffer->size;
+    }
+
+    std::string out = fmt::format(
+            "[pool={}:pool_size={}:slot_size={}:wasted={}:reallocations={}:"
+            "shrinks={}:created={}:reused={}]",
+            fmt::ptr(pool_.get()), pool_size, pool_slot_size_, pool_size - used_size,
+            pool_stats_.reallocations, pool_stats_.shrinks,
+            pool_stats_.created_buffers, pool_stats_.reused_buffers);
+
     int32_t idx = 0;
     for (const std::unique_ptr<Buffer>& buffer : buffers_)
     {
@@ -382,17 +600,14 @@ void WaylandSHMRenderTarget::Trace(GraphicsResourcesTrackable::Tracer *tracer) n
 {
     WaylandRenderTarget::Trace(tracer);
 
-    if (!buffers_.empty())
+    if (pool_)
     {
-        std::shared_ptr<WaylandSharedMemoryHelper> pool = buffers_[0]->shared_pool_helper;
-        CHECK(pool);
-
         tracer->TraceResource("Wayland shared memory pool",
                               TRACKABLE_TYPE_POOL,
                               TRACKABLE_DEVICE_CPU,
                               TRACKABLE_OWNERSHIP_SHARED,
-                              TraceIdFromPointer(pool->GetMappedAddress()),
-                              pool->GetPoolSize());
+                              TraceIdFromPointer(pool_->GetMappedAddress()),
+                              pool_->GetPoolSize());
     }
 
     int32_t index = 0;
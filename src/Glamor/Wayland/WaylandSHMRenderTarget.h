@@ -18,6 +18,9 @@
 #ifndef COCOA_GLAMOR_WAYLAND_WAYLANDSHMRENDERTARGET_H
 #define COCOA_GLAMOR_WAYLAND_WAYLANDSHMRENDERTARGET_H
 
+#include <chrono>
+#include <optional>
+
 #include "include/core/SkRect.h"
 #include "include/core/SkRegion.h"
 
@@ -28,6 +31,18 @@ GLAMOR_NAMESPACE_BEGIN
 
 class WaylandSharedMemoryHelper;
 
+/**
+ * Buffers are sub-allocated from a shared memory pool, which is divided into
+ * equally sized slots with some headroom. When the surface is resized,
+ * buffers are recreated in the free slots of the current pool as long as the
+ * new size fits, and the pool is only reallocated when it is too small
+ * (growing geometrically) or when it has been oversized for a while.
+ * Interactive resizing therefore does not create new shared memory files
+ * for each configure event.
+ *
+ * Under memory pressure, the oversized pool is shrunk at the beginning
+ * of the next frame without waiting for the delay.
+ */
 class WaylandSHMRenderTarget : public WaylandRenderTarget
 {
 public:
@@ -46,6 +61,9 @@ public:
         wl_buffer          *buffer;
         void               *ptr;
         size_t              size;
+        int32_t             width;
+        int32_t             height;
+        int32_t             pool_slot;
         sk_sp<SkSurface>    surface;
         std::shared_ptr<WaylandSharedMemoryHelper>
                             shared_pool_helper;
@@ -73,16 +91,42 @@ public:
     static void FrameDoneCallback(void *data, wl_callback *cb, uint32_t extraData);
 
     void Trace(GraphicsResourcesTrackable::Tracer *tracer) noexcept override;
+    size_t GetPurgeableBytes() noexcept override;
+    void PurgeResources(MemoryPressureLevel level) noexcept override;
 
 private:
+    struct PoolStatistics
+    {
+        uint32_t reallocations;
+        uint32_t shrinks;
+        uint32_t created_buffers;
+        uint32_t reused_buffers;
+    };
+
     void ReleaseAllBuffers(bool forceRelease);
-    void AllocateAppendBuffers(int32_t count, int32_t width, int32_t height, SkColorType format);
+    void DestroyBuffer(Buffer *buffer);
+    void RetireBuffer(std::unique_ptr<Buffer> buffer);
+    void RebuildBuffers(int32_t width, int32_t height);
+    std::unique_ptr<Buffer> CreateBuffer(int32_t width, int32_t height);
+    int32_t AcquirePoolSlot(size_t size);
+    void ReallocatePool(size_t slot_size);
+    void MaybeShrinkPool();
     int32_t GetNextDrawingBuffer();
+    g_nodiscard size_t GetBufferBytes(int32_t width, int32_t height) const;
+    g_nodiscard bool IsReusableBuffer(const Buffer *buffer) const;
 
     std::vector<std::unique_ptr<Buffer>> buffers_;
     std::vector<std::unique_ptr<Buffer>> deferred_destructing_buffers_;
     int32_t                              drawing_buffer_idx_;
     int32_t                              committed_buffer_idx_;
+
+    std::shared_ptr<WaylandSharedMemoryHelper>
+                                         pool_;
+    size_t                               pool_slot_size_;
+    std::optional<std::chrono::steady_clock::time_point>
+                                         pool_oversized_since_;
+    bool                                 pool_shrink_requested_;
+    PoolStatistics                       pool_stats_;
 };
 
 GLAMOR_NAMESPACE_END
@@ -118,6 +118,7 @@ void WaylandSeatPointerDevice::on_enter(void *data,
 
     // Update the serial number first
     surface_object->SetPointerEntered(serial, pointer);
+    surface_object->GetPointerMotionCoalescer().Reset();
 
     // Set an appropriate cursor which is associated with the surface
     auto cursor_base = surface_object->GetAttachedCursor();
@@ -160,6 +161,9 @@ void WaylandSeatPointerDevice::on_leave(void *data,
         return;
     }
 
+    // Deliver the pending motion before the pointer leaves
+    surface_object->CommitPointerMotionGroup(true);
+    surface_object->GetPointerMotionCoalescer().Reset();
     surface_object->SetPointerEntered(0, nullptr);
 
     // Stop the cursor's animation
@@ -180,7 +184,7 @@ void WaylandSeatPointerDevice::on_leave(void *data,
 
 void WaylandSeatPointerDevice::on_motion(void *data,
                                          wl_pointer *pointer,
-                                         g_maybe_unused uint32_t time,
+                                         uint32_t time,
                                          wl_fixed_t surface_x,
                                          wl_fixed_t surface_y)
 {
@@ -194,10 +198,9 @@ void WaylandSeatPointerDevice::on_motion(void *data,
         return;
     }
 
-    PresentSignal info;
-    info.EmplaceBack<double>(wl_fixed_to_double(surface_x));
-    info.EmplaceBack<double>(wl_fixed_to_double(surface_y));
-    surface->Emit(GLSI_SURFACE_POINTER_MOTION, std::move(info));
+    // Motion is delivered when the event group is completed (`on_frame`)
+    surface->GetPointerMotionCoalescer().Push(
+            time, wl_fixed_to_double(surface_x), wl_fixed_to_double(surface_y));
 }
 
 void WaylandSeatPointerDevice::on_button(void *data,
@@ -234,6 +237,10 @@ void WaylandSeatPointerDevice::on_button(void *data,
         return;
     }
 
+    // The button event must not be delivered before the motion
+    // which moves the pointer to where the button is pressed.
+    surface->CommitPointerMotionGroup(true);
+
     bool pressed = WL_POINTER_BUTTON_STATE_PRESSED == state;
 
     PresentSignal info;
@@ -340,6 +347,10 @@ void WaylandSeatPointerDevice::on_frame(void *data, wl_pointer *pointer)
         listener->ResetEventGroupStates();
     });
 
+    // The pointer may have left the surface in this event group
+    if (auto surface = extract_surface_from_pointer(data, pointer))
+        surface->CommitPointerMotionGroup(false);
+
     if (listener->axis_scroll_type_ != kNo_ScrollType)
     {
         auto surface = extract_surface_from_pointer(data, pointer);
@@ -21,6 +21,7 @@
 
 #include "Core/Journal.h"
 #include "Core/Errors.h"
+#include "Glamor/GraphicsResourcesTrackable.h"
 #include "Glamor/Wayland/WaylandSharedMemoryHelper.h"
 GLAMOR_NAMESPACE_BEGIN
 
@@ -139,12 +140,16 @@ WaylandSharedMemoryHelper::WaylandSharedMemoryHelper(wl_shm *shm, wl_shm_pool *p
     , pool_size_(size)
     , vma_mapped_address_(ptr)
 {
+    GraphicsResourcesTrackable::AccountResource(
+            TrackableCategory::kShmBuffers, static_cast<int64_t>(pool_size_), 1);
 }
 
 WaylandSharedMemoryHelper::~WaylandSharedMemoryHelper()
 {
     wl_shm_pool_destroy(shm_pool_);
     munmap(vma_mapped_address_, pool_size_);
+    GraphicsResourcesTrackable::AccountResource(
+            TrackableCategory::kShmBuffers, -static_cast<int64_t>(pool_size_), -1);
 }
 
 GLAMOR_NAMESPACE_END
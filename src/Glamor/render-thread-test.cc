@@ -0,0 +1,297 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPictureRecorder.h"
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/EventLoop.h"
+#include "Glamor/Glamor.h"
+#include "Glamor/PresentThread.h"
+#include "Glamor/HeadlessSurface.h"
+#include "Glamor/ContentAggregator.h"
+#include "Glamor/Layers/LayerTree.h"
+#include "Glamor/Layers/TransformLayer.h"
+#include "Glamor/Layers/PictureLayer.h"
+#include "Glamor/Layers/PictureContentHash.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * render-thread-test binds two headless raster surfaces to dedicated render
+ * threads (see `ContentAggregator::SetDedicatedRenderThread`) and drives them
+ * from a real present thread: frames are updated for both surfaces in every
+ * step, and the surfaces are resized or inspected while their frames may
+ * still be painted on the render threads. Each step is a separate present
+ * thread task, so the replies of the render threads are delivered by the
+ * event loop between steps. The last frame of each surface is checked
+ * against the color it was painted with.
+ *
+ * It is meant to be run under the address or thread sanitizer.
+ */
+
+namespace {
+
+constexpr int32_t kTestSteps = 240;
+constexpr int32_t kTargetsCount = 2;
+
+const SkISize g_surface_sizes[] = {
+    SkISize::Make(320, 240),
+    SkISize::Make(400, 300),
+    SkISize::Make(256, 256)
+};
+
+constexpr int32_t kSurfaceSizesCount = sizeof(g_surface_sizes) / sizeof(SkISize);
+
+std::shared_ptr<LayerTree> make_solid_layer_tree(const SkISize& size, SkColor color)
+{
+    SkRect bounds = SkRect::Make(size);
+
+    SkPictureRecorder recorder;
+    SkCanvas *canvas = recorder.beginRecording(bounds);
+    SkPaint paint;
+    paint.setColor(color);
+    canvas->drawRect(bounds, paint);
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+    root->AppendChildLayer(std::make_shared<PictureLayer>(
+            false, picture, ComputePictureContentHash(picture)));
+
+    auto tree = std::make_shared<LayerTree>(size);
+    tree->SetRootLayer(root);
+    return tree;
+}
+
+class RenderThreadTest
+{
+public:
+    explicit RenderThreadTest(PresentThread *thread)
+        : thread_(thread), failed_(false) {}
+
+    // Called on the main thread
+    void Start();
+
+    g_nodiscard bool HasFailed() const {
+        return failed_;
+    }
+
+private:
+    struct Target
+    {
+        std::shared_ptr<HeadlessSurface>    surface;
+        std::shared_ptr<ContentAggregator>  aggregator;
+        SkColor                             last_color = SK_ColorBLACK;
+        int32_t                             size_index = 0;
+        int32_t                             frames_updated = 0;
+        int32_t                             frames_dropped = 0;
+        int32_t                             resizes = 0;
+    };
+
+    void Submit(std::function<void()> task, std::function<void()> next);
+    void Fail(const std::string& what);
+
+    // Following methods are called on the present thread
+    void Setup();
+    void Step(int32_t step);
+    void Finish();
+    bool UpdateTarget(Target& target, SkColor color);
+    void ResizeTarget(Target& target);
+
+    PresentThread  *thread_;
+    Target          targets_[kTargetsCount];
+    bool            failed_;
+};
+
+void RenderThreadTest::Submit(std::function<void()> task, std::function<void()> next)
+{
+    thread_->SubmitTaskNoRet(std::move(task), [this, next = std::move(next)] {
+        if (failed_ || !next)
+        {
+            thread_->Dispose();
+            return;
+        }
+        next();
+    }, [this](const std::string& what) {
+        Fail(fmt::format("Caught an exception on present thread: {}", what));
+        thread_->Dispose();
+    });
+}
+
+void RenderThreadTest::Fail(const std::string& what)
+{
+    fmt::print(stderr, "FAILED: {}\n", what);
+    failed_ = true;
+}
+
+void RenderThreadTest::Start()
+{
+    Submit([this] { Setup(); }, [this] {
+        // Steps are submitted one by one from the main thread
+        auto step = std::make_shared<std::function<void(int32_t)>>();
+        *step = [this, step](int32_t i) {
+            if (i == kTestSteps)
+            {
+                Submit([this] { Finish(); }, {});
+                // Break the reference cycle
+                *step = nullptr;
+                return;
+            }
+            Submit([this, i] { Step(i); }, [step, i] { (*step)(i + 1); });
+        };
+        (*step)(0);
+    });
+}
+
+void RenderThreadTest::Setup()
+{
+    for (int32_t i = 0; i < kTargetsCount; i++)
+    {
+        Target& target = targets_[i];
+        target.size_index = i % kSurfaceSizesCount;
+
+        const SkISize& size = g_surface_sizes[target.size_index];
+        target.surface = HeadlessSurface::Make(size.width(), size.height());
+        target.aggregator = target.surface->GetContentAggregator();
+        if (!target.aggregator->SetDedicatedRenderThread(true))
+            Fail(fmt::format("Failed to bind surface #{} to a render thread", i));
+    }
+}
+
+bool RenderThreadTest::UpdateTarget(Target& target, SkColor color)
+{
+    SkISize size = SkISize::Make(target.surface->GetWidth(), target.surface->GetHeight());
+    auto result = target.aggregator->Update(make_solid_layer_tree(size, color));
+
+    switch (result)
+    {
+    case ContentAggregator::UpdateResult::kSuccess:
+        target.last_color = color;
+        target.frames_updated++;
+        return true;
+    case ContentAggregator::UpdateResult::kFrameDropped:
+        target.frames_dropped++;
+        return false;
+    default:
+        Fail("Failed to update the content aggregator");
+        return false;
+    }
+}
+
+void RenderThreadTest::ResizeTarget(Target& target)
+{
+    target.size_index = (target.size_index + 1) % kSurfaceSizesCount;
+    const SkISize& size = g_surface_sizes[target.size_index];
+    if (!target.surface->Resize(size.width(), size.height()))
+        Fail("Failed to resize the surface");
+    target.resizes++;
+}
+
+void RenderThreadTest::Step(int32_t step)
+{
+    for (int32_t i = 0; i < kTargetsCount; i++)
+    {
+        // The frame may have been submitted by a reply of the render thread
+        targets_[i].aggregator->PresentPendingFrame();
+        UpdateTarget(targets_[i], SkColorSetRGB(step & 0xff, i * 0x7f, 0x40));
+    }
+
+    // Both the render threads may be painting now
+    if (step % 3 == 0)
+        ResizeTarget(targets_[0]);
+    if (step % 5 == 0)
+        ResizeTarget(targets_[1]);
+    if (step % 7 == 0)
+        targets_[1].surface->GetBuffersDescriptor();
+}
+
+void RenderThreadTest::Finish()
+{
+    for (int32_t i = 0; i < kTargetsCount; i++)
+    {
+        Target& target = targets_[i];
+
+        // The last step may have resized the surface after its frame was
+        // painted, so paint one more frame with a known color.
+        target.aggregator->FlushRenderThread();
+        target.aggregator->PresentPendingFrame();
+        SkColor color = SkColorSetRGB(0x20, 0xff - i * 0x7f, 0xc0);
+        if (!UpdateTarget(target, color))
+        {
+            Fail(fmt::format("Surface #{} did not accept the last frame", i));
+            continue;
+        }
+        target.aggregator->FlushRenderThread();
+        target.aggregator->PresentPendingFrame();
+
+        auto *rt = static_cast<HeadlessRenderTarget*>(target.surface->GetRenderTarget().get());
+        SkBitmap pixel;
+        pixel.allocPixels(SkImageInfo::MakeN32Premul(1, 1));
+        if (!rt->GetFrameSurface()->readPixels(pixel, rt->GetWidth() / 2, rt->GetHeight() / 2))
+            Fail(fmt::format("Failed to read the frame of surface #{}", i));
+        else if (pixel.getColor(0, 0) != color)
+        {
+            Fail(fmt::format("Surface #{} has color {:#x}, expecting {:#x}",
+                             i, pixel.getColor(0, 0), color));
+        }
+
+        fmt::print("surface #{}: {} frames updated, {} dropped, {} resizes\n",
+                   i, target.frames_updated, target.frames_dropped, target.resizes);
+        if (target.frames_updated == 0)
+            Fail(fmt::format("No frames were updated for surface #{}", i));
+
+        target.surface->Close();
+        target.aggregator.reset();
+        target.surface.reset();
+    }
+}
+
+} // namespace anonymous
+GLAMOR_NAMESPACE_END
+
+int main()
+{
+    using namespace cocoa;
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    EventLoop::New();
+
+    gl::ContextOptions options;
+    gl::GlobalScope::New(options, EventLoop::GetCurrent());
+
+    int ret = 1;
+    if (gl::GlobalScope::Ref().StartPresentThread())
+    {
+        gl::RenderThreadTest test(gl::GlobalScope::Ref().GetPresentThread());
+        test.Start();
+
+        // The loop exits once the present thread has exited
+        EventLoop::GetCurrent()->run();
+        gl::GlobalScope::Ref().DisposePresentThread();
+
+        ret = test.HasFailed() ? 1 : 0;
+        fmt::print("{}\n", ret == 0 ? "PASSED" : "FAILED");
+    }
+
+    gl::GlobalScope::Delete();
+    EventLoop::Delete();
+    Journal::Delete();
+    return ret;
+}
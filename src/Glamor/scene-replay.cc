@@ -0,0 +1,208 @@
+/**
+ * This file is part of Cocoa.
+ *
+ * Cocoa is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * Cocoa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cocoa. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <thread>
+
+#include "fmt/format.h"
+
+#include "Core/Project.h"
+#include "Core/Journal.h"
+#include "Core/EventLoop.h"
+#include "Glamor/Glamor.h"
+#include "Glamor/RenderTarget.h"
+#include "Glamor/HeadlessSurface.h"
+#include "Glamor/ContentAggregator.h"
+#include "Glamor/GProfiler.h"
+#include "Glamor/GProfilerHistogram.h"
+#include "Glamor/Layers/LayerTree.h"
+#include "Glamor/Layers/SceneStream.h"
+GLAMOR_NAMESPACE_BEGIN
+
+/**
+ * scene-replay drives a raster ContentAggregator through a scene stream
+ * recorded by `ContentAggregator.startSceneRecording()`, and reports the
+ * GProfiler statistics of each frame. Frames are submitted as soon as the
+ * previous one is presented unless `--realtime` is specified.
+ */
+
+namespace {
+
+int64_t duration_us(GProfiler::Timepoint from, GProfiler::Timepoint to)
+{
+    if (to < from)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+// Stages reported for each frame, see `GProfiler::FrameStage`
+struct ReplayStage
+{
+    const char *name;
+    GProfiler::FrameMilestone from;
+    GProfiler::FrameMilestone to;
+};
+
+const ReplayStage g_replay_stages[] = {
+    { "update",  GProfiler::kBegin_FrameMilestone,        GProfiler::kRequested_FrameMilestone },
+    { "preroll", GProfiler::kPrerollBegin_FrameMilestone, GProfiler::kPrerollEnd_FrameMilestone },
+    { "paint",   GProfiler::kPaintBegin_FrameMilestone,   GProfiler::kPaintEnd_FrameMilestone },
+    { "submit",  GProfiler::kPaintEnd_FrameMilestone,     GProfiler::kRequested_FrameMilestone }
+};
+
+constexpr size_t kReplayStagesCount = sizeof(g_replay_stages) / sizeof(ReplayStage);
+
+int replay_main(const char *path, bool realtime)
+{
+    std::unique_ptr<SceneStreamReader> reader = SceneStreamReader::Make(path);
+    if (!reader)
+    {
+        fmt::print(stderr, "Failed to open scene stream {}\n", path);
+        return 1;
+    }
+
+    std::optional<SceneStreamReader::Frame> frame = reader->ReadNextFrame();
+    if (!frame)
+    {
+        fmt::print(stderr, "No frames in scene stream {}\n", path);
+        return 1;
+    }
+
+    SkISize frame_size = frame->layer_tree->GetFrameSize();
+    if (frame_size.isEmpty())
+    {
+        fmt::print(stderr, "Invalid frame size in scene stream {}\n", path);
+        return 1;
+    }
+
+    std::shared_ptr<HeadlessSurface> surface =
+            HeadlessSurface::Make(frame_size.width(), frame_size.height());
+    std::shared_ptr<ContentAggregator> aggregator = surface->GetContentAggregator();
+    const std::shared_ptr<GProfiler>& profiler = aggregator->GetAttachedProfiler();
+    CHECK(profiler);
+
+    GProfilerHistogram histograms[kReplayStagesCount];
+    uint32_t frames_count = 0, frames_failed = 0;
+
+    fmt::print("frame,timestampMs");
+    for (const ReplayStage& stage : g_replay_stages)
+        fmt::print(",{}Us", stage.name);
+    fmt::print(",arenaBytes\n");
+
+    auto replay_begin = std::chrono::steady_clock::now();
+    while (frame)
+    {
+        if (realtime)
+        {
+            std::this_thread::sleep_until(
+                    replay_begin + std::chrono::microseconds(frame->timestamp_us));
+        }
+
+        // The window may be resized during recording
+        const SkISize& size = frame->layer_tree->GetFrameSize();
+        auto rt = surface->GetRenderTarget();
+        if (!size.isEmpty() && (size.width() != rt->GetWidth() || size.height() != rt->GetHeight()))
+            rt->Resize(size.width(), size.height());
+
+        auto result = aggregator->Update(frame->layer_tree);
+        if (result != ContentAggregator::UpdateResult::kSuccess)
+        {
+            frames_failed++;
+            frame = reader->ReadNextFrame();
+            continue;
+        }
+        aggregator->PresentPendingFrame();
+
+        GProfiler::Report::Ptr report = profiler->GenerateCurrentReport();
+        CHECK(report && report->n_entries > 0);
+        const GProfiler::Report::Entry& entry = report->entries[report->n_entries - 1];
+
+        fmt::print("{},{:.3f}", frames_count, static_cast<double>(frame->timestamp_us) / 1000);
+        for (size_t i = 0; i < kReplayStagesCount; i++)
+        {
+            int64_t us = duration_us(entry.milestones[g_replay_stages[i].from],
+                                     entry.milestones[g_replay_stages[i].to]);
+            histograms[i].Record(us);
+            fmt::print(",{}", us);
+        }
+        fmt::print(",{}\n", entry.frame_arena_bytes);
+
+        // Only the latest sample is interesting
+        profiler->PurgeRecentHistorySamples(false);
+
+        frames_count++;
+        frame = reader->ReadNextFrame();
+    }
+
+    auto replay_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - replay_begin);
+
+    fmt::print(stderr, "Replayed {} frames ({} failed, {} pictures) in {}ms\n",
+               frames_count, frames_failed, reader->GetPicturesCount(), replay_time.count());
+    for (size_t i = 0; i < kReplayStagesCount; i++)
+    {
+        GProfilerHistogram::Counts counts{};
+        uint64_t max = 0;
+        histograms[i].AccumulateInto(counts, max);
+        GProfilerHistogram::Summary summary = GProfilerHistogram::Summarize(counts, max);
+        fmt::print(stderr, "  {:<8} p50 {}us, p90 {}us, p99 {}us, max {}us\n",
+                   g_replay_stages[i].name, summary.p50, summary.p90, summary.p99, summary.max);
+    }
+
+    surface->Close();
+    return reader->HasError() ? 1 : 0;
+}
+
+} // namespace anonymous
+GLAMOR_NAMESPACE_END
+
+int main(int argc, const char **argv)
+{
+    using namespace cocoa;
+
+    const char *path = nullptr;
+    bool realtime = false, bad_args = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string_view(argv[i]) == "--realtime")
+            realtime = true;
+        else if (!path)
+            path = argv[i];
+        else
+            bad_args = true;
+    }
+
+    if (!path || bad_args)
+    {
+        fmt::print(stderr, "Usage: {} [--realtime] <scene-stream>\n", argv[0]);
+        return 1;
+    }
+
+    Journal::New(LOG_LEVEL_QUIET, Journal::OutputDevice::kStandardError, false);
+    EventLoop::New();
+
+    gl::ContextOptions options;
+    options.SetEnableProfiler(true);
+    gl::GlobalScope::New(options, EventLoop::GetCurrent());
+
+    int ret = gl::replay_main(path, realtime);
+
+    gl::GlobalScope::Delete();
+    EventLoop::Delete();
+    Journal::Delete();
+    return ret;
+}
@@ -32,6 +32,8 @@
 #include "Core/Filesystem.h"
 #include "Core/ProcessSignalHandler.h"
 #include "Core/ApplicationInfo.h"
+#include "Core/CpuInfo.h"
+#include "Core/CpuDispatch.h"
 #include "Core/TraceEvent.h"
 #include "Gallium/Runtime.h"
 #include "Gallium/BindingManager.h"
@@ -53,6 +55,8 @@ cmd::ParseState initialize_logger(cmd::ParseResult& args)
     const char *file = nullptr;
     LogLevel level = LOG_LEVEL_QUIET;
     bool color = true;
+    bool async = false;
+    Journal::OverflowPolicy policy = Journal::OverflowPolicy::kDrop;
     Journal::OutputDevice output = Journal::OutputDevice::kStandardOut;
 
     for (const auto& arg : args.options)
@@ -79,11 +83,22 @@ cmd::ParseState initialize_logger(cmd::ParseResult& args)
         }
         else if arg_longopt_match("disable-log-decoration")
             color = false;
+        else if arg_longopt_match("log-async")
+        {
+            async = true;
+            if (!arg.value || arg.value->v_str == "drop") policy = Journal::OverflowPolicy::kDrop;
+            else if (arg.value->v_str == "block")         policy = Journal::OverflowPolicy::kBlock;
+            else
+            {
+                fmt::print(stderr, "Illegal specifier for log overflow policy: {}\n", arg.value->v_str);
+                return cmd::ParseState::kError;
+            }
+        }
     }
     if (output == Journal::OutputDevice::kFile)
         color = false;
 
-    Journal::New(level, output, color, file);
+    Journal::New(level, output, color, file, async, policy);
     return cmd::ParseState::kSuccess;
 }
 
@@ -190,6 +205,16 @@ cmd::ParseState startup_initialize(int argc, char const **argv,
         {
             init_only = true;
         }
+        else if arg_longopt_match("cpu-tier")
+        {
+            std::optional<CpuInfo::Tier> tier = CpuInfo::ParseTier(arg.value->v_str);
+            if (!tier)
+            {
+                fmt::print(stderr, "Error: Option --cpu-tier has an invalid value\n");
+                return cmd::ParseState::kError;
+            }
+            CpuInfo::Ref().setTierOverride(*tier);
+        }
         else if arg_longopt_match("v8-concurrent-workers")
         {
             if (arg.value->v_int < 0)
@@ -319,6 +344,58 @@ cmd::ParseState startup_initialize(int argc, char const **argv,
             size_t v = arg.value->v_int;
             glamor_options.SetProfilerRingBufferThreshold(v);
         }
+        else if arg_longopt_match("gl-dynamic-resolution")
+        {
+            glamor_options.SetEnableDynamicResolution(true);
+        }
+        else if arg_longopt_match("gl-dynamic-resolution-min-scale")
+        {
+            float v = arg.value->v_float;
+            if (v <= 0 || v > 1)
+            {
+                fmt::print(stderr, "Error: Option --gl-dynamic-resolution-min-scale has an invalid value\n");
+                return cmd::ParseState::kError;
+            }
+            glamor_options.SetDynamicResolutionMinScale(v);
+        }
+        else if arg_longopt_match("gl-dynamic-resolution-budget")
+        {
+            float v = arg.value->v_float;
+            if (v <= 0)
+            {
+                fmt::print(stderr, "Error: Option --gl-dynamic-resolution-budget has an invalid value\n");
+                return cmd::ParseState::kError;
+            }
+            glamor_options.SetDynamicResolutionFrameBudget(v);
+        }
+        else if arg_longopt_match("gl-pointer-resampling")
+        {
+            glamor_options.SetEnablePointerResampling(true);
+        }
+        else if arg_longopt_match("gl-frame-pacing")
+        {
+            glamor_options.SetEnableFramePacing(true);
+        }
+        else if arg_longopt_match("gl-filter-cache-budget")
+        {
+            int32_t v = arg.value->v_int;
+            if (v < 0)
+            {
+                fmt::print(stderr, "Error: Option --gl-filter-cache-budget has an invalid value\n");
+                return cmd::ParseState::kError;
+            }
+            glamor_options.SetFilterCacheBudget(static_cast<size_t>(v) * 1024 * 1024);
+        }
+        else if arg_longopt_match("gl-memory-budget")
+        {
+            int32_t v = arg.value->v_int;
+            if (v < 0)
+            {
+                fmt::print(stderr, "Error: Option --gl-memory-budget has an invalid value\n");
+                return cmd::ParseState::kError;
+            }
+            glamor_options.SetMemoryBudget(static_cast<size_t>(v) * 1024 * 1024);
+        }
         else if arg_longopt_match("gl-hwcompose-disable-presentation")
         {
             glamor_options.SetDisableHWComposePresent(true);
@@ -349,6 +426,9 @@ cmd::ParseState startup_initialize(int argc, char const **argv,
         app_env->js_first_script_name = args.orphans[0];
     }
 
+    // Tier override has been applied, select the variants of hot kernels
+    CpuDispatchRegistry::ResolveAll();
+
     return init_only ? cmd::ParseState::kJustInitialize : cmd::ParseState::kSuccess;
 }
 
@@ -434,9 +514,12 @@ int startup_main(int argc, char const **argv)
         perfetto::TrackEvent::Register();
     }
 
+    CpuInfo::New();
+
     ScopeExitAutoInvoker epilogue([]() -> void {
         ApplicationInfo::Delete();
         Journal::Delete();
+        CpuInfo::Delete();
     });
 
     gallium::Runtime::Options rt_options;
@@ -43,8 +43,9 @@ const char *get_averror_str(int error)
 struct AVStreamDecoder::DataAVIOContextPriv
 {
 public:
-    // 4K streaming data buffer
-    constexpr static size_t kBufferSize = 4 * 1024;
+    // 64K streaming data buffer. A larger buffer means fewer read calls
+    // on the underlying data when the media file is demuxed sequentially.
+    constexpr static size_t kBufferSize = 64 * 1024;
 
     explicit DataAVIOContextPriv(std::shared_ptr<Data> from_data)
         : data_(std::move(from_data))
@@ -52,6 +53,9 @@ public:
     {
         CHECK(data_);
 
+        // Media files are demuxed sequentially in most cases
+        data_->advise(vfs::AdviseHint::kSequential);
+
         // There is no need to free `buffer` as it is freed
         // by libavformat automatically.
         auto *buffer = static_cast<uint8_t*>(av_malloc(kBufferSize));
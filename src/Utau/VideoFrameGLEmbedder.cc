@@ -17,6 +17,7 @@
 
 #include <future>
 #include <chrono>
+#include <mutex>
 
 #include "include/core/SkPixmap.h"
 #include "include/core/SkBitmap.h"
@@ -97,6 +98,11 @@ struct VideoFrameGLEmbedder::SwscaleContextCache
 
     SwscaleContextCache() : override_idx(0) {}
 
+    // Frames committed by one embedder may be acquired by several render
+    // threads at the same time (see `gl::RenderThread`). Neither the cache
+    // nor the `SwsContext`s in it are thread-safe, so the lock must be held
+    // while a context returned by `UpdateContext` is being used.
+    std::mutex lock;
     std::array<SwsContextParamPair, kMaxContexts> contexts;
     int override_idx;
 
@@ -245,6 +251,7 @@ AVFrame *convert_frame_to_rgb(AVFrame *frame,
     param.dsth = scale_size.height();
     param.sampling = sampling;
 
+    std::scoped_lock<std::mutex> lock(sws_ctx_cache->lock);
     SwsContext *ctx = sws_ctx_cache->UpdateContext(param);
     if (!ctx)
         return nullptr;
@@ -497,7 +504,8 @@ public:
             promise->set_value(map_frame);
         };
 
-        EventLoop::GetCurrent()->enqueueThreadPoolTrivialTask(async_executor, {});
+        EventLoop::GetCurrent()->enqueueThreadPoolTrivialTask(
+                std::move(async_executor), {}, EventLoop::ThreadPoolLane::kInteractive);
     }
 
     ~VAAPIVBOAccessor() override {
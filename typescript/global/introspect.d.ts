@@ -42,6 +42,30 @@ interface TracingConfig {
     }>;
 }
 
+interface NativeHeapArenaStatistics {
+    readonly index: number;
+    readonly threads: number;
+    readonly activeBytes: number;
+    readonly dirtyBytes: number;
+    readonly muzzyBytes: number;
+    readonly smallAllocatedBytes: number;
+    readonly largeAllocatedBytes: number;
+    readonly tcacheBytes: number;
+}
+
+interface NativeHeapStatistics {
+    readonly allocated: number;
+    readonly active: number;
+    readonly resident: number;
+    readonly mapped: number;
+    readonly metadata: number;
+    readonly retained: number;
+    readonly tcacheBytes: number;
+    readonly threadAllocated: number;     /* calling thread only */
+    readonly threadDeallocated: number;   /* calling thread only */
+    readonly arenas: Array<NativeHeapArenaStatistics>;  /* empty if not requested */
+}
+
 interface Introspect {
     /**
      * Register a callback function for uncaught exception.
@@ -163,6 +187,34 @@ interface Introspect {
 
     startProcessTracing(config: TracingConfig): void;
     finishProcessTracing(file: string): Promise<number>;
+
+    /**
+     * Get statistics of the native heap (jemalloc), which includes memory
+     * allocated by native libraries and is invisible to V8 heap statistics.
+     * An exception is thrown if the allocator does not support introspection
+     * (e.g. sanitizer builds).
+     *
+     * @param perArena Also collect statistics of each arena, which is slower.
+     */
+    getNativeHeapStatistics(perArena?: boolean): NativeHeapStatistics;
+
+    /**
+     * Return unused dirty pages of the native heap to the operating system.
+     */
+    purgeNativeHeap(): void;
+
+    /**
+     * Set how long unused dirty and muzzy pages are kept in the native heap
+     * before they are returned to the operating system. 0 means purging
+     * immediately, and -1 disables purging.
+     */
+    setNativeHeapDecayTime(dirtyMs: number, muzzyMs: number): void;
+
+    /**
+     * Emit native heap statistics as counters of the "memory" tracing category
+     * every `intervalMs` milliseconds. 0 stops the emission.
+     */
+    setNativeHeapTraceInterval(intervalMs: number): void;
 }
 
 declare let introspect: Introspect;
@@ -132,6 +132,30 @@ export function queryCapabilities(cap: Capability): boolean | number | string;
  * run independently. An active PresentThread is treated as a pending work in event
  * loop, which prevents the exiting of the event loop until the thread is disposed.
  */
+export interface ResourceCategoryCounters {
+    bytes: number;
+    objects: number;
+    peakBytes: number;
+    peakObjects: number;
+}
+
+export interface ResourceCounters {
+    // Image snapshots of the layers cached by the rasterizer
+    layerCache: ResourceCategoryCounters;
+
+    // Shared memory pools of the Wayland raster render targets
+    shmBuffers: ResourceCategoryCounters;
+
+    // GPU surfaces imported from other GPU contexts
+    textures: ResourceCategoryCounters;
+
+    // GPU semaphores imported from other GPU contexts (`bytes` is always 0)
+    importedSemaphores: ResourceCategoryCounters;
+
+    // Video frames referenced by the layer trees (`bytes` is estimated)
+    videoFrames: ResourceCategoryCounters;
+}
+
 export class PresentThread {
     private constructor();
 
@@ -154,6 +178,27 @@ export class PresentThread {
      */
     createDisplay(): Promise<Display>;
 
+    /**
+     * Get the counters of graphics resources, aggregated by category.
+     * The counters are maintained incrementally when the resources are
+     * created or destroyed, so it is cheap enough to be called every frame.
+     * Values are also emitted as Perfetto counter tracks (`Resources.*`).
+     */
+    getResourceCounters(): ResourceCounters;
+
+    /**
+     * Get the aggregated latencies (in microseconds) of the messages
+     * transferred between the main thread and the PresentThread, as a string
+     * in JSON format. For each receiver type and opcode, the time spent
+     * queued, executing on the PresentThread and returning to the main thread
+     * is reported, along with the sampled depths of both queues.
+     * Returns null unless profiling is enabled by `--gl-transfer-queue-profile`
+     * (see `Constants.CAPABILITY_MESSAGE_QUEUE_PROFILING_ENABLED`).
+     * The same profile is written to the working directory when the
+     * PresentThread exits.
+     */
+    getMessageQueueProfileJSON(): string | null;
+
     /**
      * Explicitly perform the garbage collection on PresentThread.
      * Most of the rendering resources (especially GPU objects) are uniquely owned
@@ -182,6 +227,13 @@ export class PresentThread {
  * @event [monitor-removed] Emitted when an existing monitor was removed.
  *                          The corresponding `Monitor` object will also be notified by `detached` signal.
  *        Prototype: (monitor: Monitor) -> void
+ *
+ * @event [memory-pressure] Emitted after the graphics caches have been purged because the
+ *                          memory budget (`--gl-memory-budget`) was exceeded or the system
+ *                          reported memory pressure. Applications should drop their own caches
+ *                          (like decoded images) when receiving this signal, especially
+ *                          when `level` is `MEMORY_PRESSURE_LEVEL_CRITICAL`.
+ *        Prototype: (level: MemoryPressureLevel, releasedBytes: number) -> void
  */
 export class Display extends EventEmitterBase {
     /**
@@ -261,6 +313,12 @@ export interface MonitorPropertySet {
     description: string;
 }
 
+export interface PointerMotionEvent {
+    time: number;
+    x: number;
+    y: number;
+}
+
 /**
  * Monitor connected to the system.
  *
@@ -310,7 +368,9 @@ export class Monitor extends EventEmitterBase {
  * @event [pointer-hovering] Emitted when the pointer device enters or leaves the window area.
  *                           Prototype: (enter: boolean) -> void
  *
- * @event [pointer-motion] Emitted when a pointer moves on the window.
+ * @event [pointer-motion] Emitted when a pointer moves on the window. Motion events are
+ *                         coalesced and emitted at most once for each frame if a frame has
+ *                         been requested; see `getCoalescedPointerMotions`.
  *                         Prototype: (double x, double y) -> void
  *
  * @event [pointer-button] Emitted when a button of pointer device is pressed or released.
@@ -404,6 +464,15 @@ export class Surface extends EventEmitterBase {
      * @param monitor   A monitor where the fullscreen window should be displayed.
      */
     setFullscreen(value: boolean, monitor: Monitor): Promise<void>;
+
+    /**
+     * Get all the motion events which are coalesced into the latest
+     * `pointer-motion` signal, in chronological order. Timestamps are in
+     * milliseconds with an undefined base.
+     * The position of the signal may differ from the last event if the
+     * pointer resampling is enabled (`--gl-pointer-resampling`).
+     */
+    getCoalescedPointerMotions(): Array<PointerMotionEvent>;
 }
 
 /**
@@ -420,6 +489,10 @@ export interface GProfilerReport {
     // for all the timing measurements in this report.
     timebaseUsSinceEpoch: number;
 
+    // Maximum number of bytes ever allocated from the per-frame arena
+    // allocator in a single frame.
+    frameArenaHighWaterMark: number;
+
     // Profiling entries. Each entry is a single frame.
     entries: Array<{
 
@@ -437,7 +510,13 @@ export interface GProfilerReport {
             paintEnd: number;
             begin: number;
             end: number;
+            // The frame signal was emitted to the user (frame start).
+            // `presented - scheduled` is the frame-start-to-present latency.
+            scheduled: number;
         };
+
+        // Number of bytes allocated from the per-frame arena in this frame.
+        frameArenaBytes: number;
     }>;
 }
 
@@ -471,6 +550,22 @@ export class GProfiler {
      *       if the rendering thread attempts to insert a new sample.
      */
     purgeRecentHistorySamples(freeMemory: boolean): void;
+
+    /**
+     * Generate a JSON string which describes the distribution of frame stage
+     * durations (preroll, paint, submit, update, presentWait, startToPresent)
+     * over a rolling window of the most recent 10~20 seconds:
+     *
+     *   { "windowMs": number,
+     *     "stages": { [name]: { count, p50Us, p90Us, p99Us, maxUs } } }
+     *
+     * All the durations are in microseconds. The same percentiles are also
+     * emitted as Perfetto counters (`GProfiler.<Stage>.P50Us`, etc.) once per
+     * second when tracing is enabled.
+     *
+     * @note Unlike `generateCurrentReport`, it never blocks the rendering thread.
+     */
+    generateStageHistogramsJSON(): string;
 }
 
 type TextureId = number;
@@ -512,6 +607,49 @@ export class ContentAggregator extends EventEmitterBase {
      */
     captureNextFrameAsPicture(): Promise<number>;
 
+    /**
+     * Record the scenes submitted by `update` into a scene stream file at `path`,
+     * until `stopSceneRecording` is called. Unlike `captureNextFrameAsPicture`,
+     * the whole sequence of layer trees is recorded (pictures and image filters
+     * are deduplicated), so that the temporal behaviours like layer reuse and
+     * raster cache warm-up can be reproduced offline by the native
+     * `scene-replay` tool, which reports per-frame profiling statistics.
+     * A recording in progress is stopped first.
+     *
+     * Contents of external textures and GPU surface views are not recorded.
+     *
+     * @return A promise rejected if the file could not be created.
+     */
+    startSceneRecording(path: string): Promise<void>;
+
+    /**
+     * Stop the recording started by `startSceneRecording` and close the file.
+     *
+     * @return The number of recorded frames, or 0 if not recording.
+     */
+    stopSceneRecording(): Promise<number>;
+
+    /**
+     * Bind the ContentAggregator to a dedicated render thread (`enabled = true`)
+     * or bind it back to the PresentThread. Painting a scene on the render
+     * thread does not delay the frames of other surfaces, which is useful for
+     * multi-window applications. The Display, surfaces and the window system
+     * protocol are still handled by the PresentThread.
+     *
+     * While a frame is being painted on the render thread, calling `update`
+     * drops the new frame, as if the previous frame has not been presented yet.
+     *
+     * Immutable objects like `CkPicture`, raster `CkImage`, `CkImageFilter`,
+     * `CkShader`, `CkTypeface` and `CkTextBlob` can be shared freely among
+     * ContentAggregators on different render threads. However, a `Scene`
+     * must not be submitted to more than one ContentAggregator which is
+     * bound to a render thread.
+     *
+     * @return A promise resolved with false if the surface does not support
+     *         dedicated render threads (only raster surfaces support it).
+     */
+    setDedicatedRenderThread(enabled: boolean): Promise<boolean>;
+
     /**
      * If HWCompose backend is used, import a semaphore object that was exported
      * from other `GpuDirectContext`, and return a number presenting the ID of
@@ -531,9 +669,23 @@ export class ContentAggregator extends EventEmitterBase {
     deleteImportedGpuCkSurface(id: bigint): Promise<void>;
 }
 
+export interface SceneToImageOptions {
+    // Scale factor of the output image in (0, 1], which is 1 by default.
+    // Thumbnails can be rasterized at the reduced size directly.
+    scale?: number;
+
+    // Color type of the output image, which is the native 32-bit
+    // color type by default.
+    colorType?: ColorType;
+}
+
 export class Scene {
-    // ~Experimental API~
-    toImage(width: number, height: number): Promise<CkImage>;
+    /**
+     * Rasterize the scene into an image of `width` x `height` (multiplied by
+     * `options.scale`) pixels. The image is split into tiles which are
+     * rasterized concurrently in worker threads.
+     */
+    toImage(width: number, height: number, options: SceneToImageOptions | null): Promise<CkImage>;
 
     /**
      * Get an S-Expression representation of the layer tree.
@@ -550,6 +702,13 @@ export class SceneBuilder {
 
     pop(): SceneBuilder;
 
+    /**
+     * Layers pushed or added after this call are painted at native resolution
+     * even if the dynamic resolution scaling is active (`--gl-dynamic-resolution`).
+     * Text and UI elements usually prefer this.
+     */
+    setPrefersNativeResolution(value: boolean): SceneBuilder;
+
     addPicture(picture: CkPicture, autoFastClipping: boolean): SceneBuilder;
 
     addVideoBuffer(vbo: VideoBuffer,
@@ -630,6 +789,8 @@ export type TextureCompressionType = number;
 export type GpuSemaphoreSubmitted = number;
 export type UpdateResult = number;
 export type ImageFilterMapDirection = number;
+export type PictureBBHMode = number;
+export type MemoryPressureLevel = number;
 
 interface Constants {
     readonly CAPABILITY_HWCOMPOSE_ENABLED: Capability;
@@ -835,6 +996,13 @@ interface Constants {
     readonly IMAGE_FILTER_MAP_DIRECTION_REVERSE: ImageFilterMapDirection;
     readonly IMAGE_FILTER_MAP_DIRECTION_FORWARD: ImageFilterMapDirection;
 
+    readonly PICTURE_BBH_MODE_NONE: PictureBBHMode;
+    readonly PICTURE_BBH_MODE_RTREE: PictureBBHMode;
+    readonly PICTURE_BBH_MODE_AUTO: PictureBBHMode;
+
+    readonly MEMORY_PRESSURE_LEVEL_MODERATE: MemoryPressureLevel;
+    readonly MEMORY_PRESSURE_LEVEL_CRITICAL: MemoryPressureLevel;
+
     /* Pointer buttons (mouse and other pointing devices) */
     readonly POINTER_BUTTON_LEFT: PointerButton;
     readonly POINTER_BUTTON_RIGHT: PointerButton;
@@ -1954,6 +2122,15 @@ export class CkPicture {
     approximateByteUsed(): number;
 
     uniqueId(): number;
+
+    /**
+     * A 64-bit hash of the drawing commands recorded in the picture.
+     * Pictures which draw the same contents have the same hash even if
+     * they are recorded separately, while their `uniqueId` differs.
+     * Images and typefaces referenced by the picture are identified by
+     * their unique IDs instead of their pixels or font data.
+     */
+    contentHash(): bigint;
 }
 
 export class CkPictureRecorder {
@@ -1961,6 +2138,8 @@ export class CkPictureRecorder {
 
     beginRecording(bounds: CkRect): CkCanvas;
 
+    beginRecordingWithBBH(bounds: CkRect, mode: PictureBBHMode): CkCanvas;
+
     getRecordingCanvas(): CkCanvas | null;
 
     finishRecordingAsPicture(): CkPicture | null;